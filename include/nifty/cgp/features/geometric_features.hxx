@@ -66,11 +66,14 @@ namespace cgp{
             FEATURES & features
         )const{
 
+            typedef nifty::filters::GaussianCurvature2D<> CurvatureOp;
             std::vector<float> curvature;
             std::vector<float> buffer(AccType::NFeatures::value);
+            // reused for all cells, so the curvature buffers are not allocated per cell
+            typename CurvatureOp::Workspace workspace;
             for(auto sigmaIndex=0; sigmaIndex<sigmas_.size(); ++sigmaIndex){
                 const auto sigma = sigmas_[sigmaIndex];
-                nifty::filters::GaussianCurvature2D<> op(sigma, -1, 2.5);
+                CurvatureOp op(sigma, -1, 2.5);
 
 
                 for(auto cell1Index=0; cell1Index<cell1GeometryVector.size(); ++cell1Index){
@@ -89,7 +92,7 @@ namespace cgp{
                         //std::cout<<"    is closed "<<"\n";
                         const auto closedLine = cell1BoundedByVector[cell1Index].size() == 0;
                         //std::cout<<"    calculate curvature "<<"\n";
-                        op(geo.begin(), geo.end(), curvature.begin(), closedLine);
+                        op(geo.begin(), geo.end(), curvature.begin(), closedLine, workspace);
 
                         // accumulate the values
                         AccType acc;
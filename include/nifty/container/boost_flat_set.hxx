@@ -1,13 +1,17 @@
 #pragma once
 
+#include <utility>
+
 
 
 #ifdef WITHIN_TRAVIS
 #include "nifty/container/flat_set.hxx"
 #define __nifty_setimpl__ nifty::container::FlatSet
+#define __nifty_ordered_unique_range__ nifty::container::ordered_unique_range
 #else
 #include <boost/container/flat_set.hpp>
 #define __nifty_setimpl__ boost::container::flat_set
+#define __nifty_ordered_unique_range__ boost::container::ordered_unique_range
 #endif
 
 namespace nifty {
@@ -16,6 +20,20 @@ namespace container{
     template<class T>
     using BoostFlatSet = __nifty_setimpl__<T>;
 
+    // move the sorted storage out of a flat set (the set is empty afterwards)
+    template<class T>
+    inline typename BoostFlatSet<T>::sequence_type
+    extractSequence(BoostFlatSet<T> & set){
+        return set.extract_sequence();
+    }
+
+    // let a flat set take over an already sorted sequence without duplicates
+    template<class T>
+    inline void
+    adoptSortedSequence(BoostFlatSet<T> & set, typename BoostFlatSet<T>::sequence_type && sequence){
+        set.adopt_sequence(__nifty_ordered_unique_range__, std::move(sequence));
+    }
+
 } // container
 } // namespace nifty
   
@@ -9,6 +9,11 @@
 namespace nifty {
 namespace container{
 
+// tag for sequences that are already sorted and free of duplicates
+// (mirrors boost::container::ordered_unique_range)
+struct ordered_unique_range_t {};
+static const ordered_unique_range_t ordered_unique_range = ordered_unique_range_t();
+
 //
 template<
     class Key, 
@@ -34,6 +39,7 @@ public:
     typedef typename Vector::size_type size_type;
     typedef typename Vector::difference_type	difference_type;
     typedef typename Vector::const_pointer const_pointer;
+    typedef std::vector<Key> sequence_type;
 
     FlatSet(const std::size_t, const Comparison& = Comparison(),
         const Allocator& = Allocator());
@@ -84,6 +90,11 @@ public:
 
     allocator_type get_allocator() const;
 
+    // move the underlying sorted sequence out, the set is empty afterwards
+    sequence_type extract_sequence();
+    // replace the content by a sorted sequence without duplicates
+    void adopt_sequence(ordered_unique_range_t, sequence_type &&);
+
     // TODO: implement C++11 member functions 'emplace' and 'emplace_hint'
 
 private:
@@ -387,6 +398,23 @@ FlatSet<Key, Comparison, Allocator>::get_allocator() const {
     return vector_.get_allocator();
 }
 
+template<class Key, class Comparison, class Allocator>
+inline typename FlatSet<Key, Comparison, Allocator>::sequence_type
+FlatSet<Key, Comparison, Allocator>::extract_sequence() {
+    sequence_type sequence;
+    sequence.swap(vector_);
+    return sequence;
+}
+
+template<class Key, class Comparison, class Allocator>
+inline void
+FlatSet<Key, Comparison, Allocator>::adopt_sequence(
+    ordered_unique_range_t,
+    sequence_type && sequence
+) {
+    vector_ = std::move(sequence);
+}
+
 }
 } // namespace nifty
 
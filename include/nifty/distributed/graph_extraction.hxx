@@ -60,10 +60,11 @@ namespace distributed {
 
 
     // load labels from block; works for normal label dataset
-    // and label multisets
+    // and label multisets, which are read with numberOfThreads
     template<class LABELS, class ROI>
     inline bool loadLabels(const std::string & path, const std::string & key,
-                           LABELS & labels, const ROI & roiBegin) {
+                           LABELS & labels, const ROI & roiBegin,
+                           const int numberOfThreads=1) {
 
         typedef typename LABELS::value_type NodeType;
 
@@ -82,7 +83,7 @@ namespace distributed {
         if(isLabelMultiset) {
             // is a label multiset -> need to use label multi-set wrapper and then load the array
             tools::LabelMultisetWrapper label_multiset(std::move(ds));
-            label_multiset.readSubarray(labels, roiBegin);
+            label_multiset.readSubarray(labels, roiBegin, numberOfThreads);
         }
         else {
             // not a label multiset -> we can just load the label array
@@ -454,7 +455,8 @@ namespace distributed {
                              NodeSet & nodes,
                              EdgeSet & edges,
                              const bool ignoreLabel=false,
-                             const bool increaseRoi=true) {
+                             const bool increaseRoi=true,
+                             const int numberOfThreads=1) {
 
         // if specified, we decrease roiBegin by 1.
         // this is necessary to capture edges that lie in between of block boundaries
@@ -481,7 +483,8 @@ namespace distributed {
         Tensor3 labels(shape);
 
         // load the label block from n5
-        const bool hasLabels = loadLabels(pathToLabels, keyToLabels, labels, actualRoiBegin);
+        const bool hasLabels = loadLabels(pathToLabels, keyToLabels, labels, actualRoiBegin,
+                                          numberOfThreads);
 
         // don't write empty labels
         if(!hasLabels) {
@@ -545,14 +548,16 @@ namespace distributed {
                                             const std::string & keyToRoi,
                                             const bool ignoreLabel=false,
                                             const bool increaseRoi=false,
-                                            const bool serializeToVarlen=false) {
+                                            const bool serializeToVarlen=false,
+                                            const int numberOfThreads=1) {
         // extract graph nodes and edges from roi
         NodeSet nodes;
         EdgeSet edges;
         extractGraphFromRoi(pathToLabels, keyToLabels,
                             roiBegin, roiEnd,
                             nodes, edges,
-                            ignoreLabel, increaseRoi);
+                            ignoreLabel, increaseRoi,
+                            numberOfThreads);
         // serialize the graph
         if(serializeToVarlen) {
             serializeGraphToVarlen(pathToGraph, keyToRoi,
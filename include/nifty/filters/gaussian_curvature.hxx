@@ -1,6 +1,12 @@
 #pragma once
 
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <vector>
+
 #include "nifty/math/numerics.hxx"
+#include "nifty/parallel/threadpool.hxx"
 #include "nifty/array/arithmetic_array.hxx"
 #include "nifty/tools/for_each_coordinate.hxx"
 
@@ -9,14 +15,38 @@ namespace filters{
 
 
 
-template<class T = long double>
-class GaussianCurvature2D{
+/// Curvature of a (discrete) curve in DIM dimensions from Gaussian derivatives
+///
+/// The first and second derivatives of every coordinate axis are computed
+/// by 1D convolution along the curve on contiguous (struct of arrays)
+/// buffers of the extrapolated coordinates.
+/// Long curves are split into blocks that are processed by a thread pool,
+/// curves with a single block are processed serially.
+/// The curve is extrapolated linearly at both ends.
+///
+/// The extrapolated coordinates live in a Workspace; callers that compute the
+/// curvature of many (short) curves should pass the same workspace to every call.
+///
+/// For DIM == 2 this is |x'y'' - y'x''| / |r'|^3, for DIM == 3 |r' x r''| / |r'|^3.
+/// The derivative kernels are not normalized, so the result is the curvature
+/// scaled by a constant that only depends on the kernels.
+///
+template<std::size_t DIM, class T = double>
+class GaussianCurvature{
+
+    static_assert(DIM == 2 || DIM == 3, "GaussianCurvature is implemented for 2D and 3D curves");
 
 public:
-    typedef typename nifty::math::NumericTraits<T>::RealPromote ValueType;
+    typedef T ValueType;
     typedef ValueType value_type;
 
-    GaussianCurvature2D(const ValueType sigma, int r = -1, const ValueType windowRatio = 3.5)
+    // scratch buffers, must not be shared between concurrent calls
+    struct Workspace{
+        // coordinates with radius() extrapolated points at both ends
+        std::array<std::vector<ValueType>, DIM> padded;
+    };
+
+    GaussianCurvature(const ValueType sigma, int r = -1, const ValueType windowRatio = 3.5)
     :   sigma_(sigma),
         radius_(std::max(1,r == -1 ? int(sigma*windowRatio + 0.5) : r    )),
         kdx_(radius_*2 + 1),
@@ -46,12 +76,23 @@ public:
     }
 
 
+    // coordinates as (size x DIM) array
+    template<class ARR0, class ARR1>
+    void operator()(const ARR0 & coordinates,
+                    ARR1 & out,
+                    const bool closedLine,
+                    const int numberOfThreads = 1) const {
+        Workspace workspace;
+        (*this)(coordinates, out, closedLine, workspace, numberOfThreads);
+    }
+
     template<class ARR0, class ARR1>
     void operator()(const ARR0 & coordinates,
                     ARR1 & out,
-                    const bool closedLine) const {
+                    const bool closedLine,
+                    Workspace & workspace,
+                    const int numberOfThreads = 1) const {
         //
-        typedef typename ARR0::value_type T0;
         typedef typename ARR1::value_type T1;
 
         struct CoordAdaptor{
@@ -59,10 +100,11 @@ public:
             : coordinates_(_coordinates){
             }
             //
-            std::array<ValueType, 2> operator[](const std::size_t i)const{
-                std::array<ValueType,2> ret;
-                ret[0] = coordinates_(i, 0);
-                ret[1] = coordinates_(i, 1);
+            std::array<ValueType, DIM> operator[](const std::size_t i)const{
+                std::array<ValueType, DIM> ret;
+                for(std::size_t d=0; d<DIM; ++d){
+                    ret[d] = coordinates_(i, d);
+                }
                 return ret;
             }
             const ARR0 & coordinates_;
@@ -72,13 +114,25 @@ public:
             OutAdaptor(ARR1 & _out)
             : out_(_out){
             }
-            T1 & operator[](const std::size_t i) {
+            T1 & operator[](const std::size_t i) const {
                 return out_(i);
             }
             ARR1 & out_;
         };
         this->impl(CoordAdaptor(coordinates), OutAdaptor(out),
-                    coordinates.shape()[0], closedLine);
+                    coordinates.shape()[0], closedLine, workspace, numberOfThreads);
+    }
+
+    template<class COORD_ITER, class OUT_ITER>
+    void operator()(
+        COORD_ITER coordsBegin,
+        COORD_ITER coordsEnd,
+        OUT_ITER   outIter,
+        const bool closedLine,
+        const int numberOfThreads = 1
+    ) const {
+        Workspace workspace;
+        (*this)(coordsBegin, coordsEnd, outIter, closedLine, workspace, numberOfThreads);
     }
 
     template<class COORD_ITER, class OUT_ITER>
@@ -86,11 +140,13 @@ public:
         COORD_ITER coordsBegin,
         COORD_ITER coordsEnd,
         OUT_ITER   outIter,
-        const bool closedLine
+        const bool closedLine,
+        Workspace & workspace,
+        const int numberOfThreads = 1
     ) const {
         this->impl(coordsBegin, outIter,
             std::distance(coordsBegin, coordsEnd),
-            closedLine);
+            closedLine, workspace, numberOfThreads);
     }
 
 
@@ -99,89 +155,109 @@ public:
     }
 private:
 
+    // number of curve points per block of work
+    static const std::size_t BlockSize = 4096;
+
     template<class COORD_ITER, class OUT_ITER>
     void impl(
         COORD_ITER coordsBegin,
         OUT_ITER   outIter,
         const std::size_t size,
-        const bool closedLine
+        const bool closedLine,
+        Workspace & workspace,
+        const int numberOfThreads
     ) const {
 
-        const auto kSize = 2*radius_ + 1;
-
-        struct CoordinateExtrapolator{
-            CoordinateExtrapolator(
-                const COORD_ITER & _coordinates,
-                const std::size_t s
-            ):  coordinates_(_coordinates),
-                size_(s)
-            {
+        const std::size_t kSize = 2*radius_ + 1;
+        const std::size_t paddedSize = size + 2*radius_;
 
-                for(auto d=0; d<2; ++d){
-                    dLow_[d] = coordinates_[0][d] - coordinates_[1][d];
-                    dHigh_[d] = coordinates_[s-1][d] - coordinates_[s-2][d];
-                }
+        // linearly extrapolated coordinates, one contiguous buffer per axis
+        auto & padded = workspace.padded;
+        for(std::size_t d=0; d<DIM; ++d){
+            padded[d].resize(paddedSize);
+        }
+        for(std::size_t i=0; i<size; ++i){
+            const auto c = coordsBegin[i];
+            for(std::size_t d=0; d<DIM; ++d){
+                padded[d][i + radius_] = c[d];
             }
-
-            std::array<ValueType,2> operator[](const int i)const{
-                std::array<ValueType,2>  ret;
-                const int s = size_;
-                if(i >= 0 && i < s){
-                    const auto c =  coordinates_[i];
-                    ret[0] = c[0];
-                    ret[1] = c[1];
-                }
-                else if(i < 0){
-                    const auto c =  coordinates_[0];
-                    const auto d = ValueType(std::abs(i));
-                    ret[0] = ValueType(c[0]) + dLow_[0]*d;
-                    ret[1] = ValueType(c[1]) + dLow_[1]*d;
-                }
-                else{ // i >= size
-                    const auto c =  coordinates_[s-1];
-                    const auto d = ValueType(i - (s - 1));
-                    ret[0] = ValueType(c[0]) + dHigh_[0]*d;
-                    ret[1] = ValueType(c[1]) + dHigh_[1]*d;
+        }
+        {
+            const auto c0 = coordsBegin[0];
+            const auto c1 = coordsBegin[1];
+            const auto cLast = coordsBegin[size-1];
+            const auto cBeforeLast = coordsBegin[size-2];
+            for(std::size_t d=0; d<DIM; ++d){
+                const ValueType dLow = c0[d] - c1[d];
+                const ValueType dHigh = cLast[d] - cBeforeLast[d];
+                for(int j=1; j<=radius_; ++j){
+                    padded[d][radius_ - j] = ValueType(c0[d]) + dLow*ValueType(j);
+                    padded[d][radius_ + size - 1 + j] = ValueType(cLast[d]) + dHigh*ValueType(j);
                 }
-                return ret;
             }
+        }
 
-            const COORD_ITER & coordinates_;
-            std::size_t size_;
-            std::array<ValueType,2>  dLow_;
-            std::array<ValueType,2>  dHigh_;
-        };
-
-        CoordinateExtrapolator cExt(coordsBegin, size);
-
-        for(int i=0; i<size; ++i){
-
-            ValueType dx[2]  = {ValueType(0),ValueType(0)};
-            ValueType dxx[2] = {ValueType(0),ValueType(0)};
+        auto processBlock = [&](const std::size_t blockIndex){
+            const std::size_t blockBegin = blockIndex * BlockSize;
+            const std::size_t blockEnd = std::min(blockBegin + BlockSize, size);
+            for(std::size_t i=blockBegin; i<blockEnd; ++i){
 
-            for(int ki=0; ki<kSize; ++ki){
+                // the derivatives of a point are accumulated in registers
+                ValueType dx[DIM], dxx[DIM];
+                for(std::size_t d=0; d<DIM; ++d){
+                    dx[d] = ValueType(0);
+                    dxx[d] = ValueType(0);
+                }
+                for(std::size_t ki=0; ki<kSize; ++ki){
+                    const ValueType kx = kdx_[ki];
+                    const ValueType kxx = kdxx_[ki];
+                    for(std::size_t d=0; d<DIM; ++d){
+                        const ValueType c = padded[d][i + ki];
+                        dx[d]  += c * kx;
+                        dxx[d] += c * kxx;
+                    }
+                }
 
-                const auto di = i - radius_ + ki;
-                const auto eCoord = cExt[di];
+                ValueType a;
+                if(DIM == 2){
+                    a = std::abs(dx[0]*dxx[1] - dx[1]*dxx[0]);
+                }
+                else{
+                    const std::size_t d1 = 1 % DIM, d2 = 2 % DIM;
+                    const ValueType c0 = dx[d1]*dxx[d2] - dx[d2]*dxx[d1];
+                    const ValueType c1 = dx[d2]*dxx[0] - dx[0]*dxx[d2];
+                    const ValueType c2 = dx[0]*dxx[d1] - dx[d1]*dxx[0];
+                    a = std::sqrt(c0*c0 + c1*c1 + c2*c2);
+                }
+                ValueType normP2 = 0;
+                for(std::size_t d=0; d<DIM; ++d){
+                    normP2 += dx[d]*dx[d];
+                }
+                // |r'|^3, sqrt is much cheaper than pow(normP2, 1.5)
+                const ValueType b = normP2 * std::sqrt(normP2);
 
-                for(auto d=0; d<2; ++d){
-                    dx[d]  += ValueType(eCoord[d]) * kdx_[ki];
-                    dxx[d] += ValueType(eCoord[d]) * kdxx_[ki];
+                if(std::abs(a) < eps_ && std::abs(b) < eps_){
+                    outIter[i] = 0.0;
+                }
+                else{
+                    outIter[i] = a / b;
                 }
             }
+        };
 
-            const auto a = std::abs(dx[0]*dxx[1] -  dx[1]*dxx[0]);
-            const auto b = std::pow(dx[0]*dx[0] + dx[1]*dx[1], 3.0/2.0);
-
-
-            if(std::abs(a) < eps_ && std::abs(b) < eps_){
-                outIter[i] = 0.0;
-            }
-            else{
-                const auto k  = (a)/(b);
-                outIter[i] = k;
+        // the thread pool only pays off for curves with several blocks
+        const std::size_t nBlocks = (size + BlockSize - 1) / BlockSize;
+        if(nBlocks <= 1 || parallel::ParallelOptions(numberOfThreads).getActualNumThreads() == 1){
+            for(std::size_t blockIndex=0; blockIndex<nBlocks; ++blockIndex){
+                processBlock(blockIndex);
             }
         }
+        else{
+            parallel::ThreadPool threadpool(numberOfThreads);
+            parallel::parallel_foreach(threadpool, nBlocks, [&](const int tid, const int64_t blockIndex){
+                processBlock(blockIndex);
+            });
+        }
     }
 
 
@@ -194,6 +270,14 @@ private:
 };
 
 
+// curvature of 2D curves, T is promoted to a real type
+template<class T = long double>
+using GaussianCurvature2D = GaussianCurvature<2, typename nifty::math::NumericTraits<T>::RealPromote>;
+
+// curvature of 3D (space) curves
+template<class T = double>
+using GaussianCurvature3D = GaussianCurvature<3, typename nifty::math::NumericTraits<T>::RealPromote>;
+
 
 
 #if 0
@@ -1,80 +1,212 @@
 #pragma once
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <memory>
+#include <numeric>
+#include <set>
+#include <vector>
+
 #include <nifty/xtensor/xtensor.hxx>
+#include "nifty/parallel/threadpool.hxx"
+#include "nifty/tools/sorted_key_lookup.hxx"
 
 
 namespace nifty {
 namespace filters {
 
 
-    template<class POINTS>
-    inline void computePointDistances(const POINTS & points, xt::xtensor<float, 2> & pointDistances) {
-        const std::size_t nPoints = points.shape()[0];
-        const unsigned ndim = points.shape()[1];
+    // uniform grid over a point set for radius queries,
+    // memory is linear in the number of points: only occupied cells are stored;
+    // the grid starts at the minimum coordinate of the points, so negative
+    // coordinates are fine
+    class PointGrid {
+    public:
+
+        template<class COORDS>
+        PointGrid(const COORDS & coords, const unsigned ndim, const float cellSize)
+        :   ndim_(ndim),
+            cellSize_(cellSize),
+            origin_(ndim, 0.f),
+            cellsPerAxis_(ndim, 1),
+            cellStrides_(ndim, 1),
+            pointsByCell_(),
+            cellKeys_(),
+            cellOffsets_(),
+            lookup_(nullptr)
+        {
+            const std::size_t nPoints = coords.size() / ndim_;
+            for(unsigned d = 0; d < ndim_ && nPoints > 0; ++d) {
+                origin_[d] = coords[d];
+                for(std::size_t i = 1; i < nPoints; ++i) {
+                    origin_[d] = std::min(origin_[d], static_cast<float>(coords[i * ndim_ + d]));
+                }
+            }
+            for(std::size_t i = 0; i < nPoints; ++i) {
+                for(unsigned d = 0; d < ndim_; ++d) {
+                    cellsPerAxis_[d] = std::max(cellsPerAxis_[d], cellCoordinate(coords[i * ndim_ + d], d) + 1);
+                }
+            }
+            for(int d = int(ndim_) - 2; d >= 0; --d) {
+                cellStrides_[d] = cellStrides_[d + 1] * cellsPerAxis_[d + 1];
+            }
 
-        for(std::size_t i = 0; i < nPoints; ++i) {
-            for(std::size_t j = i + 1; j < nPoints; ++j) {
+            // sort the points by cell
+            std::vector<uint64_t> pointKeys(nPoints);
+            for(std::size_t i = 0; i < nPoints; ++i) {
+                uint64_t key = 0;
+                for(unsigned d = 0; d < ndim_; ++d) {
+                    key += cellCoordinate(coords[i * ndim_ + d], d) * cellStrides_[d];
+                }
+                pointKeys[i] = key;
+            }
+            pointsByCell_.resize(nPoints);
+            std::iota(pointsByCell_.begin(), pointsByCell_.end(), 0);
+            std::sort(pointsByCell_.begin(), pointsByCell_.end(), [&](const uint64_t a, const uint64_t b){
+                return pointKeys[a] < pointKeys[b] || (pointKeys[a] == pointKeys[b] && a < b);
+            });
+
+            for(std::size_t i = 0; i < nPoints; ++i) {
+                const uint64_t key = pointKeys[pointsByCell_[i]];
+                if(cellKeys_.empty() || cellKeys_.back() != key) {
+                    cellKeys_.push_back(key);
+                    cellOffsets_.push_back(i);
+                }
+            }
+            cellOffsets_.push_back(nPoints);
+            lookup_.reset(new tools::SortedKeyLookup<uint64_t>(cellKeys_));
+        }
 
-                float dist = 0;
-                for(unsigned d = 0; d < ndim; ++d) {
-                    const float diff = (static_cast<float>(points(i, d)) - static_cast<float>(points(j, d)));
-                    dist += diff * diff;
+        // lookup_ references cellKeys_
+        PointGrid(const PointGrid &) = delete;
+        PointGrid(PointGrid &&) = delete;
+        PointGrid & operator=(const PointGrid &) = delete;
+        PointGrid & operator=(PointGrid &&) = delete;
+
+        // call f(pointId) for all points in cells that intersect the
+        // axis aligned box of half width radius around center
+        template<class F>
+        void forEachPointInBox(const float * center, const float radius, F && f) const {
+            std::vector<uint64_t> cellBegin(ndim_), cellEnd(ndim_), cell(ndim_);
+            for(unsigned d = 0; d < ndim_; ++d) {
+                const float lower = center[d] - radius;
+                const float upper = center[d] + radius;
+                if(upper < origin_[d]) {
+                    return;
+                }
+                cellBegin[d] = lower <= origin_[d] ? 0 : std::min(cellCoordinate(lower, d), cellsPerAxis_[d]);
+                cellEnd[d] = std::min(cellCoordinate(upper, d) + 1, cellsPerAxis_[d]);
+                if(cellBegin[d] >= cellEnd[d]) {
+                    return;
+                }
+            }
+
+            cell = cellBegin;
+            for(;;) {
+                uint64_t key = 0;
+                for(unsigned d = 0; d < ndim_; ++d) {
+                    key += cell[d] * cellStrides_[d];
+                }
+                const std::size_t cellIndex = lookup_->find(key);
+                if(cellIndex != tools::SortedKeyLookup<uint64_t>::NotFound) {
+                    for(std::size_t i = cellOffsets_[cellIndex]; i < cellOffsets_[cellIndex + 1]; ++i) {
+                        f(pointsByCell_[i]);
+                    }
                 }
-                dist = sqrt(dist);
 
-                pointDistances(i, j) = dist;
-                pointDistances(j, i) = dist;
+                // next cell
+                int d = int(ndim_) - 1;
+                for(; d >= 0; --d) {
+                    if(++cell[d] < cellEnd[d]) {
+                        break;
+                    }
+                    cell[d] = cellBegin[d];
+                }
+                if(d < 0) {
+                    break;
+                }
             }
         }
-    }
 
+    private:
+        // coord must not be smaller than origin_[d]
+        uint64_t cellCoordinate(const float coord, const unsigned d) const {
+            return static_cast<uint64_t>(std::floor((coord - origin_[d]) / cellSize_));
+        }
 
+        unsigned ndim_;
+        float cellSize_;
+        std::vector<float> origin_;
+        std::vector<uint64_t> cellsPerAxis_;
+        std::vector<uint64_t> cellStrides_;
+        std::vector<uint64_t> pointsByCell_;
+        std::vector<uint64_t> cellKeys_;
+        std::vector<std::size_t> cellOffsets_;
+        std::unique_ptr<tools::SortedKeyLookup<uint64_t>> lookup_;
+    };
+
+
+    // for every point, find the point with the largest value in the distance map
+    // within the radius given by the distance map at the point itself
+    // (ties are resolved in favour of the smaller point id);
+    // the neighbours are found with a uniform grid, so memory is linear
+    // and the queries run in parallel
     template<class DISTANCE_MAP, class POINTS>
-    inline uint64_t findBestPoint(const uint64_t pointId, const float thisDistance, const DISTANCE_MAP & distanceMap,
-                                  const POINTS & points, const xt::xtensor<float, 2> & pointDistances) {
-        const std::size_t nPoints = pointDistances.shape()[0];
+    inline void nonMaximumDistanceSuppression(const DISTANCE_MAP & distanceMap, const POINTS & points,
+                                              std::set<uint64_t> & pointsOut,
+                                              const int numberOfThreads=-1) {
+        const std::size_t nPoints = points.shape()[0];
         const unsigned ndim = points.shape()[1];
-        float maxDistance = -std::numeric_limits<float>::max();
-        uint64_t bestPoint = pointId;
+        if(nPoints == 0) {
+            return;
+        }
 
+        // the coordinates and distance map values of the points
+        std::vector<float> coords(nPoints * ndim);
+        std::vector<float> values(nPoints);
         xt::xindex pointCoord(ndim);
+        double meanRadius = 0;
         for(std::size_t i = 0; i < nPoints; ++i) {
-            if(pointDistances(pointId, i) > thisDistance) {
-                continue;
-            }
-
             for(unsigned d = 0; d < ndim; ++d) {
                 pointCoord[d] = points(i, d);
+                coords[i * ndim + d] = static_cast<float>(points(i, d));
             }
-            const float dist = distanceMap[pointCoord];
-            if(dist > maxDistance) {
-                bestPoint = i;
-                maxDistance = dist;
-            }
+            values[i] = distanceMap[pointCoord];
+            meanRadius += std::max(values[i], 0.f);
         }
+        meanRadius /= nPoints;
 
-        return bestPoint;
-    }
+        // cells of the size of a typical query radius
+        const float cellSize = std::max(1.f, static_cast<float>(meanRadius));
+        const PointGrid grid(coords, ndim, cellSize);
 
+        std::vector<uint64_t> bestPoints(nPoints);
+        parallel::ThreadPool threadpool(numberOfThreads);
+        parallel::parallel_foreach(threadpool, nPoints, [&](const int tid, const int64_t pointId) {
+            const float * center = &coords[pointId * ndim];
+            const float radius = values[pointId];
 
-    template<class DISTANCE_MAP, class POINTS>
-    inline void nonMaximumDistanceSuppression(const DISTANCE_MAP & distanceMap, const POINTS & points,
-                                              std::set<uint64_t> & pointsOut) {
-        const int64_t nPoints = points.shape()[0];
-        const unsigned ndim = points.shape()[1];
-
-        // compute the euclidean distances between all points
-        xt::xtensor<float, 2> pointDistances = xt::zeros<float>({nPoints, nPoints});
-        computePointDistances(points, pointDistances);
+            float maxDistance = -std::numeric_limits<float>::max();
+            uint64_t bestPoint = pointId;
+            grid.forEachPointInBox(center, std::max(radius, 0.f), [&](const uint64_t i) {
+                float dist = 0;
+                for(unsigned d = 0; d < ndim; ++d) {
+                    const float diff = center[d] - coords[i * ndim + d];
+                    dist += diff * diff;
+                }
+                if(std::sqrt(dist) > radius) {
+                    return;
+                }
+                const float val = values[i];
+                if(val > maxDistance || (val == maxDistance && i < bestPoint)) {
+                    bestPoint = i;
+                    maxDistance = val;
+                }
+            });
+            bestPoints[pointId] = bestPoint;
+        });
 
-        xt::xindex pointCoord(ndim);
-        // iterate over all points and find the closest seed
-        for(std::size_t pointId = 0; pointId < nPoints; ++pointId) {
-            for(unsigned d = 0; d < ndim; ++d) {
-                pointCoord[d] = points(pointId, d);
-            }
-            const float dist = distanceMap[pointCoord];
-            pointsOut.insert(findBestPoint(pointId, dist, distanceMap, points, pointDistances));
-        }
+        pointsOut.insert(bestPoints.begin(), bestPoints.end());
     }
 
 }
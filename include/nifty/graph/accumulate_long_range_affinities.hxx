@@ -0,0 +1,198 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+#include "nifty/nifty.hxx"
+#include "nifty/array/arithmetic_array.hxx"
+#include "nifty/parallel/threadpool.hxx"
+#include "nifty/tools/for_each_coordinate.hxx"
+#include "nifty/tools/runtime_check.hxx"
+#include "nifty/xtensor/xtensor.hxx"
+
+
+namespace nifty{
+namespace graph{
+
+    namespace detail_accumulate_affinities{
+
+        // affinities are accumulated as float, whatever the storage type
+        inline float affinityToFloat(const float value){
+            return value;
+        }
+
+        // uint8 affinities are fixed point values in [0, 1]
+        inline float affinityToFloat(const uint8_t value){
+            return float(value) / 255.f;
+        }
+
+        // uint16 affinities hold the bits of float16 values
+        // (numpy float16 arrays are passed as a uint16 view)
+        inline float affinityToFloat(const uint16_t value){
+            return half_float::detail::half2float<float>(value);
+        }
+
+
+        /// Direct mapped cache in front of graph.findEdge.
+        ///
+        /// Neighbouring voxels of a block mostly see the same few label pairs,
+        /// so a small cache per thread answers most lookups without
+        /// searching the adjacency of the graph.
+        template<class GRAPH>
+        class CachedEdgeFinder{
+        public:
+            CachedEdgeFinder(const GRAPH & graph, const std::size_t cacheBits = 10)
+            :   graph_(graph),
+                cacheShift_(64 - cacheBits),
+                entries_(std::size_t(1) << cacheBits)
+            {}
+
+            int64_t findEdge(const uint64_t u, const uint64_t v){
+                const uint64_t a = std::min(u, v);
+                const uint64_t b = std::max(u, v);
+                auto & entry = entries_[slot(a, b)];
+                if(entry.u != a || entry.v != b){
+                    entry.u = a;
+                    entry.v = b;
+                    entry.edge = graph_.findEdge(a, b);
+                }
+                return entry.edge;
+            }
+
+        private:
+            struct Entry{
+                // u == v is never queried, so this marks an empty slot
+                uint64_t u{std::numeric_limits<uint64_t>::max()};
+                uint64_t v{std::numeric_limits<uint64_t>::max()};
+                int64_t edge{-1};
+            };
+
+            std::size_t slot(const uint64_t a, const uint64_t b)const{
+                // fibonacci hashing of the pair
+                return ((a * 0x9E3779B97F4A7C15ull) ^ (b + 0x632BE59BD9B4E019ull + (a << 6))) * 0x9E3779B97F4A7C15ull >> cacheShift_;
+            }
+
+            const GRAPH & graph_;
+            std::size_t cacheShift_;
+            std::vector<Entry> entries_;
+        };
+
+    } // namespace detail_accumulate_affinities
+
+
+    /// Accumulate the (weighted) mean, the maximum and the (weighted) number
+    /// of the affinities that connect the nodes of an edge of a graph.
+    ///
+    /// Every voxel p is linked to p + offset for all offsets, and if the labels
+    /// u and v of the two voxels are different and (u, v) is an edge of the graph
+    /// the affinity of the link contributes to this edge.
+    /// The graph does not need to be a region adjacency graph and can contain
+    /// long range edges.
+    ///
+    /// \param labels the label image, any integer value type
+    /// \param affinities channel first affinities (offsets x shape) of type
+    ///                   float, uint8 (scaled to [0, 1]) or uint16 (float16 bits),
+    ///                   strided views are read without copies
+    /// \param weight functor weight(offsetIndex, coordinate) -> float of the link
+    /// \param meanAffinities (Output) the weighted mean affinity of every edge
+    /// \param maxAffinities (Output) the maximal affinity of every edge
+    /// \param sizes (Output) the sum of the weights of every edge
+    ///
+    template<std::size_t DIM, class GRAPH, class LABELS, class AFFINITIES, class WEIGHT,
+             class MEAN, class MAX, class SIZES>
+    void accumulateAffinitiesMeanAndLength(
+            const GRAPH & graph,
+            const LABELS & labels,
+            const AFFINITIES & affinities,
+            const std::vector<array::StaticArray<int64_t, DIM>> & offsets,
+            WEIGHT && weight,
+            const bool hasIgnoreLabel,
+            const uint64_t ignoreLabel,
+            MEAN & meanAffinities,
+            MAX & maxAffinities,
+            SIZES & sizes,
+            const int numberOfThreads = -1
+    ){
+        typedef array::StaticArray<int64_t, DIM + 1> AffinityCoord;
+        typedef detail_accumulate_affinities::CachedEdgeFinder<GRAPH> EdgeFinderType;
+
+        array::StaticArray<int64_t, DIM> shape;
+        for(int d = 0; d < DIM; ++d){
+            shape[d] = labels.shape()[d];
+            NIFTY_CHECK_OP(shape[d], ==, affinities.shape()[d + 1], "affinities have wrong shape");
+        }
+        NIFTY_CHECK_OP(offsets.size(), ==, affinities.shape()[0], "Affinities and offsets do not match");
+
+        nifty::parallel::ParallelOptions pOpts(numberOfThreads);
+        nifty::parallel::ThreadPool threadpool(pOpts);
+        const std::size_t actualNumberOfThreads = pOpts.getActualNumThreads();
+
+        const std::size_t numberOfEdges = graph.edgeIdUpperBound() + 1;
+        std::vector<float> accAff(actualNumberOfThreads * numberOfEdges, 0.f);
+        std::vector<float> maxAff(actualNumberOfThreads * numberOfEdges, 0.f);
+        std::vector<float> counter(actualNumberOfThreads * numberOfEdges, 0.f);
+        std::vector<EdgeFinderType> edgeFinders(actualNumberOfThreads, EdgeFinderType(graph));
+
+        nifty::tools::parallelForEachCoordinate(threadpool, shape,
+            [&](const auto threadId, const auto & coordP){
+                const uint64_t u = labels[coordP];
+                if(hasIgnoreLabel && u == ignoreLabel){
+                    return;
+                }
+                auto & edgeFinder = edgeFinders[threadId];
+                const std::size_t threadOffset = threadId * numberOfEdges;
+                AffinityCoord affCoord;
+                std::copy(coordP.begin(), coordP.end(), affCoord.begin() + 1);
+                for(int io = 0; io < offsets.size(); ++io){
+                    const auto coordQ = offsets[io] + coordP;
+                    if(!coordQ.allInsideShape(shape)){
+                        continue;
+                    }
+                    const uint64_t v = labels[coordQ];
+                    if(u == v || (hasIgnoreLabel && v == ignoreLabel)){
+                        continue;
+                    }
+                    const auto edge = edgeFinder.findEdge(u, v);
+                    if(edge < 0){
+                        continue;
+                    }
+                    affCoord[0] = io;
+                    const float affValue = detail_accumulate_affinities::affinityToFloat(
+                        xtensor::read(affinities, affCoord.asStdArray())
+                    );
+                    const float w = weight(io, coordP);
+                    const std::size_t i = threadOffset + edge;
+                    maxAff[i] = std::max(maxAff[i], affValue);
+                    counter[i] += w;
+                    accAff[i] += affValue * w;
+                }
+            }
+        );
+
+        // reduce the thread results and normalize
+        parallel::parallel_foreach(threadpool, numberOfEdges, [&](const int tid, const int64_t edge){
+            float acc = accAff[edge];
+            float mx = maxAff[edge];
+            float count = counter[edge];
+            for(std::size_t t = 1; t < actualNumberOfThreads; ++t){
+                const std::size_t i = t * numberOfEdges + edge;
+                acc += accAff[i];
+                count += counter[i];
+                mx = std::max(mx, maxAff[i]);
+            }
+            maxAffinities(edge) = mx;
+            if(count > 0.){
+                meanAffinities(edge) = acc / count;
+                sizes(edge) = count;
+            }
+            else{
+                meanAffinities(edge) = 0.;
+                sizes(edge) = 0.;
+            }
+        });
+    }
+
+}
+}
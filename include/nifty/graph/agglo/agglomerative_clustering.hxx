@@ -2,6 +2,7 @@
 
 #include <iostream>
 #include "nifty/graph/subgraph_mask.hxx"
+#include "nifty/graph/agglo/merge_tree.hxx"
 
 namespace nifty{
 namespace graph{
@@ -16,33 +17,31 @@ class AgglomerativeClustering;
 
 
 
+// records the merges in a MergeTree
 template<class AGGLOMERATIVE_CLUSTERING>
 class DendrogramAgglomerativeClusteringVisitor{
-private:
-
-    typedef std::tuple<uint64_t,uint64_t, double, double> MergeEncodingType; 
-
 public:
     typedef AGGLOMERATIVE_CLUSTERING AgglomerativeClusteringType;
     typedef typename AgglomerativeClusteringType::GraphType GraphType;
+    typedef MergeTree<uint64_t, double, double> MergeTreeType;
 
-    typedef typename GraphType:: template NodeMap<double> NodeToEncoding;
+    typedef typename GraphType:: template NodeMap<uint64_t> NodeToEncoding;
     typedef typename GraphType:: template NodeMap<double> NodeSize;
 
 
     DendrogramAgglomerativeClusteringVisitor(
         const AgglomerativeClusteringType & agglomerativeClustering
     )
-    :   nodeSizes_(agglomerativeClustering.graph()),
-        agglomerativeClustering_(agglomerativeClustering),
+    :   agglomerativeClustering_(agglomerativeClustering),
+        nodeSizes_(agglomerativeClustering.graph()),
         nodeToEncoding_(agglomerativeClustering.graph()),
-        encoding_(),
-        timeStamp_(agglomerativeClustering.graph().numberOfNodes())
+        mergeTree_(agglomerativeClustering.graph().nodeIdUpperBound() + 1)
     {
         for( auto node : agglomerativeClustering.graph().nodes()){
             nodeToEncoding_[node] = node;
             nodeSizes_[node] = 1.0;
         }
+        mergeTree_.reserve(agglomerativeClustering.graph().numberOfNodes());
     }
 
     template<class NODE_SIZES>
@@ -50,16 +49,16 @@ public:
         const AgglomerativeClusteringType & agglomerativeClustering,
         NODE_SIZES & nodeSizes
     )
-    :   nodeSizes_(agglomerativeClustering.graph()),
-        agglomerativeClustering_(agglomerativeClustering),
+    :   agglomerativeClustering_(agglomerativeClustering),
+        nodeSizes_(agglomerativeClustering.graph()),
         nodeToEncoding_(agglomerativeClustering.graph()),
-        encoding_(),
-        timeStamp_(agglomerativeClustering.graph().numberOfNodes())
+        mergeTree_(agglomerativeClustering.graph().nodeIdUpperBound() + 1)
     {
         for( auto node : agglomerativeClustering.graph().nodes()){
             nodeToEncoding_[node] = node;
             nodeSizes_[node] = nodeSizes[node];
         }
+        mergeTree_.reserve(agglomerativeClustering.graph().numberOfNodes());
     }
 
 
@@ -68,33 +67,27 @@ public:
     }
 
     void visit(const uint64_t aliveNode, const uint64_t deadNode, const double p){
-        //std::cout<<"a "<<aliveNode<<" d "<<deadNode<<" p "<<p<<"\n";
-
-        auto ea = nodeToEncoding_[aliveNode];
-        auto ed = nodeToEncoding_[deadNode];
+        const auto ea = nodeToEncoding_[aliveNode];
+        const auto ed = nodeToEncoding_[deadNode];
 
         nodeSizes_[aliveNode] += nodeSizes_[deadNode];
 
-        nodeToEncoding_[aliveNode] = timeStamp_;
-        nodeToEncoding_[deadNode] = timeStamp_;
-
-        encoding_.emplace_back(ea, ed, p, nodeSizes_[aliveNode]);
-        ++timeStamp_;
-
+        const auto merged = mergeTree_.addMerge(ea, ed, p, nodeSizes_[aliveNode]);
+        nodeToEncoding_[aliveNode] = merged;
+        nodeToEncoding_[deadNode] = merged;
     }
     const auto & agglomerativeClustering()const{
         return agglomerativeClustering_;
     }
-    const auto & dendrogramEncoding()const{
-        return encoding_;
+    const MergeTreeType & mergeTree()const{
+        return mergeTree_;
     }
 private:
     const AgglomerativeClusteringType & agglomerativeClustering_;
 
     NodeSize nodeSizes_;
     NodeToEncoding nodeToEncoding_;
-    std::vector<MergeEncodingType > encoding_;
-    uint64_t timeStamp_;
+    MergeTreeType mergeTree_;
 };
 
 // template<class AGGLOMERATIVE_CLUSTERING>
@@ -1,5 +1,11 @@
 #pragma once
 
+#include <cmath>
+#include <cstdint>
+
+#include "nifty/parallel/threadpool.hxx"
+#include "nifty/graph/graph_tags.hxx"
+
 namespace nifty{
 namespace graph{
 namespace agglo{
@@ -13,6 +19,8 @@ struct EdgeWeightedClusterPolicySettings{
     double sizeRegularizer{0.5};
     uint64_t numberOfNodesStop{1};
     uint64_t numberOfEdgesStop{0};
+    // threads used to initialize the edge maps and the queue
+    int numberOfThreads{1};
 };
 
 
@@ -21,6 +29,60 @@ inline bool isNegativeInf(const double val){
 }
 
 
+// \cond SUPPRESS_DOXYGEN
+namespace detail_cluster_policies{
+
+    template<class GRAPH, class F>
+    inline void parallelForEachEdge(const GRAPH & graph, parallel::ThreadPool & threadpool,
+                                    F && f, ContiguousTag){
+        parallel::parallel_foreach(threadpool, graph.edgeIdUpperBound() + 1,
+        [&](const int tid, const int64_t edge){
+            f(tid, uint64_t(edge));
+        });
+    }
+
+    template<class GRAPH, class F>
+    inline void parallelForEachEdge(const GRAPH & graph, parallel::ThreadPool & threadpool,
+                                    F && f, SparseTag){
+        graph.forEachEdge([&](const uint64_t edge){
+            f(0, edge);
+        });
+    }
+
+} // end namespace detail_cluster_policies
+// \endcond
+
+
+/// call f(threadId, edge) for every edge of the graph,
+/// in parallel if the edge ids are contiguous
+template<class GRAPH, class F>
+inline void parallelForEachEdge(const GRAPH & graph, parallel::ThreadPool & threadpool, F && f){
+    detail_cluster_policies::parallelForEachEdge(graph, threadpool, f, typename GRAPH::EdgeIdTag());
+}
+
+
+/// push every edge of the graph into an empty queue with the priority computeWeight(edge).
+///
+/// With more than one thread the priorities are computed in parallel
+/// and the heap is built in one go, otherwise the edges are pushed
+/// one after another (which fixes the order of edges with equal priority).
+template<class GRAPH, class QUEUE, class F>
+inline void initializeQueue(const GRAPH & graph, parallel::ThreadPool & threadpool,
+                            QUEUE & pq, F && computeWeight){
+    if(threadpool.nThreads() <= 1){
+        for(const auto edge : graph.edges()){
+            pq.push(edge, computeWeight(edge));
+        }
+        return;
+    }
+    parallelForEachEdge(graph, threadpool, [&](const int tid, const uint64_t edge){
+        pq.setPriority(edge, computeWeight(edge));
+    });
+    const auto edges = graph.edges();
+    pq.buildHeap(edges.begin(), edges.end());
+}
+
+
 
 
 } // namespace agglo
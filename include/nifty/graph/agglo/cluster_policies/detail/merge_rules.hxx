@@ -1,10 +1,16 @@
 #pragma once
 
-#include <string>
-#include <nifty/histogram/histogram.hxx>
+#include <algorithm>
 #include <cmath>
+#include <limits>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <nifty/histogram/histogram_pool.hxx>
 
 #include "nifty/tools/runtime_check.hxx"
+#include "nifty/parallel/threadpool.hxx"
+#include "nifty/graph/agglo/cluster_policies/cluster_policies_common.hxx"
 #include <nifty/nifty.hxx>
 
 namespace nifty{
@@ -42,15 +48,16 @@ namespace merge_rules{
             const GraphType & g,
             const VALUES & values,
             const WEIGHTS & weights,
-            const SettingsType & settings = SettingsType()
+            const SettingsType & settings = SettingsType(),
+            const int numberOfThreads = 1
         ):  values_(g),
             weights_(g)
         {
-            for(auto edge : g.edges()){
-
+            parallel::ThreadPool threadpool(numberOfThreads);
+            parallelForEachEdge(g, threadpool, [&](const int tid, const uint64_t edge){
                 values_[edge] = values[edge];
                 weights_[edge] = weights[edge];
-            }
+            });
         }
 
         void merge(const uint64_t aliveEdge, const uint64_t deadEdge){
@@ -121,15 +128,16 @@ namespace merge_rules{
                 const GraphType & g,
                 const VALUES & values,
                 const WEIGHTS & weights,
-                const SettingsType & settings = SettingsType()
+                const SettingsType & settings = SettingsType(),
+                const int numberOfThreads = 1
         ):  values_(g),
             weights_(g)
         {
-            for(auto edge : g.edges()){
-
+            parallel::ThreadPool threadpool(numberOfThreads);
+            parallelForEachEdge(g, threadpool, [&](const int tid, const uint64_t edge){
                 values_[edge] = values[edge]*weights[edge];
                 weights_[edge] = weights[edge];
-            }
+            });
         }
 
         void merge(const uint64_t aliveEdge, const uint64_t deadEdge){
@@ -202,16 +210,17 @@ namespace merge_rules{
             const GraphType & g,
             const VALUES & values,
             const WEIGHTS & weights,
-            const SettingsType & settings = SettingsType()
+            const SettingsType & settings = SettingsType(),
+            const int numberOfThreads = 1
         ):  values_(g),
             weights_(g),
             settings_(settings)
         {
-            for(auto edge : g.edges()){
-
+            parallel::ThreadPool threadpool(numberOfThreads);
+            parallelForEachEdge(g, threadpool, [&](const int tid, const uint64_t edge){
                 values_[edge] = values[edge];
                 weights_[edge] = weights[edge];
-            }
+            });
         }
 
         void merge(const uint64_t aliveEdge, const uint64_t deadEdge){
@@ -303,16 +312,17 @@ namespace merge_rules{
             const GraphType & g,
             const VALUES & values,
             const WEIGHTS & weights,
-            const SettingsType & settings = SettingsType()
+            const SettingsType & settings = SettingsType(),
+            const int numberOfThreads = 1
         ):  values_(g),
             weights_(g),
             settings_(settings)
         {
-            for(auto edge : g.edges()){
-
+            parallel::ThreadPool threadpool(numberOfThreads);
+            parallelForEachEdge(g, threadpool, [&](const int tid, const uint64_t edge){
                 values_[edge] = values[edge];
                 weights_[edge] = weights[edge];
-            }
+            });
         }
 
         void merge(const uint64_t aliveEdge, const uint64_t deadEdge){
@@ -385,7 +395,11 @@ namespace merge_rules{
         }
     };
 
-    template<class G, class T>
+    /// Rank order (quantile) of the merged values.
+    ///
+    /// The histograms of all edges share min, max and number of bins and live
+    /// in one contiguous HistogramPool, a merge is a row wise add of the counts.
+    template<class G, class T, class BINCOUNT = float>
     class  RankOrderEdgeMap{
     public:
         static auto staticName(){
@@ -397,8 +411,7 @@ namespace merge_rules{
             return ss.str();
         }
         typedef G GraphType;
-        typedef nifty::histogram::Histogram<double, double>          HistogramType;
-        typedef typename GraphType:: template EdgeMap<HistogramType> HistogramEdgeMapType;
+        typedef nifty::histogram::HistogramPool<double, BINCOUNT>   HistogramPoolType;
         typedef typename GraphType:: template EdgeMap<T>             SizeEdgeMapType;
 
         typedef RankOrderSettings SettingsType;
@@ -408,59 +421,57 @@ namespace merge_rules{
             const GraphType & g,
             const VALUES & values,
             const WEIGHTS & weights,
-            const SettingsType & settings = SettingsType()
-        ):  histogram_(g),
+            const SettingsType & settings = SettingsType(),
+            const int numberOfThreads = 1
+        ):  histograms_(),
             settings_(settings)
         {
-            T minVal =        std::numeric_limits<T>::infinity();
-            T maxVal = -1.0 * std::numeric_limits<T>::infinity();
-
-            for(auto edge : g.edges()){
+            parallel::ThreadPool threadpool(numberOfThreads);
+            const std::size_t nThreads = std::max(std::size_t(1), threadpool.nThreads());
+            std::vector<T> threadMinVals(nThreads,        std::numeric_limits<T>::infinity());
+            std::vector<T> threadMaxVals(nThreads, -1.0 * std::numeric_limits<T>::infinity());
 
+            parallelForEachEdge(g, threadpool, [&](const int tid, const uint64_t edge){
                 const auto val = T(values[edge]);
-                maxVal = std::max(maxVal, val);
-                minVal = std::min(minVal, val);
-            }
+                threadMaxVals[tid] = std::max(threadMaxVals[tid], val);
+                threadMinVals[tid] = std::min(threadMinVals[tid], val);
+            });
+            const T minVal = *std::min_element(threadMinVals.begin(), threadMinVals.end());
+            const T maxVal = *std::max_element(threadMaxVals.begin(), threadMaxVals.end());
 
-            for(auto edge : g.edges()){
-                auto & hist = histogram_[edge];
-                hist.assign(minVal, maxVal, settings_.numberOfBins);
-                hist.insert(values[edge], weights[edge]);
-            }
+            histograms_.assign(g.edgeIdUpperBound() + 1, minVal, maxVal, settings_.numberOfBins);
+            parallelForEachEdge(g, threadpool, [&](const int tid, const uint64_t edge){
+                histograms_.insert(edge, values[edge], weights[edge]);
+            });
         }
 
         void merge(const uint64_t aliveEdge, const uint64_t deadEdge){
-            histogram_[aliveEdge].merge(histogram_[deadEdge]);
+            histograms_.merge(aliveEdge, deadEdge);
         }
 
         void setValueFrom(const uint64_t targetEdge, const uint64_t sourceEdge){
-            auto & thist= histogram_[targetEdge];
-            const auto &  shist = histogram_[sourceEdge];
-
-            const auto tsum = thist.sum();
-            thist = shist;
-            thist.normalize(tsum);
-
+            const auto tsum = histograms_.sum(targetEdge);
+            histograms_.copy(targetEdge, sourceEdge);
+            histograms_.normalize(targetEdge, tsum);
         }
         void setFrom(const uint64_t targetEdge, const uint64_t sourceEdge){
-            histogram_[targetEdge] = histogram_[sourceEdge];
+            histograms_.copy(targetEdge, sourceEdge);
         }
         void set(const uint64_t targetEdge, const T & value, const T &  weight){
-            auto & hist =  histogram_[targetEdge];
-            hist.clearCounts();
-            hist.insert(value, weight);
+            histograms_.clearCounts(targetEdge);
+            histograms_.insert(targetEdge, value, weight);
         }
 
         T weight(const uint64_t edge)const{
             NIFTY_CHECK(false,"Not implemented");
-            return histogram_[edge].rank(settings_.q);
+            return histograms_.rank(edge, settings_.q);
         }
 
         T operator[](const uint64_t edge)const{
-            return histogram_[edge].rank(settings_.q);
+            return histograms_.rank(edge, settings_.q);
         }
     private:
-        HistogramEdgeMapType histogram_;
+        HistogramPoolType histograms_;
         SettingsType settings_;
     };
 
@@ -491,12 +502,14 @@ namespace merge_rules{
             const GraphType & g,
             const VALUES & values,
             const WEIGHTS & weights,
-            const SettingsType & settings = SettingsType()
+            const SettingsType & settings = SettingsType(),
+            const int numberOfThreads = 1
         ):  values_(g)
         {
-            for(auto edge : g.edges()){
+            parallel::ThreadPool threadpool(numberOfThreads);
+            parallelForEachEdge(g, threadpool, [&](const int tid, const uint64_t edge){
                 values_[edge] = values[edge];
-            }
+            });
         }
 
         void merge(const uint64_t aliveEdge, const uint64_t deadEdge){
@@ -551,14 +564,16 @@ namespace merge_rules{
                 const GraphType & g,
                 const VALUES & values,
                 const WEIGHTS & weights,
-                const SettingsType & settings = SettingsType()
+                const SettingsType & settings = SettingsType(),
+                const int numberOfThreads = 1
         ):  values_(g),
             weights_(g)
         {
-            for(auto edge : g.edges()){
+            parallel::ThreadPool threadpool(numberOfThreads);
+            parallelForEachEdge(g, threadpool, [&](const int tid, const uint64_t edge){
                 values_[edge] = values[edge];
                 weights_[edge] = weights[edge];
-            }
+            });
         }
 
         void merge(const uint64_t aliveEdge, const uint64_t deadEdge){
@@ -629,12 +644,14 @@ namespace merge_rules{
             const GraphType & g,
             const VALUES & values,
             const WEIGHTS & weights,
-            const SettingsType & settings = SettingsType()
+            const SettingsType & settings = SettingsType(),
+            const int numberOfThreads = 1
         ):  values_(g)
         {
-            for(auto edge : g.edges()){
+            parallel::ThreadPool threadpool(numberOfThreads);
+            parallelForEachEdge(g, threadpool, [&](const int tid, const uint64_t edge){
                 values_[edge] = values[edge];
-            }
+            });
         }
 
         void merge(const uint64_t aliveEdge, const uint64_t deadEdge){
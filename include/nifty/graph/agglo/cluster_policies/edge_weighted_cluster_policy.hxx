@@ -67,7 +67,7 @@ public:
     EdgeContractionGraphType & edgeContractionGraph();
 
 private:
-    void initializeWeights() ;
+    void initializeWeights(parallel::ThreadPool & threadpool);
     double computeWeight(const uint64_t edge) const;
 
 public:
@@ -121,14 +121,15 @@ EdgeWeightedClusterPolicy(
     settings_(settings),
     edgeContractionGraph_(graph, *this)
 {
-    graph_.forEachEdge([&](const uint64_t edge){
+    parallel::ThreadPool threadpool(settings_.numberOfThreads);
+    parallelForEachEdge(graph_, threadpool, [&](const int tid, const uint64_t edge){
         edgeIndicators_[edge] = edgeIndicators[edge];
         edgeSizes_[edge] = edgeSizes[edge];
     });
     graph_.forEachNode([&](const uint64_t node){
         nodeSizes_[node] = nodeSizes[node];
     });
-    this->initializeWeights();
+    this->initializeWeights(threadpool);
 }
 
 template<class GRAPH, bool ENABLE_UCM>
@@ -153,9 +154,12 @@ isDone() const {
 template<class GRAPH, bool ENABLE_UCM>
 inline void 
 EdgeWeightedClusterPolicy<GRAPH, ENABLE_UCM>::
-initializeWeights() {
-    for(const auto edge : graph_.edges())
-        pq_.push(edge, this->computeWeight(edge));
+initializeWeights(
+    parallel::ThreadPool & threadpool
+) {
+    initializeQueue(graph_, threadpool, pq_, [&](const uint64_t edge){
+        return this->computeWeight(edge);
+    });
 }
 
 template<class GRAPH, bool ENABLE_UCM>
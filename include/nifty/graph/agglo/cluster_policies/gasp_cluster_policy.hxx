@@ -3,13 +3,13 @@
 #include <functional>
 #include <set>
 #include <unordered_set>
-#include <boost/container/flat_set.hpp>
 #include <string>
 #include <cmath>        // std::abs
 
 #include "nifty/tools/changable_priority_queue.hxx"
 #include "nifty/graph/edge_contraction_graph.hxx"
 #include "nifty/graph/agglo/cluster_policies/cluster_policies_common.hxx"
+#include "nifty/graph/agglo/cluster_policies/non_link_constraints.hxx"
 #include <iostream>
 #include <algorithm>    // std::max
 #include <xtensor/xview.hpp>
@@ -37,10 +37,6 @@ namespace nifty{
                 typedef typename GRAPH:: template EdgeMap<float> FloatEdgeMap;
                 typedef typename GRAPH:: template NodeMap<float> FloatNodeMap;
 
-                // Flat sets for storing cannot-link constraints:
-                typedef boost::container::flat_set<uint64_t> SetType;
-                typedef typename GRAPH:: template NodeMap<SetType > NonLinkConstraints;
-
                 typedef UPDATE_RULE UpdateRuleType;
             public:
                 typedef typename UpdateRuleType::SettingsType UpdateRuleSettingsType;
@@ -57,8 +53,12 @@ namespace nifty{
                     uint64_t numberOfNodesStop{1};
                     double sizeRegularizer{0.};
                     bool addNonLinkConstraints{false};
+                    // Bloom filter pre-check for the cannot-link constraints
+                    bool nonLinkConstraintsBloomFilter{true};
                     bool mergeConstrainedEdgesAtTheEnd{false};
                     bool collectStats{false};
+                    // threads used to initialize the edge maps and the queue
+                    int numberOfThreads{1};
                 };
 
                 enum class EdgeStates : uint8_t {
@@ -106,17 +106,9 @@ namespace nifty{
 
                 bool isEdgeConstrained(const uint64_t edge){
                     const auto uv = edgeContractionGraph_.uv(edge);
-                    const auto u = uv.first;
-                    const auto v = uv.second;
-                    const auto & setU  = nonLinkConstraints_[u];
-                    const auto & setV  = nonLinkConstraints_[v];
-                    // This find operation gets expensive (log(N)), so we look into the smaller set:
-                    // NIFTY_CHECK((setU.find(v)!=setU.end()) == (setV.find(u)!=setV.end()),"");
-                    if (setU.size() < setV.size()) {
-                        return setU.find(v)!=setU.end();
-                    } else {
-                        return setV.find(u)!=setV.end();
-                    }
+                    return nonLinkConstraints_.isConstrained(uv.first, uv.second, [&](const uint64_t node){
+                        return edgeContractionGraph_.findRepresentativeNode(node);
+                    });
                 }
 
 
@@ -140,11 +132,7 @@ namespace nifty{
                     const auto reprEdge = edgeContractionGraph_.findRepresentativeEdge(edge);
                     NIFTY_ASSERT(accumulated_weights_[reprEdge]<=0.);
                     const auto uv = edgeContractionGraph_.uv(reprEdge);
-                    const auto u = uv.first;
-                    const auto v = uv.second;
-                    // This insert operation, first performs a search (logN) and then insert (if not found)accumulated_weights_[reprEdge]
-                    nonLinkConstraints_[uv.first].insert(uv.second);
-                    nonLinkConstraints_[uv.second].insert(uv.first);
+                    nonLinkConstraints_.add(uv.first, uv.second);
                 }
 
                 auto exportFinalNodeDataOriginalGraph(){
@@ -315,8 +303,8 @@ namespace nifty{
                     const SettingsType & settings
             )
                     :   graph_(graph),
-                        nonLinkConstraints_(graph),
-                        accumulated_weights_(graph, signedWeights, edgeSizes, settings.updateRule),
+                        nonLinkConstraints_(graph.nodeIdUpperBound()+1, settings.nonLinkConstraintsBloomFilter),
+                        accumulated_weights_(graph, signedWeights, edgeSizes, settings.updateRule, settings.numberOfThreads),
                         edgeState_(graph),
                         nodeSizes_(graph),
                         pq_(graph.edgeIdUpperBound()+1),
@@ -346,10 +334,13 @@ namespace nifty{
                         max_node_size_ = uint8_t(nodeSizes[node]);
                 });
 
-                graph_.forEachEdge([&](const uint64_t edge){
+                parallel::ThreadPool threadpool(settings_.numberOfThreads);
+                parallelForEachEdge(graph_, threadpool, [&](const int tid, const uint64_t edge){
                     const auto loc = isLocalEdge[edge];
                     edgeState_[edge] = (loc == 1 ? EdgeStates::LOCAL : EdgeStates::LIFTED);
-                    pq_.push(edge, this->computeWeight(edge));
+                });
+                initializeQueue(graph_, threadpool, pq_, [&](const uint64_t edge){
+                    return this->computeWeight(edge);
                 });
             }
 
@@ -522,20 +513,9 @@ namespace nifty{
 
 
                 if (settings_.addNonLinkConstraints) {
-                    auto  & aliveNodeNlc = nonLinkConstraints_[aliveNode];
-                    const auto & deadNodeNlc = nonLinkConstraints_[deadNode];
-                    aliveNodeNlc.insert(deadNodeNlc.begin(), deadNodeNlc.end());
-
-
-                    for(const auto v : deadNodeNlc){
-                        auto & nlc = nonLinkConstraints_[v];
-
-                        // best way to change values in set...
-                        nlc.erase(deadNode);
-                        nlc.insert(aliveNode);
-                    }
-
-                    aliveNodeNlc.erase(deadNode);
+                    nonLinkConstraints_.merge(aliveNode, deadNode, [&](const uint64_t node){
+                        return edgeContractionGraph_.findRepresentativeNode(node);
+                    });
                 }
 
             }
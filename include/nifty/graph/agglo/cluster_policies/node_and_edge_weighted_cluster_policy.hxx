@@ -56,6 +56,8 @@ public:
         double sizeRegularizer{0.5};
         uint64_t numberOfNodesStop{1};
         uint64_t numberOfEdgesStop{0};
+        // threads used to initialize the edge maps and the queue
+        int numberOfThreads{1};
     };
 
     template<
@@ -80,7 +82,7 @@ public:
     EdgeContractionGraphType & edgeContractionGraph();
 
 private:
-    void initializeWeights() ;
+    void initializeWeights(parallel::ThreadPool & threadpool);
     double computeWeight(const uint64_t edge) const;
     double weightFromNodes(const uint64_t u, const uint64_t v) const;
 
@@ -140,7 +142,8 @@ NodeAndEdgeWeightedClusterPolicy(
     edgeContractionGraph_(graph, *this),
     pq_(graph.edgeIdUpperBound()+1)
 {
-    graph_.forEachEdge([&](const uint64_t edge){
+    parallel::ThreadPool threadpool(settings_.numberOfThreads);
+    parallelForEachEdge(graph_, threadpool, [&](const int tid, const uint64_t edge){
         edgeIndicators_[edge] = edgeIndicators[edge];
         edgeSizes_[edge] = edgeSizes[edge];
     });
@@ -154,7 +157,7 @@ NodeAndEdgeWeightedClusterPolicy(
             valProxy[c] = valProxyIn[c];
         }
     });
-    this->initializeWeights();
+    this->initializeWeights(threadpool);
 }
 
 template<class GRAPH, bool ENABLE_UCM>
@@ -179,9 +182,12 @@ isDone() const {
 template<class GRAPH, bool ENABLE_UCM>
 inline void 
 NodeAndEdgeWeightedClusterPolicy<GRAPH, ENABLE_UCM>::
-initializeWeights() {
-    for(const auto edge : graph_.edges())
-        pq_.push(edge, this->computeWeight(edge));
+initializeWeights(
+    parallel::ThreadPool & threadpool
+) {
+    initializeQueue(graph_, threadpool, pq_, [&](const uint64_t edge){
+        return this->computeWeight(edge);
+    });
 }
 
 template<class GRAPH, bool ENABLE_UCM>
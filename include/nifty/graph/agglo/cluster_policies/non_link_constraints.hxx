@@ -0,0 +1,156 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+namespace nifty{
+namespace graph{
+namespace agglo{
+
+
+/// Cannot-link (non-link) constraints between the clusters of an agglomeration.
+///
+/// Every cluster, identified by its union find root, keeps a sorted vector
+/// of the nodes it must not be merged with.
+/// The entries are updated lazily: when two clusters are merged the smaller
+/// vector is appended to the larger one and the partners of the dead cluster
+/// are only marked as dirty.
+/// A dirty vector is brought back to sorted unique roots in one batch
+/// before the next lookup, which replaces the per entry erase / insert of
+/// a flat set by a single pass over the vector.
+///
+/// An optional 64 bit Bloom filter per cluster answers most lookups of
+/// unconstrained pairs without touching the vectors at all.
+///
+/// All member functions that need the current clusters take a functor
+/// findRoot(node) -> root, e.g. the node union find of an edge contraction graph.
+///
+class NonLinkConstraints{
+public:
+
+    NonLinkConstraints(const uint64_t numberOfNodes = 0, const bool useBloomFilter = true)
+    :   constraints_(numberOfNodes),
+        bloom_(numberOfNodes, 0),
+        isDirty_(numberOfNodes, false),
+        useBloomFilter_(useBloomFilter),
+        buffer_()
+    {}
+
+    /// constrain the two clusters with the roots u and v
+    void add(const uint64_t u, const uint64_t v){
+        // the entries are deduplicated in the next cleanup
+        constraints_[u].push_back(v);
+        constraints_[v].push_back(u);
+        isDirty_[u] = true;
+        isDirty_[v] = true;
+        bloom_[u] |= bloomBit(v);
+        bloom_[v] |= bloomBit(u);
+    }
+
+    /// are the clusters with the roots u and v constrained
+    template<class FIND_ROOT>
+    bool isConstrained(const uint64_t u, const uint64_t v, FIND_ROOT && findRoot){
+        if(useBloomFilter_ && ((bloom_[u] & bloomBit(v)) == 0 || (bloom_[v] & bloomBit(u)) == 0)){
+            return false;
+        }
+        // constraints are symmetric, so we look into the smaller set
+        const bool lookInU = constraints_[u].size() < constraints_[v].size();
+        const uint64_t owner = lookInU ? u : v;
+        const uint64_t other = lookInU ? v : u;
+        cleanup(owner, findRoot);
+        const auto & set = constraints_[owner];
+        return std::binary_search(set.begin(), set.end(), other);
+    }
+
+    /// merge the constraints of the cluster deadNode into aliveNode,
+    /// findRoot must already return aliveNode for deadNode
+    template<class FIND_ROOT>
+    void merge(const uint64_t aliveNode, const uint64_t deadNode, FIND_ROOT && findRoot){
+        auto & deadSet = constraints_[deadNode];
+        if(deadSet.empty()){
+            return;
+        }
+
+        // the partners of the dead cluster now hold a stale id
+        const auto aliveBit = bloomBit(aliveNode);
+        for(const auto node : deadSet){
+            const auto root = findRoot(node);
+            isDirty_[root] = true;
+            bloom_[root] |= aliveBit;
+        }
+
+        // small into large: keep the larger vector and append the smaller one
+        auto & aliveSet = constraints_[aliveNode];
+        if(aliveSet.size() < deadSet.size()){
+            aliveSet.swap(deadSet);
+        }
+        aliveSet.insert(aliveSet.end(), deadSet.begin(), deadSet.end());
+        std::vector<uint64_t>().swap(deadSet);
+
+        isDirty_[aliveNode] = true;
+        isDirty_[deadNode] = false;
+        bloom_[aliveNode] |= bloom_[deadNode];
+        bloom_[deadNode] = 0;
+    }
+
+    /// number of (possibly stale and duplicated) entries of a cluster
+    uint64_t numberOfEntries(const uint64_t node)const{
+        return constraints_[node].size();
+    }
+
+private:
+
+    static uint64_t bloomBit(const uint64_t node){
+        // fibonacci hashing onto the 64 bits
+        return uint64_t(1) << ((node * 0x9E3779B97F4A7C15ull) >> 58);
+    }
+
+    // bring the entries of a cluster back to sorted unique roots
+    template<class FIND_ROOT>
+    void cleanup(const uint64_t owner, FIND_ROOT && findRoot){
+        if(!isDirty_[owner]){
+            return;
+        }
+        auto & set = constraints_[owner];
+
+        // entries that are still roots keep their sorted order (up to the
+        // unsorted tail of new entries), the relabeled ones are sorted
+        // separately and merged in
+        buffer_.clear();
+        std::size_t nKept = 0;
+        for(std::size_t i = 0; i < set.size(); ++i){
+            const auto node = set[i];
+            const auto root = findRoot(node);
+            if(root == owner){
+                continue;
+            }
+            if(root == node && (nKept == 0 || set[nKept - 1] < node)){
+                set[nKept++] = node;
+            }
+            else{
+                buffer_.push_back(root);
+            }
+        }
+        set.resize(nKept);
+        std::sort(buffer_.begin(), buffer_.end());
+        buffer_.erase(std::unique(buffer_.begin(), buffer_.end()), buffer_.end());
+        set.insert(set.end(), buffer_.begin(), buffer_.end());
+        std::inplace_merge(set.begin(), set.begin() + nKept, set.end());
+        set.erase(std::unique(set.begin(), set.end()), set.end());
+
+        isDirty_[owner] = false;
+    }
+
+    std::vector<std::vector<uint64_t>> constraints_;
+    std::vector<uint64_t> bloom_;
+    std::vector<char> isDirty_;
+    bool useBloomFilter_;
+    std::vector<uint64_t> buffer_;
+};
+
+
+} // namespace agglo
+} // namespace nifty::graph
+} // namespace nifty
@@ -0,0 +1,313 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <utility>
+#include <vector>
+
+#include "nifty/parallel/threadpool.hxx"
+#include "nifty/tools/runtime_check.hxx"
+#include "nifty/ufd/ufd.hxx"
+
+namespace nifty{
+namespace graph{
+namespace agglo{
+
+
+/// Merge tree (dendrogram) of an agglomerative clustering in a compact
+/// structure of arrays layout.
+///
+/// The leaves are the nodes 0, ..., numberOfLeaves - 1 of the clustered graph,
+/// the i-th merge creates the node numberOfLeaves + i from its two children
+/// (the same convention as a scipy linkage matrix).
+///
+/// \tparam INDEX type of the node ids, uint32_t halves the memory for graphs
+///               with less than 2^31 nodes
+/// \tparam HEIGHT type of the merge heights
+/// \tparam SIZE type of the cluster sizes
+///
+template<class INDEX = uint64_t, class HEIGHT = float, class SIZE = double>
+class MergeTree{
+public:
+    typedef INDEX IndexType;
+    typedef HEIGHT HeightType;
+    typedef SIZE SizeType;
+
+    MergeTree(const uint64_t numberOfLeaves = 0)
+    :   numberOfLeaves_(numberOfLeaves),
+        childrenA_(),
+        childrenB_(),
+        heights_(),
+        sizes_()
+    {
+        NIFTY_CHECK_OP(2 * numberOfLeaves, <=, uint64_t(std::numeric_limits<INDEX>::max()),
+                       "index type is too small for the number of leaves");
+    }
+
+    void reserve(const uint64_t numberOfMerges){
+        childrenA_.reserve(numberOfMerges);
+        childrenB_.reserve(numberOfMerges);
+        heights_.reserve(numberOfMerges);
+        sizes_.reserve(numberOfMerges);
+    }
+
+    /// Add the next merge, the children are leaf or merge node ids.
+    ///
+    /// \return the node id of the merged cluster
+    ///
+    uint64_t addMerge(const uint64_t childA, const uint64_t childB,
+                      const HEIGHT height, const SIZE size){
+        childrenA_.push_back(static_cast<INDEX>(childA));
+        childrenB_.push_back(static_cast<INDEX>(childB));
+        heights_.push_back(height);
+        sizes_.push_back(size);
+        return numberOfLeaves_ + heights_.size() - 1;
+    }
+
+    uint64_t numberOfLeaves()const{
+        return numberOfLeaves_;
+    }
+    uint64_t numberOfMerges()const{
+        return heights_.size();
+    }
+    uint64_t numberOfNodes()const{
+        return numberOfLeaves_ + heights_.size();
+    }
+
+    const std::vector<INDEX> & childrenA()const{
+        return childrenA_;
+    }
+    const std::vector<INDEX> & childrenB()const{
+        return childrenB_;
+    }
+    const std::vector<HEIGHT> & heights()const{
+        return heights_;
+    }
+    const std::vector<SIZE> & sizes()const{
+        return sizes_;
+    }
+
+    /// Monotone merge heights: the height of a merge is raised to the
+    /// heights of the merges that created its children.
+    /// The cuts and ucm values below are defined on these heights,
+    /// for a monotone clustering they equal the merge heights.
+    void ultrametricHeights(std::vector<HEIGHT> & out)const;
+
+    /// Flat clustering at a threshold: all merges with (ultrametric)
+    /// height <= threshold are applied.
+    ///
+    /// \param labels (Output) for each leaf the dense cluster label,
+    ///               clusters are labeled in the order of their smallest leaf
+    ///
+    template<class LABELS>
+    void cut(const HEIGHT threshold, LABELS & labels)const{
+        std::vector<HEIGHT> heights;
+        ultrametricHeights(heights);
+        std::vector<INDEX> parents;
+        this->parents(parents);
+        std::vector<INDEX> clusterRoots, denseLabels;
+        cutImpl(threshold, heights, parents, clusterRoots, denseLabels, labels);
+    }
+
+    /// Flat clusterings for many thresholds, computed in parallel.
+    ///
+    /// \param labels (Output) 2d array of shape (thresholds, numberOfLeaves)
+    ///
+    template<class THRESHOLDS, class LABELS>
+    void cuts(const THRESHOLDS & thresholds, LABELS & labels,
+              const int numberOfThreads = -1)const;
+
+    /// Ultrametric contour map on the edges of a graph whose nodes are the
+    /// leaves: the height of the merge that first connected the two end nodes.
+    /// Edges whose end nodes never get merged are set to infinity.
+    template<class GRAPH, class EDGE_MAP>
+    void edgeUcm(const GRAPH & graph, EDGE_MAP & edgeMap)const;
+
+private:
+
+    // parent of every node, the root(s) point to numberOfNodes
+    void parents(std::vector<INDEX> & parents)const{
+        parents.assign(numberOfNodes(), static_cast<INDEX>(numberOfNodes()));
+        for(uint64_t i = 0; i < numberOfMerges(); ++i){
+            parents[childrenA_[i]] = static_cast<INDEX>(numberOfLeaves_ + i);
+            parents[childrenB_[i]] = static_cast<INDEX>(numberOfLeaves_ + i);
+        }
+    }
+
+    template<class LABELS>
+    void cutImpl(const HEIGHT threshold,
+                 const std::vector<HEIGHT> & heights,
+                 const std::vector<INDEX> & parents,
+                 std::vector<INDEX> & clusterRoots,
+                 std::vector<INDEX> & denseLabels,
+                 LABELS & labels)const;
+
+    uint64_t numberOfLeaves_;
+    std::vector<INDEX> childrenA_;
+    std::vector<INDEX> childrenB_;
+    std::vector<HEIGHT> heights_;
+    std::vector<SIZE> sizes_;
+};
+
+
+template<class INDEX, class HEIGHT, class SIZE>
+inline void
+MergeTree<INDEX, HEIGHT, SIZE>::ultrametricHeights(
+    std::vector<HEIGHT> & out
+)const{
+    out.resize(numberOfMerges());
+    for(uint64_t i = 0; i < numberOfMerges(); ++i){
+        HEIGHT height = heights_[i];
+        for(const uint64_t child : {uint64_t(childrenA_[i]), uint64_t(childrenB_[i])}){
+            if(child >= numberOfLeaves_){
+                height = std::max(height, out[child - numberOfLeaves_]);
+            }
+        }
+        out[i] = height;
+    }
+}
+
+
+template<class INDEX, class HEIGHT, class SIZE>
+template<class LABELS>
+inline void
+MergeTree<INDEX, HEIGHT, SIZE>::cutImpl(
+    const HEIGHT threshold,
+    const std::vector<HEIGHT> & heights,
+    const std::vector<INDEX> & parents,
+    std::vector<INDEX> & clusterRoots,
+    std::vector<INDEX> & denseLabels,
+    LABELS & labels
+)const{
+    const uint64_t nNodes = numberOfNodes();
+    const INDEX noLabel = static_cast<INDEX>(nNodes);
+
+    // top down: a node belongs to the cluster of its parent if the parent
+    // merge is applied, parents always have larger ids than their children
+    clusterRoots.resize(nNodes);
+    for(uint64_t node = nNodes; node-- > 0;){
+        const uint64_t parent = parents[node];
+        const bool parentApplied = parent < nNodes && heights[parent - numberOfLeaves_] <= threshold;
+        clusterRoots[node] = parentApplied ? clusterRoots[parent] : static_cast<INDEX>(node);
+    }
+
+    denseLabels.assign(nNodes, noLabel);
+    INDEX nextLabel = 0;
+    for(uint64_t leaf = 0; leaf < numberOfLeaves_; ++leaf){
+        auto & label = denseLabels[clusterRoots[leaf]];
+        if(label == noLabel){
+            label = nextLabel++;
+        }
+        labels[leaf] = label;
+    }
+}
+
+
+template<class INDEX, class HEIGHT, class SIZE>
+template<class THRESHOLDS, class LABELS>
+inline void
+MergeTree<INDEX, HEIGHT, SIZE>::cuts(
+    const THRESHOLDS & thresholds,
+    LABELS & labels,
+    const int numberOfThreads
+)const{
+    std::vector<HEIGHT> heights;
+    ultrametricHeights(heights);
+    std::vector<INDEX> parents;
+    this->parents(parents);
+
+    parallel::ThreadPool threadpool(numberOfThreads);
+    const std::size_t nThreads = std::max(std::size_t(1), threadpool.nThreads());
+    std::vector<std::vector<INDEX>> perThreadRoots(nThreads), perThreadDenseLabels(nThreads);
+    std::vector<std::vector<INDEX>> perThreadLabels(nThreads, std::vector<INDEX>(numberOfLeaves_));
+
+    parallel::parallel_foreach(threadpool, thresholds.size(), [&](const int tid, const int64_t t){
+        auto & cutLabels = perThreadLabels[tid];
+        cutImpl(static_cast<HEIGHT>(thresholds[t]), heights, parents,
+                perThreadRoots[tid], perThreadDenseLabels[tid], cutLabels);
+        for(uint64_t leaf = 0; leaf < numberOfLeaves_; ++leaf){
+            labels(t, leaf) = cutLabels[leaf];
+        }
+    });
+}
+
+
+template<class INDEX, class HEIGHT, class SIZE>
+template<class GRAPH, class EDGE_MAP>
+inline void
+MergeTree<INDEX, HEIGHT, SIZE>::edgeUcm(
+    const GRAPH & graph,
+    EDGE_MAP & edgeMap
+)const{
+    NIFTY_CHECK_OP(uint64_t(graph.nodeIdUpperBound() + 1), <=, numberOfLeaves_,
+                   "the graph has more nodes than the merge tree has leaves");
+    std::vector<HEIGHT> heights;
+    ultrametricHeights(heights);
+
+    // replay the merges with a union find over the leaves,
+    // every cluster keeps the edges that leave it; when two clusters are merged
+    // the edges of the smaller one are checked, so every edge is visited
+    // O(log(numberOfEdges)) times
+    const uint64_t edgeBound = graph.edgeIdUpperBound() + 1;
+    std::vector<char> isSet(edgeBound, false);
+    std::vector<std::vector<uint64_t>> clusterEdges(numberOfLeaves_);
+    graph.forEachEdge([&](const uint64_t edge){
+        const auto uv = graph.uv(edge);
+        edgeMap[edge] = std::numeric_limits<HEIGHT>::infinity();
+        if(uv.first != uv.second){
+            clusterEdges[uv.first].push_back(edge);
+            clusterEdges[uv.second].push_back(edge);
+        }
+    });
+
+    // an arbitrary leaf of every node
+    std::vector<INDEX> representativeLeaf(numberOfMerges());
+    auto leafOf = [&](const uint64_t node) -> uint64_t {
+        return node < numberOfLeaves_ ? node : representativeLeaf[node - numberOfLeaves_];
+    };
+
+    ufd::Ufd<uint64_t> ufd(numberOfLeaves_);
+    for(uint64_t i = 0; i < numberOfMerges(); ++i){
+        const uint64_t leafA = leafOf(childrenA_[i]);
+        representativeLeaf[i] = static_cast<INDEX>(leafA);
+        uint64_t rootA = ufd.find(leafA);
+        uint64_t rootB = ufd.find(leafOf(childrenB_[i]));
+        if(rootA == rootB){
+            continue;
+        }
+        if(clusterEdges[rootA].size() < clusterEdges[rootB].size()){
+            std::swap(rootA, rootB);
+        }
+
+        auto & largeEdges = clusterEdges[rootA];
+        auto & smallEdges = clusterEdges[rootB];
+        for(const auto edge : smallEdges){
+            if(isSet[edge]){
+                continue;
+            }
+            const auto uv = graph.uv(edge);
+            const auto ru = ufd.find(uv.first);
+            const auto rv = ufd.find(uv.second);
+            if((ru == rootA && rv == rootB) || (ru == rootB && rv == rootA)){
+                edgeMap[edge] = heights[i];
+                isSet[edge] = true;
+            }
+            else{
+                largeEdges.push_back(edge);
+            }
+        }
+        std::vector<uint64_t>().swap(smallEdges);
+
+        ufd.merge(rootA, rootB);
+        const auto newRoot = ufd.find(rootA);
+        if(newRoot != rootA){
+            clusterEdges[newRoot].swap(largeEdges);
+        }
+    }
+}
+
+
+} // namespace agglo
+} // namespace nifty::graph
+} // namespace nifty
@@ -1,11 +1,15 @@
 #pragma once
 
 
+#include <algorithm>
 #include <unordered_map>
+#include <vector>
 
 #include "nifty/graph/subgraph_mask.hxx"
 #include "nifty/graph/breadth_first_search.hxx"
 #include "nifty/ufd/ufd.hxx"
+#include "nifty/ufd/concurrent_ufd.hxx"
+#include "nifty/parallel/threadpool.hxx"
 
 
 namespace nifty{
@@ -79,6 +83,29 @@ public:
         return ufd_.numberOfSets() - offset_;
     }
 
+    // parallel versions of the build functions above,
+    // the edges are merged concurrently with a ConcurrentUfd
+    template<class NODE_LABELS>
+    uint64_t buildFromLabels(const NODE_LABELS & nodeLabels, const int numberOfThreads){
+        return parallelBuild(numberOfThreads, [&](const uint64_t edge){
+            return nodeLabels[graph_.u(edge)] == nodeLabels[graph_.v(edge)];
+        });
+    }
+
+    template<class EDGE_LABELS>
+    uint64_t buildFromEdgeLabels(const EDGE_LABELS & edgeLabels, const int numberOfThreads){
+        return parallelBuild(numberOfThreads, [&](const uint64_t edge){
+            return edgeLabels[edge] == 0;
+        });
+    }
+
+    template<class SUBGRAPH_MASK>
+    uint64_t build(const SUBGRAPH_MASK & mask, const int numberOfThreads){
+        return parallelBuild(numberOfThreads, [&](const uint64_t edge){
+            return mask.useEdge(edge) && mask.useNode(graph_.u(edge)) && mask.useNode(graph_.v(edge));
+        });
+    }
+
     void reset(){
         ufd_.reset();
     }
@@ -144,6 +171,48 @@ public:
     
     }
 
+    // parallel version of denseRelabeling, produces the same labels
+    template<class NODE_MAP>
+    void parallelDenseRelabeling(
+        NODE_MAP & nodeMap,
+        const int numberOfThreads
+    )const{
+        parallel::ThreadPool threadpool(numberOfThreads);
+        const uint64_t size = ufd_.numberOfElements();
+        const std::size_t nChunks = std::max(std::size_t(1),
+                                             std::min(std::size_t(size), std::size_t(threadpool.nThreads())));
+        auto chunkBegin = [&](const std::size_t c){ return (size * c) / nChunks; };
+
+        // the representatives are labeled in the order of their index
+        std::vector<uint64_t> chunkOffsets(nChunks + 1, 0);
+        parallel::parallel_foreach(threadpool, nChunks, [&](const int tid, const int64_t c){
+            uint64_t count = 0;
+            for(uint64_t j = chunkBegin(c); j < chunkBegin(c + 1); ++j){
+                count += ufd_.find(j) == j;
+            }
+            chunkOffsets[c + 1] = count;
+        });
+        for(std::size_t c = 0; c < nChunks; ++c){
+            chunkOffsets[c + 1] += chunkOffsets[c];
+        }
+
+        std::vector<uint64_t> representativeLabels(size);
+        parallel::parallel_foreach(threadpool, nChunks, [&](const int tid, const int64_t c){
+            uint64_t label = chunkOffsets[c];
+            for(uint64_t j = chunkBegin(c); j < chunkBegin(c + 1); ++j){
+                if(ufd_.find(j) == j){
+                    representativeLabels[j] = label;
+                    ++label;
+                }
+            }
+        });
+
+        forEachEdgeOrNodeId(threadpool, graph_.nodeIdUpperBound() + 1, graph_.numberOfNodes(),
+                            graph_.nodes(), [&](const uint64_t node){
+            nodeMap[node] = representativeLabels[this->componentLabel(node)] - offset_;
+        });
+    }
+
     const GraphType & graph()const{
         return graph_;
     }
@@ -151,6 +220,51 @@ public:
 
 
 private:
+
+    // call f(id) in parallel for all ids of a range of the graph,
+    // which is a plain index loop if the ids are contiguous
+    template<class ID_RANGE, class F>
+    static void forEachEdgeOrNodeId(
+        parallel::ThreadPool & threadpool,
+        const uint64_t idUpperBoundPlusOne,
+        const uint64_t numberOfIds,
+        const ID_RANGE & ids,
+        F && f
+    ){
+        if(idUpperBoundPlusOne == numberOfIds){
+            parallel::parallel_foreach(threadpool, numberOfIds, [&](const int tid, const int64_t id){
+                f(uint64_t(id));
+            });
+        }
+        else{
+            std::vector<uint64_t> idVector;
+            idVector.reserve(numberOfIds);
+            for(const auto id : ids){
+                idVector.push_back(id);
+            }
+            parallel::parallel_foreach(threadpool, idVector.size(), [&](const int tid, const int64_t i){
+                f(idVector[i]);
+            });
+        }
+    }
+
+    template<class USE_EDGE>
+    uint64_t parallelBuild(const int numberOfThreads, USE_EDGE && useEdge){
+        parallel::ThreadPool threadpool(numberOfThreads);
+        ufd::ConcurrentUfd<uint64_t> concurrentUfd(ufd_.numberOfElements());
+
+        forEachEdgeOrNodeId(threadpool, graph_.edgeIdUpperBound() + 1, graph_.numberOfEdges(),
+                            graph_.edges(), [&](const uint64_t edge){
+            if(useEdge(edge)){
+                concurrentUfd.merge(graph_.u(edge), graph_.v(edge));
+            }
+        });
+
+        ufd_.assignPartition(concurrentUfd);
+        needsReset_ = true;
+        return ufd_.numberOfSets() - offset_;
+    }
+
     const GraphType & graph_;
     nifty::ufd::Ufd< > ufd_;
     uint64_t offset_;
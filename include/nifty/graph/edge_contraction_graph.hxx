@@ -1,7 +1,10 @@
 #pragma once
 
+#include <algorithm>
 #include <functional>
 #include <type_traits>
+#include <utility>
+#include <vector>
 
 #include <nifty/container/boost_flat_set.hxx>
 #include "nifty/graph/undirected_graph_base.hxx"
@@ -19,6 +22,17 @@ namespace graph{
     template<class GRAPH, class CALLBACK, bool WITH_EDGE_UFD = true>
     class EdgeContractionGraph;
 
+    /// How the adjacency of the dead node is moved into the
+    /// adjacency of the alive node when an edge is contracted.
+    enum AdjacencyMergeMode{
+        /// insert the adjacencies of the dead node one by one into the
+        /// sorted adjacency of the alive node, O(deg(dead) * deg(alive))
+        INSERT_MERGE,
+        /// merge both sorted adjacencies in a single linear pass
+        /// in the storage of the alive node, O(deg(dead) + deg(alive))
+        SORT_MERGE
+    };
+
     template<class GRAPH, class OUTER_CALLBACK, class SET>
     class EdgeContractionGraphWithSets;
 
@@ -265,6 +279,13 @@ namespace graph{
             innerCallback_.initSets();
         }
 
+        void setAdjacencyMergeMode(const AdjacencyMergeMode mode){
+            cgraph_.setAdjacencyMergeMode(mode);
+        }
+        AdjacencyMergeMode adjacencyMergeMode()const{
+            return cgraph_.adjacencyMergeMode();
+        }
+
         const GraphType & baseGraph()const{
             return cgraph_.baseGraph();
         }
@@ -418,8 +439,20 @@ namespace graph{
             return nodeUfd_;
         }
 
-    private:
+        void setAdjacencyMergeMode(const AdjacencyMergeMode mode){
+            adjacencyMergeMode_ = mode;
+        }
+        AdjacencyMergeMode adjacencyMergeMode()const{
+            return adjacencyMergeMode_;
+        }
 
+    private:
+        void insertMergeAdjacency(const uint64_t aliveNode, const uint64_t deadNode);
+        void sortMergeAdjacency(const uint64_t aliveNode, const uint64_t deadNode);
+        void mergeDoubleEdge(const uint64_t aliveNode, const uint64_t deadNode, const int64_t adjToDeadNode,
+                             const int64_t edgeInAlive, const int64_t edgeInDead);
+        void relabelAdjacency(const int64_t node, const uint64_t deadNode, const uint64_t aliveNode,
+                              const int64_t edge);
         void relabelEdge(const uint64_t edge,const uint64_t deadNode, const uint64_t aliveNode);
 
         const GraphType & graph_;
@@ -431,6 +464,10 @@ namespace graph{
         NodeUfdType nodeUfd_;
         uint64_t currentNodeNum_;
         uint64_t currentEdgeNum_;
+
+        AdjacencyMergeMode adjacencyMergeMode_;
+        // recycled between contractions by SORT_MERGE
+        std::vector<std::pair<NodeAdjacency, int64_t> > doubleEdges_;
     };
 
 
@@ -447,7 +484,9 @@ namespace graph{
         //edges_(graph_),
         nodeUfd_(graph_.nodeIdUpperBound()+1),
         currentNodeNum_(graph_.numberOfNodes()),
-        currentEdgeNum_(graph_.numberOfEdges())
+        currentEdgeNum_(graph_.numberOfEdges()),
+        adjacencyMergeMode_(SORT_MERGE),
+        doubleEdges_()
     {
         this->reset();
     }
@@ -653,54 +692,38 @@ namespace graph{
 
         // we will "shift/move" the adj. nodes
         // from 'adjDead' into 'adjAlive':
+        if(adjacencyMergeMode_ == SORT_MERGE){
+            this->sortMergeAdjacency(aliveNode, deadNode);
+        }
+        else{
+            this->insertMergeAdjacency(aliveNode, deadNode);
+        }
+
+        callback_.contractEdgeDone(edgeToContract);
+    }
+
+    template<class GRAPH, class CALLBACK, bool WITH_EDGE_UFD>
+    inline void 
+    EdgeContractionGraph<GRAPH, CALLBACK, WITH_EDGE_UFD>::
+    insertMergeAdjacency(
+        const uint64_t aliveNode,
+        const uint64_t deadNode
+    ){
+        auto & adjAlive = nodes_[aliveNode];
+        auto & adjDead = nodes_[deadNode];
+
         for(auto adj : adjDead){
 
             const auto adjToDeadNode = adj.node();
             const auto adjToDeadNodeEdge = adj.edge();
 
-
             // check if adjToDeadNode is also in 
             // aliveNodes adjacency  => double edge
             const auto findResIter = adjAlive.find(NodeAdjacency(adjToDeadNode));
             if(findResIter != adjAlive.end()){ // we found a double edge
-
                 NIFTY_TEST_OP(findResIter->node(),==,adjToDeadNode)
-                const auto edgeInAlive = findResIter->edge();
-                    //NIFTY_ASSERT(pq_.contains(edgeInAlive));
-                        //  const auto wEdgeInAlive = pq_.priority(edgeInAlive);
-                        //  const auto wEdgeInDead = pq_.priority(adjToDeadNodeEdge);
-           
-                // erase the deadNodeEdge 
-                        //  pq_.deleteItem(adjToDeadNodeEdge);
-                        //  pq_.changePriority(edgeInAlive, wEdgeInAlive + wEdgeInDead);
-                
-                if(!WITH_EDGE_UFD){
-                        callback_.mergeEdges(edgeInAlive, adjToDeadNodeEdge);
-                }
-                else{
-                    const auto ret = this->edgeUfdMerge(edgeInAlive, adjToDeadNodeEdge);
-                    const auto aliveEdge = ret.first;
-                    const auto deadEdge = ret.second;
-                    if(aliveEdge == edgeInAlive){
-                        callback_.mergeEdges(edgeInAlive, adjToDeadNodeEdge);
-
-                    }
-                    else{
-                        //auto & uv = this->uv(aliveEdge);
-                        ///uv.first = aliveNode;
-                        //uv.second = adjToDeadNode;
-
-                        nodes_[aliveNode].find(NodeAdjacency(adjToDeadNode))->changeEdgeIndex(aliveEdge);
-                        nodes_[adjToDeadNode].find(NodeAdjacency(aliveNode))->changeEdgeIndex(aliveEdge);
-                        callback_.mergeEdges(aliveEdge, deadEdge);
-                    }
-                }   
-                // relabel adjacency
-                --currentEdgeNum_;
-                auto & s = nodes_[adjToDeadNode];
-                auto findRes = s.find(NodeAdjacency(deadNode));
-                s.erase(NodeAdjacency(deadNode));
-
+                this->mergeDoubleEdge(aliveNode, deadNode, adjToDeadNode,
+                                      findResIter->edge(), adjToDeadNodeEdge);
             }
             else{   // no double edge
                 // shift adjacency from dead to alive
@@ -718,8 +741,133 @@ namespace graph{
                 this->relabelEdge(adjToDeadNodeEdge, deadNode, aliveNode);
             }
         }
+    }
 
-        callback_.contractEdgeDone(edgeToContract);
+    template<class GRAPH, class CALLBACK, bool WITH_EDGE_UFD>
+    inline void 
+    EdgeContractionGraph<GRAPH, CALLBACK, WITH_EDGE_UFD>::
+    sortMergeAdjacency(
+        const uint64_t aliveNode,
+        const uint64_t deadNode
+    ){
+        auto & adjAlive = nodes_[aliveNode];
+        const auto & adjDead = nodes_[deadNode];
+
+        // find the double edges, the lower bounds are monotone
+        doubleEdges_.clear();
+        auto searchBegin = adjAlive.begin();
+        for(const auto adj : adjDead){
+            searchBegin = std::lower_bound(searchBegin, adjAlive.end(), adj);
+            if(searchBegin == adjAlive.end()){
+                break;
+            }
+            if(searchBegin->node() == adj.node()){
+                doubleEdges_.emplace_back(*searchBegin, adj.edge());
+            }
+        }
+
+        // merge the sorted adjacencies backwards in the storage of the alive node:
+        // the entries of the alive node are moved as blocks, every entry behind
+        // the first insert position is moved exactly once,
+        // double edges keep the entry of the alive node
+        auto sequence = container::extractSequence(adjAlive);
+        const std::size_t aliveSize = sequence.size();
+        sequence.resize(aliveSize + adjDead.size() - doubleEdges_.size());
+        NodeAdjacency * const data = sequence.data();
+        NodeAdjacency * aliveEnd = data + aliveSize;
+        NodeAdjacency * writeEnd = data + sequence.size();
+        for(auto deadIter = adjDead.end(); deadIter != adjDead.begin(); ){
+            --deadIter;
+            NodeAdjacency * blockBegin = std::lower_bound(data, aliveEnd, *deadIter);
+            const bool isDouble = blockBegin != aliveEnd && blockBegin->node() == deadIter->node();
+            if(isDouble){
+                ++blockBegin;
+            }
+            writeEnd = std::move_backward(blockBegin, aliveEnd, writeEnd);
+            aliveEnd = blockBegin;
+            if(!isDouble){
+                *(--writeEnd) = *deadIter;
+            }
+        }
+        container::adoptSortedSequence(adjAlive, std::move(sequence));
+
+        // update the neighbours of the dead node,
+        // in the same order as INSERT_MERGE to keep the callback order
+        auto doubleIter = doubleEdges_.begin();
+        for(const auto adj : adjDead){
+            const auto adjToDeadNode = adj.node();
+            if(doubleIter != doubleEdges_.end() && doubleIter->first.node() == adjToDeadNode){
+                this->mergeDoubleEdge(aliveNode, deadNode, adjToDeadNode,
+                                      doubleIter->first.edge(), doubleIter->second);
+                ++doubleIter;
+            }
+            else{
+                this->relabelAdjacency(adjToDeadNode, deadNode, aliveNode, adj.edge());
+                this->relabelEdge(adj.edge(), deadNode, aliveNode);
+            }
+        }
+    }
+
+    template<class GRAPH, class CALLBACK, bool WITH_EDGE_UFD>
+    inline void 
+    EdgeContractionGraph<GRAPH, CALLBACK, WITH_EDGE_UFD>::
+    mergeDoubleEdge(
+        const uint64_t aliveNode,
+        const uint64_t deadNode,
+        const int64_t adjToDeadNode,
+        const int64_t edgeInAlive,
+        const int64_t adjToDeadNodeEdge
+    ){
+        if(!WITH_EDGE_UFD){
+                callback_.mergeEdges(edgeInAlive, adjToDeadNodeEdge);
+        }
+        else{
+            const auto ret = this->edgeUfdMerge(edgeInAlive, adjToDeadNodeEdge);
+            const auto aliveEdge = ret.first;
+            const auto deadEdge = ret.second;
+            if(aliveEdge == edgeInAlive){
+                callback_.mergeEdges(edgeInAlive, adjToDeadNodeEdge);
+
+            }
+            else{
+                nodes_[aliveNode].find(NodeAdjacency(adjToDeadNode))->changeEdgeIndex(aliveEdge);
+                nodes_[adjToDeadNode].find(NodeAdjacency(aliveNode))->changeEdgeIndex(aliveEdge);
+                callback_.mergeEdges(aliveEdge, deadEdge);
+            }
+        }   
+        // relabel adjacency
+        --currentEdgeNum_;
+        nodes_[adjToDeadNode].erase(NodeAdjacency(deadNode));
+    }
+
+    template<class GRAPH, class CALLBACK, bool WITH_EDGE_UFD>
+    inline void 
+    EdgeContractionGraph<GRAPH, CALLBACK, WITH_EDGE_UFD>::
+    relabelAdjacency(
+        const int64_t node,
+        const uint64_t deadNode,
+        const uint64_t aliveNode,
+        const int64_t edge
+    ){
+        // replace the entry of the dead node by one of the alive node:
+        // a single rotation of the entries in between instead of
+        // an erase and an insert that both shift the tail
+        auto & s = nodes_[node];
+        NIFTY_ASSERT(s.find(NodeAdjacency(deadNode)) != s.end());
+        NIFTY_ASSERT(s.find(NodeAdjacency(aliveNode)) == s.end());
+
+        auto sequence = container::extractSequence(s);
+        const auto deadPos = std::lower_bound(sequence.begin(), sequence.end(), NodeAdjacency(deadNode));
+        const auto alivePos = std::lower_bound(sequence.begin(), sequence.end(), NodeAdjacency(aliveNode));
+        if(deadPos < alivePos){
+            std::rotate(deadPos, deadPos + 1, alivePos);
+            *(alivePos - 1) = NodeAdjacency(aliveNode, edge);
+        }
+        else{
+            std::rotate(alivePos, deadPos, deadPos + 1);
+            *alivePos = NodeAdjacency(aliveNode, edge);
+        }
+        container::adoptSortedSequence(s, std::move(sequence));
     }
 
     template<class GRAPH, class CALLBACK, bool WITH_EDGE_UFD>
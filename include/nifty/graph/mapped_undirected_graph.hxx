@@ -0,0 +1,524 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <boost/iterator/counting_iterator.hpp>
+
+#include "nifty/tools/runtime_check.hxx"
+#include "nifty/graph/undirected_graph_base.hxx"
+#include "nifty/graph/detail/adjacency.hxx"
+#include "nifty/graph/graph_tags.hxx"
+
+namespace nifty{
+namespace graph{
+
+
+/// Binary graph file format (version 1)
+///
+/// All numbers are stored little-endian and every section starts
+/// at a multiple of 64 bytes, so the sections can be used in place
+/// after the file has been memory-mapped:
+///
+///  - the header (GraphFileHeader)
+///  - uv:          numberOfEdges pairs of int64 (u, v)
+///  - adjacency:   (optional) numberOfNodes + 1 uint64 row offsets,
+///                 followed by 2 * numberOfEdges pairs of int64 (node, edge),
+///                 sorted by node within each row
+///  - edge maps:   numberOfEdgeMaps arrays of numberOfEdges float64
+struct GraphFileHeader{
+    char     magic[8];
+    uint32_t version;
+    uint32_t flags;
+    uint64_t numberOfNodes;
+    uint64_t numberOfEdges;
+    uint64_t numberOfEdgeMaps;
+    uint64_t uvOffset;
+    uint64_t adjacencyOffset;
+    uint64_t edgeMapsOffset;
+    uint64_t fileSize;
+    uint64_t reserved[7];
+};
+
+// \cond SUPPRESS_DOXYGEN
+namespace detail_graph_file{
+
+    const char magic[8] = {'N', 'I', 'F', 'T', 'Y', 'G', 'R', 'F'};
+    const uint32_t version = 1;
+    const uint32_t hasAdjacencyFlag = 1;
+    const uint64_t alignment = 64;
+
+    static_assert(sizeof(GraphFileHeader) == 128, "unexpected graph file header size");
+
+    inline uint64_t align(const uint64_t offset){
+        return (offset + alignment - 1) / alignment * alignment;
+    }
+
+    inline bool isLittleEndian(){
+        const uint16_t one = 1;
+        uint8_t firstByte;
+        std::memcpy(&firstByte, &one, 1);
+        return firstByte == 1;
+    }
+
+    // the row offsets are followed by the (node, edge) pairs
+    inline uint64_t adjacencyEntriesOffset(const GraphFileHeader & header){
+        return align(header.adjacencyOffset + (header.numberOfNodes + 1) * sizeof(uint64_t));
+    }
+
+    // layout of the sections, everything but the header
+    inline void computeLayout(GraphFileHeader & header){
+        header.uvOffset = align(sizeof(GraphFileHeader));
+        uint64_t end = header.uvOffset + 2 * header.numberOfEdges * sizeof(int64_t);
+        if(header.flags & hasAdjacencyFlag){
+            header.adjacencyOffset = align(end);
+            end = adjacencyEntriesOffset(header) + 4 * header.numberOfEdges * sizeof(int64_t);
+        }
+        else{
+            header.adjacencyOffset = 0;
+        }
+        header.edgeMapsOffset = align(end);
+        end = header.edgeMapsOffset + header.numberOfEdgeMaps * align(header.numberOfEdges * sizeof(double));
+        header.fileSize = end;
+    }
+
+    // buffered sequential writer which keeps track of the position
+    class Writer{
+    public:
+        Writer(const std::string & path)
+        :   out_(path, std::ios::binary | std::ios::trunc),
+            position_(0)
+        {
+            NIFTY_CHECK(out_.good(), "cannot open "+path+" for writing");
+            buffer_.reserve(bufferSize);
+        }
+
+        template<class T>
+        void write(const T value){
+            const char * bytes = reinterpret_cast<const char *>(&value);
+            buffer_.insert(buffer_.end(), bytes, bytes + sizeof(T));
+            position_ += sizeof(T);
+            if(buffer_.size() >= bufferSize){
+                flush();
+            }
+        }
+
+        void padTo(const uint64_t offset){
+            NIFTY_CHECK_OP(position_, <=, offset, "graph file sections overlap");
+            while(position_ < offset){
+                write(uint8_t(0));
+            }
+        }
+
+        void flush(){
+            out_.write(buffer_.data(), buffer_.size());
+            NIFTY_CHECK(out_.good(), "writing the graph file failed");
+            buffer_.clear();
+        }
+
+        uint64_t position() const{
+            return position_;
+        }
+
+    private:
+        static const std::size_t bufferSize = 1 << 22;
+        std::ofstream out_;
+        std::vector<char> buffer_;
+        uint64_t position_;
+    };
+
+} // namespace nifty::graph::detail_graph_file
+// \endcond
+
+
+/// Write a graph with contiguous ids and optional edge maps to a binary graph file.
+///
+/// \param path     path of the file, an existing file is overwritten
+/// \param graph    graph with contiguous node and edge ids
+/// \param edgeMaps edge maps with graph.numberOfEdges() entries, stored as float64
+/// \param withAdjacency store the adjacency (CSR), otherwise readers rebuild it
+template<class GRAPH, class EDGE_MAP = std::vector<double> >
+void writeGraphFile(
+    const std::string & path,
+    const GRAPH & graph,
+    const std::vector<EDGE_MAP> & edgeMaps = std::vector<EDGE_MAP>(),
+    const bool withAdjacency = true
+){
+    static_assert(std::is_same<typename GRAPH::NodeIdTag, ContiguousTag>::value &&
+                  std::is_same<typename GRAPH::EdgeIdTag, ContiguousTag>::value,
+                  "writeGraphFile needs contiguous node and edge ids");
+    NIFTY_CHECK(detail_graph_file::isLittleEndian(), "graph files are only supported on little-endian hosts");
+
+    GraphFileHeader header;
+    std::memset(&header, 0, sizeof(GraphFileHeader));
+    std::memcpy(header.magic, detail_graph_file::magic, sizeof(header.magic));
+    header.version = detail_graph_file::version;
+    header.flags = withAdjacency ? detail_graph_file::hasAdjacencyFlag : 0;
+    header.numberOfNodes = graph.numberOfNodes();
+    header.numberOfEdges = graph.numberOfEdges();
+    header.numberOfEdgeMaps = edgeMaps.size();
+    detail_graph_file::computeLayout(header);
+
+    detail_graph_file::Writer writer(path);
+    const char * headerBytes = reinterpret_cast<const char *>(&header);
+    for(std::size_t i = 0; i < sizeof(GraphFileHeader); ++i){
+        writer.write(headerBytes[i]);
+    }
+
+    writer.padTo(header.uvOffset);
+    for(uint64_t edge = 0; edge < header.numberOfEdges; ++edge){
+        const auto uv = graph.uv(edge);
+        writer.write(int64_t(uv.first));
+        writer.write(int64_t(uv.second));
+    }
+
+    if(withAdjacency){
+        writer.padTo(header.adjacencyOffset);
+        uint64_t offset = 0;
+        writer.write(offset);
+        for(uint64_t node = 0; node < header.numberOfNodes; ++node){
+            offset += std::distance(graph.adjacencyBegin(node), graph.adjacencyEnd(node));
+            writer.write(offset);
+        }
+        NIFTY_CHECK_OP(offset, ==, 2 * header.numberOfEdges, "graph adjacency does not match the edges");
+
+        writer.padTo(detail_graph_file::adjacencyEntriesOffset(header));
+        std::vector<std::pair<int64_t, int64_t> > row;
+        for(uint64_t node = 0; node < header.numberOfNodes; ++node){
+            row.clear();
+            for(auto adj : graph.adjacency(node)){
+                row.emplace_back(adj.node(), adj.edge());
+            }
+            std::sort(row.begin(), row.end());
+            for(const auto & nodeAndEdge : row){
+                writer.write(nodeAndEdge.first);
+                writer.write(nodeAndEdge.second);
+            }
+        }
+    }
+
+    for(std::size_t i = 0; i < edgeMaps.size(); ++i){
+        const auto & edgeMap = edgeMaps[i];
+        NIFTY_CHECK_OP(uint64_t(edgeMap.size()), ==, header.numberOfEdges, "edge map has the wrong size");
+        writer.padTo(header.edgeMapsOffset + i * detail_graph_file::align(header.numberOfEdges * sizeof(double)));
+        for(uint64_t edge = 0; edge < header.numberOfEdges; ++edge){
+            writer.write(static_cast<double>(edgeMap[edge]));
+        }
+    }
+    writer.padTo(header.fileSize);
+    writer.flush();
+}
+
+
+/// Read-only memory mapping of a binary graph file.
+///
+/// The file is mapped shared, so all processes which map
+/// the same file share its pages through the page cache.
+class GraphFile{
+public:
+    GraphFile(const std::string & path)
+    :   data_(nullptr),
+        size_(0)
+    {
+        NIFTY_CHECK(detail_graph_file::isLittleEndian(), "graph files are only supported on little-endian hosts");
+
+        const int fd = ::open(path.c_str(), O_RDONLY);
+        NIFTY_CHECK(fd >= 0, "cannot open graph file "+path);
+        struct stat fileStat;
+        if(::fstat(fd, &fileStat) != 0 || uint64_t(fileStat.st_size) < sizeof(GraphFileHeader)){
+            ::close(fd);
+            throw std::runtime_error(path+" is not a graph file");
+        }
+        size_ = fileStat.st_size;
+        void * data = ::mmap(nullptr, size_, PROT_READ, MAP_SHARED, fd, 0);
+        // the mapping stays valid after the descriptor is closed
+        ::close(fd);
+        NIFTY_CHECK(data != MAP_FAILED, "cannot map graph file "+path);
+        data_ = static_cast<const char *>(data);
+
+        try{
+            checkHeader(path);
+        }
+        catch(...){
+            ::munmap(const_cast<char *>(data_), size_);
+            throw;
+        }
+    }
+
+    ~GraphFile(){
+        ::munmap(const_cast<char *>(data_), size_);
+    }
+
+    GraphFile(const GraphFile &) = delete;
+    GraphFile & operator=(const GraphFile &) = delete;
+
+    const GraphFileHeader & header() const{
+        return *reinterpret_cast<const GraphFileHeader *>(data_);
+    }
+
+    uint64_t numberOfNodes() const{
+        return header().numberOfNodes;
+    }
+    uint64_t numberOfEdges() const{
+        return header().numberOfEdges;
+    }
+    uint64_t numberOfEdgeMaps() const{
+        return header().numberOfEdgeMaps;
+    }
+    bool hasAdjacency() const{
+        return header().flags & detail_graph_file::hasAdjacencyFlag;
+    }
+
+    /// u and v of edge e are at 2*e and 2*e+1
+    const int64_t * uvIds() const{
+        return reinterpret_cast<const int64_t *>(data_ + header().uvOffset);
+    }
+
+    /// numberOfNodes + 1 row offsets into adjacency()
+    const uint64_t * adjacencyOffsets() const{
+        NIFTY_CHECK(hasAdjacency(), "graph file has no adjacency");
+        return reinterpret_cast<const uint64_t *>(data_ + header().adjacencyOffset);
+    }
+
+    /// (node, edge) pairs, sorted by node within each row
+    const int64_t * adjacency() const{
+        NIFTY_CHECK(hasAdjacency(), "graph file has no adjacency");
+        return reinterpret_cast<const int64_t *>(data_ + detail_graph_file::adjacencyEntriesOffset(header()));
+    }
+
+    const double * edgeMap(const uint64_t i) const{
+        NIFTY_CHECK_OP(i, <, numberOfEdgeMaps(), "edge map index out of range");
+        const auto & h = header();
+        return reinterpret_cast<const double *>(
+            data_ + h.edgeMapsOffset + i * detail_graph_file::align(h.numberOfEdges * sizeof(double)));
+    }
+
+private:
+    void checkHeader(const std::string & path) const{
+        const auto & h = header();
+        NIFTY_CHECK(std::memcmp(h.magic, detail_graph_file::magic, sizeof(h.magic)) == 0,
+                    path+" is not a graph file");
+        NIFTY_CHECK_OP(h.version, ==, detail_graph_file::version, "unsupported graph file version");
+
+        // bound the counts by the file size first, so computing the layout can not overflow
+        const uint64_t maxFileSize = uint64_t(1) << 60;
+        NIFTY_CHECK_OP(size_, <, maxFileSize, "graph file is too large");
+        NIFTY_CHECK(h.numberOfNodes <= size_ / sizeof(uint64_t) &&
+                    h.numberOfEdges <= size_ / (2 * sizeof(int64_t)), path+" has an invalid header");
+        const uint64_t edgeMapSize = detail_graph_file::align(h.numberOfEdges * sizeof(double));
+        NIFTY_CHECK(edgeMapSize == 0 || h.numberOfEdgeMaps <= size_ / edgeMapSize, path+" has an invalid header");
+
+        // the reader recomputes the layout, so corrupt section offsets can not point
+        // outside of the mapping, the node and edge ids in the sections are not checked
+        GraphFileHeader expected = h;
+        detail_graph_file::computeLayout(expected);
+        NIFTY_CHECK(expected.uvOffset == h.uvOffset &&
+                    expected.adjacencyOffset == h.adjacencyOffset &&
+                    expected.edgeMapsOffset == h.edgeMapsOffset &&
+                    expected.fileSize == h.fileSize, path+" has an invalid layout");
+        NIFTY_CHECK_OP(h.fileSize, <=, size_, "graph file is truncated");
+    }
+
+    const char * data_;
+    uint64_t size_;
+};
+
+
+/// Read-only undirected graph on top of a memory-mapped graph file.
+///
+/// Edges and adjacency are used in place, nothing is copied.
+/// If the file was written without adjacency, the adjacency
+/// is built in memory when the graph is constructed.
+class MappedUndirectedGraph : public
+    UndirectedGraphBase<
+        MappedUndirectedGraph,
+        boost::counting_iterator<int64_t>,
+        boost::counting_iterator<int64_t>,
+        const detail_graph::UndirectedAdjacency<int64_t,int64_t,int64_t,int64_t> *
+    >
+{
+public:
+    typedef detail_graph::UndirectedAdjacency<int64_t,int64_t,int64_t,int64_t> NodeAdjacency;
+    typedef boost::counting_iterator<int64_t> NodeIter;
+    typedef boost::counting_iterator<int64_t> EdgeIter;
+    typedef const NodeAdjacency * AdjacencyIter;
+
+    typedef ContiguousTag EdgeIdTag;
+    typedef ContiguousTag NodeIdTag;
+
+    typedef SortedTag EdgeIdOrderTag;
+    typedef SortedTag NodeIdOrderTag;
+
+    // the (node, edge) pairs of the file are used as adjacency
+    static_assert(sizeof(NodeAdjacency) == 2 * sizeof(int64_t) &&
+                  std::is_standard_layout<NodeAdjacency>::value,
+                  "adjacency does not match the graph file layout");
+
+    MappedUndirectedGraph(const std::string & path)
+    :   MappedUndirectedGraph(std::make_shared<const GraphFile>(path)){
+    }
+
+    // offsets_ and adjacency_ may point into the owned adjacency
+    MappedUndirectedGraph(const MappedUndirectedGraph &) = delete;
+    MappedUndirectedGraph & operator=(const MappedUndirectedGraph &) = delete;
+
+    MappedUndirectedGraph(std::shared_ptr<const GraphFile> file)
+    :   file_(file),
+        uvIds_(file->uvIds())
+    {
+        if(file_->hasAdjacency()){
+            offsets_ = file_->adjacencyOffsets();
+            adjacency_ = reinterpret_cast<const NodeAdjacency *>(file_->adjacency());
+        }
+        else{
+            buildAdjacency();
+        }
+    }
+
+    // MUST IMPL INTERFACE
+    int64_t u(const int64_t e)const{
+        NIFTY_ASSERT_OP(e,<,numberOfEdges());
+        return uvIds_[2*e];
+    }
+    int64_t v(const int64_t e)const{
+        NIFTY_ASSERT_OP(e,<,numberOfEdges());
+        return uvIds_[2*e + 1];
+    }
+
+    int64_t findEdge(const int64_t u, const int64_t v)const{
+        NIFTY_ASSERT_OP(u,<,numberOfNodes());
+        NIFTY_ASSERT_OP(v,<,numberOfNodes());
+        const auto end = adjacencyEnd(u);
+        const auto fres = std::lower_bound(adjacencyBegin(u), end, NodeAdjacency(v));
+        if(fres != end && fres->node() == v)
+            return fres->edge();
+        else
+            return -1;
+    }
+
+    int64_t nodeIdUpperBound() const{
+        return numberOfNodes() == 0 ? 0 : numberOfNodes()-1;
+    }
+    int64_t edgeIdUpperBound() const{
+        return numberOfEdges() == 0 ? 0 : numberOfEdges()-1;
+    }
+    uint64_t numberOfEdges() const{
+        return file_->numberOfEdges();
+    }
+    uint64_t numberOfNodes() const{
+        return file_->numberOfNodes();
+    }
+
+    NodeIter nodesBegin()const{
+        return NodeIter(0);
+    }
+    NodeIter nodesEnd()const{
+        return NodeIter(numberOfNodes());
+    }
+    EdgeIter edgesBegin()const{
+        return EdgeIter(0);
+    }
+    EdgeIter edgesEnd()const{
+        return EdgeIter(numberOfEdges());
+    }
+
+    AdjacencyIter adjacencyBegin(const int64_t node)const{
+        NIFTY_ASSERT_OP(node,<,numberOfNodes());
+        return adjacency_ + offsets_[node];
+    }
+    AdjacencyIter adjacencyEnd(const int64_t node)const{
+        NIFTY_ASSERT_OP(node,<,numberOfNodes());
+        return adjacency_ + offsets_[node + 1];
+    }
+    AdjacencyIter adjacencyOutBegin(const int64_t node)const{
+        return adjacencyBegin(node);
+    }
+
+    std::pair<int64_t,int64_t> uv(const int64_t e)const{
+        return std::pair<int64_t,int64_t>(uvIds_[2*e], uvIds_[2*e + 1]);
+    }
+
+    template<class F>
+    void forEachEdge(F && f)const{
+        for(uint64_t edge=0; edge< numberOfEdges(); ++edge){
+            f(edge);
+        }
+    }
+
+    template<class F>
+    void forEachNode(F && f)const{
+        for(uint64_t node=0; node< numberOfNodes(); ++node){
+            f(node);
+        }
+    }
+
+    const GraphFile & file() const{
+        return *file_;
+    }
+
+    uint64_t numberOfEdgeMaps() const{
+        return file_->numberOfEdgeMaps();
+    }
+
+    /// pointer to the numberOfEdges() values of an edge map in the file
+    const double * edgeMap(const uint64_t i) const{
+        return file_->edgeMap(i);
+    }
+
+private:
+    // counting sort of the edge ends, rows are sorted by node afterwards
+    void buildAdjacency(){
+        const auto nNodes = numberOfNodes();
+        const auto nEdges = numberOfEdges();
+        ownedOffsets_.assign(nNodes + 1, 0);
+        for(uint64_t e = 0; e < nEdges; ++e){
+            NIFTY_CHECK(uint64_t(uvIds_[2*e]) < nNodes && uint64_t(uvIds_[2*e + 1]) < nNodes,
+                        "graph file has an edge with an invalid node id");
+            ++ownedOffsets_[uvIds_[2*e] + 1];
+            ++ownedOffsets_[uvIds_[2*e + 1] + 1];
+        }
+        for(uint64_t node = 0; node < nNodes; ++node){
+            ownedOffsets_[node + 1] += ownedOffsets_[node];
+        }
+
+        ownedAdjacency_.resize(2 * nEdges);
+        std::vector<uint64_t> position(ownedOffsets_.begin(), ownedOffsets_.end() - 1);
+        for(uint64_t e = 0; e < nEdges; ++e){
+            const auto u = uvIds_[2*e];
+            const auto v = uvIds_[2*e + 1];
+            ownedAdjacency_[position[u]++] = NodeAdjacency(v, e);
+            ownedAdjacency_[position[v]++] = NodeAdjacency(u, e);
+        }
+        for(uint64_t node = 0; node < nNodes; ++node){
+            std::sort(ownedAdjacency_.begin() + ownedOffsets_[node],
+                      ownedAdjacency_.begin() + ownedOffsets_[node + 1]);
+        }
+
+        offsets_ = ownedOffsets_.data();
+        adjacency_ = ownedAdjacency_.data();
+    }
+
+    std::shared_ptr<const GraphFile> file_;
+    const int64_t * uvIds_;
+    const uint64_t * offsets_;
+    const NodeAdjacency * adjacency_;
+
+    std::vector<uint64_t> ownedOffsets_;
+    std::vector<NodeAdjacency> ownedAdjacency_;
+};
+
+
+} // namespace nifty::graph
+} // namespace nifty
@@ -0,0 +1,116 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <numeric>
+#include <vector>
+
+#include "nifty/graph/graph_tags.hxx"
+#include "nifty/parallel/threadpool.hxx"
+
+namespace nifty{
+namespace graph{
+namespace opt{
+namespace common{
+
+    // \cond SUPPRESS_DOXYGEN
+    namespace detail_eval_node_labels{
+
+        // number of edges that are summed up by one task
+        const uint64_t blockSize = 1 << 16;
+
+        // sum of the weights of the cut edges in [edgeBegin, edgeEnd)
+        template<class WEIGHT_TYPE, class GRAPH, class WEIGHTS, class NODE_LABELS>
+        WEIGHT_TYPE blockCutWeight(
+            const GRAPH & graph,
+            const WEIGHTS & weights,
+            const NODE_LABELS & nodeLabels,
+            const uint64_t edgeBegin,
+            const uint64_t edgeEnd
+        ){
+            // a select instead of a branch, the labels of random edges are not predictable
+            WEIGHT_TYPE sum = static_cast<WEIGHT_TYPE>(0);
+            for(uint64_t edge = edgeBegin; edge < edgeEnd; ++edge){
+                const auto uv = graph.uv(edge);
+                sum += nodeLabels[uv.first] != nodeLabels[uv.second] ? weights[edge] : static_cast<WEIGHT_TYPE>(0);
+            }
+            return sum;
+        }
+
+        template<class WEIGHT_TYPE, class GRAPH, class WEIGHTS, class NODE_LABELS>
+        WEIGHT_TYPE cutWeight(
+            const GRAPH & graph,
+            const WEIGHTS & weights,
+            const NODE_LABELS & nodeLabels,
+            const int numberOfThreads,
+            ContiguousTag
+        ){
+            const uint64_t numberOfEdges = graph.numberOfEdges();
+            const uint64_t numberOfBlocks = (numberOfEdges + blockSize - 1) / blockSize;
+            auto sumBlock = [&](const uint64_t block){
+                return blockCutWeight<WEIGHT_TYPE>(graph, weights, nodeLabels, block * blockSize,
+                                                   std::min(numberOfEdges, (block + 1) * blockSize));
+            };
+
+            parallel::ParallelOptions pOpts(numberOfThreads);
+            if(pOpts.getActualNumThreads() <= 1 || numberOfBlocks <= 1){
+                WEIGHT_TYPE sum = static_cast<WEIGHT_TYPE>(0);
+                for(uint64_t block = 0; block < numberOfBlocks; ++block){
+                    sum += sumBlock(block);
+                }
+                return sum;
+            }
+
+            // the block sums are added in block order, as in the single threaded case
+            std::vector<WEIGHT_TYPE> blockSums(numberOfBlocks);
+            parallel::ThreadPool threadpool(pOpts);
+            parallel::parallel_foreach(threadpool, numberOfBlocks, [&](const int tid, const int64_t block){
+                blockSums[block] = sumBlock(block);
+            });
+            return std::accumulate(blockSums.begin(), blockSums.end(), static_cast<WEIGHT_TYPE>(0));
+        }
+
+        template<class WEIGHT_TYPE, class GRAPH, class WEIGHTS, class NODE_LABELS>
+        WEIGHT_TYPE cutWeight(
+            const GRAPH & graph,
+            const WEIGHTS & weights,
+            const NODE_LABELS & nodeLabels,
+            const int numberOfThreads,
+            SparseTag
+        ){
+            WEIGHT_TYPE sum = static_cast<WEIGHT_TYPE>(0);
+            for(const auto edge: graph.edges()){
+                const auto uv = graph.uv(edge);
+                if(nodeLabels[uv.first] != nodeLabels[uv.second]){
+                    sum += weights[edge];
+                }
+            }
+            return sum;
+        }
+
+    } // namespace detail_eval_node_labels
+    // \endcond
+
+
+    /// Sum of the weights of the edges whose end nodes have different labels.
+    ///
+    /// For graphs with contiguous edge ids the edges are summed up in blocks
+    /// of consecutive ids, which are distributed over numberOfThreads threads.
+    /// The block sums are added in block order, so the result does not
+    /// depend on the number of threads.
+    /// Graphs with sparse edge ids are evaluated edge by edge.
+    template<class WEIGHT_TYPE, class GRAPH, class WEIGHTS, class NODE_LABELS>
+    WEIGHT_TYPE cutWeight(
+        const GRAPH & graph,
+        const WEIGHTS & weights,
+        const NODE_LABELS & nodeLabels,
+        const int numberOfThreads = 1
+    ){
+        return detail_eval_node_labels::cutWeight<WEIGHT_TYPE>(graph, weights, nodeLabels, numberOfThreads,
+                                                               typename GRAPH::EdgeIdTag());
+    }
+
+} // namespace nifty::graph::opt::common
+} // namespace nifty::graph::opt
+} // namespace nifty::graph
+} // namespace nifty
@@ -7,6 +7,8 @@
 
 #include <iomanip>
 #include <algorithm>
+#include <atomic>
+#include <functional>
 #include <unordered_set>
 #include <vector>
 #include <stack>
@@ -39,7 +41,9 @@ namespace detail_kernighang_lin{
         :   differences(graph),
             isMoved(graph),
             referencedBy(graph),
-            vertexLabels(graph)
+            vertexLabels(graph),
+            stamps(graph, 0),
+            lastStamp(0)
         {
 
         }
@@ -48,6 +52,10 @@ namespace detail_kernighang_lin{
         typename GraphType:: template NodeMap<char>           isMoved;
         typename GraphType:: template NodeMap<std::size_t>    referencedBy;
         typename GraphType:: template NodeMap<uint64_t>       vertexLabels;
+        // isMoved and referencedBy of a node are only valid if
+        // its stamp is the stamp of the current two cut
+        typename GraphType:: template NodeMap<uint64_t>       stamps;
+        std::atomic<uint64_t> lastStamp;
 
         std::size_t maxNotUsedLabel;
     };
@@ -76,7 +84,6 @@ namespace detail_kernighang_lin{
 
             void updateDifference(const uint64_t var, const double diff){
                 if(diff > difference){
-                    //std::cout<<"update diff from  "<<difference<<" to "<<diff<<"\n";
                     v = var;
                     difference = diff;
                 }
@@ -92,73 +99,110 @@ namespace detail_kernighang_lin{
             graph_(objective.graph()),
             liftedGraph_(objective.liftedGraph()),
             weights_(objective.weights()),
-            border_(),
+            borderQueue_(objective.graph().nodeIdUpperBound() + 1),
             moves_(){
         }
 
+        /**
+         * @brief      Improve the two cut between A and B by moving single nodes
+         *
+         * @details    The movable nodes (the nodes at the border of A and B) are kept
+         *             in a max priority queue keyed on the gain of moving them to the
+         *             other set, so the best move is found without scanning the border.
+         *             A move only changes the gains of its lifted neighbours, and only
+         *             the gains of nodes in the border are kept up to date, a node gets
+         *             its gain when it enters the border.
+         *             The border is found from the smaller of both sets, nodes of the
+         *             larger set that are not in the border are not touched.
+         *
+         *             Only A, B and the lifted neighbours of their nodes are read,
+         *             so two cuts of pairs without lifted edges between them
+         *             can run concurrently on the same buffers.
+         *
+         * @return     the decrease of the energy
+         */
         template<class SET>
         double optimizeTwoCut(
             SET & A,
             SET & B,
             TwoCutBuffers<GraphType> & buffer
         ){
-            auto gainFromMerging = 0.0;
-            auto computeDifferences = [&](const SET & varSet, const uint64_t labelAA, const uint64_t labelBB){
-                for(const auto var : varSet){
-
-                    double diffExt = 0.0;
-                    double diffInt = 0.0;
-                    uint64_t refCnt = 0;
-
-                    for(auto adj : liftedGraph_.adjacency(var)){
-
-                        const auto label =  buffer.vertexLabels[adj.node()];
-                        const auto edge = adj.edge();
-
-                        if (label == labelAA){
-                            //std::cout<<"e "<<edge<<" w "<<weights_[edge]<<"\n";
-                            diffInt += weights_[edge];
-                        }
-                        else if (label == labelBB){
-                            //std::cout<<"e "<<edge<<" w "<<weights_[edge]<<"\n";
-                            diffExt += weights_[edge];
-                        }
+            // gain of moving var from the set labeled labelOwn to the set labeled labelOther
+            auto computeDifference = [&](const uint64_t var, const uint64_t labelOwn, const uint64_t labelOther){
+                double diffExt = 0.0;
+                double diffInt = 0.0;
+                for(auto adj : liftedGraph_.adjacency(var)){
+                    const auto label =  buffer.vertexLabels[adj.node()];
+                    const auto edge = adj.edge();
+
+                    if (label == labelOwn){
+                        diffInt += weights_[edge];
                     }
-
-                    for(auto adj : graph_.adjacency(var)){
-                        if (buffer.vertexLabels[adj.node()] == labelBB)
-                            ++refCnt;
+                    else if (label == labelOther){
+                        diffExt += weights_[edge];
                     }
+                }
+                return diffExt - diffInt;
+            };
 
-                    buffer.differences[var] = diffExt - diffInt;
-                    buffer.referencedBy[var] = refCnt;
+            // nodes that are not stamped yet are neither moved nor referenced
+            const uint64_t stamp = ++buffer.lastStamp;
+            auto touch = [&](const uint64_t var){
+                if(buffer.stamps[var] != stamp){
+                    buffer.stamps[var] = stamp;
+                    buffer.referencedBy[var] = 0;
                     buffer.isMoved[var] = 0;
-
-                    gainFromMerging += diffExt;
                 }
             };
+            auto isMoved = [&](const uint64_t var){
+                return buffer.stamps[var] == stamp && buffer.isMoved[var];
+            };
 
             if (A.empty()){
-                //std::cout<<"return A empty\n";
                 return .0;
             }
 
             const auto labelA = buffer.vertexLabels[A[0]];
             const auto labelB = (!B.empty()) ? buffer.vertexLabels[B[0]] : buffer.maxNotUsedLabel;
 
-            computeDifferences(A, labelA, labelB);
-            computeDifferences(B, labelB, labelA);
-            gainFromMerging /= 2.0;
+            // the border (the nodes with neighbours in the other set) and the weight
+            // of the lifted edges between A and B are found from the smaller set,
+            // the nodes of the larger set are only touched if they are at the border
+            borderQueue_.clear();
+            auto gainFromMerging = 0.0;
+            {
+                const bool aIsSmaller = A.size() <= B.size();
+                const auto & smallerSet = aIsSmaller ? A : B;
+                const auto labelSmaller = aIsSmaller ? labelA : labelB;
+                const auto labelLarger = aIsSmaller ? labelB : labelA;
+                for(const auto var : smallerSet){
+                    touch(var);
+                    for(auto adj : graph_.adjacency(var)){
+                        const auto adjNode = adj.node();
+                        if(buffer.vertexLabels[adjNode] == labelLarger){
+                            ++buffer.referencedBy[var];
+                            touch(adjNode);
+                            if(++buffer.referencedBy[adjNode] == 1)
+                                borderQueue_.push(adjNode, buffer.differences[adjNode] =
+                                    computeDifference(adjNode, labelLarger, labelSmaller));
+                        }
+                    }
+                    if(buffer.referencedBy[var] > 0)
+                        borderQueue_.push(var, buffer.differences[var] =
+                            computeDifference(var, labelSmaller, labelLarger));
 
-            // compute border
-            border_.clear();
-            for (const auto varA : A)
-                if (buffer.referencedBy[varA] > 0)
-                    border_.push_back(varA);
-            for (const auto varB : B)
-                if (buffer.referencedBy[varB] > 0)
-                    border_.push_back(varB);
+                    for(auto adj : liftedGraph_.adjacency(var)){
+                        if(buffer.vertexLabels[adj.node()] == labelLarger)
+                            gainFromMerging += weights_[adj.edge()];
+                    }
+                }
+            }
 
+            if(B.empty()){
+                // no border yet, any node of A can start the new set
+                for (const auto varA : A)
+                    buffer.differences[varA] = computeDifference(varA, labelA, labelB);
+            }
 
 
             moves_.clear();
@@ -166,96 +210,79 @@ namespace detail_kernighang_lin{
             std::pair<double, std::size_t> maxMove { std::numeric_limits<double>::lowest(), 0 };
 
             for (auto k = 0; k < settings_.numberOfIterations; ++k){
-                //std::cout<<"k "<<k<<"\n";
-
-
-                //for(const auto node: graph_.nodes()){
-                //    //std::cout<<"buffer.differences[ "<<node<<" ] "<<buffer.differences[node]<<"\n";
-                //}
-                //for(const auto bvar: border_){
-                //    //std::cout<<"border var "<<bvar<<"\n";
-                //}
 
                 Move m;
                 if(B.empty() && k == 0){
+                    // no border yet, any node of A can start the new set
                     for(const auto varA : A){
-                        //std::cout<<"k0 or bEmpty\n";
                         m.updateDifference(varA, buffer.differences[varA]);
                     }
                 }
-                else{
-                    uint64_t borderSize =  border_.size();
-                    for (std::size_t i = 0; i < borderSize; ){
-
-                        if (buffer.referencedBy[border_[i]] == 0)
-                            std::swap(border_[i], border_[--borderSize]);
-                        else{
-                            //std::cout<<"else ..\n";
-                            //std::cout<<"buffer var i .."<<border_[i]<<"\n";
-                            //std::cout<<"buffer.differences there "<<buffer.differences[border_[i]]<<"\n";
-                            m.updateDifference(border_[i], buffer.differences[border_[i]]);
-                            ++i;
-                        }
-                    }
-                    border_.erase(border_.begin() + borderSize, border_.end());
+                else if(!borderQueue_.empty()){
+                    m.v = borderQueue_.top();
+                    m.difference = borderQueue_.topPriority();
                 }
 
                 if(m.v == -1)
                     break;
 
+                if(borderQueue_.contains(m.v))
+                    borderQueue_.deleteItem(m.v);
+                touch(m.v);
+
                 const auto oldLabel = buffer.vertexLabels[m.v];
                 m.newLabel = (oldLabel == labelA ) ? labelB : labelA;
 
-                // update differences and references
+                buffer.vertexLabels[m.v] = m.newLabel;
+                buffer.referencedBy[m.v] = 0;
+                buffer.differences[m.v] = std::numeric_limits<double>::lowest();
+                buffer.isMoved[m.v] = 1;
+
+                // update the gains of the lifted neighbours in the border
                 for(const auto adj : liftedGraph_.adjacency(m.v)){
 
                     const auto adjNode = adj.node();
                     const auto adjEdge = adj.edge();
 
-                    if(buffer.isMoved[adjNode])
+                    if(!borderQueue_.contains(adjNode))
                         continue;
 
                     const auto label = buffer.vertexLabels[adjNode];
                     if (label == m.newLabel){
-                        //std::cout<<"e "<<adjEdge<<" w "<<weights_[adjEdge]<<"\n";
                         buffer.differences[adjNode] -= 2.0*weights_[adjEdge];
                     }
-                    else if (label == oldLabel){
-                        //std::cout<<"e "<<adjEdge<<" w "<<weights_[adjEdge]<<"\n";
+                    else{
                         buffer.differences[adjNode] += 2.0*weights_[adjEdge];
                     }
+                    borderQueue_.changePriority(adjNode, buffer.differences[adjNode]);
                 }
 
+                // update the references and with them the border
                 for(const auto adj : graph_.adjacency(m.v)){
 
                     const auto adjNode = adj.node();
-                    const auto adjEdge = adj.edge();
 
-                    if(buffer.isMoved[adjNode])
+                    if(isMoved(adjNode))
                         continue;
 
                     const auto label = buffer.vertexLabels[adjNode];
 
-                    if (label == m.newLabel)
-                        --buffer.referencedBy[adjNode];
-                    
+                    if (label == m.newLabel){
+                        if (--buffer.referencedBy[adjNode] == 0)
+                            borderQueue_.deleteItem(adjNode);
+                    }
                     else if (label == oldLabel){
-                        ++buffer.referencedBy[adjNode];
-                        if (buffer.referencedBy[adjNode] == 1)
-                            border_.push_back(adjNode);
+                        touch(adjNode);
+                        if (++buffer.referencedBy[adjNode] == 1)
+                            borderQueue_.push(adjNode, buffer.differences[adjNode] =
+                                computeDifference(adjNode, oldLabel, m.newLabel));
                     }
                 }
 
-
-                buffer.vertexLabels[m.v] = m.newLabel;
-                buffer.referencedBy[m.v] = 0;
-                buffer.differences[m.v] = std::numeric_limits<double>::lowest();
-                buffer.isMoved[m.v] = 1;
                 moves_.push_back(m);
 
                 cumulativeDiff += m.difference;
                 if (cumulativeDiff > maxMove.first){
-                    //std::cout<<"set max move with diff "<<cumulativeDiff<<"\n";
                     maxMove = std::make_pair(cumulativeDiff, moves_.size());
                 }
 
@@ -275,7 +302,6 @@ namespace detail_kernighang_lin{
 
                 B.clear();
 
-                //std::cout<<"return gainFromMerging\n";
                 return gainFromMerging;
             }
             else if (maxMove.first > settings_.epsilon)
@@ -295,8 +321,8 @@ namespace detail_kernighang_lin{
                 if (B.empty())
                     ++buffer.maxNotUsedLabel;
 
-                A.erase(std::partition(A.begin(), A.end(), [&](uint64_t a) { return !buffer.isMoved[a]; }), A.end());
-                B.erase(std::partition(B.begin(), B.end(), [&](uint64_t b) { return !buffer.isMoved[b]; }), B.end());
+                A.erase(std::partition(A.begin(), A.end(), [&](uint64_t a) { return !isMoved(a); }), A.end());
+                B.erase(std::partition(B.begin(), B.end(), [&](uint64_t b) { return !isMoved(b); }), B.end());
 
                 for (std::size_t i = 0; i < maxMove.second; ++i)
                     // move vertex to the other set
@@ -305,7 +331,6 @@ namespace detail_kernighang_lin{
                     else
                         A.push_back(moves_[i].v);
 
-                //std::cout<<"return maxMove first\n";
                 return maxMove.first;
             }
             else{
@@ -316,7 +341,6 @@ namespace detail_kernighang_lin{
                         buffer.vertexLabels[moves_[i].v] = labelB;
             }
 
-            //std::cout<<"return 0 at end\n";
             return .0;
 
         }
@@ -330,7 +354,8 @@ namespace detail_kernighang_lin{
         const GraphType & graph_;
         const LiftedGraphType & liftedGraph_;
         const WeightsMap & weights_;
-        std::vector<uint64_t> border_;
+        // border nodes by their gain, largest first
+        tools::ChangeablePriorityQueue<double, std::greater<double> > borderQueue_;
         std::vector<Move> moves_;
     };
 
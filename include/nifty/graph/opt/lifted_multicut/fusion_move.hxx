@@ -2,10 +2,11 @@
 
 #include <mutex>          // std::mutex
 #include <memory>
-#include <unordered_set>
+#include <vector>
 
 #include "nifty/graph/opt/lifted_multicut/lifted_multicut_greedy_additive.hxx"
 #include "nifty/tools/runtime_check.hxx"
+#include "nifty/parallel/parallel_sort.hxx"
 #include "nifty/ufd/ufd.hxx"
 #include "nifty/graph/opt/lifted_multicut/lifted_multicut_base.hxx"
 #include "nifty/graph/opt/common/solver_factory.hxx"
@@ -62,20 +63,31 @@ namespace lifted_multicut{
             }
         }
 
+        /**
+         * @brief      Fuse the proposals into result
+         *
+         * @param      proposals   the proposals
+         * @param      result      (Output) the fused labels
+         * @param      threadpool  if given, the edges of the contracted
+         *                         problem are sorted with this thread pool
+         *                         (the fuse must not run inside this pool)
+         */
         template<class NODE_MAP>
         void fuse(
             std::initializer_list<const NODE_MAP *> proposals,
-            NODE_MAP * result
+            NODE_MAP * result,
+            parallel::ThreadPool * threadpool = nullptr
         ){
             std::vector<const NODE_MAP *> p(proposals);
-            fuse(p, result);
+            fuse(p, result, threadpool);
         }
 
 
         template<class NODE_MAP >
         void fuse(
             const std::vector< const NODE_MAP *> & proposals,
-            NODE_MAP * result 
+            NODE_MAP * result,
+            parallel::ThreadPool * threadpool = nullptr
         ){
             ufd_.reset();
 
@@ -97,7 +109,7 @@ namespace lifted_multicut{
                     ufd_.merge(u, v);
             }
 
-            this->fuseImpl(result);
+            this->fuseImpl(result, threadpool);
 
             // evaluate if the result
             // is indeed better than each proposal
@@ -122,54 +134,96 @@ namespace lifted_multicut{
         }
 
     private:
+        template<class T, class COMP>
+        static void sortEdges(std::vector<T> & edges, parallel::ThreadPool * threadpool, COMP comp){
+            if(threadpool != nullptr){
+                parallel::parallelSort(*threadpool, edges.begin(), edges.end(), comp);
+            }
+            else{
+                std::sort(edges.begin(), edges.end(), comp);
+            }
+        }
+
         template<class NODE_MAP>
-        void fuseImpl(NODE_MAP * result){
+        void fuseImpl(NODE_MAP * result, parallel::ThreadPool * threadpool){
 
-            // dense relabeling
-            std::unordered_set<uint64_t> relabelingSet;
+            // dense relabeling, the roots are numbered in node order
+            uint64_t numberOfNodes = 0;
             for(const auto node: graph_.nodes()){
-                relabelingSet.insert(ufd_.find(node));
+                if(ufd_.find(node) == node){
+                    nodeToDense_[node] = numberOfNodes++;
+                }
             }
-            auto denseLabel = 0;
-            for(auto sparse: relabelingSet){
-                nodeToDense_[sparse] = denseLabel;
-                ++denseLabel;
+            for(const auto node: graph_.nodes()){
+                nodeToDense_[node] = nodeToDense_[ufd_.find(node)];
             }
-            const auto numberOfNodes = relabelingSet.size();
-            
-            // build the graph
-            FmGraphType       fmGraph(numberOfNodes);
-            
 
+            // the edges between the contracted nodes, as keys u * numberOfNodes + v with u < v,
+            // parallel edges are removed by sorting instead of searching the adjacencies
+            NIFTY_CHECK_OP(numberOfNodes, <, uint64_t(1) << 32, "too many nodes in the contracted graph");
+            auto edgeKey = [&](const uint64_t u, const uint64_t v){
+                const auto lu = nodeToDense_[u];
+                const auto lv = nodeToDense_[v];
+                return lu < lv ? lu * numberOfNodes + lv : lv * numberOfNodes + lu;
+            };
+
+            std::vector<uint64_t> fmEdges;
             for(auto edge : graph_.edges()){
                 const auto uv = graph_.uv(edge);
-                const auto u = uv.first;
-                const auto v = uv.second;
-                const auto lu = nodeToDense_[ufd_.find(u)];
-                const auto lv = nodeToDense_[ufd_.find(v)];
-                if(lu != lv){
-                    fmGraph.insertEdge(lu, lv);
+                if(nodeToDense_[uv.first] != nodeToDense_[uv.second]){
+                    fmEdges.push_back(edgeKey(uv.first, uv.second));
                 }
             }
+            sortEdges(fmEdges, threadpool, std::less<uint64_t>());
+            fmEdges.erase(std::unique(fmEdges.begin(), fmEdges.end()), fmEdges.end());
 
-            FmObjective fmObjective(fmGraph);
+            // the edges are sorted, so the adjacencies are filled by appending
+            FmGraphType       fmGraph(numberOfNodes, fmEdges.size());
+            for(const auto key : fmEdges){
+                fmGraph.insertEdge(key / numberOfNodes, key % numberOfNodes);
+            }
 
+            // lifted edges with their weights, consecutive edges often
+            // connect the same nodes and are summed up right away
+            typedef std::pair<uint64_t, double> WeightedEdge;
+            std::vector<WeightedEdge> fmLiftedEdges;
             for(auto edge : liftedGraph_.edges()){
                 const auto uv = liftedGraph_.uv(edge);
-                const auto u = uv.first;
-                const auto v = uv.second;
-                const auto lu = nodeToDense_[ufd_.find(u)];
-                const auto lv = nodeToDense_[ufd_.find(v)];
-                if(lu != lv){
-                    fmObjective.setCost(lu,lv,objective_.weights()[edge],false);
+                if(nodeToDense_[uv.first] == nodeToDense_[uv.second]){
+                    continue;
+                }
+                const auto key = edgeKey(uv.first, uv.second);
+                if(!fmLiftedEdges.empty() && fmLiftedEdges.back().first == key){
+                    fmLiftedEdges.back().second += objective_.weights()[edge];
+                }
+                else{
+                    fmLiftedEdges.emplace_back(key, objective_.weights()[edge]);
                 }
             }
+            sortEdges(fmLiftedEdges, threadpool, [](const WeightedEdge & a, const WeightedEdge & b){
+                return a.first < b.first;
+            });
+
+            // sum up the weights of parallel lifted edges in place
+            std::size_t nLiftedEdges = 0;
+            for(std::size_t i = 0; i < fmLiftedEdges.size(); ++i){
+                if(nLiftedEdges > 0 && fmLiftedEdges[nLiftedEdges - 1].first == fmLiftedEdges[i].first){
+                    fmLiftedEdges[nLiftedEdges - 1].second += fmLiftedEdges[i].second;
+                }
+                else{
+                    fmLiftedEdges[nLiftedEdges++] = fmLiftedEdges[i];
+                }
+            }
+            fmLiftedEdges.resize(nLiftedEdges);
 
+            FmObjective fmObjective(fmGraph, nLiftedEdges - std::min(nLiftedEdges, fmEdges.size()));
+            for(const auto & e : fmLiftedEdges){
+                fmObjective.setCost(e.first / numberOfNodes, e.first % numberOfNodes, e.second, false);
+            }
 
 
-            const auto fmEdges = fmGraph.numberOfEdges();
 
-            if(fmEdges == 0){
+            if(fmGraph.numberOfEdges() == 0){
                 for(const auto node : graph_.nodes()){
                     result->operator[](node)  = ufd_.find(node);
                 }
@@ -188,8 +242,8 @@ namespace lifted_multicut{
                     const auto uv = graph_.uv(edge);
                     const auto u = uv.first;
                     const auto v = uv.second;
-                    const auto lu = nodeToDense_[ufd_.find(u)];
-                    const auto lv = nodeToDense_[ufd_.find(v)];
+                    const auto lu = nodeToDense_[u];
+                    const auto lv = nodeToDense_[v];
                     if(lu != lv){
                         if(fmLabels[lu] == fmLabels[lv]){
                             ufd_.merge(u, v);
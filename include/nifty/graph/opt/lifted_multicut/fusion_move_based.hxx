@@ -253,7 +253,76 @@ namespace lifted_multicut{
     optimizeMultiThread(
         VisitorProxyType & visitorProxy
     ){
-        NIFTY_CHECK(false, "currently only single thread is implemented");
+        // every iteration generates one proposal per thread, fuses each
+        // of them with the current best and then fuses the results
+        // pairwise in a tree until a single labeling is left
+        const auto numberOfThreads = parallelOptions_.getActualNumThreads();
+        std::vector<NodeLabelsType> proposals(numberOfThreads, NodeLabelsType(graph_));
+        std::vector<NodeLabelsType> fused(numberOfThreads, NodeLabelsType(graph_));
+        auto iterWithoutImprovement = 0;
+
+        for(auto iteration=0; iteration<settings_.numberOfIterations; ++iteration){
+
+            // generate the proposals, the generator has one random stream per
+            // thread and proposal i always uses stream i, so the result does
+            // not depend on the scheduling
+            parallel::parallel_foreach(threadPool_, numberOfThreads, [&](const int tid, const int i){
+                proposalGenerator_->generateProposal(*currentBest_, proposals[i], i);
+            });
+
+            // fuse with the current best, unless the starting
+            // point was trivial (one connected comp.)
+            const bool trivialStart = currentBestEnergy_ >=-0.000000001 && iteration==0;
+            parallel::parallel_foreach(threadPool_, numberOfThreads, [&](const int tid, const int i){
+                if(trivialStart){
+                    fused[i] = proposals[i];
+                }
+                else{
+                    fusionMoves_[tid]->fuse({&proposals[i], currentBest_}, &fused[i]);
+                }
+            });
+
+            // tree reduction, the pairs of a level are fused in parallel,
+            // a single fuse sorts the contracted edges with the thread pool instead
+            for(std::size_t width = 1; width < numberOfThreads; width *= 2){
+                const std::size_t numberOfFuses = (numberOfThreads + 2 * width - 1) / (2 * width);
+                auto fusePair = [&](const int tid, const std::size_t f, parallel::ThreadPool * threadpool){
+                    const auto first = 2 * f * width;
+                    const auto second = first + width;
+                    if(second < numberOfThreads){
+                        // the result may not alias an input
+                        auto & result = proposals[first];
+                        fusionMoves_[tid]->fuse({&fused[first], &fused[second]}, &result, threadpool);
+                        std::swap(fused[first], result);
+                    }
+                };
+                if(numberOfFuses == 1){
+                    fusePair(0, 0, &threadPool_);
+                }
+                else{
+                    parallel::parallel_foreach(threadPool_, numberOfFuses, [&](const int tid, const int64_t f){
+                        fusePair(tid, f, nullptr);
+                    });
+                }
+            }
+
+            const auto eFuse = objective_.evalNodeLabels(fused[0]);
+            if(trivialStart || eFuse<currentBestEnergy_){
+                currentBestEnergy_ = eFuse;
+                graph_.forEachNode([&](const uint64_t node){
+                    (*currentBest_)[node] = fused[0][node];
+                });
+                iterWithoutImprovement = 0;
+            }
+            else{
+                ++iterWithoutImprovement;
+                if(iterWithoutImprovement >= settings_.stopIfNoImprovement){
+                    break;
+                }
+            }
+
+            visitorProxy.visit(this);
+        }
     }
 
     template<class OBJECTIVE>
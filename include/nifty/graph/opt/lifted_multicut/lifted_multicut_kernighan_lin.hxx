@@ -14,6 +14,7 @@
 #include "nifty/tools/changable_priority_queue.hxx"
 
 #include "nifty/tools/runtime_check.hxx"
+#include "nifty/parallel/threadpool.hxx"
 #include "nifty/ufd/ufd.hxx"
 #include "nifty/graph/detail/adjacency.hxx"
 #include "nifty/graph/opt/lifted_multicut/lifted_multicut_base.hxx"
@@ -62,6 +63,9 @@ namespace lifted_multicut{
             std::size_t numberOfInnerIterations { std::numeric_limits<std::size_t>::max() };
             std::size_t numberOfOuterIterations { 100 };
             double epsilon { 1e-7 };
+            // pairs of partitions that are not linked
+            // by lifted edges are optimized in parallel
+            int numberOfThreads { 1 };
         };
 
 
@@ -81,6 +85,9 @@ namespace lifted_multicut{
         void initializePartiton();
         void buildRegionAdjacencyGraph();
         void optimizePairs(double & energyDecrease);
+        void optimizePairsParallel(double & energyDecrease);
+        bool linkedToRound(const uint64_t pi, const std::vector<uint8_t> & inRound) const;
+        void mergeLiftedEdges(const uint64_t piU, const uint64_t piV);
 
         void introduceNewPartitions(double & energyDecrease);
         void connectedComponentLabeling();
@@ -98,7 +105,10 @@ namespace lifted_multicut{
         NodeLabelsType * currentBest_;
         double currentBestEnergy_;
 
-        TwoCutType twoCut_;
+        nifty::parallel::ParallelOptions parallelOptions_;
+        nifty::parallel::ThreadPool threadPool_;
+        // one two cut per thread, the first one is used for the serial parts
+        std::vector<TwoCutType> twoCuts_;
         ComponentsType components_;
         std::vector< std::vector<uint64_t> > partitions_;
         TwoCutBuffersType twoCutBuffers_;
@@ -113,6 +123,9 @@ namespace lifted_multicut{
         //edges from labels connected component / rag graph
         std::vector<std::unordered_set<uint64_t> > edges_;
 
+        // partitions connected by lifted edges, used by optimizePairsParallel
+        std::vector<std::vector<uint64_t> > liftedEdges_;
+
         uint64_t numberOfComponents_;
     };
 
@@ -130,7 +143,9 @@ namespace lifted_multicut{
         currentBest_(nullptr),
         currentBestEnergy_(0.0),
         //
-        twoCut_(objective),
+        parallelOptions_(settings.numberOfThreads),
+        threadPool_(parallelOptions_),
+        twoCuts_(),
         components_(objective.graph()),
         partitions_(),
         twoCutBuffers_(objective.graph()),
@@ -138,9 +153,16 @@ namespace lifted_multicut{
         visited_(objective.graph()),
         changed_(),
         edges_(),
+        liftedEdges_(),
         numberOfComponents_(0)
     {
-
+        const auto numberOfThreads = parallelOptions_.getActualNumThreads();
+        twoCuts_.reserve(numberOfThreads);
+        typename TwoCutType::SettingsType twoCutSettings;
+        twoCutSettings.numberOfIterations = settings_.numberOfInnerIterations;
+        for(std::size_t t = 0; t < numberOfThreads; ++t){
+            twoCuts_.emplace_back(objective, twoCutSettings);
+        }
     }
 
     template<class OBJECTIVE>
@@ -171,7 +193,10 @@ namespace lifted_multicut{
             auto energyDecrease = 0.0;
 
             this->buildRegionAdjacencyGraph();
-            this->optimizePairs(energyDecrease);
+            if(twoCuts_.size() > 1)
+                this->optimizePairsParallel(energyDecrease);
+            else
+                this->optimizePairs(energyDecrease);
             this->introduceNewPartitions(energyDecrease);
 
             if(energyDecrease == .0)
@@ -293,7 +318,7 @@ namespace lifted_multicut{
                     if (!pV.empty() && (changed_[piU] || changed_[piV])){
 
                         // HERE WE TRY TO UPDATE THE PAIR OF PARTITIONS
-                        const auto ret = twoCut_.optimizeTwoCut(pU, pV, twoCutBuffers_);
+                        const auto ret = twoCuts_[0].optimizeTwoCut(pU, pV, twoCutBuffers_);
                         //std::cout<<"to cut ret "<<ret<<"\n";
                         if(ret > settings_.epsilon){
                             changed_[piU] = 1;
@@ -318,6 +343,150 @@ namespace lifted_multicut{
     }
 
 
+    // Same as optimizePairs, but the pairs are processed in rounds:
+    // each round takes the remaining pairs (in the order of optimizePairs)
+    // that are not linked by lifted edges to a pair taken before and
+    // optimizes them in parallel. The two cuts of a round do not see
+    // each other, so the result is the same as processing them one after the other.
+    // A two cut with a gain moves nodes between its partitions, so afterwards
+    // both of them are treated as linked to the partitions either was linked to.
+    template<class OBJECTIVE>
+    inline void 
+    LiftedMulticutKernighanLin<OBJECTIVE>::
+    optimizePairsParallel(
+        double & energyDecrease
+    ){
+        // partitions are labeled with their index here
+        const auto & vertexLabels = twoCutBuffers_.vertexLabels;
+        liftedEdges_.resize(numberOfComponents_);
+        std::vector<int64_t> lastSeen(numberOfComponents_, -1);
+        for(uint64_t piU=0; piU<numberOfComponents_; ++piU){
+            liftedEdges_[piU].clear();
+            for(const auto node : partitions_[piU]){
+                for(const auto adj : liftedGraph_.adjacency(node)){
+                    const auto piV = vertexLabels[adj.node()];
+                    if(piV != piU && lastSeen[piV] != int64_t(piU)){
+                        lastSeen[piV] = piU;
+                        liftedEdges_[piU].push_back(piV);
+                    }
+                }
+            }
+        }
+
+        std::vector<std::pair<uint64_t, uint64_t> > pairs;
+        for(uint64_t piU=0; piU<numberOfComponents_; ++piU){
+            for(const auto piV : edges_[piU]){
+                pairs.emplace_back(piU, piV);
+            }
+        }
+
+        std::vector<std::pair<uint64_t, uint64_t> > remaining;
+        std::vector<std::pair<uint64_t, uint64_t> > round;
+        std::vector<double> gains;
+        // partitions that are in, or linked to, a pair of the current round
+        std::vector<uint8_t> blocked(numberOfComponents_, 0);
+        std::vector<uint64_t> blockedList;
+        // partitions of the pairs of the current round
+        std::vector<uint8_t> inRound(numberOfComponents_, 0);
+
+        while(!pairs.empty()){
+
+            remaining.clear();
+            round.clear();
+            for(const auto & pair : pairs){
+                const auto piU = pair.first;
+                const auto piV = pair.second;
+                if(blocked[piU] || blocked[piV]){
+                    remaining.push_back(pair);
+                    continue;
+                }
+                if(partitions_[piU].empty() || partitions_[piV].empty() || !(changed_[piU] || changed_[piV]))
+                    continue;
+                if(linkedToRound(piU, inRound) || linkedToRound(piV, inRound)){
+                    remaining.push_back(pair);
+                    continue;
+                }
+
+                round.push_back(pair);
+                inRound[piU] = 1;
+                inRound[piV] = 1;
+                for(const auto pi : {piU, piV}){
+                    blocked[pi] = 1;
+                    blockedList.push_back(pi);
+                    for(const auto piW : liftedEdges_[pi]){
+                        blocked[piW] = 1;
+                        blockedList.push_back(piW);
+                    }
+                }
+            }
+
+            gains.resize(round.size());
+            parallel::parallel_foreach(threadPool_, round.size(), [&](const int tid, const int64_t i){
+                gains[i] = twoCuts_[tid].optimizeTwoCut(
+                    partitions_[round[i].first], partitions_[round[i].second], twoCutBuffers_
+                );
+            });
+
+            for(std::size_t i = 0; i < round.size(); ++i){
+                const auto piU = round[i].first;
+                const auto piV = round[i].second;
+                if(gains[i] > settings_.epsilon){
+                    changed_[piU] = 1;
+                    changed_[piV] = 1;
+                }
+                // nodes are only moved if the two cut has a gain
+                if(gains[i] > 0.0){
+                    mergeLiftedEdges(piU, piV);
+                }
+                energyDecrease += gains[i];
+                inRound[piU] = 0;
+                inRound[piV] = 0;
+            }
+            for(const auto pi : blockedList){
+                blocked[pi] = 0;
+            }
+            blockedList.clear();
+            pairs.swap(remaining);
+        }
+
+        // remove partitions that became empty after the previous step
+        auto partionF =  [](const std::vector<uint64_t>& s) { return !s.empty(); };
+        auto newEnd = std::partition(partitions_.begin(), partitions_.end(), partionF);
+        partitions_.resize(newEnd - partitions_.begin());
+    }
+
+
+    template<class OBJECTIVE>
+    inline bool
+    LiftedMulticutKernighanLin<OBJECTIVE>::
+    linkedToRound(
+        const uint64_t pi,
+        const std::vector<uint8_t> & inRound
+    ) const {
+        for(const auto piW : liftedEdges_[pi]){
+            if(inRound[piW])
+                return true;
+        }
+        return false;
+    }
+
+
+    template<class OBJECTIVE>
+    inline void
+    LiftedMulticutKernighanLin<OBJECTIVE>::
+    mergeLiftedEdges(
+        const uint64_t piU,
+        const uint64_t piV
+    ){
+        auto & edgesU = liftedEdges_[piU];
+        auto & edgesV = liftedEdges_[piV];
+        edgesU.insert(edgesU.end(), edgesV.begin(), edgesV.end());
+        std::sort(edgesU.begin(), edgesU.end());
+        edgesU.erase(std::unique(edgesU.begin(), edgesU.end()), edgesU.end());
+        edgesV = edgesU;
+    }
+
+
     template<class OBJECTIVE>
     inline void 
     LiftedMulticutKernighanLin<OBJECTIVE>::
@@ -336,7 +505,7 @@ namespace lifted_multicut{
 
                 // CALL VISITOR HERE
                 std::vector<uint64_t> newSet;
-                energyDecrease += twoCut_.optimizeTwoCut(partitions_[i], newSet, twoCutBuffers_);
+                energyDecrease += twoCuts_[0].optimizeTwoCut(partitions_[i], newSet, twoCutBuffers_);
 
                 flag = !newSet.empty();
                 if (!newSet.empty())
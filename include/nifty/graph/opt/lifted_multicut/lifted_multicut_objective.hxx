@@ -7,6 +7,7 @@
 #include "nifty/graph/undirected_list_graph.hxx"
 #include "nifty/graph/subgraph_mask.hxx"
 #include "nifty/graph/graph_maps.hxx"
+#include "nifty/graph/opt/common/eval_node_labels.hxx"
 #include "nifty/graph/opt/multicut/multicut_objective.hxx"
 #include "nifty/graph/breadth_first_search.hxx"
 #include "nifty/parallel/threadpool.hxx"
@@ -33,20 +34,9 @@ namespace lifted_multicut{
 
 
         template<class NODE_LABELS>
-        WEIGHT_TYPE evalNodeLabels(const NODE_LABELS & nodeLabels)const{
-            WEIGHT_TYPE sum = static_cast<WEIGHT_TYPE>(0.0);
-
-            const auto & w = _child().weights();
-            const auto & lg = _child().liftedGraph();
-
-            for(const auto edge: lg.edges()){
-                const auto uv = lg.uv(edge);
-
-                if(nodeLabels[uv.first] != nodeLabels[uv.second]){
-                    sum += w[edge];
-                }
-            }
-            return sum;
+        WEIGHT_TYPE evalNodeLabels(const NODE_LABELS & nodeLabels, const int numberOfThreads = 1)const{
+            return common::cutWeight<WEIGHT_TYPE>(_child().liftedGraph(), _child().weights(),
+                                                  nodeLabels, numberOfThreads);
         }
 
         uint64_t numberOfLiftedEdges()const{
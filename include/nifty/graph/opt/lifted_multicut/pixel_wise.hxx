@@ -1,9 +1,12 @@
 #pragma once
 
 
+#include <algorithm>
+#include <array>
 #include <iostream>
-
-#include <boost/container/flat_map.hpp>
+#include <limits>
+#include <numeric>
+#include <vector>
 
 #include <xtensor/xoperation.hpp>
 #include <xtensor/xmath.hpp>
@@ -11,7 +14,10 @@
 #include <xtensor/xexpression.hpp>
 #include <xtensor/xview.hpp>
 
-#include "nifty/ufd/ufd.hxx"
+#include "nifty/parallel/parallel_sort.hxx"
+#include "nifty/parallel/threadpool.hxx"
+#include "nifty/tools/runtime_check.hxx"
+#include "nifty/ufd/concurrent_ufd.hxx"
 #include "nifty/graph/undirected_list_graph.hxx"
 #include "nifty/python/graph/undirected_grid_graph.hxx"
 #include "nifty/graph/opt/lifted_multicut/lifted_multicut_objective.hxx"
@@ -26,80 +32,164 @@ namespace lifted_multicut{
 
 
         template<std::size_t DIM>
-        struct EvalHelper;
-
-        template<>
-        struct EvalHelper<2>{
+        using Coordinate = std::array<int64_t, DIM>;
+
+        // c order strides of a shape
+        template<std::size_t DIM, class SHAPE>
+        Coordinate<DIM> cOrderStrides(const SHAPE & shape){
+            Coordinate<DIM> strides;
+            strides[DIM - 1] = 1;
+            for(int d = int(DIM) - 2; d >= 0; --d){
+                strides[d] = strides[d + 1] * shape[d + 1];
+            }
+            return strides;
+        }
 
-            template<class OBJ, class D_LABELS>
-            static auto evaluate(
-                const OBJ & obj,
-                const xt::xexpression<D_LABELS> & e_labels
-            ){
-                const auto & labels = e_labels.derived_cast();
-                const auto & weights = obj.weights();
-                const auto & offsets = obj.offsets();
-                const auto & shape = obj.shape();
-                const auto & n_offsets = obj.n_offsets();
+        // call f(index, coordinate) for all pixels of the slice p0 along the first
+        // axis in c order, the slices are the blocks that are processed in parallel
+        template<std::size_t DIM, class SHAPE, class F>
+        void forEachPixelOfSlice(const SHAPE & shape, const int64_t p0, F && f){
+            uint64_t sliceSize = 1;
+            for(std::size_t d = 1; d < DIM; ++d){
+                sliceSize *= shape[d];
+            }
+            Coordinate<DIM> p;
+            p.fill(0);
+            p[0] = p0;
+            uint64_t index = p0 * sliceSize;
+            for(uint64_t i = 0; i < sliceSize; ++i, ++index){
+                f(index, p);
+                for(int d = int(DIM) - 1; d > 0; --d){
+                    if(++p[d] < shape[d]){
+                        break;
+                    }
+                    p[d] = 0;
+                }
+            }
+        }
 
-                auto e = 0.0;
+        // the offsets of an objective as coordinates and
+        // as differences of the flat indices in c order
+        template<std::size_t DIM>
+        struct Offsets{
+            template<class OBJ>
+            Offsets(const OBJ & obj)
+            :   coordinates(obj.n_offsets()),
+                deltas(obj.n_offsets(), 0)
+            {
+                const auto strides = cOrderStrides<DIM>(obj.shape());
+                for(std::size_t o = 0; o < obj.n_offsets(); ++o){
+                    for(std::size_t d = 0; d < DIM; ++d){
+                        coordinates[o][d] = obj.offsets()(o, d);
+                        deltas[o] += coordinates[o][d] * strides[d];
+                    }
+                }
+            }
 
-                for(int p0=0; p0<shape[0]; ++p0)
-                for(int p1=0; p1<shape[1]; ++p1){
-                    const auto label_p = labels(p0, p1);
-                    for(int offset_index=0; offset_index<n_offsets; ++offset_index){
-                        const int q0 = p0 + offsets(offset_index, 0);
-                        const int q1 = p1 + offsets(offset_index, 1);
-                        if(q0 >= 0 && q0 < shape[0]  && q1 >= 0 && q1 < shape[1]){
-                            const auto label_q = labels(q0, q1);
-                            if(label_p != label_q){
-                                e += weights(p0, p1, offset_index);
-                            }
-                        }
+            // is p + offset inside of the shape
+            template<class SHAPE>
+            bool inside(const SHAPE & shape, const std::size_t offsetIndex, const Coordinate<DIM> & p)const{
+                for(std::size_t d = 0; d < DIM; ++d){
+                    const auto q = p[d] + coordinates[offsetIndex][d];
+                    if(q < 0 || q >= shape[d]){
+                        return false;
                     }
                 }
-                return e;
+                return true;
             }
-        };
 
-        template<>
-        struct EvalHelper<3>{
-            template<class OBJ, class D_LABELS>
-            static auto evaluate(
-                const OBJ & obj,
-                const xt::xexpression<D_LABELS> & e_labels
-            ){
-                const auto & labels = e_labels.derived_cast();
-                const auto & weights = obj.weights();
-                const auto & offsets = obj.offsets();
-                const auto & shape = obj.shape();
-                const auto & n_offsets = obj.n_offsets();
+            std::vector<Coordinate<DIM>> coordinates;
+            std::vector<int64_t> deltas;
+        };
 
-                auto e = 0.0;
-                for(int p0=0; p0<shape[0]; ++p0)
-                for(int p1=0; p1<shape[1]; ++p1)
-                for(int p2=0; p2<shape[2]; ++p2)
-                {
-                    const auto label_p = labels(p0, p1, p2);
+        // copy the labels labelAt(coordinate) to flat labels in c order
+        template<std::size_t DIM, class SHAPE, class LABEL_AT>
+        void flattenLabels(
+            const SHAPE & shape,
+            LABEL_AT && labelAt,
+            parallel::ThreadPool & threadpool,
+            std::vector<uint64_t> & labels
+        ){
+            uint64_t size = 1;
+            for(std::size_t d = 0; d < DIM; ++d){
+                size *= shape[d];
+            }
+            labels.resize(size);
+            parallel::parallel_foreach(threadpool, shape[0], [&](const int tid, const int64_t p0){
+                forEachPixelOfSlice<DIM>(shape, p0, [&](const uint64_t index, const Coordinate<DIM> & p){
+                    labels[index] = labelAt(p);
+                });
+            });
+        }
 
-                    for(int offset_index=0; offset_index<n_offsets; ++offset_index){  
-                        const int q0 = p0 + offsets(offset_index, 0);
-                        const int q1 = p1 + offsets(offset_index, 1);
-                        const int q2 = p2 + offsets(offset_index, 2);
-                        if(q0 >= 0 && q0 < shape[0] && 
-                           q1 >= 0 && q1 < shape[1] && 
-                           q2 >= 0 && q2 < shape[2]
-                        ){
-                            const auto label_q = labels(q0, q1, q2);
-                            if(label_p != label_q){
-                                e += weights(p0, p1, p2, offset_index);
-                            }
+        // energy of flat labels in c order, every slice is summed up
+        // on its own, so the result does not depend on the number of threads
+        template<std::size_t DIM, class OBJ>
+        double evaluate(
+            const OBJ & obj,
+            const Offsets<DIM> & offsets,
+            const std::vector<uint64_t> & labels,
+            parallel::ThreadPool & threadpool
+        ){
+            const auto & shape = obj.shape();
+            const auto n_offsets = obj.n_offsets();
+            const auto * weights = obj.weights().data();
+
+            std::vector<double> sliceEnergies(shape[0], 0.0);
+            parallel::parallel_foreach(threadpool, shape[0], [&](const int tid, const int64_t p0){
+                double e = 0.0;
+                forEachPixelOfSlice<DIM>(shape, p0, [&](const uint64_t index, const Coordinate<DIM> & p){
+                    const auto label_p = labels[index];
+                    for(std::size_t offset_index = 0; offset_index < n_offsets; ++offset_index){
+                        if(offsets.inside(shape, offset_index, p) &&
+                           label_p != labels[index + offsets.deltas[offset_index]]){
+                            e += weights[index * n_offsets + offset_index];
                         }
                     }
-                }
-                return e;
+                });
+                sliceEnergies[p0] = e;
+            });
+            return std::accumulate(sliceEnergies.begin(), sliceEnergies.end(), 0.0);
+        }
+
+        // dense clusters of the cells of the grid downsampled by factor: neighbouring
+        // cells are merged if agree(p, q) holds for the flat indices p and q of their first pixels
+        template<std::size_t DIM, class SHAPE, class AGREE>
+        uint64_t cellClusters(
+            const SHAPE & shape,
+            const int factor,
+            AGREE && agree,
+            parallel::ThreadPool & threadpool,
+            std::vector<uint64_t> & clusters
+        ){
+            Coordinate<DIM> cellShape;
+            uint64_t numberOfCells = 1;
+            for(std::size_t d = 0; d < DIM; ++d){
+                cellShape[d] = (shape[d] + factor - 1) / factor;
+                numberOfCells *= cellShape[d];
             }
-        };
+            const auto strides = cOrderStrides<DIM>(shape);
+            const auto cellStrides = cOrderStrides<DIM>(cellShape);
+
+            ufd::ConcurrentUfd<uint64_t> ufd(numberOfCells);
+            parallel::parallel_foreach(threadpool, cellShape[0], [&](const int tid, const int64_t c0){
+                forEachPixelOfSlice<DIM>(cellShape, c0, [&](const uint64_t cell, const Coordinate<DIM> & c){
+                    uint64_t p = 0;
+                    for(std::size_t d = 0; d < DIM; ++d){
+                        p += c[d] * factor * strides[d];
+                    }
+                    for(std::size_t d = 0; d < DIM; ++d){
+                        if(c[d] + 1 < cellShape[d] && agree(p, p + factor * strides[d])){
+                            ufd.merge(cell, cell + cellStrides[d]);
+                        }
+                    }
+                });
+            });
+
+            clusters.resize(numberOfCells);
+            ufd.elementLabeling(clusters.begin(), threadpool);
+            return numberOfCells == 0 ? 0 : *std::max_element(clusters.begin(), clusters.end()) + 1;
+        }
 
 
         template<std::size_t DIM>
@@ -253,9 +343,17 @@ namespace lifted_multicut{
 
         template<class D_LABELS>
         auto evaluate(
-            const xt::xexpression<D_LABELS> & e_labels
+            const xt::xexpression<D_LABELS> & e_labels,
+            const int numberOfThreads = 1
         )const{
-            return detail_plmc::EvalHelper<DIM>::evaluate(*this, e_labels);
+            const auto & labels = e_labels.derived_cast();
+            parallel::ParallelOptions pOpts(numberOfThreads);
+            parallel::ThreadPool threadpool(pOpts);
+            std::vector<uint64_t> flatLabels;
+            detail_plmc::flattenLabels<DIM>(shape_, [&](const detail_plmc::Coordinate<DIM> & p){
+                return labels.element(p.begin(), p.end());
+            }, threadpool, flatLabels);
+            return detail_plmc::evaluate<DIM>(*this, detail_plmc::Offsets<DIM>(*this), flatLabels, threadpool);
         }
         const auto & weights()const{
             return weights_;
@@ -347,17 +445,27 @@ namespace lifted_multicut{
 
 
 
+    /**
+     * @brief      Fusion of pixel-wise proposals for a PixelWiseLmcObjective
+     *
+     * @details    The pixels are clustered into the connected components on which
+     *             all proposals agree, the lifted multicut problem of the clusters is
+     *             solved with the solver factory and the result is kept if it is better
+     *             than the best proposal.
+     *             The connected components, the contraction and the evaluation
+     *             of the objective run in parallel on slices of the first axis.
+     *
+     *             fuseCoarseToFine runs the fusion on downsampled grids first:
+     *             with a factor f the clusters are built from cells of f^DIM pixels,
+     *             where the proposals are sampled at the first pixel of every cell.
+     *             The contracted problem of the cells is exact w.r.t. the full
+     *             resolution objective, so the result of every level is a valid
+     *             proposal for the next, finer level.
+     */
     template<std::size_t DIM>
-    class PixelWiseLmcConnetedComponentsFusion;
-
-    template<>
-    class PixelWiseLmcConnetedComponentsFusion<2>
+    class PixelWiseLmcConnetedComponentsFusion
     {
     public:
-        static const std::size_t DIM = 2;
-
-
-
         typedef nifty::graph::UndirectedGraph<>                 CCGraphType;
         typedef LiftedMulticutObjective<CCGraphType, double >   CCObjectiveType;
         typedef LiftedMulticutBase<CCObjectiveType>             CCBaseType;
@@ -366,736 +474,280 @@ namespace lifted_multicut{
         // factory for the lifted primal rounder
         typedef nifty::graph::opt::common::SolverFactoryBase<CCBaseType> CCLmcFactoryBase;
 
+        typedef xt::xtensor<uint64_t, DIM, xt::layout_type::row_major> LabelsType;
+        typedef detail_plmc::Coordinate<DIM>                            Coordinate;
 
-
-
-
-
-
+        struct  Settings
+        {
+            int numberOfThreads{1};
+        };
 
         PixelWiseLmcConnetedComponentsFusion(
             const PixelWiseLmcObjective<DIM> & objective,
-            std::shared_ptr<CCLmcFactoryBase> solver_fatory
+            std::shared_ptr<CCLmcFactoryBase> solver_fatory,
+            const Settings & settings = Settings()
         )
         :   objective_(objective),
-            ufd_(objective.n_variables()),
-            solver_fatory_(solver_fatory)
+            solver_fatory_(solver_fatory),
+            parallelOptions_(settings.numberOfThreads),
+            threadpool_(parallelOptions_),
+            offsets_(objective)
         {
 
         }
 
-
-        struct  Settings
-        {
-            
-        };
-
-
-        
-
         template<class D_LABELS_A, class D_LABELS_B>
         auto fuse(
             const xt::xexpression<D_LABELS_A>  & e_labels_a,
             const xt::xexpression<D_LABELS_B>  & e_labels_b
         ){
-
-            ufd_.reset();
-
-            const auto & shape = objective_.shape();
             const auto & labels_a = e_labels_a.derived_cast();
             const auto & labels_b = e_labels_b.derived_cast();
-
-            typename xt::xtensor<uint64_t, DIM>::shape_type reshape{std::size_t(shape[0]), std::size_t(shape[1])};
-            auto res = xt::xtensor<uint64_t, DIM, xt::layout_type::row_major>(reshape);
-
-
-            this->merge_ufd(e_labels_a, e_labels_b);
-
-            // 
-            auto e_a = objective_.evaluate(labels_a);
-            auto e_b = objective_.evaluate(labels_b);
-            this->_build_(res, [&](
-                const auto & cc_node_labels,
-                const auto & cc_energy
-            ){
-                if(cc_energy < std::min(e_a, e_b)){
-
-                    auto res_iter = res.begin();
-                    for(auto var=0; var<objective_.n_variables(); ++var){
-                        const auto dense_var = *res_iter;
-                        *res_iter = cc_node_labels[dense_var];
-                        //*res_iter = cc_node_labels[to_dense[ufd_.find(var)]];
-                        ++res_iter;
-                    }   
-
-                }
-                else if(e_a < e_b){
-                    std::copy(labels_a.begin(), labels_a.end(), res.begin());
-                }
-                else{
-                    std::copy(labels_b.begin(), labels_b.end(), res.begin());
-                }
-            });
-
-            return res;
-
+            std::vector<std::vector<uint64_t>> proposals(2);
+            detail_plmc::flattenLabels<DIM>(objective_.shape(), [&](const Coordinate & p){
+                return labels_a.element(p.begin(), p.end());
+            }, threadpool_, proposals[0]);
+            detail_plmc::flattenLabels<DIM>(objective_.shape(), [&](const Coordinate & p){
+                return labels_b.element(p.begin(), p.end());
+            }, threadpool_, proposals[1]);
+            return this->fuseProposals(proposals, std::vector<int>({1}));
         }
 
-
+        // labels: the proposals stacked along the last axis
         template<class D_LABELS>
         auto fuse(
             const xt::xexpression<D_LABELS>  & e_labels
         ){
-
-
-
-            ufd_.reset();
-
-            const auto & shape = objective_.shape();
-
-
-
-
-
-            typename xt::xtensor<uint64_t, DIM>::shape_type reshape{std::size_t(shape[0]), std::size_t(shape[1])};
-            auto res = xt::xtensor<uint64_t, DIM, xt::layout_type::row_major>(reshape);
-
-
-            this->merge_ufd2(e_labels);
-
-
-            // 
-           
-            this->_build_(res, [&](
-                const auto & cc_node_labels,
-                const auto & cc_energy
-            ){
-
-                const auto & labels = e_labels.derived_cast();
-                const auto n_proposals = labels.shape()[DIM];
-                auto best_e = std::numeric_limits<float>::infinity();
-                auto best_i = 0;
-
-                for(auto i=0; i<n_proposals; ++i){
-                    const auto l = xt::view(e_labels.derived_cast(),xt::all(), xt::all(),i);
-                    const auto e = objective_.evaluate(l);
-                    if(e < best_e){
-                        best_e = e;
-                        best_i = i;
-                    }
-                }
-                
-
-                if(cc_energy < best_e){//cc_energy < std::min(e_a, e_b)){
-                    
-                    auto res_iter = res.begin();
-                    for(auto var=0; var<objective_.n_variables(); ++var){
-                        const auto dense_var = *res_iter;
-                        *res_iter = cc_node_labels[dense_var];
-                        //*res_iter = cc_node_labels[to_dense[ufd_.find(var)]];
-                        ++res_iter;
-                    }   
-
-                }
-                else{
-                    const auto l = xt::view(e_labels.derived_cast(),xt::all(), xt::all(),best_i);
-                    std::copy(l.begin(), l.end(), res.begin());
-                }
-            });
-
-            return res;
-
+            return this->fuseCoarseToFine(e_labels, std::vector<int>({1}));
         }
 
-    private:
-
-
-        template<class D_LABELS_A, class D_LABELS_B>
-        auto merge_ufd(
-            const xt::xexpression<D_LABELS_A>  & e_labels_a,
-            const xt::xexpression<D_LABELS_B>  & e_labels_b
-        ){
-            const auto & shape = objective_.shape();
-            const auto & labels_a = e_labels_a.derived_cast();
-            const auto & labels_b = e_labels_b.derived_cast();
-
-            uint64_t node_p = 0;
-            for(int p0=0; p0<shape[0]; ++p0)
-            for(int p1=0; p1<shape[1]; ++p1){
-
-                const auto p_label_a = labels_a(p0, p1);
-                const auto p_label_b = labels_b(p0, p1);
-
-                if(p0 + 1 < shape[0]){
-                    const auto q_label_a = labels_a(p0+1, p1);
-                    const auto q_label_b = labels_b(p0+1, p1);
-                    if(p_label_a == q_label_a && p_label_b == q_label_b){
-                        const auto node_q = node_p + shape[1];
-                        ufd_.merge(node_p, node_q);
-                    }
-                }
-                if(p1 + 1 < shape[1]){
-                    const auto q_label_a = labels_a(p0, p1+1);
-                    const auto q_label_b = labels_b(p0, p1+1);
-                    if(p_label_a == q_label_a && p_label_b == q_label_b){
-                        const auto node_q = node_p + 1;
-                        ufd_.merge(node_p, node_q);
-                    }
-                }
-                ++node_p;
-            }
-        }
-
-
-
-
+        // labels: the proposals stacked along the last axis,
+        // factors: the downsampling factors of the levels, from coarse to fine
         template<class D_LABELS>
-        auto merge_ufd2(
-            const xt::xexpression<D_LABELS>  & e_labels
+        auto fuseCoarseToFine(
+            const xt::xexpression<D_LABELS>  & e_labels,
+            const std::vector<int> & factors
         ){
-            const auto & shape = objective_.shape();
             const auto & labels = e_labels.derived_cast();
-            const auto n_offsets = labels.shape()[DIM];
-
-            //const auto pview = xt::view(labels,0,0,xt::all());
-            //const auto bla = pview(0);
-
-            uint64_t node_p = 0;
-            for(int p0=0; p0<shape[0]; ++p0)
-            for(int p1=0; p1<shape[1]; ++p1){
-                if(p0 + 1 < shape[0]){
-                    bool do_merge = true;
-                    for(auto o=0; o<n_offsets; ++o){
-                        const auto p_label = labels(p0,  p1,o);
-                        const auto q_label = labels(p0+1,p1,o);
-                        if(p_label != q_label ){ 
-                            do_merge = false;
-                            break;
-                        }
-                    }
-                    if(do_merge){
-                        const auto node_q = node_p + shape[1];
-                        ufd_.merge(node_p, node_q);
-                    }
-                }
-                if(p1 + 1 < shape[1]){
-                    bool do_merge = true;
-                    for(auto o=0; o<n_offsets; ++o){
-                        const auto p_label = labels(p0, p1,  o);
-                        const auto q_label = labels(p0, p1+1,o);
-                        if(p_label != q_label ){ 
-                            do_merge = false;
-                            break;
-                        }
-                    }
-                    if(do_merge){
-                        const auto node_q = node_p + 1;
-                        ufd_.merge(node_p, node_q);
-                    }
-                }
-                ++node_p;
+            const std::size_t n_proposals = labels.shape()[DIM];
+            NIFTY_CHECK_OP(n_proposals, >, 0, "fusion needs at least one proposal");
+
+            std::vector<std::vector<uint64_t>> proposals(n_proposals);
+            for(std::size_t i = 0; i < n_proposals; ++i){
+                detail_plmc::flattenLabels<DIM>(objective_.shape(), [&](const Coordinate & p){
+                    std::array<int64_t, DIM + 1> pi;
+                    std::copy(p.begin(), p.end(), pi.begin());
+                    pi[DIM] = i;
+                    return labels.element(pi.begin(), pi.end());
+                }, threadpool_, proposals[i]);
             }
+            return this->fuseProposals(proposals, factors);
         }
 
+    private:
 
-
-        template<class F>
-        auto _build_(
-            xt::xtensor<uint64_t, DIM, xt::layout_type::row_major> & res,
-            F && f
+        LabelsType fuseProposals(
+            const std::vector<std::vector<uint64_t>> & proposals,
+            const std::vector<int> & factors
         ){
+            NIFTY_CHECK(!factors.empty(), "fusion needs at least one downsampling factor");
 
-
-            const auto & shape = objective_.shape();
-            const auto & offsets = objective_.offsets();
-            const auto & weights = objective_.weights();
-            const auto & n_offsets = objective_.n_offsets();
-            // const auto & labels_a = e_labels_a.derived_cast();
-            // const auto & labels_b = e_labels_b.derived_cast();
-
-
-            // make map dense   
-            const auto cc_n_variables = ufd_.numberOfSets();
-            boost::container::flat_map<uint64_t, uint64_t> to_dense;
-            ufd_.representativeLabeling(to_dense);
-            {
-                auto res_iter = res.begin();
-                for(auto var=0; var<objective_.n_variables(); ++var){
-                    *res_iter = to_dense[ufd_.find(var)];
-                    ++res_iter;
-                }   
-            }
-
-
-
-            
-            // build the normal graph
-            CCGraphType cc_graph(cc_n_variables);
-
-            uint64_t node_p = 0 ;
-            for(int p0=0; p0<shape[0]; ++p0)
-            for(int p1=0; p1<shape[1]; ++p1){
-
-                const auto p_label = ufd_.find(node_p);
-
-                if(p0 + 1 < shape[0]){
-                    const auto node_q = node_p + shape[1];
-                    const auto q_label = ufd_.find(node_q);
-                    if(p_label != q_label){
-                        cc_graph.insertEdge(to_dense[p_label],to_dense[q_label]);
-                    }
+            auto best_e = std::numeric_limits<double>::infinity();
+            std::size_t best_i = 0;
+            for(std::size_t i = 0; i < proposals.size(); ++i){
+                const auto e = detail_plmc::evaluate<DIM>(objective_, offsets_, proposals[i], threadpool_);
+                if(e < best_e){
+                    best_e = e;
+                    best_i = i;
                 }
-                if(p1 + 1 < shape[1]){
-                    const auto node_q = node_p + 1;
-                    const auto q_label = ufd_.find(node_q);
-                    if(p_label != q_label){
-                        cc_graph.insertEdge(to_dense[p_label],to_dense[q_label]);
-                    }
-                }
-                ++node_p;
             }
 
-            CCObjectiveType cc_obj(cc_graph);
-
-            node_p = 0 ;
-
-            // fill the lifted obj
-            for(int p0=0; p0<shape[0]; ++p0)
-            for(int p1=0; p1<shape[1]; ++p1){
-
-                const auto p_label = ufd_.find(node_p);
-
-                for(int offset_index=0; offset_index<n_offsets; ++offset_index){
-                    const int q0 = p0 + offsets(offset_index, 0);
-                    const int q1 = p1 + offsets(offset_index, 1);
-                    if(q0 >= 0 && q0 < shape[0]  && q1 >= 0 && q1 < shape[1]){
+            // the result of the previous level is an additional proposal
+            std::vector<uint64_t> current, res;
+            auto current_e = std::numeric_limits<double>::infinity();
+            bool has_current = false;
 
-                        const auto node_q = q0*shape[1] + q1;
-                        const auto q_label = ufd_.find(node_q);
-                        if(p_label != q_label){
-
-                            cc_obj.setCost(to_dense[p_label], to_dense[q_label], 
-                                weights(p0,p1,offset_index));
+            for(const auto factor : factors){
+                NIFTY_CHECK_OP(factor, >=, 1, "downsampling factors must be positive");
+                current_e = this->fuseClusters(factor, [&](const uint64_t p, const uint64_t q){
+                    if(has_current && current[p] != current[q]){
+                        return false;
+                    }
+                    for(const auto & proposal : proposals){
+                        if(proposal[p] != proposal[q]){
+                            return false;
                         }
                     }
-                }
-                ++node_p;
+                    return true;
+                },
+                has_current ? std::min(current_e, best_e) : best_e,
+                [&](std::vector<uint64_t> & best){
+                    best = has_current && current_e <= best_e ? current : proposals[best_i];
+                }, res);
+                current.swap(res);
+                has_current = true;
             }
 
-
-            auto solver = solver_fatory_->create(cc_obj);
-            CCNodeLabels cc_node_labels(cc_graph);
-
-
-            nifty::graph::opt::common::VerboseVisitor<CCBaseType> visitor;
-            solver->optimize(cc_node_labels, nullptr);
-            auto e_res = cc_obj.evalNodeLabels(cc_node_labels);
-            delete solver;  
-            f(cc_node_labels, e_res);
+            typename LabelsType::shape_type shape;
+            std::copy(objective_.shape().begin(), objective_.shape().end(), shape.begin());
+            LabelsType result(shape);
+            std::copy(current.begin(), current.end(), result.begin());
+            return result;
         }
 
-
-        const PixelWiseLmcObjective<DIM> & objective_;
-        nifty::ufd::Ufd<uint64_t> ufd_;
-        std::shared_ptr<CCLmcFactoryBase>  solver_fatory_;
-    };
-
-
-
-    template<>
-    class PixelWiseLmcConnetedComponentsFusion<3>
-    {
-    public:
-        static const std::size_t DIM = 3;
-
-
-
-        typedef nifty::graph::UndirectedGraph<>                 CCGraphType;
-        typedef LiftedMulticutObjective<CCGraphType, double >   CCObjectiveType;
-        typedef LiftedMulticutBase<CCObjectiveType>             CCBaseType;
-        typedef typename CCBaseType::VisitorBaseType            CVisitorBaseType;
-        typedef typename CCBaseType::NodeLabelsType             CCNodeLabels;
-        // factory for the lifted primal rounder
-        typedef nifty::graph::opt::common::SolverFactoryBase<CCBaseType> CCLmcFactoryBase;
-
-
-
-
-
-
-
-        PixelWiseLmcConnetedComponentsFusion(
-            const PixelWiseLmcObjective<DIM> & objective,
-            std::shared_ptr<CCLmcFactoryBase> solver_fatory
-        )
-        :   objective_(objective),
-            ufd_(objective.n_variables()),
-            solver_fatory_(solver_fatory)
-        {
-
+        template<class T, class COMP>
+        void sortEdges(std::vector<T> & edges, COMP comp){
+            parallel::parallelSort(threadpool_, edges.begin(), edges.end(), comp);
         }
 
-
-        struct  Settings
-        {
-            
-        };
-
-
-        
-
-        template<class D_LABELS_A, class D_LABELS_B>
-        auto fuse(
-            const xt::xexpression<D_LABELS_A>  & e_labels_a,
-            const xt::xexpression<D_LABELS_B>  & e_labels_b
+        // cluster the cells of the grid downsampled by factor, solve the lifted multicut
+        // problem of the clusters and write the result to res if its energy is
+        // smaller than best_e, otherwise writeBest(res) is called.
+        // Returns the energy of res.
+        template<class AGREE, class WRITE_BEST>
+        double fuseClusters(
+            const int factor,
+            AGREE && agree,
+            const double best_e,
+            WRITE_BEST && writeBest,
+            std::vector<uint64_t> & res
         ){
-
-            ufd_.reset();
-
             const auto & shape = objective_.shape();
-            const auto & labels_a = e_labels_a.derived_cast();
-            const auto & labels_b = e_labels_b.derived_cast();
-
-            typename xt::xtensor<int, DIM>::shape_type reshape{
-                std::size_t(shape[0]), 
-                std::size_t(shape[1]),
-                std::size_t(shape[2])
-            };
-            auto res = xt::xtensor<int, DIM, xt::layout_type::row_major>(reshape);
-
-
-            this->merge_ufd(e_labels_a, e_labels_b);
-
-            // 
-            auto e_a = objective_.evaluate(labels_a);
-            auto e_b = objective_.evaluate(labels_b);
-            this->_build_(res, [&](
-                const auto & cc_node_labels,
-                const auto & cc_energy
-            ){
-                if(cc_energy < std::min(e_a, e_b)){
-
-                    auto res_iter = res.begin();
-                    for(auto var=0; var<objective_.n_variables(); ++var){
-                        const auto dense_var = *res_iter;
-                        *res_iter = cc_node_labels[dense_var];
-                        //*res_iter = cc_node_labels[to_dense[ufd_.find(var)]];
-                        ++res_iter;
-                    }   
-
-                }
-                else if(e_a < e_b){
-                    std::copy(labels_a.begin(), labels_a.end(), res.begin());
-                }
-                else{
-                    std::copy(labels_b.begin(), labels_b.end(), res.begin());
-                }
-            });
-
-            return res;
-
-        }
-
-
-        template<class D_LABELS>
-        auto fuse(
-            const xt::xexpression<D_LABELS>  & e_labels
-        ){
-
-            //NIFTY_CHECK(false,"");
-
-            ufd_.reset();
-
-            const auto & shape = objective_.shape();
-            typename xt::xtensor<int, DIM>::shape_type reshape{
-                std::size_t(shape[0]), std::size_t(shape[1]),std::size_t(shape[2])
-            };
-            auto res = xt::xtensor<int, DIM, xt::layout_type::row_major>(reshape);
-
-
-            this->merge_ufd2(e_labels);
-
-
-            // 
-           
-            this->_build_(res, [&](
-                const auto & cc_node_labels,
-                const auto & cc_energy
-            ){
-
-                const auto & labels = e_labels.derived_cast();
-                const auto n_proposals = labels.shape()[DIM];
-                auto best_e = std::numeric_limits<float>::infinity();
-                auto best_i = 0;
-
-                for(auto i=0; i<n_proposals; ++i){
-                    const auto l = xt::view(e_labels.derived_cast(),xt::all(), xt::all(), xt::all(),i);
-                    const auto e = objective_.evaluate(l);
-                    if(e < best_e){
-                        best_e = e;
-                        best_i = i;
+            const auto n_offsets = objective_.n_offsets();
+            const auto * weights = objective_.weights().data();
+            const auto strides = detail_plmc::cOrderStrides<DIM>(shape);
+            const auto n_variables = objective_.n_variables();
+
+            // connected components of the cells
+            const auto cc_n_variables = detail_plmc::cellClusters<DIM>(shape, factor, agree, threadpool_, cellClusters_);
+            NIFTY_CHECK_OP(cc_n_variables, <, uint64_t(1) << 32, "too many connected components");
+
+            // the cluster of every pixel
+            Coordinate cellShape;
+            for(std::size_t d = 0; d < DIM; ++d){
+                cellShape[d] = (shape[d] + factor - 1) / factor;
+            }
+            const auto cellStrides = detail_plmc::cOrderStrides<DIM>(cellShape);
+            res.resize(n_variables);
+            auto * r = res.data();
+            parallel::parallel_foreach(threadpool_, shape[0], [&](const int tid, const int64_t p0){
+                detail_plmc::forEachPixelOfSlice<DIM>(shape, p0, [&](const uint64_t index, const Coordinate & p){
+                    uint64_t cell = 0;
+                    for(std::size_t d = 0; d < DIM; ++d){
+                        cell += (p[d] / factor) * cellStrides[d];
                     }
-                }
-                
-
-                if(cc_energy < best_e){//cc_energy < std::min(e_a, e_b)){
-                    
-                    auto res_iter = res.begin();
-                    for(auto var=0; var<objective_.n_variables(); ++var){
-                        const auto dense_var = *res_iter;
-                        *res_iter = cc_node_labels[dense_var];
-                        //*res_iter = cc_node_labels[to_dense[ufd_.find(var)]];
-                        ++res_iter;
-                    }   
-
-                }
-                else{
-                    const auto l = xt::view(e_labels.derived_cast(),xt::all(),xt::all(), xt::all(),best_i);
-                    std::copy(l.begin(), l.end(), res.begin());
-                }
+                    r[index] = cellClusters_[cell];
+                });
             });
 
-            return res;
-
-        }
-
-    private:
-
-
-        template<class D_LABELS_A, class D_LABELS_B>
-        auto merge_ufd(
-            const xt::xexpression<D_LABELS_A>  & e_labels_a,
-            const xt::xexpression<D_LABELS_B>  & e_labels_b
-        ){
-            const auto & shape = objective_.shape();
-            const auto & labels_a = e_labels_a.derived_cast();
-            const auto & labels_b = e_labels_b.derived_cast();
-
-            uint64_t node_p = 0;
-            for(int p0=0; p0<shape[0]; ++p0)
-            for(int p1=0; p1<shape[1]; ++p1)
-            for(int p2=0; p2<shape[2]; ++p2){
-
-                const auto p_label_a = labels_a(p0, p1, p2);
-                const auto p_label_b = labels_b(p0, p1, p2);
-
-                if(p0 + 1 < shape[0]){
-                    const auto q_label_a = labels_a(p0+1, p1, p2);
-                    const auto q_label_b = labels_b(p0+1, p1, p2);
-                    if(p_label_a == q_label_a && p_label_b == q_label_b){
-                        const auto node_q = node_p + shape[1]*shape[2];
-                        ufd_.merge(node_p, node_q);
-                    }
-                }
-                if(p1 + 1 < shape[1]){
-                    const auto q_label_a = labels_a(p0, p1+1, p2);
-                    const auto q_label_b = labels_b(p0, p1+1, p2);
-                    if(p_label_a == q_label_a && p_label_b == q_label_b){
-                        const auto node_q = node_p + shape[2];
-                        ufd_.merge(node_p, node_q);
-                    }
-                }
-                if(p2 + 1 < shape[2]){
-                    const auto q_label_a = labels_a(p0, p1, p2+1);
-                    const auto q_label_b = labels_b(p0, p1, p2+1);
-                    if(p_label_a == q_label_a && p_label_b == q_label_b){
-                        const auto node_q = node_p + 1;
-                        ufd_.merge(node_p, node_q);
-                    }
-                }
-                ++node_p;
-            }
-        }
-
-
-
-
-        template<class D_LABELS>
-        auto merge_ufd2(
-            const xt::xexpression<D_LABELS>  & e_labels
-        ){
-            //NIFTY_CHECK(false,"");
-            const auto & shape = objective_.shape();
-            const auto & labels = e_labels.derived_cast();
-            const auto n_offsets = labels.shape()[DIM];
-
-            //const auto pview = xt::view(labels,0,0,xt::all());
-            //const auto bla = pview(0);
-
-            uint64_t node_p = 0;
-            for(int p0=0; p0<shape[0]; ++p0)
-            for(int p1=0; p1<shape[1]; ++p1)
-            for(int p2=0; p2<shape[2]; ++p2){
-
-                if(p0 + 1 < shape[0]){
-                    bool do_merge = true;
-                    for(auto o=0; o<n_offsets; ++o){
-                        const auto p_label = labels(p0,  p1, p2, o);
-                        const auto q_label = labels(p0+1,p1, p2, o);
-                        if(p_label != q_label ){ 
-                            do_merge = false;
-                            break;
+            // the edges and lifted edges between the clusters of every slice as keys
+            // u * cc_n_variables + v with u < v, consecutive pixels often
+            // link the same clusters and are summed up right away
+            typedef std::pair<uint64_t, double> WeightedEdge;
+            std::vector<std::vector<uint64_t>> sliceEdges(shape[0]);
+            std::vector<std::vector<WeightedEdge>> sliceLiftedEdges(shape[0]);
+            auto edgeKey = [&](const uint64_t u, const uint64_t v){
+                return u < v ? u * cc_n_variables + v : v * cc_n_variables + u;
+            };
+            parallel::parallel_foreach(threadpool_, shape[0], [&](const int tid, const int64_t p0){
+                auto & edges = sliceEdges[p0];
+                auto & liftedEdges = sliceLiftedEdges[p0];
+                detail_plmc::forEachPixelOfSlice<DIM>(shape, p0, [&](const uint64_t index, const Coordinate & p){
+                    const auto u = r[index];
+                    for(std::size_t d = 0; d < DIM; ++d){
+                        if(p[d] + 1 < shape[d]){
+                            const auto v = r[index + strides[d]];
+                            if(u != v){
+                                const auto key = edgeKey(u, v);
+                                if(edges.empty() || edges.back() != key){
+                                    edges.push_back(key);
+                                }
+                            }
                         }
                     }
-                    if(do_merge){
-                        const auto node_q = node_p + shape[2];
-                        ufd_.merge(node_p, node_q);
-                    }
-                }
-                if(p1 + 1 < shape[1]){
-                    bool do_merge = true;
-                    for(auto o=0; o<n_offsets; ++o){
-                        const auto p_label = labels(p0, p1,   p2, o);
-                        const auto q_label = labels(p0, p1+1, p2, o);
-                        if(p_label != q_label ){ 
-                            do_merge = false;
-                            break;
+                    for(std::size_t offset_index = 0; offset_index < n_offsets; ++offset_index){
+                        if(!offsets_.inside(shape, offset_index, p)){
+                            continue;
                         }
-                    }
-                    if(do_merge){
-                        const auto node_q = node_p + 1;
-                        ufd_.merge(node_p, node_q);
-                    }
-                }
-                if(p2 + 1 < shape[2]){
-                    bool do_merge = true;
-                    for(auto o=0; o<n_offsets; ++o){
-                        const auto p_label = labels(p0, p1,   p2, o);
-                        const auto q_label = labels(p0, p1+1, p2, o);
-                        if(p_label != q_label ){ 
-                            do_merge = false;
-                            break;
+                        const auto v = r[index + offsets_.deltas[offset_index]];
+                        if(u == v){
+                            continue;
+                        }
+                        const auto key = edgeKey(u, v);
+                        const double w = weights[index * n_offsets + offset_index];
+                        if(!liftedEdges.empty() && liftedEdges.back().first == key){
+                            liftedEdges.back().second += w;
+                        }
+                        else{
+                            liftedEdges.emplace_back(key, w);
                         }
                     }
-                    if(do_merge){
-                        const auto node_q = node_p + 1;
-                        ufd_.merge(node_p, node_q);
-                    }
-                }
-                ++node_p;
-            }
-        }
-
-
-
-        template<class F>
-        auto _build_(
-            xt::xtensor<int, DIM, xt::layout_type::row_major> & res,
-            F && f
-        ){
-
+                });
+            });
 
-            const auto & shape = objective_.shape();
-            const auto & offsets = objective_.offsets();
-            const auto & weights = objective_.weights();
-            const auto & n_offsets = objective_.n_offsets();
-
-            // make map dense   
-            const auto cc_n_variables = ufd_.numberOfSets();
-            boost::container::flat_map<uint64_t, uint64_t> to_dense;
-            ufd_.representativeLabeling(to_dense);
-            {
-                auto res_iter = res.begin();
-                for(auto var=0; var<objective_.n_variables(); ++var){
-                    *res_iter = to_dense[ufd_.find(var)];
-                    ++res_iter;
-                }   
+            std::vector<uint64_t> cc_edges;
+            std::vector<WeightedEdge> cc_lifted_edges;
+            for(int64_t p0 = 0; p0 < shape[0]; ++p0){
+                cc_edges.insert(cc_edges.end(), sliceEdges[p0].begin(), sliceEdges[p0].end());
+                cc_lifted_edges.insert(cc_lifted_edges.end(), sliceLiftedEdges[p0].begin(), sliceLiftedEdges[p0].end());
+                std::vector<uint64_t>().swap(sliceEdges[p0]);
+                std::vector<WeightedEdge>().swap(sliceLiftedEdges[p0]);
             }
+            this->sortEdges(cc_edges, std::less<uint64_t>());
+            cc_edges.erase(std::unique(cc_edges.begin(), cc_edges.end()), cc_edges.end());
+            this->sortEdges(cc_lifted_edges, [](const WeightedEdge & a, const WeightedEdge & b){
+                return a.first < b.first;
+            });
 
-
-            
-            // build the normal graph
-            CCGraphType cc_graph(cc_n_variables);
-
-            uint64_t node_p = 0 ;
-            for(int p0=0; p0<shape[0]; ++p0)
-            for(int p1=0; p1<shape[1]; ++p1)
-            for(int p2=0; p2<shape[2]; ++p2)
-            {
-
-                const auto p_label = ufd_.find(node_p);
-
-                if(p0 + 1 < shape[0]){
-                    const auto node_q = node_p + shape[1]*shape[2];
-                    const auto q_label = ufd_.find(node_q);
-                    if(p_label != q_label){
-                        cc_graph.insertEdge(to_dense[p_label],to_dense[q_label]);
-                    }
+            // sum up the weights of parallel lifted edges in place
+            std::size_t n_lifted_edges = 0;
+            for(std::size_t i = 0; i < cc_lifted_edges.size(); ++i){
+                if(n_lifted_edges > 0 && cc_lifted_edges[n_lifted_edges - 1].first == cc_lifted_edges[i].first){
+                    cc_lifted_edges[n_lifted_edges - 1].second += cc_lifted_edges[i].second;
                 }
-                if(p1 + 1 < shape[1]){
-                    const auto node_q = node_p + shape[2];
-                    const auto q_label = ufd_.find(node_q);
-                    if(p_label != q_label){
-                        cc_graph.insertEdge(to_dense[p_label],to_dense[q_label]);
-                    }
-                }
-                if(p2 + 1 < shape[2]){
-                    const auto node_q = node_p + 1;
-                    const auto q_label = ufd_.find(node_q);
-                    if(p_label != q_label){
-                        cc_graph.insertEdge(to_dense[p_label],to_dense[q_label]);
-                    }
+                else{
+                    cc_lifted_edges[n_lifted_edges++] = cc_lifted_edges[i];
                 }
-                ++node_p;
             }
+            cc_lifted_edges.resize(n_lifted_edges);
 
-            CCObjectiveType cc_obj(cc_graph);
-
-            node_p = 0 ;
-
-            // fill the lifted obj
-            for(int p0=0; p0<shape[0]; ++p0)
-            for(int p1=0; p1<shape[1]; ++p1)
-            for(int p2=0; p2<shape[1]; ++p2)
-            {
-
-                const auto p_label = ufd_.find(node_p);
-
-                for(int offset_index=0; offset_index<n_offsets; ++offset_index){
-                    const int q0 = p0 + offsets(offset_index, 0);
-                    const int q1 = p1 + offsets(offset_index, 1);
-                    const int q2 = p2 + offsets(offset_index, 2);
-                    if( q0 >= 0 && q0 < shape[0] && 
-                        q1 >= 0 && q1 < shape[1] &&
-                        q2 >= 0 && q2 < shape[2]
-                    ){
-
-                        const auto node_q = q0*shape[1]*shape[2] + q1*shape[2] + q2;
-                        const auto q_label = ufd_.find(node_q);
-                        if(p_label != q_label){
-
-                            cc_obj.setCost(to_dense[p_label], to_dense[q_label], 
-                                weights(p0,p1,p2,offset_index));
-                        }
-                    }
-                }
-                ++node_p;
+            // the edges are sorted, so the adjacencies are filled by appending
+            CCGraphType cc_graph(cc_n_variables, cc_edges.size());
+            for(const auto key : cc_edges){
+                cc_graph.insertEdge(key / cc_n_variables, key % cc_n_variables);
+            }
+            CCObjectiveType cc_obj(cc_graph, n_lifted_edges - std::min(n_lifted_edges, cc_edges.size()));
+            for(const auto & e : cc_lifted_edges){
+                cc_obj.setCost(e.first / cc_n_variables, e.first % cc_n_variables, e.second, false);
             }
-
 
             auto solver = solver_fatory_->create(cc_obj);
             CCNodeLabels cc_node_labels(cc_graph);
-
-
-            nifty::graph::opt::common::VerboseVisitor<CCBaseType> visitor;
-
-
             solver->optimize(cc_node_labels, nullptr);
-            auto e_res = cc_obj.evalNodeLabels(cc_node_labels);
-            delete solver;  
-            f(cc_node_labels, e_res);
-        }
+            const auto cc_e = cc_obj.evalNodeLabels(cc_node_labels);
+            delete solver;
 
+            if(cc_e < best_e){
+                parallel::parallel_foreach(threadpool_, n_variables, [&](const int tid, const int64_t index){
+                    r[index] = cc_node_labels[r[index]];
+                });
+                return cc_e;
+            }
+            writeBest(res);
+            return best_e;
+        }
 
         const PixelWiseLmcObjective<DIM> & objective_;
-        nifty::ufd::Ufd<uint64_t> ufd_;
         std::shared_ptr<CCLmcFactoryBase>  solver_fatory_;
+        parallel::ParallelOptions parallelOptions_;
+        parallel::ThreadPool threadpool_;
+        detail_plmc::Offsets<DIM> offsets_;
+        std::vector<uint64_t> cellClusters_;
     };
 
 
 
 
-
 } // namespace lifted_multicut
 } // namespace nifty::graph::opt
 } // namespace nifty::graph
@@ -1,6 +1,7 @@
 
 #pragma once
 
+#include <random>
 #include <vector>
 
 #include "nifty/graph/opt/lifted_multicut/lifted_multicut_base.hxx"
@@ -53,10 +54,10 @@ namespace lifted_multicut{
             negativeEdges_(),
             graphEdgeWeights_(objective.graph()),
             gens_(numberOfThreads_),
-            dist_(0.0, settings.sigma),
+            dists_(numberOfThreads_, std::normal_distribution<>(0.0, settings.sigma)),
             intDist_()
         {
-            // use thread index as seed
+            // use thread index as seed, every thread has its own random stream
             for(auto i=0; i<numberOfThreads_; ++i)
                 gens_[i] = std::mt19937(i);
 
@@ -135,6 +136,9 @@ namespace lifted_multicut{
                 const auto & graph = objective_.graph();
                 const auto & liftedGraph = objective_.liftedGraph();
                 auto & gen = gens_[tid];
+                auto & dist = dists_[tid];
+                // copy, the distribution is not thread safe
+                auto intDist = intDist_;
 
                 EdgeWeights noisyEdgeWeights(graph);
                 NodeLabelsType  seeds(graph, 0);
@@ -148,12 +152,12 @@ namespace lifted_multicut{
 
 
                 graph.forEachEdge([&](const uint64_t edge){
-                    noisyEdgeWeights[edge] = graphEdgeWeights_[edge] + dist_(gen);
+                    noisyEdgeWeights[edge] = graphEdgeWeights_[edge] + dist(gen);
                 });
 
 
                 for(std::size_t i=0; i <  (nSeeds == 1 ? 1 : nSeeds/2); ++i){
-                    const auto randIndex = intDist_(gen);
+                    const auto randIndex = intDist(gen);
                     const auto edge  = negativeEdges_[randIndex];
                     const auto uv = liftedGraph.uv(edge);
           
@@ -175,8 +179,9 @@ namespace lifted_multicut{
         EdgeWeights graphEdgeWeights_;
 
 
+        // one generator and normal distribution per thread
         std::vector<std::mt19937> gens_;
-        std::normal_distribution<> dist_;
+        std::vector<std::normal_distribution<> > dists_;
         std::uniform_int_distribution<>  intDist_;
 
         
@@ -3,6 +3,7 @@
 #include "nifty/tools/runtime_check.hxx"
 #include "nifty/graph/subgraph_mask.hxx"
 #include "nifty/graph/graph_maps.hxx"
+#include "nifty/graph/opt/common/eval_node_labels.hxx"
 
 namespace nifty{
 namespace graph{
@@ -17,18 +18,9 @@ namespace mincut{
         typedef MincutObjectiveBase<ChildObjective, GRAPH, WEIGHT_TYPE> Self;
 
         template<class NODE_LABELS>
-        WEIGHT_TYPE evalNodeLabels(const NODE_LABELS & nodeLabels)const{
-            WEIGHT_TYPE sum = static_cast<WEIGHT_TYPE>(0.0);
-            const auto & w = _child().weights();
-            const auto & g = _child().graph();
-            for(const auto edge: g.edges()){
-                const auto uv = g.uv(edge);
-
-                if(nodeLabels[uv.first] != nodeLabels[uv.second]){
-                    sum += w[edge];
-                }
-            }
-            return sum;
+        WEIGHT_TYPE evalNodeLabels(const NODE_LABELS & nodeLabels, const int numberOfThreads = 1)const{
+            return common::cutWeight<WEIGHT_TYPE>(_child().graph(), _child().weights(),
+                                                  nodeLabels, numberOfThreads);
         }
     private:
         ChildObjective & _child(){
@@ -3,6 +3,7 @@
 #include "nifty/tools/runtime_check.hxx"
 #include "nifty/graph/subgraph_mask.hxx"
 #include "nifty/graph/graph_maps.hxx"
+#include "nifty/graph/opt/common/eval_node_labels.hxx"
 
 namespace nifty{
 namespace graph{
@@ -17,19 +18,12 @@ namespace minstcut{
         typedef MinstcutObjectiveBase<ChildObjective, GRAPH, WEIGHT_TYPE> Self;
 
         template<class NODE_LABELS>
-        WEIGHT_TYPE evalNodeLabels(const NODE_LABELS & nodeLabels)const{
-            WEIGHT_TYPE sum = static_cast<WEIGHT_TYPE>(0.0);
-            const auto & w = _child().weights();
+        WEIGHT_TYPE evalNodeLabels(const NODE_LABELS & nodeLabels, const int numberOfThreads = 1)const{
             const auto & g = _child().graph();
             const auto & u = _child().unaries();
 
-            for(const auto edge: g.edges()){
-                const auto uv = g.uv(edge);
-
-                if(nodeLabels[uv.first] != nodeLabels[uv.second]){
-                    sum += w[edge];
-                }
-            }
+            WEIGHT_TYPE sum = common::cutWeight<WEIGHT_TYPE>(g, _child().weights(),
+                                                             nodeLabels, numberOfThreads);
             for(auto node : g.nodes()){
                 const auto l = nodeLabels[node];
                 const auto & costPair = u[node];
@@ -1,15 +1,22 @@
 #pragma once
 
+#include <algorithm>
+#include <limits>
+#include <memory>
+#include <numeric>
+#include <string>
+#include <tuple>
+#include <vector>
 
 #include "nifty/tools/runtime_check.hxx"
+#include "nifty/parallel/threadpool.hxx"
+#include "nifty/ufd/ufd.hxx"
 
 #include "nifty/graph/opt/multicut/multicut_base.hxx"
-#include "nifty/graph/opt/multicut/multicut_factory.hxx"
+#include "nifty/graph/opt/common/solver_factory.hxx"
 #include "nifty/graph/opt/multicut/multicut_objective.hxx"
-
-
-
-
+#include "nifty/graph/opt/multicut/multicut_contraction.hxx"
+#include "nifty/graph/undirected_list_graph.hxx"
 
 
 namespace nifty{
@@ -17,102 +24,318 @@ namespace graph{
 namespace opt{
 namespace multicut{
 
-   
-
 
+    /// Hierarchical block-wise multicut.
+    ///
+    /// The nodes of the graph are partitioned into connected blocks of
+    /// at most blockSize nodes (grown by breadth first search).
+    /// The sub-multicuts on the edges inside of the blocks are solved in parallel,
+    /// the graph is contracted with the block solutions and the procedure is
+    /// repeated on the reduced graph until it has at most numberOfNodesStop
+    /// nodes or the block solutions do not reduce it anymore.
+    /// The reduced graph is then solved as a whole.
+    /// Clusters are never split on a coarser level, so the block solutions
+    /// are only a (good) restriction of the global problem.
+    ///
     template<class OBJECTIVE>
     class BlockMulticut : public MulticutBase<OBJECTIVE>
     {
-    public: 
+    public:
 
         typedef OBJECTIVE ObjectiveType;
         typedef typename ObjectiveType::WeightType WeightType;
-        typedef MulticutBase<ObjectiveType> BaseType;
+        typedef MulticutBase<OBJECTIVE> BaseType;
         typedef typename BaseType::VisitorBaseType VisitorBaseType;
-        typedef typename BaseType::VisitorProxy VisitorProxy;
-        typedef typename BaseType::EdgeLabels EdgeLabels;
+        typedef typename BaseType::VisitorProxyType VisitorProxyType;
         typedef typename BaseType::NodeLabelsType NodeLabelsType;
         typedef typename ObjectiveType::GraphType GraphType;
-        typedef typename ObjectiveType::GraphType GraphType;
         typedef typename ObjectiveType::WeightsMap WeightsMap;
-        typedef typename GraphType:: template EdgeMap<uint8_t> IsDirtyEdge;
-
-
-        typedef MulticutFactoryBase<ObjectiveType>  McFactoryBase;
 
+    public:
+        typedef UndirectedGraph<>                                                      SubmodelGraph;
+        typedef MulticutObjective<SubmodelGraph, WeightType>                           SubmodelObjective;
+        typedef MulticutBase<SubmodelObjective>                                        SubmodelMulticutBaseType;
+        typedef nifty::graph::opt::common::SolverFactoryBase<SubmodelMulticutBaseType> SubmodelFactoryBase;
+        typedef typename SubmodelMulticutBaseType::NodeLabelsType                      SubmodelNodeLabels;
 
-    
     public:
 
         struct SettingsType{
-            std::shared_ptr<McFactoryBase> multicutFactory;
+            // solver for the sub-multicuts of the blocks
+            std::shared_ptr<SubmodelFactoryBase> submodelFactory;
+            // solver for the final reduced problem, the submodelFactory is used if empty
+            std::shared_ptr<SubmodelFactoryBase> reducedProblemFactory;
+            // maximum number of nodes in a block
+            uint64_t blockSize{1000};
+            // solve the reduced problem as a whole once it has at most this many nodes
+            uint64_t numberOfNodesStop{1000};
+            // stop the hierarchy if a level removes less than this fraction of the nodes
+            double minimumReduction{0.01};
+            int numberOfLevels{100};
+            int numberOfThreads{-1};
         };
 
         virtual ~BlockMulticut(){
-            
+
         }
         BlockMulticut(const ObjectiveType & objective, const SettingsType & settings = SettingsType());
 
 
-        virtual void optimize(NodeLabels & nodeLabels, VisitorBaseType * visitor);
+        virtual void optimize(NodeLabelsType & nodeLabels, VisitorBaseType * visitor);
         virtual const ObjectiveType & objective() const;
 
 
-        virtual const NodeLabels & currentBestNodeLabels( ){
+        virtual const NodeLabelsType & currentBestNodeLabels( ){
             return *currentBest_;
         }
 
         virtual std::string name()const{
             return std::string("BlockMulticut");
         }
-        virtual void weightsChanged(){ 
-        }
-        virtual double currentBestEnergy() {
-           return currentBestEnergy_;
+        virtual void weightsChanged(){
         }
+
     private:
 
+        // a contracted problem and the cluster of every node of the previous level
+        typedef ContractedMulticutProblem<WeightType> Level;
+
+        template<class GRAPH, class WEIGHTS>
+        uint64_t solveBlocks(const GRAPH & graph, const WEIGHTS & weights,
+                             const uint64_t blockSize,
+                             parallel::ThreadPool & threadpool,
+                             std::vector<uint64_t> & nodeToCluster);
 
         const ObjectiveType & objective_;
+        const GraphType & graph_;
+        const WeightsMap & weights_;
+        NodeLabelsType * currentBest_;
+
         SettingsType settings_;
-        NodeLabels * currentBest_;
-        double currentBestEnergy_;
-    
     };
 
-    
+
     template<class OBJECTIVE>
     BlockMulticut<OBJECTIVE>::
     BlockMulticut(
-        const ObjectiveType & objective, 
+        const ObjectiveType & objective,
         const SettingsType & settings
     )
     :   objective_(objective),
-        settings_(settings),
+        graph_(objective.graph()),
+        weights_(objective.weights()),
         currentBest_(nullptr),
-        currentBestEnergy_(std::numeric_limits<double>::infinity())
+        settings_(settings)
     {
-
+        if(!bool(settings_.submodelFactory)){
+            throw std::runtime_error("BlockMulticut SettingsType: submodelFactory may not be empty!");
+        }
+        if(!bool(settings_.reducedProblemFactory)){
+            settings_.reducedProblemFactory = settings_.submodelFactory;
+        }
+        NIFTY_CHECK_OP(settings_.blockSize, >=, 2, "BlockMulticut: blockSize must be at least 2");
     }
 
     template<class OBJECTIVE>
     void BlockMulticut<OBJECTIVE>::
     optimize(
-        NodeLabels & nodeLabels,  VisitorBaseType * visitor
-    ){  
-
-
-        
-        VisitorProxy visitorProxy(visitor);
+        NodeLabelsType & nodeLabels,  VisitorBaseType * visitor
+    ){
+        VisitorProxyType visitorProxy(visitor);
         currentBest_ = &nodeLabels;
-        currentBestEnergy_ = objective_.evalNodeLabels(nodeLabels);
-        
         visitorProxy.begin(this);
 
-  
+        parallel::ThreadPool threadpool(settings_.numberOfThreads);
+
+        // solve the blocks and contract the graph level by level
+        std::vector<Level> levels;
+        uint64_t numberOfNodes = graph_.numberOfNodes();
+        for(int l = 0; l < settings_.numberOfLevels && numberOfNodes > settings_.numberOfNodesStop; ++l){
+            levels.emplace_back();
+            auto & level = levels.back();
+            uint64_t numberOfClusters;
+            if(l == 0){
+                numberOfClusters = solveBlocks(graph_, weights_, settings_.blockSize, threadpool, level.nodeToCluster);
+                contractMulticutProblem(graph_, weights_, numberOfClusters, level);
+            }
+            else{
+                const auto & previous = levels[l - 1];
+                numberOfClusters = solveBlocks(*previous.graph, previous.objective->weights(),
+                                               settings_.blockSize, threadpool, level.nodeToCluster);
+                contractMulticutProblem(*previous.graph, previous.objective->weights(), numberOfClusters, level);
+            }
+
+            visitorProxy.printLog(nifty::logging::LogLevel::INFO,
+                std::string("level ") + std::to_string(l) + std::string(": ") +
+                std::to_string(numberOfNodes) + std::string(" -> ") +
+                std::to_string(numberOfClusters) + std::string(" nodes"));
+
+            // the block solutions have converged, solve what is left as a whole
+            const bool converged = double(numberOfNodes - numberOfClusters) <
+                                   settings_.minimumReduction * double(numberOfNodes);
+            numberOfNodes = numberOfClusters;
+            if(converged || !visitorProxy.visit(this)){
+                break;
+            }
+        }
+
+        // solve the reduced problem as a whole
+        std::vector<uint64_t> labels;
+        if(levels.empty()){
+            // the input is small enough: solve it on a copy
+            Level level;
+            std::vector<uint64_t> identity(graph_.nodeIdUpperBound() + 1);
+            std::iota(identity.begin(), identity.end(), 0);
+            level.nodeToCluster = identity;
+            contractMulticutProblem(graph_, weights_, identity.size(), level);
+            levels.push_back(std::move(level));
+        }
+        {
+            const auto & top = levels.back();
+            SubmodelNodeLabels topLabels(*top.graph);
+            std::unique_ptr<SubmodelMulticutBaseType> solver(
+                settings_.reducedProblemFactory->create(*top.objective));
+            solver->optimize(topLabels, nullptr);
+            labels.assign(topLabels.begin(), topLabels.end());
+        }
+
+        // project the solution down to the input graph
+        for(auto l = levels.size(); l-- > 0;){
+            const auto & nodeToCluster = levels[l].nodeToCluster;
+            std::vector<uint64_t> finer(nodeToCluster.size());
+            for(std::size_t node = 0; node < nodeToCluster.size(); ++node){
+                finer[node] = labels[nodeToCluster[node]];
+            }
+            labels.swap(finer);
+        }
+        graph_.forEachNode([&](const uint64_t node){
+            nodeLabels[node] = labels[node];
+        });
+
         visitorProxy.end(this);
     }
 
+    // grow connected blocks with a breadth first search, solve the
+    // sub-multicuts on their inner edges in parallel and assign a dense
+    // cluster id to every node (connected components of the block solutions)
+    template<class OBJECTIVE>
+    template<class GRAPH, class WEIGHTS>
+    uint64_t BlockMulticut<OBJECTIVE>::
+    solveBlocks(
+        const GRAPH & graph,
+        const WEIGHTS & weights,
+        const uint64_t blockSize,
+        parallel::ThreadPool & threadpool,
+        std::vector<uint64_t> & nodeToCluster
+    ){
+        const uint64_t nodeBound = graph.nodeIdUpperBound() + 1;
+        const uint64_t noBlock = std::numeric_limits<uint64_t>::max();
+
+        // partition the nodes, within a block the nodes are in bfs order
+        std::vector<uint64_t> blockOfNode(nodeBound, noBlock);
+        std::vector<uint64_t> localIndex(nodeBound);
+        std::vector<std::vector<uint64_t>> blocks;
+        graph.forEachNode([&](const uint64_t seed){
+            if(blockOfNode[seed] != noBlock){
+                return;
+            }
+            const uint64_t blockId = blocks.size();
+            blocks.emplace_back();
+            auto & blockNodes = blocks.back();
+            blockOfNode[seed] = blockId;
+            localIndex[seed] = 0;
+            blockNodes.push_back(seed);
+            for(std::size_t i = 0; i < blockNodes.size() && blockNodes.size() < blockSize; ++i){
+                for(const auto adj : graph.adjacency(blockNodes[i])){
+                    const uint64_t other = adj.node();
+                    if(blockOfNode[other] == noBlock){
+                        blockOfNode[other] = blockId;
+                        localIndex[other] = blockNodes.size();
+                        blockNodes.push_back(other);
+                        if(blockNodes.size() == blockSize){
+                            break;
+                        }
+                    }
+                }
+            }
+        });
+
+        // solve the blocks, the largest ones first
+        const uint64_t nBlocks = blocks.size();
+        std::vector<uint64_t> blockOrder(nBlocks);
+        std::iota(blockOrder.begin(), blockOrder.end(), 0);
+        std::sort(blockOrder.begin(), blockOrder.end(), [&](const uint64_t a, const uint64_t b){
+            return blocks[a].size() > blocks[b].size();
+        });
+
+        std::vector<std::vector<uint64_t>> blockClusters(nBlocks);
+        std::vector<uint64_t> numberOfBlockClusters(nBlocks + 1, 0);
+        parallel::parallel_foreach(threadpool, nBlocks, [&](const int tid, const int64_t i){
+            const auto blockId = blockOrder[i];
+            const auto & blockNodes = blocks[blockId];
+            const uint64_t nSubNodes = blockNodes.size();
+            auto & clusters = blockClusters[blockId];
+            clusters.resize(nSubNodes);
+
+            // the inner edges of the block
+            std::vector<std::tuple<uint64_t, uint64_t, WeightType>> subEdges;
+            for(uint64_t u = 0; u < nSubNodes; ++u){
+                for(const auto adj : graph.adjacency(blockNodes[u])){
+                    const uint64_t other = adj.node();
+                    if(blockOfNode[other] == blockId && localIndex[other] > u){
+                        subEdges.emplace_back(u, localIndex[other], weights[adj.edge()]);
+                    }
+                }
+            }
+
+            ufd::Ufd<uint64_t> ufd(nSubNodes);
+            if(!subEdges.empty()){
+                SubmodelGraph subGraph(nSubNodes, subEdges.size());
+                for(const auto & e : subEdges){
+                    subGraph.insertEdge(std::get<0>(e), std::get<1>(e));
+                }
+                SubmodelObjective subObj(subGraph);
+                auto & subWeights = subObj.weights();
+                for(std::size_t e = 0; e < subEdges.size(); ++e){
+                    subWeights[e] = std::get<2>(subEdges[e]);
+                }
+
+                SubmodelNodeLabels subLabels(subGraph);
+                std::unique_ptr<SubmodelMulticutBaseType> subSolver(settings_.submodelFactory->create(subObj));
+                subSolver->optimize(subLabels, nullptr);
+
+                // merge along uncut edges only, so that clusters are connected
+                for(const auto & e : subEdges){
+                    const auto u = std::get<0>(e);
+                    const auto v = std::get<1>(e);
+                    if(subLabels[u] == subLabels[v]){
+                        ufd.merge(u, v);
+                    }
+                }
+            }
+            std::vector<uint64_t> rootLabel(nSubNodes, noBlock);
+            uint64_t nClusters = 0;
+            for(uint64_t u = 0; u < nSubNodes; ++u){
+                auto & label = rootLabel[ufd.find(u)];
+                if(label == noBlock){
+                    label = nClusters++;
+                }
+                clusters[u] = label;
+            }
+            numberOfBlockClusters[blockId + 1] = nClusters;
+        });
+
+        // global dense cluster ids
+        std::partial_sum(numberOfBlockClusters.begin(), numberOfBlockClusters.end(),
+                         numberOfBlockClusters.begin());
+        nodeToCluster.assign(nodeBound, 0);
+        graph.forEachNode([&](const uint64_t node){
+            const auto blockId = blockOfNode[node];
+            nodeToCluster[node] = numberOfBlockClusters[blockId] + blockClusters[blockId][localIndex[node]];
+        });
+        return numberOfBlockClusters.back();
+    }
+
     template<class OBJECTIVE>
     const typename BlockMulticut<OBJECTIVE>::ObjectiveType &
     BlockMulticut<OBJECTIVE>::
@@ -125,4 +348,3 @@ namespace multicut{
 } // namespace nifty::graph::opt
 } // namespace nifty::graph
 } // namespace nifty
-
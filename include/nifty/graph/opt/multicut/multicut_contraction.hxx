@@ -0,0 +1,88 @@
+#pragma once
+
+#include <algorithm>
+#include <memory>
+#include <tuple>
+#include <vector>
+
+#include "nifty/graph/opt/multicut/multicut_objective.hxx"
+#include "nifty/graph/undirected_list_graph.hxx"
+
+
+namespace nifty{
+namespace graph{
+namespace opt{
+namespace multicut{
+
+
+    /// A multicut problem contracted with a clustering of the nodes
+    /// of a finer problem: the clusters are the nodes and the weights
+    /// of parallel edges are summed up.
+    template<class WEIGHT_TYPE>
+    struct ContractedMulticutProblem{
+        typedef UndirectedGraph<>                           GraphType;
+        typedef MulticutObjective<GraphType, WEIGHT_TYPE>   ObjectiveType;
+
+        std::unique_ptr<GraphType> graph;
+        std::unique_ptr<ObjectiveType> objective;
+        // the cluster of every node of the finer problem
+        std::vector<uint64_t> nodeToCluster;
+    };
+
+
+    /// Contract graph with the clusters in problem.nodeToCluster
+    /// (dense ids in [0, numberOfClusters)) into problem.graph / problem.objective.
+    template<class GRAPH, class WEIGHTS, class WEIGHT_TYPE>
+    void contractMulticutProblem(
+        const GRAPH & graph,
+        const WEIGHTS & weights,
+        const uint64_t numberOfClusters,
+        ContractedMulticutProblem<WEIGHT_TYPE> & problem
+    ){
+        typedef ContractedMulticutProblem<WEIGHT_TYPE> ProblemType;
+        const auto & nodeToCluster = problem.nodeToCluster;
+        std::vector<std::tuple<uint64_t, uint64_t, WEIGHT_TYPE>> edges;
+        edges.reserve(graph.numberOfEdges());
+        graph.forEachEdge([&](const uint64_t edge){
+            const auto uv = graph.uv(edge);
+            const auto cu = nodeToCluster[uv.first];
+            const auto cv = nodeToCluster[uv.second];
+            if(cu != cv){
+                edges.emplace_back(std::min(cu, cv), std::max(cu, cv), weights[edge]);
+            }
+        });
+        std::sort(edges.begin(), edges.end(), [](const auto & a, const auto & b){
+            return std::get<0>(a) < std::get<0>(b) ||
+                (std::get<0>(a) == std::get<0>(b) && std::get<1>(a) < std::get<1>(b));
+        });
+
+        // sum up parallel edges in place
+        std::size_t nEdges = 0;
+        for(std::size_t i = 0; i < edges.size(); ++i){
+            if(nEdges > 0 && std::get<0>(edges[nEdges - 1]) == std::get<0>(edges[i]) &&
+                             std::get<1>(edges[nEdges - 1]) == std::get<1>(edges[i])){
+                std::get<2>(edges[nEdges - 1]) += std::get<2>(edges[i]);
+            }
+            else{
+                edges[nEdges++] = edges[i];
+            }
+        }
+        edges.resize(nEdges);
+
+        // the edges are sorted, so the adjacencies are filled by appending
+        problem.graph.reset(new typename ProblemType::GraphType(numberOfClusters, nEdges));
+        for(const auto & e : edges){
+            problem.graph->insertEdge(std::get<0>(e), std::get<1>(e));
+        }
+        problem.objective.reset(new typename ProblemType::ObjectiveType(*problem.graph));
+        auto & problemWeights = problem.objective->weights();
+        for(std::size_t e = 0; e < nEdges; ++e){
+            problemWeights[e] = std::get<2>(edges[e]);
+        }
+    }
+
+
+} // namespace nifty::graph::opt::multicut
+} // namespace nifty::graph::opt
+} // namespace nifty::graph
+} // namespace nifty
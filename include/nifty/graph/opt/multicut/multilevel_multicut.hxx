@@ -0,0 +1,354 @@
+#pragma once
+
+#include <algorithm>
+#include <limits>
+#include <memory>
+#include <numeric>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "nifty/tools/runtime_check.hxx"
+
+#include "nifty/graph/opt/multicut/multicut_base.hxx"
+#include "nifty/graph/opt/common/solver_factory.hxx"
+#include "nifty/graph/opt/multicut/multicut_objective.hxx"
+#include "nifty/graph/opt/multicut/multicut_contraction.hxx"
+#include "nifty/graph/undirected_list_graph.hxx"
+
+
+namespace nifty{
+namespace graph{
+namespace opt{
+namespace multicut{
+
+
+    /// Multilevel multicut with V-cycles.
+    ///
+    /// The graph is coarsened level by level with a heavy edge matching:
+    /// every node is merged with the neighbour it shares the largest
+    /// positive (attractive) weight with, as long as both are unmatched.
+    /// The coarsest level is solved with coarsestFactory and the solution
+    /// is projected back down, where every level is refined with
+    /// refinementFactory (e.g. KernighanLin), warm-started from the projection.
+    ///
+    /// Further cycles only match nodes within the clusters of the current
+    /// solution, so every coarse level can represent it. The solvers do not
+    /// have to respect the warm start (e.g. GreedyAdditive ignores it), so the
+    /// result of a cycle is only kept if its energy is not worse than the
+    /// current one. A cycle that does not improve the energy ends the optimization.
+    /// The first cycle starts from the given node labels as well,
+    /// nodeLabels that are all equal (the default) do not restrict it.
+    ///
+    template<class OBJECTIVE>
+    class MultilevelMulticut : public MulticutBase<OBJECTIVE>
+    {
+    public:
+
+        typedef OBJECTIVE ObjectiveType;
+        typedef typename ObjectiveType::WeightType WeightType;
+        typedef MulticutBase<OBJECTIVE> BaseType;
+        typedef typename BaseType::VisitorBaseType VisitorBaseType;
+        typedef typename BaseType::VisitorProxyType VisitorProxyType;
+        typedef typename BaseType::NodeLabelsType NodeLabelsType;
+        typedef typename ObjectiveType::GraphType GraphType;
+        typedef typename ObjectiveType::WeightsMap WeightsMap;
+        typedef nifty::graph::opt::common::SolverFactoryBase<BaseType> FactoryBase;
+
+    public:
+        typedef ContractedMulticutProblem<WeightType>                                  Level;
+        typedef typename Level::GraphType                                              SubmodelGraph;
+        typedef typename Level::ObjectiveType                                          SubmodelObjective;
+        typedef MulticutBase<SubmodelObjective>                                        SubmodelMulticutBaseType;
+        typedef nifty::graph::opt::common::SolverFactoryBase<SubmodelMulticutBaseType> SubmodelFactoryBase;
+        typedef typename SubmodelMulticutBaseType::NodeLabelsType                      SubmodelNodeLabels;
+
+    public:
+
+        struct SettingsType{
+            // solver for the coarsest level
+            std::shared_ptr<SubmodelFactoryBase> coarsestFactory;
+            // warm-started refinement of the coarse levels, no refinement if empty
+            std::shared_ptr<SubmodelFactoryBase> refinementFactory;
+            // warm-started refinement of the input graph, no refinement if empty
+            std::shared_ptr<FactoryBase> inputRefinementFactory;
+            // stop coarsening once a level has at most this many nodes
+            uint64_t numberOfNodesStop{1000};
+            // stop coarsening if a level removes less than this fraction of the nodes
+            double minimumReduction{0.05};
+            int numberOfLevels{100};
+            int numberOfCycles{1};
+            // seed for the order in which the nodes are matched
+            uint64_t seed{42};
+        };
+
+        virtual ~MultilevelMulticut(){
+
+        }
+        MultilevelMulticut(const ObjectiveType & objective, const SettingsType & settings = SettingsType());
+
+
+        virtual void optimize(NodeLabelsType & nodeLabels, VisitorBaseType * visitor);
+        virtual const ObjectiveType & objective() const;
+
+
+        virtual const NodeLabelsType & currentBestNodeLabels( ){
+            return *currentBest_;
+        }
+
+        virtual std::string name()const{
+            return std::string("MultilevelMulticut");
+        }
+        virtual void weightsChanged(){
+        }
+
+    private:
+
+        template<class GRAPH, class WEIGHTS, class LABELS>
+        uint64_t heavyEdgeMatching(const GRAPH & graph, const WEIGHTS & weights,
+                                   const LABELS & labels,
+                                   std::vector<uint64_t> & nodeToCluster);
+
+        void vCycle(NodeLabelsType & nodeLabels, VisitorProxyType & visitorProxy);
+
+        const ObjectiveType & objective_;
+        const GraphType & graph_;
+        const WeightsMap & weights_;
+        NodeLabelsType * currentBest_;
+
+        SettingsType settings_;
+        std::mt19937 gen_;
+    };
+
+
+    template<class OBJECTIVE>
+    MultilevelMulticut<OBJECTIVE>::
+    MultilevelMulticut(
+        const ObjectiveType & objective,
+        const SettingsType & settings
+    )
+    :   objective_(objective),
+        graph_(objective.graph()),
+        weights_(objective.weights()),
+        currentBest_(nullptr),
+        settings_(settings),
+        gen_(settings.seed)
+    {
+        if(!bool(settings_.coarsestFactory)){
+            throw std::runtime_error("MultilevelMulticut SettingsType: coarsestFactory may not be empty!");
+        }
+        NIFTY_CHECK_OP(settings_.numberOfCycles, >=, 1, "MultilevelMulticut: numberOfCycles must be at least 1");
+    }
+
+    template<class OBJECTIVE>
+    void MultilevelMulticut<OBJECTIVE>::
+    optimize(
+        NodeLabelsType & nodeLabels,  VisitorBaseType * visitor
+    ){
+        VisitorProxyType visitorProxy(visitor);
+        currentBest_ = &nodeLabels;
+        visitorProxy.begin(this);
+
+        auto currentEnergy = objective_.evalNodeLabels(nodeLabels);
+        NodeLabelsType cycleLabels(graph_);
+        for(int cycle = 0; cycle < settings_.numberOfCycles; ++cycle){
+            graph_.forEachNode([&](const uint64_t node){
+                cycleLabels[node] = nodeLabels[node];
+            });
+            vCycle(cycleLabels, visitorProxy);
+
+            const auto cycleEnergy = objective_.evalNodeLabels(cycleLabels);
+            visitorProxy.printLog(nifty::logging::LogLevel::INFO,
+                std::string("cycle ") + std::to_string(cycle) + std::string(": energy ") +
+                std::to_string(cycleEnergy));
+
+            const bool improved = cycleEnergy < currentEnergy;
+            if(cycleEnergy <= currentEnergy){
+                graph_.forEachNode([&](const uint64_t node){
+                    nodeLabels[node] = cycleLabels[node];
+                });
+                currentEnergy = cycleEnergy;
+            }
+            if(!improved || !visitorProxy.visit(this)){
+                break;
+            }
+        }
+
+        visitorProxy.end(this);
+    }
+
+    // one V-cycle starting from (and restricted to) the clusters of nodeLabels
+    template<class OBJECTIVE>
+    void MultilevelMulticut<OBJECTIVE>::
+    vCycle(
+        NodeLabelsType & nodeLabels,
+        VisitorProxyType & visitorProxy
+    ){
+        // coarsen, the labels of a level are the labels its nodes are restricted to
+        std::vector<Level> levels;
+        std::vector<std::vector<uint64_t>> levelLabels;
+        uint64_t numberOfNodes = graph_.numberOfNodes();
+        for(int l = 0; l < settings_.numberOfLevels && numberOfNodes > settings_.numberOfNodesStop; ++l){
+            levels.emplace_back();
+            auto & level = levels.back();
+            uint64_t numberOfClusters;
+            if(l == 0){
+                numberOfClusters = heavyEdgeMatching(graph_, weights_, nodeLabels, level.nodeToCluster);
+                contractMulticutProblem(graph_, weights_, numberOfClusters, level);
+            }
+            else{
+                const auto & previous = levels[l - 1];
+                numberOfClusters = heavyEdgeMatching(*previous.graph, previous.objective->weights(),
+                                                     levelLabels.back(), level.nodeToCluster);
+                contractMulticutProblem(*previous.graph, previous.objective->weights(), numberOfClusters, level);
+            }
+
+            // all nodes of a cluster have the same label
+            levelLabels.emplace_back(numberOfClusters);
+            auto & coarseLabels = levelLabels.back();
+            const auto & nodeToCluster = level.nodeToCluster;
+            if(l == 0){
+                graph_.forEachNode([&](const uint64_t node){
+                    coarseLabels[nodeToCluster[node]] = nodeLabels[node];
+                });
+            }
+            else{
+                const auto & fineLabels = levelLabels[l - 1];
+                for(std::size_t node = 0; node < nodeToCluster.size(); ++node){
+                    coarseLabels[nodeToCluster[node]] = fineLabels[node];
+                }
+            }
+
+            visitorProxy.printLog(nifty::logging::LogLevel::INFO,
+                std::string("level ") + std::to_string(l) + std::string(": ") +
+                std::to_string(numberOfNodes) + std::string(" -> ") +
+                std::to_string(numberOfClusters) + std::string(" nodes"));
+
+            const bool converged = double(numberOfNodes - numberOfClusters) <
+                                   settings_.minimumReduction * double(numberOfNodes);
+            numberOfNodes = numberOfClusters;
+            if(converged){
+                break;
+            }
+        }
+
+        // solve the coarsest level, warm-started from the current labels
+        std::vector<uint64_t> labels;
+        if(levels.empty()){
+            // the input is small enough: solve it on a copy
+            Level level;
+            level.nodeToCluster.resize(graph_.nodeIdUpperBound() + 1);
+            std::iota(level.nodeToCluster.begin(), level.nodeToCluster.end(), 0);
+            contractMulticutProblem(graph_, weights_, level.nodeToCluster.size(), level);
+            levels.push_back(std::move(level));
+            levelLabels.emplace_back(levels.back().nodeToCluster.size(), 0);
+            graph_.forEachNode([&](const uint64_t node){
+                levelLabels.back()[node] = nodeLabels[node];
+            });
+        }
+        {
+            const auto & top = levels.back();
+            SubmodelNodeLabels topLabels(*top.graph);
+            std::copy(levelLabels.back().begin(), levelLabels.back().end(), topLabels.begin());
+            std::unique_ptr<SubmodelMulticutBaseType> solver(settings_.coarsestFactory->create(*top.objective));
+            solver->optimize(topLabels, nullptr);
+            labels.assign(topLabels.begin(), topLabels.end());
+        }
+
+        // project the solution down and refine it level by level
+        for(auto l = levels.size(); l-- > 0;){
+            const auto & nodeToCluster = levels[l].nodeToCluster;
+            std::vector<uint64_t> finer(nodeToCluster.size(), 0);
+            auto project = [&](const uint64_t node){
+                finer[node] = labels[nodeToCluster[node]];
+            };
+            // node ids of the input graph may be sparse, the ids that are not
+            // present have no cluster; the coarse levels are contiguous
+            if(l == 0){
+                graph_.forEachNode(project);
+            }
+            else{
+                for(std::size_t node = 0; node < nodeToCluster.size(); ++node){
+                    project(node);
+                }
+            }
+            labels.swap(finer);
+
+            if(l > 0 && bool(settings_.refinementFactory)){
+                const auto & fine = levels[l - 1];
+                SubmodelNodeLabels fineLabels(*fine.graph);
+                std::copy(labels.begin(), labels.end(), fineLabels.begin());
+                std::unique_ptr<SubmodelMulticutBaseType> solver(settings_.refinementFactory->create(*fine.objective));
+                solver->optimize(fineLabels, nullptr);
+                labels.assign(fineLabels.begin(), fineLabels.end());
+            }
+        }
+        graph_.forEachNode([&](const uint64_t node){
+            nodeLabels[node] = labels[node];
+        });
+
+        if(bool(settings_.inputRefinementFactory)){
+            std::unique_ptr<BaseType> solver(settings_.inputRefinementFactory->create(objective_));
+            solver->optimize(nodeLabels, nullptr);
+        }
+    }
+
+    // merge every unmatched node with the unmatched neighbour with the same label
+    // it shares the heaviest positive edge with, returns the number of clusters
+    template<class OBJECTIVE>
+    template<class GRAPH, class WEIGHTS, class LABELS>
+    uint64_t MultilevelMulticut<OBJECTIVE>::
+    heavyEdgeMatching(
+        const GRAPH & graph,
+        const WEIGHTS & weights,
+        const LABELS & labels,
+        std::vector<uint64_t> & nodeToCluster
+    ){
+        const uint64_t nodeBound = graph.nodeIdUpperBound() + 1;
+        const uint64_t unmatched = std::numeric_limits<uint64_t>::max();
+
+        // random order, so that the matching does not follow the node ids
+        std::vector<uint64_t> order;
+        order.reserve(graph.numberOfNodes());
+        graph.forEachNode([&](const uint64_t node){
+            order.push_back(node);
+        });
+        std::shuffle(order.begin(), order.end(), gen_);
+
+        nodeToCluster.assign(nodeBound, unmatched);
+        uint64_t numberOfClusters = 0;
+        for(const auto node : order){
+            if(nodeToCluster[node] != unmatched){
+                continue;
+            }
+            uint64_t bestNode = unmatched;
+            WeightType bestWeight = 0;
+            for(const auto adj : graph.adjacency(node)){
+                const uint64_t other = adj.node();
+                const auto w = weights[adj.edge()];
+                if(w > bestWeight && nodeToCluster[other] == unmatched && labels[other] == labels[node]){
+                    bestNode = other;
+                    bestWeight = w;
+                }
+            }
+            nodeToCluster[node] = numberOfClusters;
+            if(bestNode != unmatched){
+                nodeToCluster[bestNode] = numberOfClusters;
+            }
+            ++numberOfClusters;
+        }
+        return numberOfClusters;
+    }
+
+    template<class OBJECTIVE>
+    const typename MultilevelMulticut<OBJECTIVE>::ObjectiveType &
+    MultilevelMulticut<OBJECTIVE>::
+    objective()const{
+        return objective_;
+    }
+
+
+} // namespace nifty::graph::opt::multicut
+} // namespace nifty::graph::opt
+} // namespace nifty::graph
+} // namespace nifty
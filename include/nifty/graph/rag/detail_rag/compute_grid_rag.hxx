@@ -9,6 +9,7 @@
 #include "nifty/container/boost_flat_set.hxx"
 #include "nifty/array/arithmetic_array.hxx"
 #include "nifty/tools/for_each_block.hxx"
+#include "nifty/tools/label_boundary_scan.hxx"
 
 #include "nifty/graph/undirected_list_graph.hxx"
 
@@ -78,11 +79,9 @@ struct ComputeRag<GridRag<DIM, LABELS>> {
             perThreadDataVec[i].adjacency.resize(rag.numberOfLabels());
         });
 
-        auto makeCoord2 = [](const Coord & coord,const std::size_t axis){
-            Coord coord2 = coord;
-            coord2[axis] += 1;
-            return coord2;
-        };
+        // the block labels are read into the top left corner of the
+        // per thread buffer, so rows are strided with the buffer shape
+        const auto bufferStrides = tools::cOrderStrides<DIM>(blockShapeWithBorder);
 
         const Coord overlapBegin(0), overlapEnd(1);
         const Coord zeroCoord(0);
@@ -102,18 +101,10 @@ struct ComputeRag<GridRag<DIM, LABELS>> {
             tools::readSubarray(labels, blockBegin, blockEnd, blockLabels);
 
             auto & adjacency = perThreadDataVec[tid].adjacency;
-            nifty::tools::forEachCoordinate(actualBlockShape,[&](const Coord & coord){
-                const auto lU = xtensor::read(blockLabels, coord.asStdArray());
-                for(std::size_t axis=0; axis<DIM; ++axis){
-                    const auto coord2 = makeCoord2(coord, axis);
-                    if(coord2[axis] < actualBlockShape[axis]){
-                        const auto lV = xtensor::read(blockLabels, coord2.asStdArray());
-                        if(lU != lV){
-                            adjacency[lV].insert(lU);
-                            adjacency[lU].insert(lV);
-                        }
-                    }
-                }
+            tools::forEachLabelBoundary(blockView.data(), bufferStrides, actualBlockShape, actualBlockShape,
+            [&](const std::size_t axis, const Coord & coord, const value_type lU, const value_type lV){
+                adjacency[lV].insert(lU);
+                adjacency[lU].insert(lV);
             });
         });
 
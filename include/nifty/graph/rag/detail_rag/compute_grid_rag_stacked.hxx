@@ -9,6 +9,7 @@
 #include "nifty/tools/timer.hxx"
 #include "nifty/tools/for_each_coordinate.hxx"
 #include "nifty/tools/for_each_block.hxx"
+#include "nifty/tools/label_boundary_scan.hxx"
 
 #include "nifty/graph/undirected_list_graph.hxx"
 
@@ -46,6 +47,7 @@ struct ComputeRag<GridRagStacked2D<LABELS>> {
     typedef typename RagType::BlockStorageType BlockStorageType;
     typedef typename RagType::NodeAdjacency NodeAdjacency;
     typedef typename RagType::EdgeStorage EdgeStorage;
+    typedef typename LabelsType::value_type LabelType;
 
 
     template<class S>
@@ -70,6 +72,8 @@ struct ComputeRag<GridRagStacked2D<LABELS>> {
         uint64_t numberOfSlices = shape[0];
         Coord2 sliceShape2({shape[1], shape[2]});
         Coord sliceShape3({static_cast<int64_t>(1), shape[1], shape[2]});
+        const int64_t sliceSize = shape[1] * shape[2];
+        const auto sliceStrides = tools::cOrderStrides<2>(sliceShape2);
 
         auto & perSliceDataVec = rag.perSliceDataVec_;
 
@@ -100,47 +104,37 @@ struct ComputeRag<GridRagStacked2D<LABELS>> {
                 const Coord blockBegin({sliceIndex, static_cast<int64_t>(0), static_cast<int64_t>(0)});
                 const Coord blockEnd({sliceIndex+1, sliceShape2[0], sliceShape2[1]});
                 tools::readSubarray(labels, blockBegin, blockEnd, sliceLabelsFlat3DView);
-                //
-                auto sliceLabels = xtensor::squeezedView(sliceLabelsFlat3DView);
+                const LabelType * sliceLabels = sliceLabelsFlat3DView.data();
+
+                // the node range of this slice, ignoring the ignore label
+                for(int64_t i=0; i<sliceSize; ++i){
+                    const auto l = sliceLabels[i];
+                    if(haveIgnoreLabel && l == ignoreLabel) {
+                        continue;
+                    }
+                    sliceData.minInSliceNode = std::min(sliceData.minInSliceNode, l);
+                    sliceData.maxInSliceNode = std::max(sliceData.maxInSliceNode, l);
+                }
 
                 // do the thing
-                nifty::tools::forEachCoordinate(sliceShape2,[&](const Coord2 & coord){
-                    const auto lU = xtensor::read(sliceLabels, coord.asStdArray());
+                tools::forEachLabelBoundary(sliceLabels, sliceStrides, sliceShape2, sliceShape2,
+                [&](const std::size_t axis, const Coord2 & coord, const LabelType lU, const LabelType lV){
                     // if we have ignore labels, we check if this is an ignore label
-                    if(haveIgnoreLabel && lU == ignoreLabel) {
+                    if(haveIgnoreLabel && (lU == ignoreLabel || lV == ignoreLabel)) {
                         return;
                     }
 
-                    sliceData.minInSliceNode = std::min(sliceData.minInSliceNode, lU);
-                    sliceData.maxInSliceNode = std::max(sliceData.maxInSliceNode, lU);
-                    for(std::size_t axis=0; axis<2; ++axis) {
-                        Coord2 coord2 = coord;
-                        ++coord2[axis];
-                        if(coord2[axis] < sliceShape2[axis]){
-                            const auto lV = xtensor::read(sliceLabels, coord2.asStdArray());
-                            // if we have ignore labels, we check if this is an ignore label
-                            if(haveIgnoreLabel && lV == ignoreLabel) {
-                                return;
-                            }
-                            if(lU != lV){
-
-                                sliceData.minInSliceNode = std::min(sliceData.minInSliceNode, lV);
-                                sliceData.maxInSliceNode = std::max(sliceData.maxInSliceNode, lV);
-
-                                // add up the len
-                                // map insert cf.: http://stackoverflow.com/questions/97050/stdmap-insert-or-stdmap-find
-                                auto e = EdgeStorage(std::min(lU,lV),std::max(lU,lV));
-                                auto findEdge = edgeLens.lower_bound(e);
-                                if( findEdge != edgeLens.end() && !(edgeLens.key_comp()(e, findEdge->first)) )
-                                    ++(findEdge->second);
-                                else
-                                    edgeLens.insert(findEdge, std::make_pair(e,1));
-
-                                if(rag.insertEdgeOnlyInNodeAdj(lU, lV)){
-                                    ++perSliceDataVec[sliceIndex].numberOfInSliceEdges;
-                                }
-                            }
-                        }
+                    // add up the len
+                    // map insert cf.: http://stackoverflow.com/questions/97050/stdmap-insert-or-stdmap-find
+                    auto e = EdgeStorage(std::min(lU,lV),std::max(lU,lV));
+                    auto findEdge = edgeLens.lower_bound(e);
+                    if( findEdge != edgeLens.end() && !(edgeLens.key_comp()(e, findEdge->first)) )
+                        ++(findEdge->second);
+                    else
+                        edgeLens.insert(findEdge, std::make_pair(e,1));
+
+                    if(rag.insertEdgeOnlyInNodeAdj(lU, lV)){
+                        ++perSliceDataVec[sliceIndex].numberOfInSliceEdges;
                     }
                 });
             });
@@ -240,12 +234,10 @@ struct ComputeRag<GridRagStacked2D<LABELS>> {
                         tools::readSubarray(labels, beginA, endA, sliceAView);
                         tools::readSubarray(labels, beginB, endB, sliceBView);
 
-                        auto sliceALabels = xtensor::squeezedView(sliceAView);
-                        auto sliceBLabels = xtensor::squeezedView(sliceBView);
-
-                        nifty::tools::forEachCoordinate(sliceShape2,[&](const Coord2 & coord){
-                            const auto lU = xtensor::read(sliceALabels, coord.asStdArray());
-                            const auto lV = xtensor::read(sliceBLabels, coord.asStdArray());
+                        // consecutive voxels with the same label pair
+                        // are counted at once
+                        tools::forEachLabelPairRun(sliceAView.data(), sliceBView.data(), sliceSize,
+                        [&](const LabelType lU, const LabelType lV, const std::ptrdiff_t runLength){
 
                             if(haveIgnoreLabel) {
                                 if(lV == ignoreLabel || lU == ignoreLabel) {
@@ -258,9 +250,9 @@ struct ComputeRag<GridRagStacked2D<LABELS>> {
                             auto e = EdgeStorage(std::min(lU,lV),std::max(lU,lV));
                             auto findEdge = edgeLens.lower_bound(e);
                             if( findEdge != edgeLens.end() && !(edgeLens.key_comp()(e, findEdge->first)) )
-                                ++(findEdge->second);
+                                findEdge->second += runLength;
                             else
-                                edgeLens.insert(findEdge, std::make_pair(e,1));
+                                edgeLens.insert(findEdge, std::make_pair(e, std::size_t(runLength)));
 
                             if(rag.insertEdgeOnlyInNodeAdj(lU, lV)){
                                 ++perSliceDataVec[sliceAIndex].numberOfToNextSliceEdges;
@@ -1,7 +1,12 @@
 #pragma once
 
-#include <vector>
+#include <condition_variable>
+#include <deque>
 #include <functional>
+#include <future>
+#include <mutex>
+#include <numeric>
+#include <vector>
 
 #include "nifty/parallel/threadpool.hxx"
 #include "vigra/accumulator.hxx"
@@ -293,8 +298,6 @@ void accumulateEdgeFeaturesFromFiltersWithAccChain(const GridRagStacked2D<LABELS
     typedef std::vector<AccChainVectorType> ChannelAccChainVectorType;
     typedef typename features::ApplyFilters<2>::FiltersToSigmasType FiltersToSigmasType;
 
-    const std::size_t actualNumberOfThreads = pOpts.getActualNumThreads();
-
     const auto & shape = rag.shape();
     const auto & labels = rag.labels();
 
@@ -314,46 +317,35 @@ void accumulateEdgeFeaturesFromFiltersWithAccChain(const GridRagStacked2D<LABELS
     Coord sliceShape3({static_cast<int64_t>(1), shape[1], shape[2]});
     Coord filterShape({int64_t(numberOfChannels), shape[1], shape[2]});
 
-    // FIXME this does not really help, because slices are not completely processed
-    // due to writing out of overhanging chunks
-    // keep track of slices that were already processed
-    // std::string filename;
-    // if(keepXYOnly) {
-    //     filename = "/groups/saalfeld/home/papec/Work/feats_from_filts_slice_list_XY.txt";
-    // } else if(keepZOnly) {
-    //     filename = "/groups/saalfeld/home/papec/Work/feats_from_filts_slice_list_Z.txt";
-    // } else {
-    //     filename = "/groups/saalfeld/home/papec/Work/feats_from_filts_slice_list.txt";
-    // }
-    // std::ofstream slicesOut(filename);
-
-    // filter computation and accumulation
-    // FIXME we only support 1 pass for now
-    //for(auto pass = 1; pass <= channelAccChainVector.front().front().passesRequired(); ++pass) {
-    //int pass = 1;
+    // the slices are streamed through a ring of slots that hold the labels and
+    // filter responses of a slice; the filters of every slice are computed once
+    // for the accumulation (slice 0 is filtered once more for the histogram range)
+    // and a slot is released as soon as the inner slice edges of its slice and
+    // the between slice edges to both neighbours are accumulated.
+    // filter tasks for upcoming slices run concurrently with the accumulation
+    // tasks of the slices that are already in memory.
+    // with one slot more than threads, at least two consecutive slices fit,
+    // so the lowest slice in memory can always be finished
+    const std::size_t numberOfWorkers = std::max(std::size_t(1), threadpool.nThreads());
+    const std::size_t numberOfSlots = numberOfWorkers + 1;
+
+    LabelBlockStorage  labelsStorage(threadpool, sliceShape3, numberOfSlots);
+    FilterBlockStorage filterStorage(threadpool, filterShape, numberOfSlots);
+    // the raw data is only needed while the filters are computed
+    DataBlockStorage   dataStorage(threadpool, sliceShape3, numberOfWorkers);
+
+    // process slice 0 to find min and max for histogram opts;
+    // these filters are computed without presmoothing, unlike the filters that are
+    // accumulated, so they can't be reused for slice 0 and slot 0 is refiltered later
+    std::vector<vigra::HistogramOptions> histoOptionsVec(numberOfChannels);
     {
-        // accumulate inner slice feature
-
-        // TODO we could do this less memory consuming, if we allocate less data here and
-        // allocate some in every thread
-        LabelBlockStorage  labelsAStorage(threadpool, sliceShape3, actualNumberOfThreads);
-        LabelBlockStorage  labelsBStorage(threadpool, sliceShape3, actualNumberOfThreads);
-        // FIXME dirty hack
-        FilterBlockStorage filterAStorage(threadpool, filterShape, actualNumberOfThreads);
-        FilterBlockStorage filterBStorage(threadpool, filterShape, actualNumberOfThreads);
-        // we only need one data storage
-        DataBlockStorage   dataStorage(threadpool, sliceShape3, actualNumberOfThreads);
-
-        // process slice 0 to find min and max for histogram opts
         Coord begin0({static_cast<int64_t>(0), static_cast<int64_t>(0), static_cast<int64_t>(0)});
         Coord end0(  {static_cast<int64_t>(1), shape[1], shape[2]});
 
-        auto data0 = dataStorage.getView(0);
+        auto & data0 = dataStorage.getView(0);
         tools::readSubarray(data, begin0, end0, data0);
         auto data0Squeezed = xtensor::squeezedView(data0);
-        // FIXME dirty hack
-        auto filter0 = filterAStorage.getView(0);
-        //auto filter0 = filterBStorage.getView(0);
+        auto & filter0 = filterStorage.getView(0);
 
         // apply filters in parallel
         calculateFilters(data0Squeezed,
@@ -362,7 +354,6 @@ void accumulateEdgeFeaturesFromFiltersWithAccChain(const GridRagStacked2D<LABELS
                          threadpool,
                          applyFilters);
 
-        std::vector<vigra::HistogramOptions> histoOptionsVec(numberOfChannels);
         Coord cShape({static_cast<int64_t>(1), sliceShape2[0], sliceShape2[1]});
         parallel::parallel_foreach(threadpool, numberOfChannels, [&](const int tid, const int64_t c){
             auto & histoOpts = histoOptionsVec[c];
@@ -375,136 +366,209 @@ void accumulateEdgeFeaturesFromFiltersWithAccChain(const GridRagStacked2D<LABELS
             auto max = *(minMax.second);
             histoOpts.setMinMax(min,max);
         });
+    }
 
-        // construct slice pairs for processing in parallel
-        std::vector<std::pair<int64_t,int64_t>> slicePairs;
-        int64_t lowerSliceId = 0;
-        int64_t upperSliceId = 1;
-        while(upperSliceId < numberOfSlices) {
-            slicePairs.emplace_back(std::make_pair(lowerSliceId,upperSliceId));
-            ++lowerSliceId;
-            ++upperSliceId;
+    // the accumulation tasks and how many of them use each slice
+    const bool doInner = !keepZOnly;
+    const bool doBetween = !keepXYOnly;
+    std::vector<int> usesLeft(numberOfSlices, 0);
+    std::size_t numberOfTasks = numberOfSlices;
+    for(uint64_t z = 0; z < numberOfSlices; ++z) {
+        if(doInner && rag.numberOfInSliceEdges(z) > 0) {
+            ++usesLeft[z];
+            ++numberOfTasks;
         }
+        if(doBetween && z + 1 < numberOfSlices) {
+            ++usesLeft[z];
+            ++usesLeft[z + 1];
+            ++numberOfTasks;
+        }
+    }
 
-        parallel::parallel_foreach(threadpool, slicePairs.size(), [&](const int tid, const int64_t pairId){
-
-            std::cout << "Processing slice pair: " << pairId << " / " << slicePairs.size() << std::endl;
-            int64_t sliceIdA = slicePairs[pairId].first; // lower slice
-            int64_t sliceIdB = slicePairs[pairId].second;// upper slice
-
-            // compute the filters for slice A
-            Coord beginA({sliceIdA, static_cast<int64_t>(0), static_cast<int64_t>(0)});
-            Coord endA({sliceIdA+1, shape[1], shape[2]});
+    enum TaskType {FILTER_TASK, INNER_TASK, BETWEEN_TASK};
+    struct Task {
+        TaskType type;
+        int64_t sliceId; // the lower slice for between slice tasks
+    };
+
+    // shared state of the streamer, guarded by mutex
+    std::mutex mutex;
+    std::condition_variable stateChanged;
+    std::vector<std::size_t> freeSlots(numberOfSlots);
+    std::iota(freeSlots.rbegin(), freeSlots.rend(), 0);
+    std::vector<std::size_t> slotOfSlice(numberOfSlices);
+    std::vector<char> filterDone(numberOfSlices, false);
+    std::deque<Task> readyTasks;
+    uint64_t nextToFilter = 0;
+    std::size_t finishedTasks = 0;
+    bool aborted = false;
+
+    auto releaseUse = [&](const int64_t z){
+        if(--usesLeft[z] == 0) {
+            freeSlots.push_back(slotOfSlice[z]);
+        }
+    };
 
-            auto labelsA = labelsAStorage.getView(tid);
-            tools::readSubarray(labels, beginA, endA, labelsA);
-            auto labelsASqueezed = xtensor::squeezedView(labelsA);
+    auto runTask = [&](const int tid, const Task & task){
+        if(task.type == FILTER_TASK) {
+            const int64_t z = task.sliceId;
+            const std::size_t slot = slotOfSlice[z];
+            Coord begin({z, static_cast<int64_t>(0), static_cast<int64_t>(0)});
+            Coord end({z + 1, shape[1], shape[2]});
 
-            // FIXME dirty hack
-            auto dataA = dataStorage.getView(tid);
-            tools::readSubarray(data, beginA, endA, dataA);
-            auto dataASqueezed = xtensor::squeezedView(dataA);
+            tools::readSubarray(labels, begin, end, labelsStorage.getView(slot));
 
-            auto filterA = filterAStorage.getView(tid);
-            calculateFilters(dataASqueezed,
+            auto & dataZ = dataStorage.getView(tid);
+            tools::readSubarray(data, begin, end, dataZ);
+            auto dataZSqueezed = xtensor::squeezedView(dataZ);
+            calculateFilters(dataZSqueezed,
                              sliceShape2,
-                             filterA,
+                             filterStorage.getView(slot),
                              applyFilters,
                              true); // presmoothing
-
-            // acccumulate the inner slice features
-            // only if not keepZOnly and if we have at least one edge in this slice
-            // (no edge can happend for defected slices)
-            if(rag.numberOfInSliceEdges(sliceIdA) > 0 && !keepZOnly) {
-                auto inEdgeOffset = rag.inSliceEdgeOffset(sliceIdA);
-                // make new acc chain vector
-                ChannelAccChainVectorType channelAccChainVec(
-                        rag.numberOfInSliceEdges(sliceIdA),
-                        AccChainVectorType(numberOfChannels)
-                );
-                accumulateInnerSliceFeatures(channelAccChainVec,
-                                             histoOptionsVec,
-                                             sliceShape2,
-                                             labelsASqueezed,
-                                             sliceIdA,
-                                             inEdgeOffset,
-                                             rag,
-                                             filterA);
-                fXY(channelAccChainVec, sliceIdA, inEdgeOffset);
+        }
+        else if(task.type == INNER_TASK) {
+            const int64_t z = task.sliceId;
+            const std::size_t slot = slotOfSlice[z];
+            auto labelsSqueezed = xtensor::squeezedView(labelsStorage.getView(slot));
+
+            auto inEdgeOffset = rag.inSliceEdgeOffset(z);
+            // make new acc chain vector
+            ChannelAccChainVectorType channelAccChainVec(
+                rag.numberOfInSliceEdges(z),
+                AccChainVectorType(numberOfChannels)
+            );
+            accumulateInnerSliceFeatures(channelAccChainVec,
+                                         histoOptionsVec,
+                                         sliceShape2,
+                                         labelsSqueezed,
+                                         z,
+                                         inEdgeOffset,
+                                         rag,
+                                         filterStorage.getView(slot));
+            fXY(channelAccChainVec, z, inEdgeOffset);
+        }
+        else {
+            const int64_t sliceIdA = task.sliceId;
+            const int64_t sliceIdB = sliceIdA + 1;
+            const std::size_t slotA = slotOfSlice[sliceIdA];
+            const std::size_t slotB = slotOfSlice[sliceIdB];
+            auto labelsASqueezed = xtensor::squeezedView(labelsStorage.getView(slotA));
+            auto labelsBSqueezed = xtensor::squeezedView(labelsStorage.getView(slotB));
+
+            auto betweenEdgeOffset = rag.betweenSliceEdgeOffset(sliceIdA);
+            auto accOffset = rag.betweenSliceEdgeOffset(sliceIdA) - rag.numberOfInSliceEdges();
+            // make new acc chain vector
+            ChannelAccChainVectorType channelAccChainVec(
+                rag.numberOfInBetweenSliceEdges(sliceIdA),
+                AccChainVectorType(numberOfChannels)
+            );
+            // accumulate features for the in between slice edges
+            accumulateBetweenSliceFeatures(channelAccChainVec,
+                                           histoOptionsVec,
+                                           sliceShape2,
+                                           labelsASqueezed,
+                                           labelsBSqueezed,
+                                           sliceIdA,
+                                           sliceIdB,
+                                           betweenEdgeOffset,
+                                           rag,
+                                           filterStorage.getView(slotA),
+                                           filterStorage.getView(slotB),
+                                           zDirection);
+            fZ(channelAccChainVec, sliceIdA, accOffset);
+        }
+    };
+
+    // must be called with the mutex locked
+    auto finishTask = [&](const Task & task){
+        const int64_t z = task.sliceId;
+        if(task.type == FILTER_TASK) {
+            filterDone[z] = true;
+            if(doInner && rag.numberOfInSliceEdges(z) > 0) {
+                readyTasks.push_back(Task{INNER_TASK, z});
             }
-
-            // read labels, data and calculate the filters for upper slice
-            // do if we are not keeping only xy edges or
-            // if we are at the last slice (which is never a lower slice and
-            // must hence be accumulated extra)
-            if(!keepXYOnly || sliceIdB == numberOfSlices - 1) {
-
-                // process upper slice
-                Coord beginB = Coord({sliceIdB, static_cast<int64_t>(0), static_cast<int64_t>(0)});
-                Coord endB   = Coord({sliceIdB + 1, shape[1], shape[2]});
-                auto filterB = filterBStorage.getView(tid);
-
-                // read labels
-                auto labelsB = labelsBStorage.getView(tid);
-                tools::readSubarray(labels, beginB, endB, labelsB);
-                auto labelsBSqueezed = xtensor::squeezedView(labelsB);
-                // read data
-                auto dataB = dataStorage.getView(tid);
-                tools::readSubarray(data, beginB, endB, dataB);
-                auto dataBSqueezed = xtensor::squeezedView(dataB);
-                // calc filter
-                calculateFilters(dataBSqueezed,
-                                 sliceShape2,
-                                 filterB,
-                                 applyFilters,
-                                 true); // activate pre-smoothing
-
-                // acccumulate the between slice features
-                if(!keepXYOnly) {
-                    auto betweenEdgeOffset = rag.betweenSliceEdgeOffset(sliceIdA);
-                    auto accOffset = rag.betweenSliceEdgeOffset(sliceIdA) - rag.numberOfInSliceEdges();
-                    // make new acc chain vector
-                    ChannelAccChainVectorType channelAccChainVec(
-                        rag.numberOfInBetweenSliceEdges(sliceIdA),
-                        AccChainVectorType(numberOfChannels)
-                    );
-                    // accumulate features for the in between slice edges
-                    accumulateBetweenSliceFeatures(channelAccChainVec,
-                                                   histoOptionsVec,
-                                                   sliceShape2,
-                                                   labelsASqueezed,
-                                                   labelsBSqueezed,
-                                                   sliceIdA,
-                                                   sliceIdB,
-                                                   betweenEdgeOffset,
-                                                   rag,
-                                                   // FIXME dirty hack
-                                                   filterA,
-                                                   filterB,
-                                                   zDirection);
-                    fZ(channelAccChainVec, sliceIdA, accOffset);
+            if(doBetween && z > 0 && filterDone[z - 1]) {
+                readyTasks.push_back(Task{BETWEEN_TASK, z - 1});
+            }
+            if(doBetween && z + 1 < int64_t(numberOfSlices) && filterDone[z + 1]) {
+                readyTasks.push_back(Task{BETWEEN_TASK, z});
+            }
+        }
+        else if(task.type == INNER_TASK) {
+            releaseUse(z);
+        }
+        else {
+            releaseUse(z);
+            releaseUse(z + 1);
+        }
+        ++finishedTasks;
+    };
+
+    auto workerLoop = [&](const int tid){
+        try{
+            for(;;){
+                Task task;
+                {
+                    std::unique_lock<std::mutex> lock(mutex);
+                    for(;;) {
+                        stateChanged.wait(lock, [&](){
+                            return aborted || finishedTasks == numberOfTasks || !readyTasks.empty() ||
+                                   (nextToFilter < numberOfSlices && !freeSlots.empty());
+                        });
+                        if(aborted || finishedTasks == numberOfTasks) {
+                            return;
+                        }
+                        // accumulation first, it frees slots
+                        if(!readyTasks.empty()) {
+                            task = readyTasks.front();
+                            readyTasks.pop_front();
+                            break;
+                        }
+                        task = Task{FILTER_TASK, int64_t(nextToFilter++)};
+                        // slices without edges to accumulate need no filters
+                        if(usesLeft[task.sliceId] == 0) {
+                            finishTask(task);
+                            continue;
+                        }
+                        slotOfSlice[task.sliceId] = freeSlots.back();
+                        freeSlots.pop_back();
+                        break;
+                    }
                 }
-
-                // accumulate the inner slice features for the last slice, which is never a lower slice
-                if(!keepZOnly && (sliceIdB == numberOfSlices - 1 && rag.numberOfInSliceEdges(sliceIdB) > 0)) {
-                    auto inEdgeOffset = rag.inSliceEdgeOffset(sliceIdB);
-                    // make new acc chain vector
-                    ChannelAccChainVectorType channelAccChainVec(
-                        rag.numberOfInSliceEdges(sliceIdB),
-                        AccChainVectorType(numberOfChannels)
-                    );
-                    accumulateInnerSliceFeatures(channelAccChainVec,
-                                                 histoOptionsVec,
-                                                 sliceShape2,
-                                                 labelsBSqueezed,
-                                                 sliceIdB,
-                                                 inEdgeOffset,
-                                                 rag,
-                                                 filterB);
-                    fXY(channelAccChainVec, sliceIdB, inEdgeOffset);
+                runTask(tid, task);
+                {
+                    std::unique_lock<std::mutex> lock(mutex);
+                    finishTask(task);
                 }
+                stateChanged.notify_all();
             }
-        });
+        }
+        catch(...){
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                aborted = true;
+            }
+            stateChanged.notify_all();
+            throw;
+        }
+    };
+
+    if(threadpool.nThreads() == 0) {
+        workerLoop(0);
+    }
+    else {
+        std::vector<std::future<void>> futures;
+        for(std::size_t t = 0; t < numberOfWorkers; ++t){
+            futures.emplace_back(threadpool.enqueue(workerLoop));
+        }
+        // wait for everything before rethrowing, the workers reference this stack frame
+        for(auto & fut : futures){
+            fut.wait();
+        }
+        for(auto & fut : futures){
+            fut.get();
+        }
     }
     std::cout << "Slices done" << std::endl;
 }
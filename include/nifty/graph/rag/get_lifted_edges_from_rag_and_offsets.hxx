@@ -1,8 +1,14 @@
 #pragma once
 
-#include <random>
-#include <thread>
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
 #include "xtensor/xexpression.hpp"
+#include "xtensor/xtensor.hpp"
 
 #include "xtensor/xview.hpp"
 #include "xtensor/xmath.hpp"
@@ -10,57 +16,219 @@
 
 #include "nifty/array/arithmetic_array.hxx"
 #include "nifty/tools/for_each_coordinate.hxx"
+#include "nifty/tools/runtime_check.hxx"
+#include "nifty/xtensor/xtensor.hxx"
 #include <cstdlib>
 
 
 namespace nifty{
     namespace graph{
 
-        template<std::size_t DIM, class RAG>
-        auto computeLiftedEdgesFromRagAndOffsets(
-                const RAG & rag,
-                const std::vector<array::StaticArray<int64_t, DIM>> & offsets,
-                std::vector<std::vector<std::pair<uint64_t,uint64_t>>> & longRangePairs,
-                // OUTPUT & outTensor,
-                const int numberOfThreads
-        ) {
-            // Check whether some of the offsets
-            const auto & labels = rag.labels();
-            const auto & shape = rag.shape();
-
-            nifty::parallel::ParallelOptions pOpts(numberOfThreads);
-            nifty::parallel::ThreadPool threadpool(pOpts);
-            const std::size_t actualNumberOfThreads = pOpts.getActualNumThreads();
-
-            // Look for lifted edges:
-            nifty::tools::parallelForEachCoordinate(threadpool,
-                        shape,
-                [&](const auto threadId, const auto & coordP){
-                    const auto u = labels[coordP];
-                    for(int io=0; io<offsets.size(); ++io){
-                        const auto offset = offsets[io];
-                        const auto coordQ = offset + coordP;
-                        // Check if both coordinates are in the volume:
-                        if(coordQ.allInsideShape(shape)){
-                            const auto v = labels[coordQ];
-
-                            // Insert new edge in graph:
-                            if (u != v) {
-                                const auto edge = rag.findEdge(u, v);
-                                if (edge < 0) {
-                                    const std::pair <uint64_t, uint64_t> newPair(u, v);
-                                    longRangePairs[threadId].push_back(newPair);
+        namespace detail_lifted_edges{
+
+            // number of offset links and sum of their affinities for one lifted edge
+            struct LiftedEdgeStatistics{
+                uint64_t count{0};
+                double affinitySum{0.};
+                void merge(const LiftedEdgeStatistics & other){
+                    count += other.count;
+                    affinitySum += other.affinitySum;
+                }
+            };
+
+            typedef std::pair<uint64_t, LiftedEdgeStatistics> KeyAndStatistics;
+
+            // (u, v) with u < v packed into one key, ordered like the pairs
+            inline uint64_t packUv(const uint64_t u, const uint64_t v){
+                return u < v ? ((u << 32) | v) : ((v << 32) | u);
+            }
+
+            // find the lifted edges: every thread deduplicates its pairs in a
+            // hash map, then the maps are merged into one sorted list in parallel,
+            // sharded by the first node of the edges
+            template<std::size_t DIM, class RAG, class AFFINITIES>
+            void liftedEdgesAndStatistics(
+                    const RAG & rag,
+                    const std::vector<array::StaticArray<int64_t, DIM>> & offsets,
+                    const AFFINITIES * affinities,
+                    std::vector<KeyAndStatistics> & out,
+                    const int numberOfThreads
+            ){
+                typedef array::StaticArray<int64_t, DIM + 1> AffinityCoord;
+                typedef std::unordered_map<uint64_t, LiftedEdgeStatistics> MapType;
+
+                const auto & labels = rag.labels();
+                const auto & shape = rag.shape();
+                const uint64_t numberOfNodes = rag.nodeIdUpperBound() + 1;
+                NIFTY_CHECK_OP(numberOfNodes, <=, uint64_t(1) << 32,
+                               "lifted edges can only be computed for less than 2^32 nodes");
+
+                nifty::parallel::ParallelOptions pOpts(numberOfThreads);
+                nifty::parallel::ThreadPool threadpool(pOpts);
+                const std::size_t actualNumberOfThreads = pOpts.getActualNumThreads();
+                std::vector<MapType> threadMaps(actualNumberOfThreads);
+
+                // Look for lifted edges:
+                nifty::tools::parallelForEachCoordinate(threadpool,
+                            shape,
+                    [&](const auto threadId, const auto & coordP){
+                        const uint64_t u = labels[coordP];
+                        auto & threadMap = threadMaps[threadId];
+                        for(int io=0; io<offsets.size(); ++io){
+                            const auto offset = offsets[io];
+                            const auto coordQ = offset + coordP;
+                            // Check if both coordinates are in the volume:
+                            if(coordQ.allInsideShape(shape)){
+                                const uint64_t v = labels[coordQ];
+                                if (u != v && rag.findEdge(u, v) < 0) {
+                                    auto & stats = threadMap[packUv(u, v)];
+                                    ++stats.count;
+                                    if(affinities != nullptr){
+                                        AffinityCoord affCoord;
+                                        affCoord[0] = io;
+                                        for(int d = 0; d < DIM; ++d){
+                                            affCoord[d + 1] = coordP[d];
+                                        }
+                                        stats.affinitySum += xtensor::read(*affinities, affCoord.asStdArray());
+                                    }
                                 }
                             }
                         }
                     }
-                }
                 );
-            return;
 
+                // sort the entries of every thread
+                std::vector<std::vector<KeyAndStatistics>> threadEntries(actualNumberOfThreads);
+                parallel::parallel_foreach(threadpool, actualNumberOfThreads, [&](const int tid, const int64_t t){
+                    auto & entries = threadEntries[t];
+                    entries.assign(threadMaps[t].begin(), threadMaps[t].end());
+                    MapType().swap(threadMaps[t]);
+                    std::sort(entries.begin(), entries.end(), [](const KeyAndStatistics & a, const KeyAndStatistics & b){
+                        return a.first < b.first;
+                    });
+                });
+
+                // merge the thread entries shard by shard, a shard is a range of first nodes
+                const std::size_t nShards = std::max(std::size_t(1), 4 * actualNumberOfThreads);
+                auto shardBegin = [&](const std::size_t s){
+                    return (numberOfNodes * s / nShards) << 32;
+                };
+                std::vector<std::vector<KeyAndStatistics>> shardEntries(nShards);
+                parallel::parallel_foreach(threadpool, nShards, [&](const int tid, const int64_t s){
+                    auto & entries = shardEntries[s];
+                    const auto keyBegin = shardBegin(s);
+                    const auto keyEnd = shardBegin(s + 1);
+                    auto keyLess = [](const KeyAndStatistics & a, const uint64_t key){
+                        return a.first < key;
+                    };
+                    for(const auto & threadEntry : threadEntries){
+                        const auto begin = std::lower_bound(threadEntry.begin(), threadEntry.end(), keyBegin, keyLess);
+                        const auto end = s + 1 == nShards ? threadEntry.end() :
+                            std::lower_bound(begin, threadEntry.end(), keyEnd, keyLess);
+                        const auto middle = entries.size();
+                        entries.insert(entries.end(), begin, end);
+                        std::inplace_merge(entries.begin(), entries.begin() + middle, entries.end(),
+                            [](const KeyAndStatistics & a, const KeyAndStatistics & b){
+                                return a.first < b.first;
+                            }
+                        );
+                    }
+                    // reduce the duplicates of different threads
+                    std::size_t nUnique = 0;
+                    for(std::size_t i = 0; i < entries.size(); ++i){
+                        if(nUnique > 0 && entries[nUnique - 1].first == entries[i].first){
+                            entries[nUnique - 1].second.merge(entries[i].second);
+                        }
+                        else{
+                            entries[nUnique++] = entries[i];
+                        }
+                    }
+                    entries.resize(nUnique);
+                });
+                std::vector<std::vector<KeyAndStatistics>>().swap(threadEntries);
+
+                // concatenate the shards
+                std::vector<std::size_t> shardOffsets(nShards + 1, 0);
+                for(std::size_t s = 0; s < nShards; ++s){
+                    shardOffsets[s + 1] = shardOffsets[s] + shardEntries[s].size();
+                }
+                out.resize(shardOffsets.back());
+                parallel::parallel_foreach(threadpool, nShards, [&](const int tid, const int64_t s){
+                    std::copy(shardEntries[s].begin(), shardEntries[s].end(), out.begin() + shardOffsets[s]);
+                    std::vector<KeyAndStatistics>().swap(shardEntries[s]);
+                });
+            }
+
+        } // namespace detail_lifted_edges
+
+
+        /// Lifted edges of a region adjacency graph: all pairs of
+        /// (non-adjacent) regions that are connected by one of the offsets.
+        ///
+        /// \param uvIds (Output) the unique lifted edges with u < v, sorted
+        ///
+        template<std::size_t DIM, class RAG>
+        void computeLiftedEdgesFromRagAndOffsets(
+                const RAG & rag,
+                const std::vector<array::StaticArray<int64_t, DIM>> & offsets,
+                std::vector<std::pair<uint64_t,uint64_t>> & uvIds,
+                const int numberOfThreads
+        ) {
+            std::vector<detail_lifted_edges::KeyAndStatistics> entries;
+            detail_lifted_edges::liftedEdgesAndStatistics<DIM>(
+                rag, offsets, static_cast<const xt::xtensor<float, DIM + 1> *>(nullptr), entries, numberOfThreads
+            );
+            uvIds.resize(entries.size());
+            for(std::size_t i = 0; i < entries.size(); ++i){
+                uvIds[i] = std::make_pair(entries[i].first >> 32, entries[i].first & 0xFFFFFFFFull);
+            }
+        }
+
+
+        /// Lifted edges of a region adjacency graph together with the number
+        /// of offset links that connect the two regions and, optionally,
+        /// the mean affinity of these links.
+        ///
+        /// \param affinities channel first affinities (offsets x shape),
+        ///                   may be a nullptr if no mean affinities are needed
+        /// \param uvIds (Output) the unique lifted edges with u < v, sorted
+        /// \param counts (Output) the number of links of every lifted edge
+        /// \param meanAffinities (Output) the mean affinity of every lifted edge,
+        ///                       not touched if affinities is a nullptr
+        ///
+        template<std::size_t DIM, class RAG, class AFFINITIES>
+        void computeLiftedEdgesFromRagAndOffsets(
+                const RAG & rag,
+                const std::vector<array::StaticArray<int64_t, DIM>> & offsets,
+                const AFFINITIES * affinities,
+                std::vector<std::pair<uint64_t,uint64_t>> & uvIds,
+                std::vector<uint64_t> & counts,
+                std::vector<double> & meanAffinities,
+                const int numberOfThreads
+        ) {
+            if(affinities != nullptr){
+                NIFTY_CHECK_OP(affinities->shape()[0], ==, offsets.size(), "need one affinity channel per offset");
+                for(int d = 0; d < DIM; ++d){
+                    NIFTY_CHECK_OP(affinities->shape()[d + 1], ==, rag.shape()[d], "affinities and labels have different shapes");
+                }
+            }
+            std::vector<detail_lifted_edges::KeyAndStatistics> entries;
+            detail_lifted_edges::liftedEdgesAndStatistics<DIM>(rag, offsets, affinities, entries, numberOfThreads);
+            uvIds.resize(entries.size());
+            counts.resize(entries.size());
+            if(affinities != nullptr){
+                meanAffinities.resize(entries.size());
+            }
+            for(std::size_t i = 0; i < entries.size(); ++i){
+                const auto & stats = entries[i].second;
+                uvIds[i] = std::make_pair(entries[i].first >> 32, entries[i].first & 0xFFFFFFFFull);
+                counts[i] = stats.count;
+                if(affinities != nullptr){
+                    meanAffinities[i] = stats.affinitySum / double(stats.count);
+                }
+            }
         }
 
 
     }
 }
-
@@ -6,6 +6,8 @@
 
 #include "nifty/graph/rag/grid_rag.hxx"
 #include "nifty/tools/for_each_block.hxx"
+#include "nifty/tools/block_pipeline.hxx"
+#include "nifty/tools/label_boundary_scan.hxx"
 #include "nifty/parallel/threadpool.hxx"
 #include "vigra/accumulator.hxx"
 
@@ -72,6 +74,7 @@ namespace graph{
                                             const AccOptions & accOptions = AccOptions()){
 
         typedef LABELS LabelsType;
+        typedef typename LabelsType::value_type LabelType;
         typedef typename DATA::value_type DataType;
         typedef typename vigra::MultiArrayShape<DIM>::type VigraCoord;
         typedef typename GridRag<DIM, LabelsType>::BlockStorageType LabelBlockStorage;
@@ -116,6 +119,7 @@ namespace graph{
             // LOOP IN PARALLEL OVER ALL BLOCKS WITH A CERTAIN OVERLAP
             const Coord overlapBegin(0), overlapEnd(1);
             const Coord storageShape = blockShape + overlapEnd;
+            const auto storageStrides = tools::cOrderStrides<DIM>(storageShape);
             LabelBlockStorage labelsBlockStorage(threadpool, storageShape, actualNumberOfThreads);
             DataBlockStorage dataBlockStorage(threadpool, storageShape, actualNumberOfThreads);
             tools::parallelForEachBlockWithOverlap(threadpool,shape, blockShape, overlapBegin, overlapEnd,
@@ -139,32 +143,26 @@ namespace graph{
                 tools::readSubarray(rag.labels(), blockBegin, blockEnd, labelsBlockView);
                 tools::readSubarray(data, blockBegin, blockEnd, dataBlockView);
 
-                // loop over all coordinates in block
-                nifty::tools::forEachCoordinate(nonOlBlockShape,[&](const Coord & coordU){
-                    const auto lU = xtensor::read(labelsBlockView, coordU.asStdArray());
-                    for(std::size_t axis=0; axis<DIM; ++axis){
-                        auto coordV = makeCoord2(coordU, axis);
-                        if(coordV[axis] < actualBlockShape[axis]){
-                            const auto lV = xtensor::read(labelsBlockView, coordV.asStdArray());
-                            if(lU != lV){
-                                const auto edge = rag.findEdge(lU,lV);
-
-                                const auto dataU = xtensor::read(dataBlockView, coordU.asStdArray());
-                                const auto dataV = xtensor::read(dataBlockView, coordV.asStdArray());
+                // only visit the voxel pairs on the boundaries between labels
+                const auto * labelsData = labelsBlockStorage.getView(tid).data();
+                tools::forEachLabelBoundary(labelsData, storageStrides, nonOlBlockShape, actualBlockShape,
+                [&](const std::size_t axis, const Coord & coordU, const LabelType lU, const LabelType lV){
+                    auto coordV = makeCoord2(coordU, axis);
+                    const auto edge = rag.findEdge(lU,lV);
 
-                                VigraCoord vigraCoordU;
-                                VigraCoord vigraCoordV;
+                    const auto dataU = xtensor::read(dataBlockView, coordU.asStdArray());
+                    const auto dataV = xtensor::read(dataBlockView, coordV.asStdArray());
 
-                                for(std::size_t d=0; d<DIM; ++d){
-                                    vigraCoordU[d] = coordU[d]+blockBegin[d];
-                                    vigraCoordV[d] = coordV[d]+blockBegin[d];
-                                }
+                    VigraCoord vigraCoordU;
+                    VigraCoord vigraCoordV;
 
-                                accVec[edge].updatePassN(dataU, vigraCoordU, pass);
-                                accVec[edge].updatePassN(dataV, vigraCoordV, pass);
-                            }
-                        }
+                    for(std::size_t d=0; d<DIM; ++d){
+                        vigraCoordU[d] = coordU[d]+blockBegin[d];
+                        vigraCoordV[d] = coordV[d]+blockBegin[d];
                     }
+
+                    accVec[edge].updatePassN(dataU, vigraCoordU, pass);
+                    accVec[edge].updatePassN(dataV, vigraCoordV, pass);
                 });
             });
         }
@@ -369,7 +367,8 @@ namespace graph{
                                                    const parallel::ParallelOptions & pOpts,
                                                    parallel::ThreadPool & threadpool,
                                                    F && f,
-                                                   const AccOptions & accOptions = AccOptions()){
+                                                   const AccOptions & accOptions = AccOptions(),
+                                                   const int numberOfIoThreads = 0){
         //std::cout<<"A\n";
 
         typedef LABELS LabelsType;
@@ -437,84 +436,119 @@ namespace graph{
 
         //std::cout<<"E\n";
 
-        // do N passes of accumulator
-        for(auto pass=1; pass <= numberOfPasses; ++pass){
-
-
-            // LOOP IN PARALLEL OVER ALL BLOCKS WITH A CERTAIN OVERLAP
-            const Coord overlapBegin(0), overlapEnd(1);
-            const Coord storageShape = blockShape + overlapEnd;
-            LabelBlockStorage labelsBlockStorage(threadpool, storageShape, actualNumberOfThreads);
-            DataBlockStorage dataBlockStorage(threadpool, storageShape, actualNumberOfThreads);
-            tools::parallelForEachBlockWithOverlap(threadpool,shape, blockShape, overlapBegin, overlapEnd,
-            [&](
-                const int tid,
-                const Coord & blockCoreBegin, const Coord & blockCoreEnd,
-                const Coord & blockBegin, const Coord & blockEnd
-            ){
-                //std::cout<<"E1\n";
-                // get the accumulator vector for this thread
-                auto & edgeAccVec = *(perThreadEdgeAccChainVector[tid]);
-                auto & nodeAccVec = *(perThreadNodeAccChainVector[tid]);
-                // actual shape of the block: might be smaller at the border as blockShape
-
-                //std::cout<<"E2\n";
-                const auto nonOlBlockShape  = blockCoreEnd - blockCoreBegin;
-                const auto actualBlockShape = blockEnd - blockBegin;
-
-                //std::cout<<"E3\n";
-                // read the labels block and the data block
-                auto labelsBlockView = labelsBlockStorage.getView(actualBlockShape, tid);
-                auto dataBlockView = dataBlockStorage.getView(actualBlockShape, tid);
-
-                //std::cout<<"E4 1\n";
-                tools::readSubarray(rag.labels(), blockBegin, blockEnd, labelsBlockView);
-
-                //std::cout<<"E4 2\n";
-                tools::readSubarray(data, blockBegin, blockEnd, dataBlockView);
-
-                //std::cout<<"E5\n";
-                // loop over all coordinates in block
-                nifty::tools::forEachCoordinate(nonOlBlockShape,[&](const Coord & coordU){
-
-                    const auto lU = xtensor::read(labelsBlockView, coordU.asStdArray());
-                    const auto dataU = xtensor::read(dataBlockView, coordU.asStdArray());
-
-                    VigraCoord vigraCoordU;
-                    for(std::size_t d=0; d<DIM; ++d){
-                        vigraCoordU[d] = coordU[d] + blockBegin[d];
-                        NIFTY_CHECK_OP(vigraCoordU[d], < ,shape[d],"");
-                    }
-
-                    if(pass <= numberOfNodePasses)
-                        nodeAccVec[lU].updatePassN(dataU, vigraCoordU, pass);
+        // accumulate the core of a block, the block views start at blockBegin
+        // and overlap by one pixel in the upper direction
+        auto accumulateBlock = [&](const int tid, const int pass,
+                                   const Coord & blockBegin,
+                                   const Coord & nonOlBlockShape,
+                                   const Coord & actualBlockShape,
+                                   const auto & labelsBlockView,
+                                   const auto & dataBlockView){
+            // get the accumulator vector for this thread
+            auto & edgeAccVec = *(perThreadEdgeAccChainVector[tid]);
+            auto & nodeAccVec = *(perThreadNodeAccChainVector[tid]);
+
+            // loop over all coordinates in block
+            nifty::tools::forEachCoordinate(nonOlBlockShape,[&](const Coord & coordU){
+
+                const auto lU = xtensor::read(labelsBlockView, coordU.asStdArray());
+                const auto dataU = xtensor::read(dataBlockView, coordU.asStdArray());
+
+                VigraCoord vigraCoordU;
+                for(std::size_t d=0; d<DIM; ++d){
+                    vigraCoordU[d] = coordU[d] + blockBegin[d];
+                    NIFTY_CHECK_OP(vigraCoordU[d], < ,shape[d],"");
+                }
 
-                    // accumulate the edge features
-                    if(pass <= numberOfEdgePasses){
-                        for(std::size_t axis=0; axis<DIM; ++axis){
-                            auto coordV = makeCoord2(coordU, axis);
-                            if(coordV[axis] < actualBlockShape[axis]){
-                                const auto lV = xtensor::read(labelsBlockView, coordV.asStdArray());
-                                if(lU != lV){
+                if(pass <= numberOfNodePasses)
+                    nodeAccVec[lU].updatePassN(dataU, vigraCoordU, pass);
 
-                                    const auto edge = rag.findEdge(lU,lV);
-                                    const auto dataV = xtensor::read(dataBlockView, coordV.asStdArray());
+                // accumulate the edge features
+                if(pass <= numberOfEdgePasses){
+                    for(std::size_t axis=0; axis<DIM; ++axis){
+                        auto coordV = makeCoord2(coordU, axis);
+                        if(coordV[axis] < actualBlockShape[axis]){
+                            const auto lV = xtensor::read(labelsBlockView, coordV.asStdArray());
+                            if(lU != lV){
 
-                                    VigraCoord vigraCoordV;
-                                    for(std::size_t d=0; d<DIM; ++d){
-                                        vigraCoordV[d] = coordV[d] + blockBegin[d];
-                                        NIFTY_CHECK_OP(vigraCoordV[d], < ,shape[d],"");
-                                    }
+                                const auto edge = rag.findEdge(lU,lV);
+                                const auto dataV = xtensor::read(dataBlockView, coordV.asStdArray());
 
-                                    edgeAccVec[edge].updatePassN(dataU, vigraCoordU, pass);
-                                    edgeAccVec[edge].updatePassN(dataV, vigraCoordV, pass);
+                                VigraCoord vigraCoordV;
+                                for(std::size_t d=0; d<DIM; ++d){
+                                    vigraCoordV[d] = coordV[d] + blockBegin[d];
+                                    NIFTY_CHECK_OP(vigraCoordV[d], < ,shape[d],"");
                                 }
+
+                                edgeAccVec[edge].updatePassN(dataU, vigraCoordU, pass);
+                                edgeAccVec[edge].updatePassN(dataV, vigraCoordV, pass);
                             }
                         }
                     }
+                }
 
-                });
             });
+        };
+
+        const Coord overlapBegin(0), overlapEnd(1);
+
+        // read the label and data blocks ahead in dedicated io threads
+        if(numberOfIoThreads > 0){
+            typedef typename GridRag<DIM, LabelsType>::value_type LabelType;
+            typedef tools::BlockPipeline<LabelType, DIM> BlockPipelineType;
+            typename BlockPipelineType::SettingsType settings;
+            settings.numberOfThreads = pOpts.getNumThreads();
+            settings.numberOfIoThreads = numberOfIoThreads;
+
+            const Coord roiBegin(0);
+            Coord roiEnd;
+            std::copy(shape.begin(), shape.end(), roiEnd.begin());
+            BlockPipelineType pipeline(tools::Blocking<DIM>(roiBegin, roiEnd, blockShape),
+                                       overlapBegin, overlapEnd, settings);
+
+            // do N passes of accumulator
+            for(auto pass=1; pass <= numberOfPasses; ++pass){
+                pipeline.runJoint(rag.labels(), data,
+                [&](const int tid, const uint64_t blockId,
+                    const typename BlockPipelineType::BlockWithHaloType & blockWithHalo,
+                    const auto & labelsBlockView, const auto & dataBlockView){
+                    const auto & outerBlock = blockWithHalo.outerBlock();
+                    accumulateBlock(tid, pass,
+                                    outerBlock.begin(),
+                                    blockWithHalo.innerBlock().shape(),
+                                    outerBlock.shape(),
+                                    labelsBlockView, dataBlockView);
+                });
+            }
+        }
+        else{
+            // do N passes of accumulator
+            for(auto pass=1; pass <= numberOfPasses; ++pass){
+
+                // LOOP IN PARALLEL OVER ALL BLOCKS WITH A CERTAIN OVERLAP
+                const Coord storageShape = blockShape + overlapEnd;
+                LabelBlockStorage labelsBlockStorage(threadpool, storageShape, actualNumberOfThreads);
+                DataBlockStorage dataBlockStorage(threadpool, storageShape, actualNumberOfThreads);
+                tools::parallelForEachBlockWithOverlap(threadpool,shape, blockShape, overlapBegin, overlapEnd,
+                [&](
+                    const int tid,
+                    const Coord & blockCoreBegin, const Coord & blockCoreEnd,
+                    const Coord & blockBegin, const Coord & blockEnd
+                ){
+                    // actual shape of the block: might be smaller at the border as blockShape
+                    const auto nonOlBlockShape  = blockCoreEnd - blockCoreBegin;
+                    const auto actualBlockShape = blockEnd - blockBegin;
+
+                    // read the labels block and the data block
+                    auto labelsBlockView = labelsBlockStorage.getView(actualBlockShape, tid);
+                    auto dataBlockView = dataBlockStorage.getView(actualBlockShape, tid);
+                    tools::readSubarray(rag.labels(), blockBegin, blockEnd, labelsBlockView);
+                    tools::readSubarray(data, blockBegin, blockEnd, dataBlockView);
+
+                    accumulateBlock(tid, pass, blockBegin, nonOlBlockShape, actualBlockShape,
+                                    labelsBlockView, dataBlockView);
+                });
+            }
         }
 
         auto & edgeResultAccVec = *perThreadEdgeAccChainVector.front();
@@ -902,7 +936,8 @@ namespace graph{
                                  xt::xexpression<FEATURE_TYPE> & edgeFeaturesOutExp,
                                  xt::xexpression<FEATURE_TYPE> & nodeFeaturesOutExp,
                                  const int numberOfThreads = -1,
-                                 const bool saveMemory = false){
+                                 const bool saveMemory = false,
+                                 const int numberOfIoThreads = 0){
         namespace acc = vigra::acc;
 
         typedef typename FEATURE_TYPE::value_type DataType;
@@ -937,7 +972,7 @@ namespace graph{
                     nodeFeaturesOut(node, 0) = acc::get<acc::Mean>(nodeAccChainVec[node]);
                     nodeFeaturesOut(node, 1) = acc::get<acc::Count>(nodeAccChainVec[node]);
                 });
-            });
+            }, AccOptions(), numberOfIoThreads);
         }
     }
 
@@ -988,7 +1023,8 @@ namespace graph{
         const array::StaticArray<int64_t, DIM> & blockShape,
         xt::xexpression<FEATURE_TYPE> & edgeFeaturesOutExp,
         xt::xexpression<FEATURE_TYPE> & nodeFeaturesOutExp,
-        const int numberOfThreads = -1
+        const int numberOfThreads = -1,
+        const int numberOfIoThreads = 0
     ){
         namespace acc = vigra::acc;
         typedef typename FEATURE_TYPE::value_type DataType;
@@ -1057,7 +1093,8 @@ namespace graph{
                     }
                 });
 
-            },AccOptions(minVal, maxVal)
+            },AccOptions(minVal, maxVal),
+            numberOfIoThreads
         );
     }
 
@@ -4,6 +4,7 @@
 #include <algorithm>
 
 #include "nifty/tools/for_each_coordinate.hxx"
+#include "nifty/tools/block_pipeline.hxx"
 #include "nifty/array/arithmetic_array.hxx"
 
 #include "nifty/xtensor/xtensor.hxx"
@@ -43,6 +44,51 @@ void projectScalarNodeDataToPixels(const GridRag<DIM, LABELS> & graph,
 }
 
 
+// boundary map from edge data: every pixel gets the maximum value of the
+// edges between its node and the nodes of its direct neighbours, pixels
+// inside of a node get 0; with ultrametric edge values (see
+// agglo::MergeTree::edgeUcm) this is the ultrametric contour map of the labels
+template<std::size_t DIM,
+         class LABELS,
+         class PIXEL_ARRAY,
+         class EDGE_MAP>
+void projectEdgeDataToPixels(const GridRag<DIM, LABELS> & graph,
+                             const EDGE_MAP & edgeData,
+                             PIXEL_ARRAY & pixelData,
+                             const int numberOfThreads=-1){
+
+    typedef array::StaticArray<int64_t, DIM> Coord;
+    typedef typename PIXEL_ARRAY::value_type DataType;
+
+    const auto & labels = graph.labels();
+    const auto & shape = graph.shape();
+
+    nifty::parallel::ThreadPool threadpool(numberOfThreads);
+    nifty::tools::parallelForEachCoordinate(threadpool, shape,
+    [&](int tid, const Coord & coord){
+        const auto u = xtensor::read(labels, coord.asStdArray());
+        DataType value = 0;
+        for(unsigned d = 0; d < DIM; ++d){
+            for(const int64_t step : {int64_t(-1), int64_t(1)}){
+                Coord ngb = coord;
+                ngb[d] += step;
+                if(ngb[d] < 0 || ngb[d] >= shape[d]){
+                    continue;
+                }
+                const auto v = xtensor::read(labels, ngb.asStdArray());
+                if(u != v){
+                    const auto edge = graph.findEdge(u, v);
+                    if(edge >= 0){
+                        value = std::max(value, static_cast<DataType>(edgeData[edge]));
+                    }
+                }
+            }
+        }
+        xtensor::write(pixelData, coord.asStdArray(), value);
+    });
+}
+
+
 template<std::size_t DIM,
          class LABELS,
          class PIXEL_ARRAY,
@@ -51,7 +97,8 @@ void projectScalarNodeDataToPixelsOutOfCore(const GridRag<DIM, LABELS> & graph,
                                             NODE_MAP & nodeData,
                                             PIXEL_ARRAY & pixelData,
                                             array::StaticArray<int64_t, DIM> blockShape,
-                                            const int numberOfThreads=-1){
+                                            const int numberOfThreads=-1,
+                                            const int numberOfIoThreads=0){
 
     typedef array::StaticArray<int64_t, DIM> Coord;
     typedef typename LABELS::value_type LabelType;
@@ -61,6 +108,46 @@ void projectScalarNodeDataToPixelsOutOfCore(const GridRag<DIM, LABELS> & graph,
     const auto & labels = graph.labels();
     const auto & shape = graph.shape();
 
+    // read the label blocks ahead in dedicated io threads
+    if(numberOfIoThreads > 0){
+        typedef tools::BlockPipeline<LabelType, DIM> BlockPipelineType;
+        typename BlockPipelineType::SettingsType settings;
+        settings.numberOfThreads = numberOfThreads;
+        settings.numberOfIoThreads = numberOfIoThreads;
+
+        const Coord roiBegin(0);
+        Coord roiEnd;
+        std::copy(shape.begin(), shape.end(), roiEnd.begin());
+        BlockPipelineType pipeline(tools::Blocking<DIM>(roiBegin, roiEnd, blockShape),
+                                   Coord(0), settings);
+
+        const std::size_t nThreads = nifty::parallel::ParallelOptions(numberOfThreads).getActualNumThreads();
+        std::vector<xt::xtensor<DataType, DIM>> perThreadBlockData(nThreads);
+
+        pipeline.run(labels, [&](const int tid, const uint64_t blockId,
+                                 const typename BlockPipelineType::BlockWithHaloType & blockWithHalo,
+                                 auto & blockLabels){
+            const auto & block = blockWithHalo.outerBlock();
+            const auto actualBlockShape = block.shape();
+            auto & blockData = perThreadBlockData[tid];
+
+            bool haveDataShape = blockData.dimension() == DIM;
+            for(unsigned d = 0; d < DIM && haveDataShape; ++d) {
+                haveDataShape = actualBlockShape[d] == blockData.shape()[d];
+            }
+            if(!haveDataShape) {
+                ArrayShape blockArrayShape;
+                std::copy(actualBlockShape.begin(), actualBlockShape.end(), blockArrayShape.begin());
+                blockData.resize(blockArrayShape);
+            }
+
+            std::transform(blockLabels.begin(), blockLabels.end(), blockData.begin(),
+                           [&](const LabelType node){return nodeData[node];});
+            tools::writeSubarray(pixelData, block.begin(), block.end(), blockData);
+        });
+        return;
+    }
+
     nifty::parallel::ThreadPool threadpool(numberOfThreads);
     struct PerThreadData{
         xt::xtensor<LabelType, DIM> blockLabels;
@@ -1,9 +1,17 @@
 #pragma once
 
+#include <algorithm>
 #include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <mutex>
 #include <string>
 #include <vector>
 
+#ifdef WITH_ZLIB
+#include <zlib.h>
+#endif
+
 #include "xtensor/xarray.hpp"
 
 #include "nifty/hdf5/hdf5.hxx"
@@ -13,6 +21,28 @@
 namespace nifty{
 namespace hdf5{
 
+    // H5Dread_chunk / H5Dget_chunk_storage_size were added in hdf5 1.10.2
+    #if H5_VERSION_GE(1, 10, 2)
+    #define NIFTY_HDF5_HAS_DIRECT_CHUNK_READ
+    #endif
+
+    // libhdf5 is not reentrant (and serializes all calls in threadsafe
+    // builds anyway), so all hdf5 calls of Hdf5Array go through this lock
+    inline std::mutex & hdf5Mutex(){
+        static std::mutex mutex;
+        return mutex;
+    }
+
+    // how Hdf5Array::readSubarray gets the data
+    //  - HYPERSLAB_READ:    H5Dread of a hyperslab, decompression happens
+    //                       inside libhdf5 and hence under the lock
+    //  - DIRECT_CHUNK_READ: fetch the raw (compressed) chunks with H5Dread_chunk
+    //                       under the lock, decompress and scatter them
+    //                       in the calling thread without holding the lock;
+    //                       datasets with filters other than deflate and shuffle
+    //                       fall back to HYPERSLAB_READ
+    enum ReadMode {HYPERSLAB_READ, DIRECT_CHUNK_READ};
+
     template<class T>
     class Hdf5Array{
     public:
@@ -32,8 +62,13 @@ namespace hdf5{
         :   groupHandle_(groupHandle),
             dataset_(),
             datatype_(),
-            isChunked_(true)
+            isChunked_(true),
+            readMode_(HYPERSLAB_READ),
+            filters_(),
+            fillValue_(0),
+            directChunkReadable_(false)
         {
+            std::lock_guard<std::mutex> lock(hdf5Mutex());
             datatype_ = H5Tcopy(hdf5Type<T>());
             const auto dim = std::distance(shapeBegin, shapeEnd);
 
@@ -81,6 +116,7 @@ namespace hdf5{
             // close the dataspace and the chunk properties
             H5Sclose(dataspace);
             H5Pclose(dcplId);
+            this->loadFilters();
         }
 
 
@@ -95,8 +131,13 @@ namespace hdf5{
         :   groupHandle_(groupHandle),
             dataset_(),
             datatype_(),
-            isChunked_(false)
+            isChunked_(false),
+            readMode_(HYPERSLAB_READ),
+            filters_(),
+            fillValue_(0),
+            directChunkReadable_(false)
         {
+            std::lock_guard<std::mutex> lock(hdf5Mutex());
             datatype_ = H5Tcopy(hdf5Type<T>());
             const auto dim = std::distance(shapeBegin, shapeEnd);
 
@@ -127,6 +168,7 @@ namespace hdf5{
             // close the dataspace and the chunk properties
             H5Sclose(dataspace);
             H5Pclose(dcplId);
+            this->loadFilters();
         }
 
         Hdf5Array(
@@ -136,9 +178,13 @@ namespace hdf5{
         :   groupHandle_(groupHandle),
             dataset_(),
             datatype_(),
-            isChunked_(true)
+            isChunked_(true),
+            readMode_(HYPERSLAB_READ),
+            filters_(),
+            fillValue_(0),
+            directChunkReadable_(false)
         {
-
+            std::lock_guard<std::mutex> lock(hdf5Mutex());
             dataset_ = H5Dopen(groupHandle_, datasetName.c_str(), H5P_DEFAULT);
             if(dataset_ < 0) {
                 throw std::runtime_error("Ccannot open dataset.");
@@ -153,6 +199,7 @@ namespace hdf5{
 
             this->loadShape(shape_);
             this->loadChunkShape(chunkShape_);
+            this->loadFilters();
         }
 
         int setCache(){
@@ -160,6 +207,7 @@ namespace hdf5{
         }
 
         ~Hdf5Array(){
+            std::lock_guard<std::mutex> lock(hdf5Mutex());
             H5Tclose(datatype_);
             H5Dclose(dataset_);
         }
@@ -188,6 +236,21 @@ namespace hdf5{
             return isChunked_;
         }
 
+        // can the dataset be read with DIRECT_CHUNK_READ
+        bool supportsDirectChunkRead()const{
+            return directChunkReadable_;
+        }
+
+        ReadMode readMode()const{
+            return readMode_;
+        }
+
+        void setReadMode(const ReadMode readMode){
+            readMode_ = readMode;
+        }
+
+        // thread safe, in DIRECT_CHUNK_READ mode concurrent calls
+        // only serialize on fetching the raw chunks
         template<class ITER, class ARRAY>
         void readSubarray(
             ITER roiBeginIter,
@@ -196,9 +259,14 @@ namespace hdf5{
             NIFTY_CHECK_OP(out.dimension(),==,
                            this->dimension(),
                            "out has wrong dimension");
-            this->loadHyperslab(roiBeginIter,
-                                roiBeginIter + out.dimension(),
-                                out.shape().begin(), out);
+            if(readMode_ == DIRECT_CHUNK_READ && directChunkReadable_){
+                this->loadChunksDirect(roiBeginIter, out);
+            }
+            else{
+                this->loadHyperslab(roiBeginIter,
+                                    roiBeginIter + out.dimension(),
+                                    out.shape().begin(), out);
+            }
         }
 
         template<class ITER, class ARRAY>
@@ -235,6 +303,7 @@ namespace hdf5{
                 ++shapeBegin;
             }
 
+            std::lock_guard<std::mutex> lock(hdf5Mutex());
             hid_t dataspace = H5Dget_space(dataset_);
             if(dataspace < 0) {
                 throw std::runtime_error("Can't open dataspace!");
@@ -295,6 +364,7 @@ namespace hdf5{
             }
 
             // select dataspace hyperslab
+            std::lock_guard<std::mutex> lock(hdf5Mutex());
             hid_t dataspace = H5Dget_space(dataset_);
             herr_t status = H5Sselect_hyperslab(dataspace, H5S_SELECT_SET,
                 &offset[0], NULL, &slabShape[0], NULL);
@@ -326,6 +396,224 @@ namespace hdf5{
             }
         }
 
+        template<class ITER, class ARRAY>
+        void loadChunksDirect(
+            ITER roiBeginIter,
+            ARRAY & out
+        ) const {
+            const std::size_t dim = this->dimension();
+            std::vector<uint64_t> roiBegin(dim), roiEnd(dim);
+            std::vector<uint64_t> chunkBegin(dim), chunkEnd(dim);
+            std::size_t chunkSize = 1;
+            for(std::size_t d = 0; d < dim; ++d) {
+                roiBegin[d] = *roiBeginIter;
+                roiEnd[d] = roiBegin[d] + out.shape()[d];
+                NIFTY_CHECK_OP(roiEnd[d], <=, shape_[d], "roi exceeds the dataset");
+                if(roiEnd[d] == roiBegin[d]) {
+                    return;
+                }
+                chunkBegin[d] = roiBegin[d] / chunkShape_[d];
+                chunkEnd[d] = (roiEnd[d] - 1) / chunkShape_[d] + 1;
+                chunkSize *= chunkShape_[d];
+                ++roiBeginIter;
+            }
+
+            std::vector<char> rawChunk;
+            std::vector<T> chunk(chunkSize);
+            std::vector<hsize_t> chunkOffset(dim);
+            std::vector<uint64_t> chunkCoord = chunkBegin;
+            for(;;) {
+                for(std::size_t d = 0; d < dim; ++d) {
+                    chunkOffset[d] = chunkCoord[d] * chunkShape_[d];
+                }
+
+                uint32_t filterMask = 0;
+                if(this->readRawChunk(chunkOffset, rawChunk, filterMask)) {
+                    this->decodeChunk(rawChunk, filterMask, chunk);
+                }
+                else {
+                    // the chunk was never written
+                    std::fill(chunk.begin(), chunk.end(), fillValue_);
+                }
+                this->scatterChunk(chunk, chunkOffset, roiBegin, roiEnd, out);
+
+                // next chunk, the last axis runs fastest
+                int d = int(dim) - 1;
+                for(; d >= 0; --d) {
+                    if(++chunkCoord[d] < chunkEnd[d]) {
+                        break;
+                    }
+                    chunkCoord[d] = chunkBegin[d];
+                }
+                if(d < 0) {
+                    break;
+                }
+            }
+        }
+
+        // the only part of a direct read that holds the lock,
+        // returns false for chunks that are not allocated
+        bool readRawChunk(
+            const std::vector<hsize_t> & chunkOffset,
+            std::vector<char> & rawChunk,
+            uint32_t & filterMask
+        ) const {
+            #ifdef NIFTY_HDF5_HAS_DIRECT_CHUNK_READ
+            std::lock_guard<std::mutex> lock(hdf5Mutex());
+            // unallocated chunks are reported as errors by some hdf5 versions,
+            // silence the error stack for them
+            hsize_t nBytes = 0;
+            herr_t status = -1;
+            H5E_BEGIN_TRY {
+                status = H5Dget_chunk_storage_size(dataset_, chunkOffset.data(), &nBytes);
+            } H5E_END_TRY;
+            if(status < 0 || nBytes == 0) {
+                return false;
+            }
+            rawChunk.resize(nBytes);
+            if(H5Dread_chunk(dataset_, H5P_DEFAULT, chunkOffset.data(), &filterMask, rawChunk.data()) < 0) {
+                throw std::runtime_error("Cannot read chunk from dataset.");
+            }
+            return true;
+            #else
+            throw std::runtime_error("direct chunk reads need hdf5 >= 1.10.2");
+            #endif
+        }
+
+        // undo the filter pipeline in reverse order,
+        // a set bit i in filterMask means that filter i was skipped for this chunk
+        void decodeChunk(
+            std::vector<char> & rawChunk,
+            const uint32_t filterMask,
+            std::vector<T> & chunk
+        ) const {
+            const std::size_t chunkBytes = chunk.size() * sizeof(T);
+            std::vector<char> buffer;
+            for(int i = int(filters_.size()) - 1; i >= 0; --i) {
+                if(filterMask & (1u << i)) {
+                    continue;
+                }
+                buffer.resize(chunkBytes);
+                if(filters_[i] == H5Z_FILTER_DEFLATE) {
+                    #ifdef WITH_ZLIB
+                    uLongf outBytes = chunkBytes;
+                    const auto status = uncompress(reinterpret_cast<Bytef *>(buffer.data()), &outBytes,
+                                                   reinterpret_cast<const Bytef *>(rawChunk.data()),
+                                                   rawChunk.size());
+                    if(status != Z_OK) {
+                        throw std::runtime_error("Cannot inflate chunk.");
+                    }
+                    buffer.resize(outBytes);
+                    #endif
+                }
+                else if(filters_[i] == H5Z_FILTER_SHUFFLE) {
+                    // byte k of element j is stored at k * nElements + j,
+                    // trailing bytes that do not form a full element are not shuffled
+                    const std::size_t nElements = rawChunk.size() / sizeof(T);
+                    buffer.resize(rawChunk.size());
+                    for(std::size_t k = 0; k < sizeof(T); ++k) {
+                        const char * src = rawChunk.data() + k * nElements;
+                        for(std::size_t j = 0; j < nElements; ++j) {
+                            buffer[j * sizeof(T) + k] = src[j];
+                        }
+                    }
+                    std::copy(rawChunk.begin() + nElements * sizeof(T), rawChunk.end(),
+                              buffer.begin() + nElements * sizeof(T));
+                }
+                rawChunk.swap(buffer);
+            }
+            NIFTY_CHECK_OP(rawChunk.size(), ==, chunkBytes, "decoded chunk has wrong size");
+            std::memcpy(chunk.data(), rawChunk.data(), chunkBytes);
+        }
+
+        // copy the intersection of a (full) chunk and the roi to out
+        template<class ARRAY>
+        void scatterChunk(
+            const std::vector<T> & chunk,
+            const std::vector<hsize_t> & chunkOffset,
+            const std::vector<uint64_t> & roiBegin,
+            const std::vector<uint64_t> & roiEnd,
+            ARRAY & out
+        ) const {
+            const std::size_t dim = this->dimension();
+            std::vector<uint64_t> begin(dim), end(dim), chunkStrides(dim, 1);
+            for(std::size_t d = 0; d < dim; ++d) {
+                begin[d] = std::max<uint64_t>(roiBegin[d], chunkOffset[d]);
+                end[d] = std::min<uint64_t>(roiEnd[d], chunkOffset[d] + chunkShape_[d]);
+            }
+            for(int d = int(dim) - 2; d >= 0; --d) {
+                chunkStrides[d] = chunkStrides[d + 1] * chunkShape_[d + 1];
+            }
+
+            // iterate over the rows along the last axis
+            const std::size_t rowLength = end[dim - 1] - begin[dim - 1];
+            const auto outStride = out.strides()[dim - 1];
+            std::vector<uint64_t> coord = begin;
+            std::vector<std::size_t> outCoord(dim);
+            for(;;) {
+                std::size_t chunkIndex = 0;
+                for(std::size_t d = 0; d < dim; ++d) {
+                    chunkIndex += (coord[d] - chunkOffset[d]) * chunkStrides[d];
+                    outCoord[d] = coord[d] - roiBegin[d];
+                }
+                const T * src = chunk.data() + chunkIndex;
+                T * dst = &out.element(outCoord.begin(), outCoord.end());
+                if(outStride == 1) {
+                    std::copy(src, src + rowLength, dst);
+                }
+                else {
+                    for(std::size_t i = 0; i < rowLength; ++i) {
+                        dst[i * outStride] = src[i];
+                    }
+                }
+
+                int d = int(dim) - 2;
+                for(; d >= 0; --d) {
+                    if(++coord[d] < end[d]) {
+                        break;
+                    }
+                    coord[d] = begin[d];
+                }
+                if(d < 0) {
+                    break;
+                }
+            }
+        }
+
+        // the filter pipeline and fill value, needed for direct chunk reads
+        void loadFilters(){
+            filters_.clear();
+            directChunkReadable_ = false;
+            auto plist = H5Dget_create_plist(dataset_);
+
+            bool supported = isChunked_;
+            const int nFilters = H5Pget_nfilters(plist);
+            for(int i = 0; i < nFilters; ++i) {
+                unsigned int flags = 0;
+                std::size_t nValues = 0;
+                unsigned int filterConfig = 0;
+                const H5Z_filter_t filter = H5Pget_filter2(plist, unsigned(i), &flags, &nValues,
+                                                           NULL, 0, NULL, &filterConfig);
+                filters_.push_back(filter);
+                #ifdef WITH_ZLIB
+                const bool deflateSupported = true;
+                #else
+                const bool deflateSupported = false;
+                #endif
+                if(!(filter == H5Z_FILTER_SHUFFLE || (filter == H5Z_FILTER_DEFLATE && deflateSupported))) {
+                    supported = false;
+                }
+            }
+            if(H5Pget_fill_value(plist, hdf5Type<T>(), &fillValue_) < 0) {
+                fillValue_ = T(0);
+            }
+            H5Pclose(plist);
+
+            #ifdef NIFTY_HDF5_HAS_DIRECT_CHUNK_READ
+            directChunkReadable_ = supported;
+            #endif
+        }
+
         void loadShape(std::vector<uint64_t> & shapeVec){
 
             hid_t filespace = H5Dget_space(dataset_);
@@ -385,6 +673,10 @@ namespace hdf5{
         std::vector<uint64_t> shape_;
         std::vector<uint64_t> chunkShape_;
         bool isChunked_;
+        ReadMode readMode_;
+        std::vector<H5Z_filter_t> filters_;
+        T fillValue_;
+        bool directChunkReadable_;
     };
 } // namespace nifty::hdf5
 
@@ -0,0 +1,207 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <type_traits>
+#include <vector>
+
+#include "nifty/histogram/histogram.hxx"
+
+namespace nifty{
+namespace histogram{
+
+    /**
+     * @brief      Many histograms with the same range and number of bins
+     *             in one contiguous (numberOfHistograms x numberOfBins) array.
+     *
+     * Min, max and bin width are shared and every histogram only stores
+     * its bin counts and their sum, so the memory per histogram is
+     * numberOfBins * sizeof(BINCOUNT) + sizeof(double) without any
+     * per histogram allocation.
+     * Inserting, merging and rank queries behave like nifty::histogram::Histogram.
+     *
+     * @tparam     T         value type
+     * @tparam     BINCOUNT  floating point type of the bin counts, inserts
+     *                       are weighted and split between neighbouring bins
+     */
+    template<class T, class BINCOUNT=float>
+    class HistogramPool{
+    public:
+        static_assert(std::is_floating_point<BINCOUNT>::value,
+                      "the bin counts of a HistogramPool must be floating point");
+        typedef BINCOUNT BincountType;
+
+        /// read only view on a single histogram of the pool,
+        /// models the histogram concept used by quantiles
+        class ConstHistogramView{
+        public:
+            ConstHistogramView(const HistogramPool & pool, const uint64_t index)
+            :   pool_(pool),
+                counts_(pool.counts(index)),
+                sum_(pool.sums_[index])
+            {}
+            const BincountType & operator[](const std::size_t i)const{
+                return counts_[i];
+            }
+            std::size_t numberOfBins()const{
+                return pool_.numberOfBins();
+            }
+            double sum()const{
+                return sum_;
+            }
+            double binToValue(const double fbin)const{
+                return pool_.binToValue(fbin);
+            }
+            float binWidth()const{
+                return pool_.binWidth();
+            }
+        private:
+            const HistogramPool & pool_;
+            const BincountType * counts_;
+            double sum_;
+        };
+
+        HistogramPool(
+            const uint64_t numberOfHistograms = 0,
+            const T minVal = 0,
+            const T maxVal = 1,
+            const std::size_t bincount = 40
+        )
+        :   counts_(),
+            sums_(),
+            numberOfBins_(bincount),
+            minVal_(minVal),
+            maxVal_(maxVal),
+            binWidth_((maxVal-minVal)/T(bincount))
+        {
+            this->assign(numberOfHistograms, minVal, maxVal, bincount);
+        }
+
+        /// resize the pool and clear all histograms
+        void assign(
+            const uint64_t numberOfHistograms,
+            const T minVal,
+            const T maxVal,
+            const std::size_t bincount
+        ){
+            numberOfBins_ = bincount;
+            minVal_ = minVal;
+            maxVal_ = maxVal;
+            binWidth_ = (maxVal-minVal)/T(bincount);
+            counts_.assign(numberOfHistograms * bincount, BincountType(0));
+            sums_.assign(numberOfHistograms, 0.0);
+        }
+
+        uint64_t numberOfHistograms()const{
+            return sums_.size();
+        }
+        std::size_t numberOfBins()const{
+            return numberOfBins_;
+        }
+        float binWidth()const{
+            return binWidth_;
+        }
+        double binToValue(const double fbin)const{
+            const double f = fbin / double(numberOfBins_ - 1);
+            return (1.0-f)*minVal_ + f*maxVal_;
+        }
+
+        BincountType * counts(const uint64_t index){
+            return counts_.data() + index * numberOfBins_;
+        }
+        const BincountType * counts(const uint64_t index)const{
+            return counts_.data() + index * numberOfBins_;
+        }
+        double sum(const uint64_t index)const{
+            return sums_[index];
+        }
+        ConstHistogramView operator[](const uint64_t index)const{
+            return ConstHistogramView(*this, index);
+        }
+
+        // inserts into distinct histograms can run concurrently
+        void insert(const uint64_t index, const T & value, const double w = 1.0){
+            BincountType * c = this->counts(index);
+            const auto b = this->fbin(value);
+            const auto low  = std::floor(b);
+            const auto high = std::ceil(b);
+
+            // low and high are the same
+            if(low + 0.5 >= high){
+                c[std::size_t(low)] += w;
+            }
+            // low and high are different
+            else{
+                const auto wLow  = high - b;
+                const auto wHigh = double(b) - low;
+                c[std::size_t(low)]  += w*wLow;
+                c[std::size_t(high)] += w*wHigh;
+            }
+            sums_[index] += w;
+        }
+
+        /// add the counts of histogram source to histogram target
+        void merge(const uint64_t target, const uint64_t source){
+            BincountType * t = this->counts(target);
+            const BincountType * s = this->counts(source);
+            for(std::size_t i = 0; i < numberOfBins_; ++i){
+                t[i] += s[i];
+            }
+            sums_[target] += sums_[source];
+        }
+
+        /// copy the counts of histogram source to histogram target
+        void copy(const uint64_t target, const uint64_t source){
+            const BincountType * s = this->counts(source);
+            std::copy(s, s + numberOfBins_, this->counts(target));
+            sums_[target] = sums_[source];
+        }
+
+        /// scale the counts of a histogram such that they sum to targetSum
+        void normalize(const uint64_t index, const double targetSum){
+            BincountType * c = this->counts(index);
+            const double sum = sums_[index];
+            for(std::size_t i = 0; i < numberOfBins_; ++i){
+                c[i] = BincountType(c[i] / sum * targetSum);
+            }
+            sums_[index] = targetSum;
+        }
+
+        void clearCounts(const uint64_t index){
+            BincountType * c = this->counts(index);
+            std::fill(c, c + numberOfBins_, BincountType(0));
+            sums_[index] = 0.0;
+        }
+
+        double rank(const uint64_t index, const double q)const{
+            double ret;
+            quantiles((*this)[index], &q, &q+1, &ret);
+            return ret;
+        }
+
+    private:
+
+        // the floating point bin in [0,numberOfBins()-1]
+        float fbin(T val)const{
+            // truncate
+            val = std::max(minVal_, val);
+            val = std::min(maxVal_, val);
+
+            // normalize
+            val -= minVal_;
+            val /= (maxVal_ - minVal_);
+
+            return val*float(numberOfBins_-1);
+        }
+
+        std::vector<BincountType> counts_;
+        std::vector<double> sums_;
+        std::size_t numberOfBins_;
+        T minVal_;
+        T maxVal_;
+        T binWidth_;
+    };
+
+}
+}
@@ -0,0 +1,83 @@
+#pragma once
+
+#include <algorithm>
+#include <functional>
+#include <iterator>
+#include <vector>
+
+#include "nifty/parallel/threadpool.hxx"
+
+namespace nifty{
+namespace parallel{
+
+
+    /**
+     * @brief      Sort a random access range with the workers of a thread pool
+     *
+     * @details    The range is split into one chunk per thread, the chunks are
+     *             sorted in parallel and then merged pairwise in
+     *             log2(numberOfThreads) parallel rounds.
+     *             Small ranges are sorted on the calling thread.
+     *
+     * @param      threadpool  the thread pool
+     * @param      begin       begin of the range
+     * @param      end         end of the range
+     * @param      comp        strict weak ordering
+     */
+    template<class ITER, class COMP = std::less<typename std::iterator_traits<ITER>::value_type>>
+    inline void parallelSort(
+        ThreadPool & threadpool,
+        ITER begin,
+        ITER end,
+        COMP comp = COMP()
+    ){
+        // below this size splitting into chunks does not pay off
+        const std::ptrdiff_t minimumSize = 1 << 15;
+
+        const std::ptrdiff_t size = std::distance(begin, end);
+        const std::ptrdiff_t nChunks = std::max(std::ptrdiff_t(1), std::ptrdiff_t(threadpool.nThreads()));
+        if(nChunks == 1 || size < minimumSize){
+            std::sort(begin, end, comp);
+            return;
+        }
+
+        std::vector<std::ptrdiff_t> chunkBounds(nChunks + 1);
+        for(std::ptrdiff_t c = 0; c <= nChunks; ++c){
+            chunkBounds[c] = (size * c) / nChunks;
+        }
+
+        parallel_foreach(threadpool, nChunks, [&](const int tid, const int64_t c){
+            std::sort(begin + chunkBounds[c], begin + chunkBounds[c + 1], comp);
+        });
+
+        for(std::ptrdiff_t width = 1; width < nChunks; width *= 2){
+            const std::ptrdiff_t nMerges = (nChunks + 2 * width - 1) / (2 * width);
+            parallel_foreach(threadpool, nMerges, [&](const int tid, const int64_t m){
+                const std::ptrdiff_t first = 2 * m * width;
+                const std::ptrdiff_t middle = std::min(first + width, nChunks);
+                const std::ptrdiff_t last = std::min(first + 2 * width, nChunks);
+                if(middle < last){
+                    std::inplace_merge(begin + chunkBounds[first],
+                                       begin + chunkBounds[middle],
+                                       begin + chunkBounds[last], comp);
+                }
+            });
+        }
+    }
+
+
+    /**
+     * @brief      Sort a vector in parallel and remove duplicates
+     *
+     * @param      threadpool  the thread pool
+     * @param      values      the values, sorted and unique afterwards
+     */
+    template<class T>
+    inline void parallelSortUnique(ThreadPool & threadpool, std::vector<T> & values){
+        parallelSort(threadpool, values.begin(), values.end());
+        values.erase(std::unique(values.begin(), values.end()), values.end());
+    }
+
+
+} // namespace parallel
+} // namespace nifty
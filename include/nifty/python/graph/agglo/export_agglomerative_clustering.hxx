@@ -149,26 +149,26 @@ namespace agglo{
                     static_assert( GraphHasContiguousNodeIds::value,
                       "dendrogram visitor dendrogramEncoding works only for graphs with contiguous node ids"
                     );
-                    //std::cout<<"a\n";
-
-                    const auto & encoding = visitor.dendrogramEncoding();
-                    // std::cout<<"encoding.size() "<<encoding.size()<<"\n";
-                    xt::pytensor<uint64_t,2> nodes = xt::ones<uint64_t>({std::size_t(encoding.size()),std::size_t(2)});
-                    //std::cout<<"b\n";
-                    xt::pytensor<double,1>   p = xt::ones<double>({encoding.size()});
-                    xt::pytensor<double,1>   s = xt::ones<double>({encoding.size()});
-                    //std::cout<<"c\n";
-                    uint64_t c = 0;
-                    for(const auto e : encoding){
-                        nodes(c,0) = std::get<0>(e);
-                        nodes(c,1) = std::get<1>(e);
-                        p(c) = std::get<2>(e);
-                        s(c) = std::get<3>(e);
-                        ++c;
+
+                    const auto & mergeTree = visitor.mergeTree();
+                    const std::size_t n = mergeTree.numberOfMerges();
+                    xt::pytensor<uint64_t,2> nodes = xt::ones<uint64_t>({n, std::size_t(2)});
+                    xt::pytensor<double,1>   p = xt::ones<double>({n});
+                    xt::pytensor<double,1>   s = xt::ones<double>({n});
+                    for(std::size_t c = 0; c < n; ++c){
+                        nodes(c,0) = mergeTree.childrenA()[c];
+                        nodes(c,1) = mergeTree.childrenB()[c];
+                        p(c) = mergeTree.heights()[c];
+                        s(c) = mergeTree.sizes()[c];
                     }
-                    // std::cout<<"d\n";
                     return std::make_tuple(nodes, p, s);
                 })
+                // copy of the merge tree, see MergeTree
+                .def("mergeTree",[](
+                    VisitorType & visitor
+                ){
+                    return visitor.mergeTree();
+                })
             ;
 
         }
@@ -4,6 +4,7 @@
 #include <vector>
 
 #include "nifty/tools/for_each_coordinate.hxx"
+#include "nifty/tools/sorted_key_lookup.hxx"
 #include "nifty/xtensor/xtensor.hxx"
 
 namespace nifty {
@@ -235,9 +236,12 @@ namespace tools {
     }
 
 
+    // the dictionary is flattened to sorted keys and values,
+    // so the lookup can be done from many threads without touching the map
     template<unsigned DIM, class T, class ARRAY>
     inline void mapDictionaryToArray(xt::xexpression<ARRAY> & arrayExp, const std::map<T, T> & dict,
-                                     bool haveIgnoreValue=false, T ignoreValue=0) {
+                                     bool haveIgnoreValue=false, T ignoreValue=0,
+                                     const int numberOfThreads=-1) {
         typedef array::StaticArray<int64_t, DIM> Coord;
         auto & array = arrayExp.derived_cast();
 
@@ -246,25 +250,26 @@ namespace tools {
             shape[i] = array.shape()[i];
         }
 
-        if(haveIgnoreValue) {
-            forEachCoordinate(shape, [&](const Coord & coord){
-                T val = xtensor::read(array, coord.asStdArray());
-                if(val != ignoreValue) {
-                    auto mapIt = dict.find(val);
-                    if(mapIt != dict.end()) {
-                        xtensor::write(array, coord.asStdArray(), mapIt->second);
-                    }
-                }
-            });
-        } else {
-            forEachCoordinate(shape, [&](const Coord & coord){
-                T val = xtensor::read(array, coord.asStdArray());
-                auto mapIt = dict.find(val);
-                if(mapIt != dict.end()) {
-                    xtensor::write(array, coord.asStdArray(), mapIt->second);
-                }
-            });
+        std::vector<T> keys, values;
+        keys.reserve(dict.size());
+        values.reserve(dict.size());
+        for(const auto & kv : dict) {
+            keys.push_back(kv.first);
+            values.push_back(kv.second);
         }
+        const SortedKeyLookup<T> lookup(keys);
+
+        parallel::ThreadPool threadpool(numberOfThreads);
+        parallelForEachCoordinate(threadpool, shape, [&](const int tid, const Coord & coord){
+            T val = xtensor::read(array, coord.asStdArray());
+            if(haveIgnoreValue && val == ignoreValue) {
+                return;
+            }
+            const auto pos = lookup.find(val);
+            if(pos != SortedKeyLookup<T>::NotFound) {
+                xtensor::write(array, coord.asStdArray(), values[pos]);
+            }
+        });
     }
 
 
@@ -0,0 +1,318 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <vector>
+
+#include "xtensor/xtensor.hpp"
+#include "nifty/xtensor/xtensor.hxx"
+
+#include "nifty/parallel/threadpool.hxx"
+#include "nifty/tools/blocking.hxx"
+#include "nifty/tools/runtime_check.hxx"
+#include "nifty/ufd/concurrent_ufd.hxx"
+
+
+namespace nifty{
+namespace tools{
+
+    namespace detail_block_connected_components{
+
+        // union find over provisional labels, the root is always the smallest
+        // label of a set, so resolving the labels in increasing order is enough
+        class ProvisionalLabels{
+        public:
+            uint64_t makeLabel(){
+                parents_.push_back(parents_.size());
+                return parents_.size() - 1;
+            }
+            uint64_t find(uint64_t label){
+                while(parents_[label] != label){
+                    parents_[label] = parents_[parents_[label]];
+                    label = parents_[label];
+                }
+                return label;
+            }
+            void merge(uint64_t a, uint64_t b){
+                a = find(a);
+                b = find(b);
+                if(a < b){
+                    parents_[b] = a;
+                }
+                else if(b < a){
+                    parents_[a] = b;
+                }
+            }
+            // map the provisional labels to dense labels 1...n in order of appearance
+            uint64_t resolve(){
+                uint64_t numberOfLabels = 0;
+                for(std::size_t label = 0; label < parents_.size(); ++label){
+                    // a parent is always smaller than its child and hence holds
+                    // the dense label of the set already
+                    const auto parent = parents_[label];
+                    parents_[label] = parent == label ? ++numberOfLabels : parents_[parent];
+                }
+                return numberOfLabels;
+            }
+            // valid after resolve
+            uint64_t denseLabel(const uint64_t label)const{
+                return parents_[label];
+            }
+            void clear(){
+                parents_.clear();
+            }
+        private:
+            std::vector<uint64_t> parents_;
+        };
+
+
+        // two pass labeling of the direct neighborhood connected components
+        // of a block, labels are written to out as 1...n, background as 0
+        template<std::size_t DIM, class T>
+        uint64_t labelBlock(
+            const xt::xtensor<T, DIM> & values,
+            const bool ignoreBackground,
+            ProvisionalLabels & provisional,
+            xt::xtensor<uint64_t, DIM> & out,
+            std::vector<uint64_t> & sizes
+        ){
+            const auto & shape = values.shape();
+            std::array<std::size_t, DIM> strides;
+            strides[DIM - 1] = 1;
+            for(int d = DIM - 2; d >= 0; --d){
+                strides[d] = strides[d + 1] * shape[d + 1];
+            }
+            const std::size_t size = values.size();
+            const T * v = values.data();
+            uint64_t * o = out.data();
+
+            // first pass: provisional labels, stored as label + 1 in out
+            provisional.clear();
+            std::array<std::size_t, DIM> coord;
+            coord.fill(0);
+            for(std::size_t i = 0; i < size; ++i){
+                const T value = v[i];
+                if(ignoreBackground && value == T(0)){
+                    o[i] = 0;
+                }
+                else{
+                    uint64_t label = 0;
+                    // the previous voxel along the last axis decides most cases
+                    for(int d = DIM - 1; d >= 0; --d){
+                        if(coord[d] == 0 || v[i - strides[d]] != value){
+                            continue;
+                        }
+                        const auto neighborLabel = o[i - strides[d]];
+                        if(label == 0){
+                            label = neighborLabel;
+                        }
+                        else if(neighborLabel != label){
+                            provisional.merge(label - 1, neighborLabel - 1);
+                        }
+                    }
+                    o[i] = label == 0 ? provisional.makeLabel() + 1 : label;
+                }
+                // next coordinate in c order
+                for(int d = DIM - 1; d >= 0; --d){
+                    if(++coord[d] < shape[d]){
+                        break;
+                    }
+                    coord[d] = 0;
+                }
+            }
+
+            // second pass: dense labels and sizes
+            const uint64_t numberOfLabels = provisional.resolve();
+            sizes.assign(numberOfLabels, 0);
+            for(std::size_t i = 0; i < size; ++i){
+                if(o[i] != 0){
+                    o[i] = provisional.denseLabel(o[i] - 1);
+                    ++sizes[o[i] - 1];
+                }
+            }
+            return numberOfLabels;
+        }
+
+        template<std::size_t DIM, class SHAPE>
+        typename xt::xtensor<uint64_t, DIM>::shape_type toShape(const SHAPE & shape){
+            typename xt::xtensor<uint64_t, DIM>::shape_type ret;
+            std::copy(shape.begin(), shape.end(), ret.begin());
+            return ret;
+        }
+
+    } // namespace detail_block_connected_components
+
+
+    /**
+     * @brief      Connected components of a label (or binary) volume, block by block
+     *
+     * @details    Every block is labeled independently with a two pass
+     *             scan (in parallel), then the components that touch across the
+     *             faces of neighbouring blocks are merged in a concurrent union find
+     *             and finally the output is relabeled block by block.
+     *             Only the block being processed is held in memory, so labels and out
+     *             can be chunked arrays (hdf5 / z5) that do not fit into memory;
+     *             the block shape must then be a multiple of the chunk shape of out.
+     *             Voxels are connected to their direct neighbours with the same value.
+     *
+     *             The labels are dense and independent of the number of threads:
+     *             components are numbered in the order of their first voxel in the
+     *             block scan order.
+     *             With ignoreBackground, voxels with value 0 get label 0 and the
+     *             components are labeled 1...n, otherwise they are labeled 0...n-1.
+     *
+     * @param      labels            input labels, values are compared for equality
+     * @param      out               (Output) connected component labels (uint64)
+     * @param      blockShape        shape of the blocks
+     * @param      ignoreBackground  should values of zero be excluded
+     * @param      sizes             (Output) number of voxels per component label,
+     *                               with ignoreBackground sizes[0] is the number of
+     *                               background voxels
+     * @param      numberOfThreads   number of threads
+     *
+     * @return     the number of components
+     */
+    template<std::size_t DIM, class LABELS, class OUT>
+    uint64_t blockConnectedComponents(
+        const LABELS & labels,
+        OUT & out,
+        const typename Blocking<DIM>::VectorType & blockShape,
+        const bool ignoreBackground,
+        std::vector<uint64_t> & sizes,
+        const int numberOfThreads = -1
+    ){
+        namespace detail = detail_block_connected_components;
+        typedef typename LABELS::value_type T;
+        typedef typename Blocking<DIM>::VectorType VectorType;
+        typedef xt::xtensor<T, DIM> ValueBuffer;
+        typedef xt::xtensor<uint64_t, DIM> LabelBuffer;
+
+        VectorType shape;
+        for(int d = 0; d < DIM; ++d){
+            shape[d] = labels.shape()[d];
+            NIFTY_CHECK_OP(out.shape()[d], ==, shape[d], "labels and out have different shapes");
+        }
+        const Blocking<DIM> blocking(VectorType(0), shape, blockShape);
+        const std::size_t numberOfBlocks = blocking.numberOfBlocks();
+
+        nifty::parallel::ParallelOptions pOpts(numberOfThreads);
+        nifty::parallel::ThreadPool threadpool(pOpts);
+        const std::size_t actualNumberOfThreads = pOpts.getActualNumThreads();
+
+        struct ThreadData{
+            ValueBuffer values;
+            LabelBuffer localLabels;
+            detail::ProvisionalLabels provisional;
+        };
+        std::vector<ThreadData> threadData(actualNumberOfThreads);
+
+        // label all blocks independently, out holds the block local labels afterwards
+        std::vector<std::vector<uint64_t>> blockSizes(numberOfBlocks);
+        parallel::parallel_foreach(threadpool, numberOfBlocks, [&](const int tid, const int64_t blockId){
+            auto & data = threadData[tid];
+            const auto block = blocking.getBlock(blockId);
+            const auto blockShapeT = detail::toShape<DIM>(block.shape());
+            data.values.resize(blockShapeT);
+            data.localLabels.resize(blockShapeT);
+            readSubarray(labels, block.begin(), block.end(), data.values);
+            detail::labelBlock<DIM>(data.values, ignoreBackground, data.provisional,
+                                    data.localLabels, blockSizes[blockId]);
+            writeSubarray(out, block.begin(), block.end(), data.localLabels);
+        });
+
+        // global ids of the block labels
+        std::vector<uint64_t> blockOffsets(numberOfBlocks + 1, 0);
+        for(std::size_t blockId = 0; blockId < numberOfBlocks; ++blockId){
+            blockOffsets[blockId + 1] = blockOffsets[blockId] + blockSizes[blockId].size();
+        }
+        const uint64_t numberOfProvisionalLabels = blockOffsets.back();
+
+        // merge the components across the lower faces of every block
+        ufd::ConcurrentUfd<uint64_t> ufd(numberOfProvisionalLabels);
+        parallel::parallel_foreach(threadpool, numberOfBlocks, [&](const int tid, const int64_t blockId){
+            auto & data = threadData[tid];
+            const auto block = blocking.getBlock(blockId);
+            for(int axis = 0; axis < DIM; ++axis){
+                const auto lowerBlockId = blocking.getNeighborId(blockId, axis, true);
+                if(lowerBlockId < 0){
+                    continue;
+                }
+                // the last slice of the lower block and the first slice of this block
+                VectorType faceBegin = block.begin();
+                VectorType faceEnd = block.end();
+                faceBegin[axis] -= 1;
+                faceEnd[axis] = faceBegin[axis] + 2;
+                const auto faceShape = detail::toShape<DIM>(faceEnd - faceBegin);
+                data.values.resize(faceShape);
+                data.localLabels.resize(faceShape);
+                readSubarray(labels, faceBegin, faceEnd, data.values);
+                readSubarray(out, faceBegin, faceEnd, data.localLabels);
+
+                std::size_t stride = 1;
+                for(int d = DIM - 1; d > axis; --d){
+                    stride *= faceShape[d];
+                }
+                const std::size_t outer = data.values.size() / (2 * stride);
+                const T * v = data.values.data();
+                const uint64_t * l = data.localLabels.data();
+                const uint64_t lowerOffset = blockOffsets[lowerBlockId] - 1;
+                const uint64_t upperOffset = blockOffsets[blockId] - 1;
+                for(std::size_t o = 0; o < outer; ++o){
+                    for(std::size_t i = 2 * o * stride; i < (2 * o + 1) * stride; ++i){
+                        const auto j = i + stride;
+                        if(v[i] != v[j] || l[i] == 0){
+                            continue;
+                        }
+                        ufd.merge(lowerOffset + l[i], upperOffset + l[j]);
+                    }
+                }
+            }
+        });
+
+        // dense labels of the provisional ids, in the order of their smallest id
+        std::vector<uint64_t> denseLabels(numberOfProvisionalLabels);
+        ufd.elementLabeling(denseLabels.begin(), threadpool);
+        const uint64_t numberOfComponents = numberOfProvisionalLabels == 0 ? 0 :
+            *std::max_element(denseLabels.begin(), denseLabels.end()) + 1;
+        const uint64_t labelOffset = ignoreBackground ? 1 : 0;
+
+        sizes.assign(numberOfComponents + labelOffset, 0);
+        for(std::size_t blockId = 0; blockId < numberOfBlocks; ++blockId){
+            for(std::size_t i = 0; i < blockSizes[blockId].size(); ++i){
+                sizes[denseLabels[blockOffsets[blockId] + i] + labelOffset] += blockSizes[blockId][i];
+            }
+        }
+        if(ignoreBackground){
+            uint64_t numberOfVoxels = 1;
+            for(int d = 0; d < DIM; ++d){
+                numberOfVoxels *= shape[d];
+            }
+            uint64_t foreground = 0;
+            for(std::size_t label = 1; label < sizes.size(); ++label){
+                foreground += sizes[label];
+            }
+            sizes[0] = numberOfVoxels - foreground;
+        }
+
+        // write the final labels
+        parallel::parallel_foreach(threadpool, numberOfBlocks, [&](const int tid, const int64_t blockId){
+            auto & data = threadData[tid];
+            const auto block = blocking.getBlock(blockId);
+            data.localLabels.resize(detail::toShape<DIM>(block.shape()));
+            readSubarray(out, block.begin(), block.end(), data.localLabels);
+            const uint64_t offset = blockOffsets[blockId] - 1;
+            for(auto & label : data.localLabels){
+                // background stays 0
+                if(label != 0){
+                    label = denseLabels[offset + label] + labelOffset;
+                }
+            }
+            writeSubarray(out, block.begin(), block.end(), data.localLabels);
+        });
+
+        return numberOfComponents;
+    }
+
+} // namespace nifty::tools
+} // namespace nifty
@@ -0,0 +1,340 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <future>
+#include <mutex>
+#include <numeric>
+#include <vector>
+
+#include "xtensor/xtensor.hpp"
+#include "nifty/xtensor/xtensor.hxx"
+
+#include "nifty/parallel/threadpool.hxx"
+#include "nifty/tools/blocking.hxx"
+
+#ifdef WITH_HDF5
+#include "nifty/hdf5/hdf5_array.hxx"
+#endif
+
+#ifdef WITH_Z5
+#include "nifty/z5/z5.hxx"
+#endif
+
+
+namespace nifty{
+namespace tools{
+
+
+    /**
+     * @brief      Read blocks of a (chunked) array ahead of the computation
+     *
+     * @details    Dedicated io threads read (and hence decompress) the
+     *             blocks of a ``Blocking`` (with optional halo) into a ring
+     *             of reusable buffers, while the compute threads work on the
+     *             blocks that were read before.
+     *             With ``numberOfBuffers`` larger than the number of compute
+     *             threads, io and computation overlap; the difference is the
+     *             number of blocks that are prefetched.
+     *
+     *             The functor passed to ``run`` is called as
+     *             ``f(tid, blockId, blockWithHalo, blockView)``, where
+     *             ``blockView`` holds the data of the outer block of
+     *             ``blockWithHalo`` and is only valid during the call.
+     *             ``runJoint`` reads the same blocks of two arrays
+     *             (e.g. labels and data) and calls
+     *             ``f(tid, blockId, blockWithHalo, blockViewA, blockViewB)``.
+     *             Blocks are handed out in the order given, but may finish
+     *             out of order.
+     *
+     * @tparam     T     value type of the array
+     * @tparam     DIM   dimension
+     */
+    template<class T, std::size_t DIM>
+    class BlockPipeline{
+    public:
+        typedef Blocking<DIM> BlockingType;
+        typedef typename BlockingType::VectorType VectorType;
+        typedef typename BlockingType::BlockWithHaloType BlockWithHaloType;
+        typedef xt::xtensor<T, DIM> BufferType;
+
+        struct SettingsType{
+            SettingsType()
+            :   numberOfThreads(-1),
+                numberOfIoThreads(1),
+                numberOfBuffers(0){
+            }
+            int numberOfThreads;
+            int numberOfIoThreads;
+            // 0 means two buffers per compute thread (double buffering)
+            std::size_t numberOfBuffers;
+        };
+
+        BlockPipeline(
+            const BlockingType & blocking,
+            const VectorType & halo = VectorType(0),
+            const SettingsType & settings = SettingsType()
+        )
+        :   BlockPipeline(blocking, halo, halo, settings)
+        {}
+
+        BlockPipeline(
+            const BlockingType & blocking,
+            const VectorType & haloBegin,
+            const VectorType & haloEnd,
+            const SettingsType & settings = SettingsType()
+        )
+        :   blocking_(blocking),
+            haloBegin_(haloBegin),
+            haloEnd_(haloEnd),
+            settings_(settings),
+            buffers_()
+        {
+            const auto numberOfComputeThreads = parallel::ParallelOptions(settings_.numberOfThreads).getActualNumThreads();
+            auto numberOfBuffers = settings_.numberOfBuffers;
+            if(numberOfBuffers == 0){
+                numberOfBuffers = 2 * numberOfComputeThreads;
+            }
+            NIFTY_CHECK_OP(numberOfBuffers, >=, 1, "BlockPipeline needs at least one buffer");
+
+            buffers_.resize(numberOfBuffers);
+            for(auto & buffer : buffers_){
+                buffer.resize(bufferShape());
+            }
+        }
+
+        const BlockingType & blocking() const {
+            return blocking_;
+        }
+
+        std::size_t numberOfBuffers() const {
+            return buffers_.size();
+        }
+
+        // run over all blocks of the blocking
+        template<class ARRAY, class F>
+        void run(const ARRAY & array, F && f){
+            std::vector<uint64_t> blockIds(blocking_.numberOfBlocks());
+            std::iota(blockIds.begin(), blockIds.end(), 0);
+            run(array, blockIds, f);
+        }
+
+        // run over the given blocks
+        template<class ARRAY, class F>
+        void run(const ARRAY & array, const std::vector<uint64_t> & blockIds, F && f){
+            schedule(blockIds.size(),
+            [&](const std::size_t slot, const std::size_t index){
+                return readBlock(array, blockIds[index], buffers_[slot]);
+            },
+            [&](const int tid, const std::size_t slot, const std::size_t index,
+                const BlockWithHaloType & blockWithHalo){
+                auto view = bufferView(buffers_[slot], blockWithHalo.outerBlock().shape());
+                f(tid, blockIds[index], blockWithHalo, view);
+            });
+        }
+
+        // run over all blocks of the blocking and read the blocks of two arrays
+        template<class ARRAY_A, class ARRAY_B, class F>
+        void runJoint(const ARRAY_A & arrayA, const ARRAY_B & arrayB, F && f){
+            std::vector<uint64_t> blockIds(blocking_.numberOfBlocks());
+            std::iota(blockIds.begin(), blockIds.end(), 0);
+            runJoint(arrayA, arrayB, blockIds, f);
+        }
+
+        // run over the given blocks and read the blocks of two arrays,
+        // the buffers of the second array are allocated for this call
+        template<class ARRAY_A, class ARRAY_B, class F>
+        void runJoint(const ARRAY_A & arrayA, const ARRAY_B & arrayB,
+                      const std::vector<uint64_t> & blockIds, F && f){
+            typedef xt::xtensor<typename ARRAY_B::value_type, DIM> BufferTypeB;
+            std::vector<BufferTypeB> buffersB(buffers_.size());
+            for(auto & buffer : buffersB){
+                buffer.resize(bufferShape());
+            }
+
+            schedule(blockIds.size(),
+            [&](const std::size_t slot, const std::size_t index){
+                readBlock(arrayB, blockIds[index], buffersB[slot]);
+                return readBlock(arrayA, blockIds[index], buffers_[slot]);
+            },
+            [&](const int tid, const std::size_t slot, const std::size_t index,
+                const BlockWithHaloType & blockWithHalo){
+                const auto & shape = blockWithHalo.outerBlock().shape();
+                auto viewA = bufferView(buffers_[slot], shape);
+                auto viewB = bufferView(buffersB[slot], shape);
+                f(tid, blockIds[index], blockWithHalo, viewA, viewB);
+            });
+        }
+
+    private:
+
+        typename BufferType::shape_type bufferShape() const {
+            typename BufferType::shape_type shape;
+            const auto & blockShape = blocking_.blockShape();
+            for(std::size_t d=0; d<DIM; ++d){
+                shape[d] = blockShape[d] + haloBegin_[d] + haloEnd_[d];
+            }
+            return shape;
+        }
+
+        template<class BUFFER>
+        static auto bufferView(BUFFER & buffer, const VectorType & shape) {
+            const VectorType zeroCoord(0);
+            xt::xstrided_slice_vector slice;
+            xtensor::sliceFromRoi(slice, zeroCoord, shape);
+            return xt::strided_view(buffer, slice);
+        }
+
+        template<class ARRAY, class BUFFER>
+        BlockWithHaloType readBlock(const ARRAY & array,
+                                    const uint64_t blockId,
+                                    BUFFER & buffer) const {
+            const auto blockWithHalo = blocking_.getBlockWithHalo(blockId, haloBegin_, haloEnd_);
+            const auto & outerBlock = blockWithHalo.outerBlock();
+            auto view = bufferView(buffer, outerBlock.shape());
+            readSubarray(array, outerBlock.begin(), outerBlock.end(), view);
+            return blockWithHalo;
+        }
+
+        // read(slot, index) reads the index-th block into the buffers of slot
+        // and process(tid, slot, index, blockWithHalo) computes on it
+        template<class READ, class PROCESS>
+        void schedule(const std::size_t numberOfBlocks, READ && read, PROCESS && process);
+
+        BlockingType blocking_;
+        VectorType haloBegin_;
+        VectorType haloEnd_;
+        SettingsType settings_;
+        std::vector<BufferType> buffers_;
+    };
+
+
+    template<class T, std::size_t DIM>
+    template<class READ, class PROCESS>
+    void BlockPipeline<T, DIM>::schedule(
+        const std::size_t numberOfBlocks,
+        READ && read,
+        PROCESS && process
+    ){
+        parallel::ThreadPool ioPool(parallel::ParallelOptions(settings_.numberOfIoThreads));
+
+        // without io threads we fall back to reading in the compute threads
+        if(ioPool.nThreads() == 0){
+            parallel::ThreadPool threadpool(settings_.numberOfThreads);
+            const std::size_t nThreads = parallel::ParallelOptions(settings_.numberOfThreads).getActualNumThreads();
+            NIFTY_CHECK_OP(buffers_.size(), >=, nThreads,
+                           "BlockPipeline needs at least one buffer per thread without io threads");
+            parallel::parallel_foreach(threadpool, numberOfBlocks, [&](const int tid, const int64_t i){
+                const auto blockWithHalo = read(tid, i);
+                process(tid, tid, i, blockWithHalo);
+            });
+            return;
+        }
+
+        // shared state of the pipeline, guarded by mutex
+        struct ReadyBlock{
+            std::size_t slot;
+            std::size_t index;
+            BlockWithHaloType blockWithHalo;
+        };
+        std::mutex mutex;
+        std::condition_variable stateChanged;
+        std::vector<std::size_t> freeSlots(buffers_.size());
+        std::iota(freeSlots.rbegin(), freeSlots.rend(), 0);
+        std::deque<ReadyBlock> readyBlocks;
+        std::size_t nextToRead = 0;
+        std::size_t nextToProcess = 0;
+        bool aborted = false;
+
+        auto abort = [&](){
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                aborted = true;
+            }
+            stateChanged.notify_all();
+        };
+
+        auto ioLoop = [&](const int ioTid){
+            try{
+                for(;;){
+                    std::size_t slot, index;
+                    {
+                        std::unique_lock<std::mutex> lock(mutex);
+                        stateChanged.wait(lock, [&](){
+                            return aborted || nextToRead == numberOfBlocks || !freeSlots.empty();
+                        });
+                        if(aborted || nextToRead == numberOfBlocks){
+                            return;
+                        }
+                        index = nextToRead++;
+                        slot = freeSlots.back();
+                        freeSlots.pop_back();
+                    }
+                    const auto blockWithHalo = read(slot, index);
+                    {
+                        std::unique_lock<std::mutex> lock(mutex);
+                        readyBlocks.push_back(ReadyBlock{slot, index, blockWithHalo});
+                    }
+                    stateChanged.notify_all();
+                }
+            }
+            catch(...){
+                abort();
+                throw;
+            }
+        };
+
+        auto computeLoop = [&](const int tid){
+            try{
+                for(;;){
+                    ReadyBlock block;
+                    {
+                        std::unique_lock<std::mutex> lock(mutex);
+                        stateChanged.wait(lock, [&](){
+                            return aborted || nextToProcess == numberOfBlocks || !readyBlocks.empty();
+                        });
+                        if(aborted || readyBlocks.empty()){
+                            return;
+                        }
+                        block = readyBlocks.front();
+                        readyBlocks.pop_front();
+                        ++nextToProcess;
+                    }
+                    process(tid, block.slot, block.index, block.blockWithHalo);
+                    {
+                        std::unique_lock<std::mutex> lock(mutex);
+                        freeSlots.push_back(block.slot);
+                    }
+                    stateChanged.notify_all();
+                }
+            }
+            catch(...){
+                abort();
+                throw;
+            }
+        };
+
+        std::vector<std::future<void>> futures;
+        for(std::size_t t=0; t<ioPool.nThreads(); ++t){
+            futures.emplace_back(ioPool.enqueue(ioLoop));
+        }
+
+        parallel::ThreadPool threadpool(settings_.numberOfThreads);
+        const std::size_t nThreads = std::max(std::size_t(1), threadpool.nThreads());
+        for(std::size_t t=0; t<nThreads; ++t){
+            futures.emplace_back(threadpool.enqueue(computeLoop));
+        }
+
+        // wait for everything before rethrowing, the loops reference this stack frame
+        for(auto & fut : futures){
+            fut.wait();
+        }
+        for(auto & fut : futures){
+            fut.get();
+        }
+    }
+
+
+} // end namespace nifty::tools
+} // end namespace nifty
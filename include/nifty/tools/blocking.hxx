@@ -1,5 +1,10 @@
 #pragma once
 
+#include <algorithm>
+#include <cstddef>
+#include <iterator>
+#include <vector>
+
 #include "nifty/array/arithmetic_array.hxx"
 
 
@@ -86,6 +91,140 @@ namespace tools{
 
 
 
+    /**
+     * @brief      Lazy range over the ids of a box of blocks in a block grid
+     *
+     * @details    The box is given in block grid coordinates ``[gridBegin, gridEnd)``,
+     *             the ids are enumerated in C-order, i.e. in increasing order.
+     *             Nothing is materialized, so ranges over huge grids are cheap.
+     */
+    template<std::size_t DIM, class T = int64_t>
+    class BlockIdRange{
+    public:
+        typedef nifty::array::StaticArray<T, DIM> VectorType;
+
+        class const_iterator{
+        public:
+            typedef std::forward_iterator_tag iterator_category;
+            typedef uint64_t value_type;
+            typedef std::ptrdiff_t difference_type;
+            typedef const uint64_t * pointer;
+            typedef const uint64_t & reference;
+
+            const_iterator(const BlockIdRange * range = nullptr, const uint64_t index = 0)
+            :   range_(range),
+                index_(index),
+                position_(),
+                blockId_(0){
+                if(range_ != nullptr){
+                    position_ = range_->gridBegin_;
+                    updateBlockId();
+                }
+            }
+
+            reference operator*() const {
+                return blockId_;
+            }
+
+            const_iterator & operator++(){
+                ++index_;
+                for(int d = int(DIM) - 1; d >= 0; --d){
+                    if(++position_[d] < range_->gridEnd_[d] || d == 0){
+                        break;
+                    }
+                    position_[d] = range_->gridBegin_[d];
+                }
+                updateBlockId();
+                return *this;
+            }
+
+            const_iterator operator++(int){
+                const_iterator tmp(*this);
+                ++(*this);
+                return tmp;
+            }
+
+            bool operator==(const const_iterator & other) const {
+                return index_ == other.index_;
+            }
+
+            bool operator!=(const const_iterator & other) const {
+                return index_ != other.index_;
+            }
+
+            // position of the current block in the block grid
+            const VectorType & gridPosition() const {
+                return position_;
+            }
+
+        private:
+            void updateBlockId(){
+                blockId_ = 0;
+                for(std::size_t d = 0; d < DIM; ++d){
+                    blockId_ += position_[d] * range_->gridStrides_[d];
+                }
+            }
+
+            const BlockIdRange * range_;
+            uint64_t index_;
+            VectorType position_;
+            uint64_t blockId_;
+        };
+
+        typedef const_iterator iterator;
+
+        BlockIdRange(
+            const VectorType & gridBegin,
+            const VectorType & gridEnd,
+            const VectorType & gridStrides
+        )
+        :   gridBegin_(gridBegin),
+            gridEnd_(gridEnd),
+            gridStrides_(gridStrides),
+            size_(1){
+            for(std::size_t d = 0; d < DIM; ++d){
+                if(gridEnd_[d] <= gridBegin_[d]){
+                    size_ = 0;
+                    break;
+                }
+                size_ *= (gridEnd_[d] - gridBegin_[d]);
+            }
+        }
+
+        const_iterator begin() const {
+            return size_ == 0 ? end() : const_iterator(this, 0);
+        }
+
+        const_iterator end() const {
+            return const_iterator(nullptr, size_);
+        }
+
+        uint64_t size() const {
+            return size_;
+        }
+
+        bool empty() const {
+            return size_ == 0;
+        }
+
+        const VectorType & gridBegin() const {
+            return gridBegin_;
+        }
+
+        const VectorType & gridEnd() const {
+            return gridEnd_;
+        }
+
+    private:
+        VectorType gridBegin_;
+        VectorType gridEnd_;
+        VectorType gridStrides_;
+        uint64_t size_;
+    };
+
+
+
+
     template<std::size_t DIM, class T = int64_t>
     class Blocking{
     public:
@@ -95,6 +234,7 @@ namespace tools{
         typedef typename BlockWithHaloType::ValueType ValueType;
         typedef typename BlockWithHaloType::ValueType value_type;
         typedef typename BlockWithHaloType::VectorType VectorType;
+        typedef BlockIdRange<DIM, T> BlockIdRangeType;
 
         Blocking(
             const VectorType & roiBegin ,
@@ -208,46 +348,76 @@ namespace tools{
         }
 
 
-        // TODO this does not work with block shifts etc I guess
+        // id of the block that contains the coordinate
         uint64_t coordinatesToBlockId(const VectorType & coordinates) const {
             uint64_t blockIndex = 0;
             for(int d = 0; d < DIM; ++d) {
-                blockIndex += coordinates[d] / blockShape_[d] * blocksPerAxisStrides_[d];
+                blockIndex += gridPositionAtAxis(coordinates[d], d) * blocksPerAxisStrides_[d];
             }
             return blockIndex;
         }
 
 
-        // get all block ids that are enclosed in the roi
-        void getBlockIdsInBoundingBox(
-                const VectorType & roiBegin,
-                const VectorType & roiEnd,
+        // ids of the blocks that contain the coordinates
+        void coordinatesToBlockIds(
+                const std::vector<VectorType> & coordinates,
                 std::vector<uint64_t> & idsOut) const {
+            idsOut.resize(coordinates.size());
+            std::transform(coordinates.begin(), coordinates.end(), idsOut.begin(),
+                           [this](const VectorType & coord){return coordinatesToBlockId(coord);});
+        }
 
-            // TODO assert that the roi is in global roi
-            idsOut.clear();
 
-            for(std::size_t blockId = 0; blockId < numberOfBlocks(); ++blockId) {
+        // block grid box of all blocks that are enclosed in the roi
+        BlockIdRangeType blockIdsInBoundingBox(
+                const VectorType & roiBegin,
+                const VectorType & roiEnd) const {
 
-                // get coordinates of the current bock
-                const auto & block = getBlock(blockId);
-                const auto & begin = block.begin();
-                const auto & end   = block.end();
+            VectorType gridBegin, gridEnd;
+            for(int d = 0; d < DIM; ++d) {
+                const T nBlocks = blocksPerAxis_[d];
+                // first block with begin >= roiBegin
+                T first = std::max(gridPositionAtAxis(roiBegin[d], d), T(0));
+                while(first < nBlocks && blockBeginAtAxis(first, d) < roiBegin[d]) {
+                    ++first;
+                }
+                // one past the last block with end <= roiEnd
+                T last = std::min(gridPositionAtAxis(roiEnd[d], d) + 1, nBlocks);
+                while(last > first && blockEndAtAxis(last - 1, d) > roiEnd[d]) {
+                    --last;
+                }
+                gridBegin[d] = first;
+                gridEnd[d] = std::max(first, last);
+            }
+            return BlockIdRangeType(gridBegin, gridEnd, blocksPerAxisStrides_);
+        }
 
-                // check for each dimension whether the current block has overlap with the roi
-                std::vector<bool> enclosedInDim(DIM, false);
-                for(auto d = 0; d < DIM; ++d) {
-                    if(begin[d] >= roiBegin[d] && end[d] <= roiEnd[d]) {
-                        enclosedInDim[d] = true;
-                    }
 
-                }
+        // block grid box of all blocks that have overlap with the roi,
+        // an empty roi selects the block containing roiBegin
+        BlockIdRangeType blockIdsOverlappingBoundingBox(
+                const VectorType & roiBegin,
+                const VectorType & roiEnd) const {
 
-                // if all dimentsions have overlap, push back the block id
-                if(std::all_of(enclosedInDim.begin(), enclosedInDim.end(), [](bool i){return i;})) {
-                    idsOut.push_back(blockId);
-                }
+            VectorType gridBegin, gridEnd;
+            for(int d = 0; d < DIM; ++d) {
+                // restrict the roi to the roi of the blocking
+                const T begin = std::max(roiBegin[d], roiBegin_[d]);
+                const T end = std::min(std::max(roiEnd[d], roiBegin[d] + 1), roiEnd_[d]);
+                gridBegin[d] = gridPositionAtAxis(begin, d);
+                gridEnd[d] = end > begin ? gridPositionAtAxis(end - 1, d) + 1 : gridBegin[d];
             }
+            return BlockIdRangeType(gridBegin, gridEnd, blocksPerAxisStrides_);
+        }
+
+
+        // get all block ids that are enclosed in the roi
+        void getBlockIdsInBoundingBox(
+                const VectorType & roiBegin,
+                const VectorType & roiEnd,
+                std::vector<uint64_t> & idsOut) const {
+            const auto range = blockIdsInBoundingBox(roiBegin, roiEnd);
+            idsOut.assign(range.begin(), range.end());
         }
 
 
@@ -256,27 +426,30 @@ namespace tools{
                 const VectorType & roiBegin,
                 const VectorType & roiEnd,
                 std::vector<uint64_t> & idsOut) const {
+            const auto range = blockIdsOverlappingBoundingBox(roiBegin, roiEnd);
+            idsOut.assign(range.begin(), range.end());
+        }
 
-            idsOut.clear();
 
-            VectorType minChunkIds;
-            VectorType maxChunkIds;
-            // determine the position in chunks
-            for(unsigned ii = 0; ii < DIM; ++ii) {
-                minChunkIds[ii] = floor(roiBegin[ii] / blockShape_[ii]);
-                maxChunkIds[ii] = static_cast<int64_t>(ceil(roiEnd[ii] / static_cast<float>(blockShape_[ii])));
-                // increase the max if we have a singleton
-                if(minChunkIds[ii] == maxChunkIds[ii])
-                    ++maxChunkIds[ii];
+        // block ids overlapping many rois, concatenated;
+        // the ids of roi i are in [offsetsOut[i], offsetsOut[i+1])
+        void getBlockIdsOverlappingBoundingBoxes(
+                const std::vector<VectorType> & roiBegins,
+                const std::vector<VectorType> & roiEnds,
+                std::vector<uint64_t> & idsOut,
+                std::vector<uint64_t> & offsetsOut) const {
+
+            const std::size_t nRois = roiBegins.size();
+            offsetsOut.resize(nRois + 1);
+            offsetsOut[0] = 0;
+            for(std::size_t i = 0; i < nRois; ++i) {
+                offsetsOut[i + 1] = offsetsOut[i] + blockIdsOverlappingBoundingBox(roiBegins[i], roiEnds[i]).size();
             }
 
-            // FIXME this only works for 3D, implement this dimension independent !
-            for(std::size_t chunkX = minChunkIds[0]; chunkX < maxChunkIds[0]; ++ chunkX) {
-                for(std::size_t chunkY = minChunkIds[1]; chunkY < maxChunkIds[1]; ++ chunkY) {
-                    for(std::size_t chunkZ = minChunkIds[2]; chunkZ < maxChunkIds[2]; ++ chunkZ) {
-                        idsOut.push_back(blocksPerAxisStrides_[0] * chunkX + blocksPerAxisStrides_[1] * chunkY + blocksPerAxisStrides_[2] * chunkZ);
-                    }
-                }
+            idsOut.resize(offsetsOut.back());
+            for(std::size_t i = 0; i < nRois; ++i) {
+                const auto range = blockIdsOverlappingBoundingBox(roiBegins[i], roiEnds[i]);
+                std::copy(range.begin(), range.end(), idsOut.begin() + offsetsOut[i]);
             }
         }
 
@@ -417,6 +590,27 @@ namespace tools{
 
     private:
 
+        // begin of the (unclipped) block grid along an axis
+        T gridOriginAtAxis(const unsigned axis) const {
+            return roiBegin_[axis] - blockShift_[axis];
+        }
+
+        // position in the block grid along an axis, may be outside of the grid
+        T gridPositionAtAxis(const T coordinate, const unsigned axis) const {
+            const T offset = coordinate - gridOriginAtAxis(axis);
+            const T bs = blockShape_[axis];
+            // floor division, offsets left of the grid origin are negative
+            return offset >= 0 ? offset / bs : -((-offset + bs - 1) / bs);
+        }
+
+        T blockBeginAtAxis(const T gridPosition, const unsigned axis) const {
+            return std::max(gridOriginAtAxis(axis) + gridPosition * blockShape_[axis], roiBegin_[axis]);
+        }
+
+        T blockEndAtAxis(const T gridPosition, const unsigned axis) const {
+            return std::min(gridOriginAtAxis(axis) + (gridPosition + 1) * blockShape_[axis], roiEnd_[axis]);
+        }
+
         uint64_t getBlockAxisPosition(const uint64_t blockId, const unsigned axis) const {
             // get the position of the block in this axis
             uint64_t index = blockId;
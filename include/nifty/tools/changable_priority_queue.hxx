@@ -138,6 +138,36 @@ public:
             bubbleUp(indices_[i]);
         }
     }
+
+    /** \brief Set the priority of an index that is not in the queue.
+
+        The heap is not touched, so the priorities of different
+        indices can be set from different threads.
+        Call buildHeap afterwards to insert the indices.
+    */
+    void setPriority(const value_type i, const priority_type p) {
+        priorities_[i] = p;
+    }
+
+    /** \brief Insert all indices of [begin, end) at once with the
+        priorities given by setPriority.
+
+        The heap is built bottom up in O(n) instead of O(n log n) for
+        n pushes. The queue must not contain any of the indices.
+    */
+    template<class ITER>
+    void buildHeap(ITER begin, ITER end) {
+        for(; begin != end; ++begin){
+            const value_type i = *begin;
+            currentSize_++;
+            indices_[i] = currentSize_;
+            heap_[currentSize_] = i;
+        }
+        for(int k = currentSize_ / 2; k >= 1; --k){
+            bubbleDown(k);
+        }
+    }
+
 private:
     
 
@@ -3,10 +3,10 @@
 #include <algorithm>
 #include <map>
 #include <vector>
-#include <boost/functional/hash.hpp>
 
 #include "nifty/xtensor/xtensor.hxx"
 #include "nifty/parallel/threadpool.hxx"
+#include "nifty/parallel/parallel_sort.hxx"
 
 namespace nifty {
 namespace tools {
@@ -64,82 +64,67 @@ private:
 
         const std::size_t nEdges = uvIds.shape()[0];
         nifty::parallel::ThreadPool threadpool(numberOfThreads);
-        const std::size_t nThreads = threadpool.nThreads();
+        const std::size_t nThreads = std::max(std::size_t(1), threadpool.nThreads());
 
-        // find new uv-ids
-        typedef boost::hash<UvType> Hash;
-        std::unordered_map<UvType, std::size_t, Hash> uvNewToIndex;
-        {
-            // use normal map because we want to have ordered keys
-            typedef std::map<UvType, std::size_t> UvMap;
-            std::vector<UvMap> perThreadData(nThreads);
+        auto newUv = [&](const EdgeType edgeId) {
+            const NodeType uNew = nodeLabeling(uvIds(edgeId, 0));
+            const NodeType vNew = nodeLabeling(uvIds(edgeId, 1));
+            return std::make_pair(std::min(uNew, vNew), std::max(uNew, vNew));
+        };
 
+        // find new uv-ids: collect the uv-ids of all edges that are not contracted
+        // and sort them, which gives the same (ordered) ids as a map but merges in parallel
+        {
+            std::vector<std::vector<UvType>> perThreadData(nThreads);
             nifty::parallel::parallel_foreach(threadpool,
                                               nEdges,
                                               [&](const int tId, const EdgeType edgeId) {
-                //
-                const NodeType u = uvIds(edgeId, 0);
-                const NodeType v = uvIds(edgeId, 1);
-                const NodeType uNew = nodeLabeling(u);
-                const NodeType vNew = nodeLabeling(v);
-                if(uNew == vNew) {
-                    return;
-                }
-                auto & uvMap = perThreadData[tId];
-                const UvType uvNew = std::make_pair(std::min(uNew, vNew),
-                                                    std::max(uNew, vNew));
-                auto mapIt = uvMap.find(uvNew);
-                if(mapIt == uvMap.end()) {
-                    uvMap[uvNew] = 1;
-                } else {
-                    mapIt->second += 1;
+                const UvType uvNew = newUv(edgeId);
+                if(uvNew.first != uvNew.second) {
+                    perThreadData[tId].push_back(uvNew);
                 }
             });
 
-            // merge
-            auto & uvMap = perThreadData[0];
-            for(int tId = 1; tId < nThreads; ++tId) {
-                const auto & uvMap2 = perThreadData[tId];
-                for(const auto & uv2 : uvMap2) {
-                    auto mapIt = uvMap.find(uv2.first);
-                    if(mapIt == uvMap.end()) {
-                       uvMap[uv2.first] = uv2.second;
-                    } else {
-                        mapIt->second += uv2.second;
-                    }
-                }
+            std::vector<UvType> allUvs;
+            std::size_t nUvs = 0;
+            for(const auto & uvs : perThreadData) {
+                nUvs += uvs.size();
             }
-
-            newUvIds_.resize(uvMap.size());
-            edgeCounts_.resize(uvMap.size(), 0);
-            std::size_t ii = 0;
-            for(const auto & uv: uvMap) {
-                newUvIds_[ii] = uv.first;
-                edgeCounts_[ii] = uv.second;
-                uvNewToIndex[uv.first] = ii;
-                ++ii;
+            allUvs.reserve(nUvs);
+            for(auto & uvs : perThreadData) {
+                allUvs.insert(allUvs.end(), uvs.begin(), uvs.end());
+                UvVectorType().swap(uvs);
+            }
+            nifty::parallel::parallelSort(threadpool, allUvs.begin(), allUvs.end());
+
+            // run length encode the sorted uv-ids
+            newUvIds_.clear();
+            edgeCounts_.clear();
+            for(std::size_t ii = 0; ii < allUvs.size();) {
+                std::size_t runEnd = ii + 1;
+                while(runEnd < allUvs.size() && allUvs[runEnd] == allUvs[ii]) {
+                    ++runEnd;
+                }
+                newUvIds_.push_back(allUvs[ii]);
+                edgeCounts_.push_back(runEnd - ii);
+                ii = runEnd;
             }
         }
 
-        // get the edge mapping
+        // get the edge mapping by binary search in the sorted new uv-ids
         {
             edgeMapping_.resize(nEdges);
 
             nifty::parallel::parallel_foreach(threadpool,
                                               nEdges,
                                               [&](const int tId, const EdgeType edgeId) {
-                //
-                const NodeType u = uvIds(edgeId, 0);
-                const NodeType v = uvIds(edgeId, 1);
-                const NodeType uNew = nodeLabeling(u);
-                const NodeType vNew = nodeLabeling(v);
-                if(uNew == vNew) {
+                const UvType uvNew = newUv(edgeId);
+                if(uvNew.first == uvNew.second) {
                     edgeMapping_[edgeId] = -1;
                     return;
                 }
-                const UvType uvNew = std::make_pair(std::min(uNew, vNew), std::max(uNew, vNew));
-                const EdgeType newEdgeId = uvNewToIndex[uvNew];
-                edgeMapping_[edgeId] = newEdgeId;
+                const auto uvIt = std::lower_bound(newUvIds_.begin(), newUvIds_.end(), uvNew);
+                edgeMapping_[edgeId] = static_cast<EdgeType>(uvIt - newUvIds_.begin());
             });
         }
 
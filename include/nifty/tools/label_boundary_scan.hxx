@@ -0,0 +1,195 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+
+#include "nifty/array/arithmetic_array.hxx"
+
+namespace nifty{
+namespace tools{
+
+
+// \cond SUPPRESS_DOXYGEN
+namespace detail_label_boundary_scan{
+
+    // number of neighbouring pairs that are compared in one
+    // branch free chunk before falling back to the scalar loop
+    const std::ptrdiff_t ChunkSize = 16;
+
+    // no early exit on purpose: written as a reduction
+    // the compiler turns this into packed compares
+    template<class T>
+    inline bool anyDifferent(const T * a, const T * b, const std::ptrdiff_t n){
+        bool different = false;
+        for(std::ptrdiff_t i=0; i<n; ++i){
+            different |= (a[i] != b[i]);
+        }
+        return different;
+    }
+
+    // call f(i) for all i in [0, n) with a[i] != b[i]
+    template<class T, class F>
+    inline void forEachMismatch(const T * a, const T * b, const std::ptrdiff_t n, F && f){
+        std::ptrdiff_t i = 0;
+        for(; i + ChunkSize <= n; i += ChunkSize){
+            if(anyDifferent(a + i, b + i, ChunkSize)){
+                for(std::ptrdiff_t j=i; j<i+ChunkSize; ++j){
+                    if(a[j] != b[j]){
+                        f(j);
+                    }
+                }
+            }
+        }
+        for(; i<n; ++i){
+            if(a[i] != b[i]){
+                f(i);
+            }
+        }
+    }
+
+} // end namespace detail_label_boundary_scan
+// \endcond
+
+
+/**
+ * @brief      C-order strides (in elements) of a dense buffer
+ *
+ * @param      bufferShape  shape of the (allocated) buffer
+ *
+ * @return     strides with ``strides[DIM-1] == 1``
+ */
+template<std::size_t DIM, class SHAPE>
+inline array::StaticArray<int64_t, DIM> cOrderStrides(const SHAPE & bufferShape){
+    array::StaticArray<int64_t, DIM> strides;
+    strides[DIM-1] = 1;
+    for(int d=int(DIM)-2; d>=0; --d){
+        strides[d] = strides[d+1] * int64_t(bufferShape[d+1]);
+    }
+    return strides;
+}
+
+
+/**
+ * @brief      Visit all pairs of direct neighbours with different labels
+ *
+ * @details    Works directly on the raw memory of a label block
+ *             stored in C-order, where the last axis must be contiguous.
+ *             The block is processed row by row:
+ *             each row is compared against itself shifted by one (last axis)
+ *             and against the next row along every other axis.
+ *             Homogeneous runs are skipped with vectorized chunk compares,
+ *             so only the positions where labels differ are visited.
+ *
+ *             The first voxel of a pair (coordU) is restricted to
+ *             ``[0, coreShape)``, the second voxel (coordU + e_axis) to
+ *             ``[0, shape)``. This matches the core / overlap logic of
+ *             ``parallelForEachBlockWithOverlap``.
+ *             Pairs are not visited in the same order as with
+ *             ``forEachCoordinate``.
+ *
+ * @param      data       pointer to the first element of the block
+ * @param      strides    element strides of the buffer, see ``cOrderStrides``
+ * @param      coreShape  shape of the region for the first voxel of a pair
+ * @param      shape      shape of the valid region of the block
+ * @param      f          functor called as ``f(axis, coordU, lU, lV)``
+ */
+template<std::size_t DIM, class T, class SHAPE_T, class F>
+inline void forEachLabelBoundary(
+    const T * data,
+    const array::StaticArray<int64_t, DIM> & strides,
+    const array::StaticArray<SHAPE_T, DIM> & coreShape,
+    const array::StaticArray<SHAPE_T, DIM> & shape,
+    F && f
+){
+    typedef array::StaticArray<int64_t, DIM> Coord;
+    const std::size_t lastAxis = DIM - 1;
+
+    for(std::size_t d=0; d<DIM; ++d){
+        if(coreShape[d] <= 0){
+            return;
+        }
+    }
+
+    const int64_t rowLength = coreShape[lastAxis];
+    // pairs along the row need the right neighbour inside the block
+    const int64_t inRowPairs = std::min(int64_t(coreShape[lastAxis]),
+                                        int64_t(shape[lastAxis]) - 1);
+
+    Coord coord(0);
+    for(;;){
+
+        int64_t rowOffset = 0;
+        for(std::size_t d=0; d<lastAxis; ++d){
+            rowOffset += coord[d] * strides[d];
+        }
+        const T * row = data + rowOffset;
+
+        // along the row
+        if(inRowPairs > 0){
+            detail_label_boundary_scan::forEachMismatch(row, row + 1, inRowPairs,
+            [&](const std::ptrdiff_t i){
+                coord[lastAxis] = i;
+                f(lastAxis, coord, row[i], row[i+1]);
+            });
+        }
+
+        // against the next row along the outer axes
+        for(std::size_t axis=0; axis<lastAxis; ++axis){
+            if(coord[axis] + 1 < shape[axis]){
+                const T * nextRow = row + strides[axis];
+                detail_label_boundary_scan::forEachMismatch(row, nextRow, rowLength,
+                [&](const std::ptrdiff_t i){
+                    coord[lastAxis] = i;
+                    f(axis, coord, row[i], nextRow[i]);
+                });
+            }
+        }
+        coord[lastAxis] = 0;
+
+        // advance to the next row
+        int d = int(lastAxis) - 1;
+        for(; d>=0; --d){
+            if(++coord[d] < coreShape[d]){
+                break;
+            }
+            coord[d] = 0;
+        }
+        if(d < 0){
+            break;
+        }
+    }
+}
+
+
+/**
+ * @brief      Run-length scan over two label rows of equal length
+ *
+ * @details    Calls ``f(lA, lB, runLength)`` once for each maximal run
+ *             of positions where both ``a`` and ``b`` are constant.
+ *             Useful to count voxel pairs between two slices without
+ *             touching a map for every voxel.
+ *
+ * @param      a     first label row
+ * @param      b     second label row
+ * @param      n     number of elements in both rows
+ * @param      f     functor called as ``f(lA, lB, runLength)``
+ */
+template<class T, class F>
+inline void forEachLabelPairRun(const T * a, const T * b, const std::ptrdiff_t n, F && f){
+    std::ptrdiff_t runBegin = 0;
+    while(runBegin < n){
+        const T lA = a[runBegin];
+        const T lB = b[runBegin];
+        std::ptrdiff_t runEnd = runBegin + 1;
+        while(runEnd < n && a[runEnd] == lA && b[runEnd] == lB){
+            ++runEnd;
+        }
+        f(lA, lB, runEnd - runBegin);
+        runBegin = runEnd;
+    }
+}
+
+
+} // end namespace nifty::tools
+} // end namespace nifty
@@ -1,7 +1,10 @@
+#include <algorithm>
+#include <numeric>
 #include <unordered_map>
 #include <boost/functional/hash.hpp>
 #include "xtensor/xtensor.hpp"
 #include "nifty/tools/blocking.hxx"
+#include "nifty/parallel/threadpool.hxx"
 
 namespace nifty {
 namespace tools {
@@ -41,6 +44,46 @@ namespace tools {
     }
 
 
+    // sort a vector of (id, count) pairs that consists of runs given by run_bounds
+    // by merging the runs pairwise and sum up the counts of equal ids
+    template<class PAIR>
+    inline void mergeCountRuns(std::vector<PAIR> & pairs, std::vector<std::size_t> & run_bounds) {
+        // the runs are usually sorted already
+        const std::size_t n_runs = run_bounds.size() - 1;
+        for(std::size_t run = 0; run < n_runs; ++run) {
+            const auto run_begin = pairs.begin() + run_bounds[run];
+            const auto run_end = pairs.begin() + run_bounds[run + 1];
+            if(!std::is_sorted(run_begin, run_end)) {
+                std::sort(run_begin, run_end);
+            }
+        }
+
+        for(std::size_t width = 1; width < n_runs; width *= 2) {
+            for(std::size_t first = 0; first + width < n_runs; first += 2 * width) {
+                const std::size_t last = std::min(first + 2 * width, n_runs);
+                std::inplace_merge(pairs.begin() + run_bounds[first],
+                                   pairs.begin() + run_bounds[first + width],
+                                   pairs.begin() + run_bounds[last]);
+            }
+        }
+
+        // accumulate equal ids
+        auto out = pairs.begin();
+        for(auto it = pairs.begin(); it != pairs.end(); ++it) {
+            if(out != pairs.begin() && (out - 1)->first == it->first) {
+                (out - 1)->second += it->second;
+            } else {
+                *out = *it;
+                ++out;
+            }
+        }
+        pairs.erase(out, pairs.end());
+    }
+
+
+    // the ids of an entry are stored sorted, so the subset is computed
+    // by merging sorted runs instead of counting in a hash map;
+    // the output is always sorted by id, argsort is deprecated and ignored
     template<class OFFSETS, class IDS, class COUNTS>
     inline void readSubset(const OFFSETS & offsets,
                            const OFFSETS & sizes,
@@ -52,45 +95,37 @@ namespace tools {
 
         typedef typename IDS::value_type IdType;
         typedef typename COUNTS::value_type CountType;
-        typedef std::unordered_map<IdType, CountType> DictType;
-        DictType count_dict;
+        typedef std::pair<IdType, CountType> IdCount;
 
         const std::size_t n_offsets = offsets.size();
+        std::vector<std::size_t> run_bounds(n_offsets + 1, 0);
+        for(std::size_t off_id = 0; off_id < n_offsets; ++off_id) {
+            run_bounds[off_id + 1] = run_bounds[off_id] + sizes[off_id];
+        }
+
+        std::vector<IdCount> pairs;
+        pairs.reserve(run_bounds.back());
         for(std::size_t off_id = 0; off_id < n_offsets; ++off_id) {
             const std::size_t offset = offsets[off_id];
             const std::size_t size = sizes[off_id];
-
             for(std::size_t pos = offset; pos < offset + size; ++pos) {
-                const IdType id = ids(pos);
-                const CountType count = counts(pos);
-
-                auto c_it = count_dict.find(id);
-                if(c_it == count_dict.end()) {
-                    count_dict.emplace(id, count);
-                } else {
-                    c_it->second += count;
-                }
+                pairs.emplace_back(ids(pos), counts(pos));
             }
         }
+        mergeCountRuns(pairs, run_bounds);
 
         // copy to the output vectors
-        const std::size_t size = count_dict.size();
+        const std::size_t size = pairs.size();
         ids_out.resize(size);
         counts_out.resize(size);
-        std::size_t i = 0;
-        for(const auto & elem : count_dict) {
-            ids_out[i] = elem.first;
-            counts_out[i] = elem.second;
-            ++i;
-        }
-
-        // argsort the vectors by the id if specified
-        if(argsort) {
-            argsort_by_first_vector(ids_out, counts_out);
+        for(std::size_t i = 0; i < size; ++i) {
+            ids_out[i] = pairs[i].first;
+            counts_out[i] = pairs[i].second;
         }
     }
 
 
+    // argsort is deprecated and ignored, see above
     template<class BLOCK, class STRIDES, class OFFSETS, class IDS, class COUNTS>
     inline void readSubset(const BLOCK & block,
                            const STRIDES & strides,
@@ -142,6 +177,10 @@ namespace tools {
     }
 
 
+    // the blocks are processed in batches: the subsets of the blocks in a batch
+    // are computed in parallel, then the entries are deduplicated serially in block order,
+    // so only the subsets of one batch are kept in memory and the result
+    // does not depend on the number of threads
     template<class BLOCKING, class OFFSETS, class IDS, class COUNTS>
     inline void downsampleMultiset(const BLOCKING & blocking,
                                    const OFFSETS & offsets,
@@ -153,7 +192,8 @@ namespace tools {
                                    IDS & new_argmax,
                                    OFFSETS & new_offsets,
                                    std::vector<typename IDS::value_type> & new_ids,
-                                   std::vector<typename COUNTS::value_type> & new_counts) {
+                                   std::vector<typename COUNTS::value_type> & new_counts,
+                                   const int numberOfThreads=1) {
         typedef typename IDS::value_type IdType;
         typedef typename COUNTS::value_type CountType;
 
@@ -172,96 +212,115 @@ namespace tools {
             strides[d] = strides[d + 1] * shape[d + 1];
         }
 
+        parallel::ThreadPool threadpool(numberOfThreads);
+        const std::size_t n_threads = std::max(std::size_t(1), threadpool.nThreads());
+        const std::size_t batch_size = 64 * n_threads;
+
+        std::vector<std::vector<IdType>> block_ids(std::min(batch_size, n_blocks));
+        std::vector<std::vector<CountType>> block_counts(block_ids.size());
+        std::vector<CountType> block_max_counts(block_ids.size());
+
         std::vector<std::size_t> new_entry_offsets;
         std::vector<std::size_t> new_entry_sizes;
-
         std::size_t current_candidate_id = 0;
-        for(std::size_t block_id = 0; block_id < n_blocks; ++block_id) {
-            // 1.) read the subset from this block
-            std::vector<IdType> this_ids;
-            std::vector<CountType> this_counts;
-            const auto block = blocking.getBlock(block_id);
-            readSubset(block, strides,
-                       offsets, entry_sizes, entry_offsets,
-                       ids, counts, this_ids, this_counts);
-
-            // 2.) apply restrict sets if specified; compute argmax label and count
-            IdType max_label;
-            CountType max_count;
-            if(restrict_set > 0 && this_ids.size() > restrict_set) {
-                // arg-sort by counts (in descending order)
-                // could use std::nth_element to index sort and only get the 'restrict_set' largest
-                // elements, but that's premature optimization for now, because it will complicate the code
-                // quite a bit
-                argsort_by_first_vector(this_counts, this_ids, false);
-                max_label = this_ids[0];
-                max_count = this_counts[0];
-                // restrict
-                this_ids.resize(restrict_set);
-                this_counts.resize(restrict_set);
-                // argsort by ids
-                argsort_by_first_vector(this_ids, this_counts);
-            } else {
-                auto max_it = std::max_element(this_counts.begin(), this_counts.end());
-                max_label = this_ids[std::distance(this_counts.begin(), max_it)];
-                max_count = *max_it;
-            }
-            new_argmax(block_id) = max_label;
-
-            // 3.) check if we have this entry already in the hashed candidates
-            HashKey hash(max_label, max_count);
-            bool add_entry = true;
-            auto candidate_it = candidate_dict.find(hash);
-            if(candidate_it != candidate_dict.end()) {
-                const auto & candidates = candidate_it->second;
-                // iterate over the candidate offsets
-                for(const std::size_t c_offset_id : candidates) {
-                    // get the entry offset and entry size for this candidate
-                    const std::size_t c_offset = new_entry_offsets[c_offset_id];
-                    const std::size_t c_size = new_entry_sizes[c_offset_id];
-
-                    // check the ids
-                    bool match = check_range(this_ids.begin(), this_ids.end(),
-                                             new_ids.begin() + c_offset,
-                                             new_ids.begin() + c_offset + c_size);
-                    // if the ids match, check the counts
-                    if(match) {
-                        match = check_range(this_counts.begin(), this_counts.end(),
-                                            new_counts.begin() + c_offset,
-                                            new_counts.begin() + c_offset + c_size);
-                    }
 
-                    // the candidates and this entry agree -> we skip making a new
-                    // entry and just push back the offset we found
-                    if(match) {
-                        new_offsets(block_id) = c_offset;
-                        add_entry = false;
-                        break;
-                    }
+        for(std::size_t batch_begin = 0; batch_begin < n_blocks; batch_begin += batch_size) {
+            const std::size_t batch_end = std::min(batch_begin + batch_size, n_blocks);
+
+            // 1.) and 2.) read the subsets of the blocks in this batch, apply restrict sets and compute the argmax
+            parallel::parallel_foreach(threadpool, batch_end - batch_begin, [&](const int tid, const int64_t batch_id){
+                const std::size_t block_id = batch_begin + batch_id;
+                auto & this_ids = block_ids[batch_id];
+                auto & this_counts = block_counts[batch_id];
+                const auto block = blocking.getBlock(block_id);
+                readSubset(block, strides,
+                           offsets, entry_sizes, entry_offsets,
+                           ids, counts, this_ids, this_counts);
+
+                IdType max_label;
+                CountType max_count;
+                if(restrict_set > 0 && this_ids.size() > restrict_set) {
+                    // arg-sort by counts (in descending order)
+                    // could use std::nth_element to index sort and only get the 'restrict_set' largest
+                    // elements, but that's premature optimization for now, because it will complicate the code
+                    // quite a bit
+                    argsort_by_first_vector(this_counts, this_ids, false);
+                    max_label = this_ids[0];
+                    max_count = this_counts[0];
+                    // restrict
+                    this_ids.resize(restrict_set);
+                    this_counts.resize(restrict_set);
+                    // argsort by ids
+                    argsort_by_first_vector(this_ids, this_counts);
+                } else {
+                    auto max_it = std::max_element(this_counts.begin(), this_counts.end());
+                    max_label = this_ids[std::distance(this_counts.begin(), max_it)];
+                    max_count = *max_it;
                 }
-            }
+                new_argmax(block_id) = max_label;
+                block_max_counts[batch_id] = max_count;
+            });
+
+            for(std::size_t block_id = batch_begin; block_id < batch_end; ++block_id) {
+                const std::size_t batch_id = block_id - batch_begin;
+                auto & this_ids = block_ids[batch_id];
+                auto & this_counts = block_counts[batch_id];
+
+                // 3.) check if we have this entry already in the hashed candidates
+                HashKey hash(new_argmax(block_id), block_max_counts[batch_id]);
+                bool add_entry = true;
+                auto candidate_it = candidate_dict.find(hash);
+                if(candidate_it != candidate_dict.end()) {
+                    const auto & candidates = candidate_it->second;
+                    // iterate over the candidate offsets
+                    for(const std::size_t c_offset_id : candidates) {
+                        // get the entry offset and entry size for this candidate
+                        const std::size_t c_offset = new_entry_offsets[c_offset_id];
+                        const std::size_t c_size = new_entry_sizes[c_offset_id];
 
-            // 4.) if we haven't found this entry, add it!
-            if(add_entry) {
-                // update the new_offsets, entry_offsets and entry sizes
-                const std::size_t this_offset = new_ids.size();
-                new_offsets(block_id) = this_offset;
-                new_entry_offsets.emplace_back(this_offset);
-                new_entry_sizes.emplace_back(this_ids.size());
-
-                // store ids and counts
-                new_ids.insert(new_ids.end(), this_ids.begin(), this_ids.end());
-                new_counts.insert(new_counts.end(), this_counts.begin(), this_counts.end());
-
-                // add this offset to the candidates
-                if(candidate_it == candidate_dict.end()) {
-                    candidate_dict.emplace(hash, std::vector<std::size_t>({current_candidate_id}));
-                } else {
-                    candidate_it->second.emplace_back(current_candidate_id);
+                        // check the ids
+                        bool match = check_range(this_ids.begin(), this_ids.end(),
+                                                 new_ids.begin() + c_offset,
+                                                 new_ids.begin() + c_offset + c_size);
+                        // if the ids match, check the counts
+                        if(match) {
+                            match = check_range(this_counts.begin(), this_counts.end(),
+                                                new_counts.begin() + c_offset,
+                                                new_counts.begin() + c_offset + c_size);
+                        }
+
+                        // the candidates and this entry agree -> we skip making a new
+                        // entry and just push back the offset we found
+                        if(match) {
+                            new_offsets(block_id) = c_offset;
+                            add_entry = false;
+                            break;
+                        }
+                    }
                 }
 
-                // increase the current candidate id
-                ++current_candidate_id;
+                // 4.) if we haven't found this entry, add it!
+                if(add_entry) {
+                    // update the new_offsets, entry_offsets and entry sizes
+                    const std::size_t this_offset = new_ids.size();
+                    new_offsets(block_id) = this_offset;
+                    new_entry_offsets.emplace_back(this_offset);
+                    new_entry_sizes.emplace_back(this_ids.size());
+
+                    // store ids and counts
+                    new_ids.insert(new_ids.end(), this_ids.begin(), this_ids.end());
+                    new_counts.insert(new_counts.end(), this_counts.begin(), this_counts.end());
+
+                    // add this offset to the candidates
+                    if(candidate_it == candidate_dict.end()) {
+                        candidate_dict.emplace(hash, std::vector<std::size_t>({current_candidate_id}));
+                    } else {
+                        candidate_it->second.emplace_back(current_candidate_id);
+                    }
+
+                    // increase the current candidate id
+                    ++current_candidate_id;
+                }
             }
         }
     }
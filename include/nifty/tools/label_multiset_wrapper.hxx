@@ -1,7 +1,17 @@
+#pragma once
+
+#include <algorithm>
+#include <cstring>
+#include <functional>
+#include <numeric>
+#include <vector>
+
 #include "z5/factory.hxx"
 #include "z5/util/util.hxx"
 #include "z5/multiarray/xtensor_util.hxx"
 
+#include "nifty/parallel/threadpool.hxx"
+
 
 namespace nifty {
 namespace tools {
@@ -18,8 +28,10 @@ namespace tools {
         }
 
 
+        // the chunks of the request are read and deserialized in parallel,
+        // every chunk is written to a disjoint part of labels
         template<class ARRAY, class COORD>
-        inline void readSubarray(ARRAY & labels, const COORD & roiBegin) {
+        inline void readSubarray(ARRAY & labels, const COORD & roiBegin, const int numberOfThreads=1) {
 
             // get the offset and shape of the request and check if it is valid
             const auto & arrShape = labels.shape();
@@ -31,19 +43,24 @@ namespace tools {
             const auto & chunking = ds_->chunking();
             chunking.getBlocksOverlappingRoi(offset, shape, chunkRequests);
 
-            z5::types::ShapeType offsetInRequest, requestShape, chunkShape;
-            z5::types::ShapeType offsetInChunk;
+            parallel::ThreadPool threadpool(numberOfThreads);
+            const std::size_t nThreads = std::max(std::size_t(1), threadpool.nThreads());
 
+            // per thread buffers for the serialized and the deserialized chunk
             const std::size_t maxChunkSize = ds_->defaultChunkSize();
-            std::size_t chunkSize = maxChunkSize;
-            std::vector<uint64_t> buffer(chunkSize);
+            std::vector<std::vector<uint64_t>> buffers(nThreads, std::vector<uint64_t>(maxChunkSize));
+            std::vector<std::vector<uint8_t>> chunkDataBuffers(nThreads);
 
             // get the fillvalue
             const uint64_t fillValue = 0;
 
             // iterate over the chunks
-            for(const auto & chunkId : chunkRequests) {
+            parallel::parallel_foreach(threadpool, chunkRequests.size(), [&](const int tid, const int64_t chunkIndex) {
+                const auto & chunkId = chunkRequests[chunkIndex];
+                auto & buffer = buffers[tid];
 
+                z5::types::ShapeType offsetInRequest, requestShape, chunkShape;
+                z5::types::ShapeType offsetInChunk;
                 bool completeOvlp = chunking.getCoordinatesInRoi(chunkId,
                                                                  offset,
                                                                  shape,
@@ -58,14 +75,14 @@ namespace tools {
 
                 // check if this chunk exists, if not fill output with fill value
                 if(!ds_->chunkExists(chunkId)) {
-                    view = fillValue;;
-                    continue;
+                    view = fillValue;
+                    return;
                 }
 
                 // get the current chunk-shape
                 ds_->getChunkShape(chunkId, chunkShape);
-                chunkSize = std::accumulate(chunkShape.begin(), chunkShape.end(),
-                                            1, std::multiplies<std::size_t>());
+                const std::size_t chunkSize = std::accumulate(chunkShape.begin(), chunkShape.end(),
+                                                              1, std::multiplies<std::size_t>());
 
                 // resize the buffer if necessary
                 if(chunkSize != buffer.size()) {
@@ -73,7 +90,7 @@ namespace tools {
                 }
 
                 // read the current chunk into the buffer
-                readChunk(chunkId, buffer);
+                readChunk(chunkId, buffer, chunkDataBuffers[tid]);
 
                 // request and chunk overlap completely
                 // -> we can read all the data from the chunk
@@ -94,10 +111,18 @@ namespace tools {
                     // but this would be harder and might be premature optimization
                     view = bufView;
                 }
-            }
+            });
         }
 
         inline bool readChunk(const std::vector<std::size_t> & chunkId, std::vector<uint64_t> & labelVector) {
+            std::vector<uint8_t> chunkData;
+            return readChunk(chunkId, labelVector, chunkData);
+        }
+
+        // read a chunk, reusing chunkData as buffer for the serialized data
+        inline bool readChunk(const std::vector<std::size_t> & chunkId,
+                              std::vector<uint64_t> & labelVector,
+                              std::vector<uint8_t> & chunkData) {
 
             // check if this chunk exists
             if(!ds_->chunkExists(chunkId)) {
@@ -107,7 +132,7 @@ namespace tools {
             // get the size of this chunk and read it
             std::size_t thisSize;
             ds_->checkVarlenChunk(chunkId, thisSize);
-            std::vector<uint8_t> chunkData(thisSize);
+            chunkData.resize(thisSize);
             ds_->readChunk(chunkId, &chunkData[0]);
 
             std::size_t chunkPos = 0;
@@ -1,47 +1,274 @@
 #pragma once
-#include <unordered_map>
+#include <algorithm>
+#include <cstdint>
+#include <unordered_set>
+#include <vector>
 
 
 #include "nifty/xtensor/xtensor.hxx"
 #include "nifty/parallel/threadpool.hxx"
+#include "nifty/parallel/parallel_sort.hxx"
+#include "nifty/tools/blocking.hxx"
+#include "nifty/tools/sorted_key_lookup.hxx"
+#include "nifty/tools/block_pipeline.hxx"
 
 namespace nifty{
 namespace tools{
 
-    template<class ARRAY>
-    void makeDense(xt::xexpression<ARRAY> & dataExp){
-        typedef typename ARRAY::value_type DataType;
-        auto & data = dataExp.derived_cast();
 
-        std::unordered_map<DataType, DataType> hmap;
-        for(auto s=0; s<data.size(); ++s){
-            const auto val = data(s);
-            hmap[val] = DataType();
+    /**
+     * @brief      Unique values of a contiguous range in parallel
+     *
+     * @details    Every thread collects the values of its chunks in a
+     *             thread local hash set, the sets are concatenated and
+     *             sorted / deduplicated with ``parallel::parallelSortUnique``.
+     *
+     * @param      data        pointer to the values
+     * @param      size        number of values
+     * @param      out         sorted unique values
+     * @param      threadpool  the thread pool
+     */
+    template<class T>
+    inline void parallelUniques(const T * data,
+                                const std::size_t size,
+                                std::vector<T> & out,
+                                parallel::ThreadPool & threadpool){
+        const std::size_t nThreads = std::max(std::size_t(1), threadpool.nThreads());
+        // a few chunks per thread for load balancing
+        const std::size_t nChunks = std::min(size, 4 * nThreads);
+
+        std::vector<std::unordered_set<T>> perThreadSets(nThreads);
+        parallel::parallel_foreach(threadpool, nChunks, [&](const int tid, const int64_t c){
+            auto & set = perThreadSets[tid];
+            const std::size_t chunkBegin = (size * c) / nChunks;
+            const std::size_t chunkEnd = (size * (c + 1)) / nChunks;
+            // runs of equal values are common in label volumes
+            T last = data[chunkBegin];
+            set.insert(last);
+            for(std::size_t i = chunkBegin + 1; i < chunkEnd; ++i){
+                if(data[i] != last){
+                    last = data[i];
+                    set.insert(last);
+                }
+            }
+        });
+
+        std::size_t nValues = 0;
+        for(const auto & set : perThreadSets){
+            nValues += set.size();
         }
-        DataType c = 0;
-        for(auto & kv : hmap){
-            kv.second = c;
-            ++c;
+        out.clear();
+        out.reserve(nValues);
+        for(auto & set : perThreadSets){
+            out.insert(out.end(), set.begin(), set.end());
+            std::unordered_set<T>().swap(set);
         }
-        for(auto s=0; s<data.size(); ++s){
-            const auto val = data(s);
-            data(s) = hmap[val];
+        parallel::parallelSortUnique(threadpool, out);
+    }
+
+
+    /**
+     * @brief      Replace every value by its position in the sorted unique values
+     *
+     * @param      data        pointer to the values, relabeled in place
+     * @param      size        number of values
+     * @param      threadpool  the thread pool
+     */
+    template<class T>
+    inline void makeDense(T * data,
+                          const std::size_t size,
+                          parallel::ThreadPool & threadpool){
+        if(size == 0){
+            return;
+        }
+        std::vector<T> uniqueValues;
+        parallelUniques(data, size, uniqueValues, threadpool);
+        const SortedKeyLookup<T> lookup(uniqueValues);
+        parallel::parallel_foreach(threadpool, size, [&](const int tid, const int64_t i){
+            data[i] = static_cast<T>(lookup.find(data[i]));
+        });
+    }
+
+
+    // true if the values of the array are stored densely in row-major order,
+    // i.e. data() and size() cover all values
+    template<class ARRAY>
+    inline bool isRowMajorContiguous(const ARRAY & array){
+        const auto & shape = array.shape();
+        const auto & strides = array.strides();
+        std::ptrdiff_t expected = 1;
+        for(int d = int(shape.size()) - 1; d >= 0; --d){
+            if(shape[d] != 1 && std::ptrdiff_t(strides[d]) != expected){
+                return false;
+            }
+            expected *= shape[d];
+        }
+        return true;
+    }
+
+
+    // relabel to consecutive labels starting at 0 (in the order of the sorted labels);
+    // arrays that are not contiguous (e.g. strided views) are relabeled in a copy
+    template<class ARRAY>
+    void makeDense(xt::xexpression<ARRAY> & dataExp, const int numberOfThreads = -1){
+        auto & data = dataExp.derived_cast();
+        parallel::ThreadPool threadpool(numberOfThreads);
+        if(isRowMajorContiguous(data)){
+            makeDense(data.data(), data.size(), threadpool);
+        }
+        else{
+            typedef typename ARRAY::value_type T;
+            std::vector<T> values(data.begin(), data.end());
+            makeDense(values.data(), values.size(), threadpool);
+            std::copy(values.begin(), values.end(), data.begin());
         }
     }
 
     template<class ARRAY1, class ARRAY2>
     void makeDense(
         const xt::xexpression<ARRAY1> & dataInExp,
-        xt::xexpression<ARRAY2> & dataOutExp
+        xt::xexpression<ARRAY2> & dataOutExp,
+        const int numberOfThreads = -1
     ){
         const auto & dataIn = dataInExp.derived_cast();
         auto & dataOut = dataOutExp.derived_cast();
-        for(auto s=0; s<dataIn.size(); ++s){
-            dataOut(s) = dataIn(s);
+        std::copy(dataIn.begin(), dataIn.end(), dataOut.begin());
+        makeDense(dataOut, numberOfThreads);
+    }
+
+
+    /**
+     * @brief      Unique values of an array that does not fit into memory
+     *
+     * @details    Streams over the blocks of ``blockShape`` with a
+     *             ``BlockPipeline``; the uniques of each block are
+     *             merged into thread local sorted vectors.
+     *
+     * @param      data             the (chunked) array, e.g. a hdf5 or z5 dataset
+     * @param      blockShape       block shape, should be a multiple of the chunk shape
+     * @param      out              sorted unique values
+     * @param      numberOfThreads  number of compute threads
+     */
+    template<class T, std::size_t DIM, class ARRAY>
+    void blockwiseUnique(const ARRAY & data,
+                         const array::StaticArray<int64_t, DIM> & blockShape,
+                         std::vector<T> & out,
+                         const int numberOfThreads = -1){
+        typedef array::StaticArray<int64_t, DIM> VectorType;
+
+        VectorType shape, roiBegin(0);
+        for(std::size_t d = 0; d < DIM; ++d){
+            shape[d] = data.shape()[d];
+        }
+        const Blocking<DIM> blocking(roiBegin, shape, blockShape);
+
+        typename BlockPipeline<T, DIM>::SettingsType settings;
+        settings.numberOfThreads = numberOfThreads;
+        BlockPipeline<T, DIM> pipeline(blocking, VectorType(0), settings);
+
+        const std::size_t nThreads = parallel::ParallelOptions(numberOfThreads).getActualNumThreads();
+        std::vector<std::vector<T>> perThread(nThreads);
+        parallel::ThreadPool serial(0);
+
+        pipeline.run(data, [&](const int tid, const uint64_t blockId,
+                                const typename Blocking<DIM>::BlockWithHaloType & blockWithHalo,
+                                const auto & view){
+            // copy to flat storage, the view is strided
+            std::vector<T> blockValues(view.begin(), view.end());
+            std::vector<T> blockUniques;
+            parallelUniques(blockValues.data(), blockValues.size(), blockUniques, serial);
+
+            auto & threadUniques = perThread[tid];
+            std::vector<T> merged;
+            merged.reserve(threadUniques.size() + blockUniques.size());
+            std::set_union(threadUniques.begin(), threadUniques.end(),
+                           blockUniques.begin(), blockUniques.end(),
+                           std::back_inserter(merged));
+            threadUniques.swap(merged);
+        });
+
+        out.clear();
+        for(const auto & threadUniques : perThread){
+            out.insert(out.end(), threadUniques.begin(), threadUniques.end());
+        }
+        parallel::ThreadPool threadpool(numberOfThreads);
+        parallel::parallelSortUnique(threadpool, out);
+    }
+
+
+    /**
+     * @brief      Map the values of an array blockwise with sorted keys and values
+     *
+     * @details    Values that are not contained in ``keys`` are kept.
+     *             ``arrayIn`` and ``arrayOut`` may be the same dataset.
+     *
+     * @param      arrayIn          input array
+     * @param      arrayOut         output array of same shape
+     * @param      blockShape       block shape, should be a multiple of the chunk shape
+     * @param      keys             sorted keys
+     * @param      values           values for the keys
+     * @param      numberOfThreads  number of compute threads
+     */
+    template<class T, std::size_t DIM, class ARRAY_IN, class ARRAY_OUT>
+    void blockwiseRelabel(const ARRAY_IN & arrayIn,
+                          ARRAY_OUT & arrayOut,
+                          const array::StaticArray<int64_t, DIM> & blockShape,
+                          const std::vector<T> & keys,
+                          const std::vector<T> & values,
+                          const int numberOfThreads = -1){
+        NIFTY_CHECK_OP(keys.size(), ==, values.size(), "keys and values need the same size");
+        typedef array::StaticArray<int64_t, DIM> VectorType;
+
+        VectorType shape, roiBegin(0);
+        for(std::size_t d = 0; d < DIM; ++d){
+            shape[d] = arrayIn.shape()[d];
+            NIFTY_CHECK_OP(arrayIn.shape()[d], ==, arrayOut.shape()[d], "input and output need the same shape");
+        }
+        const Blocking<DIM> blocking(roiBegin, shape, blockShape);
+
+        typename BlockPipeline<T, DIM>::SettingsType settings;
+        settings.numberOfThreads = numberOfThreads;
+        BlockPipeline<T, DIM> pipeline(blocking, VectorType(0), settings);
+
+        const SortedKeyLookup<T> lookup(keys);
+        pipeline.run(arrayIn, [&](const int tid, const uint64_t blockId,
+                                  const typename Blocking<DIM>::BlockWithHaloType & blockWithHalo,
+                                  auto & view){
+            for(auto & val : view){
+                const auto pos = lookup.find(val);
+                if(pos != SortedKeyLookup<T>::NotFound){
+                    val = values[pos];
+                }
+            }
+            const auto & block = blockWithHalo.outerBlock();
+            writeSubarray(arrayOut, block.begin(), block.end(), view);
+        });
+    }
+
+
+    /**
+     * @brief      Out of core version of ``makeDense``
+     *
+     * @details    Two passes over the input: one to collect the uniques,
+     *             one to write the relabeled blocks.
+     *
+     * @return     the number of unique values
+     */
+    template<std::size_t DIM, class ARRAY_IN, class ARRAY_OUT>
+    std::size_t blockwiseMakeDense(const ARRAY_IN & arrayIn,
+                                   ARRAY_OUT & arrayOut,
+                                   const array::StaticArray<int64_t, DIM> & blockShape,
+                                   const int numberOfThreads = -1){
+        typedef typename ARRAY_IN::value_type T;
+        std::vector<T> keys;
+        blockwiseUnique(arrayIn, blockShape, keys, numberOfThreads);
+        std::vector<T> values(keys.size());
+        for(std::size_t i = 0; i < values.size(); ++i){
+            values[i] = static_cast<T>(i);
         }
-        makeDense(dataOut);
+        blockwiseRelabel(arrayIn, arrayOut, blockShape, keys, values, numberOfThreads);
+        return keys.size();
     }
 
 }
 }
-
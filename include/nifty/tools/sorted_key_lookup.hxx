@@ -0,0 +1,73 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+namespace nifty{
+namespace tools{
+
+
+    /**
+     * @brief      Maps values to their position in a sorted vector of keys
+     *
+     * @details    If the range of the keys is not much larger than their
+     *             number, the lookup goes through a dense table,
+     *             otherwise through binary search.
+     *             Both are free of hashing and safe to use from many threads.
+     *             The keys are referenced, not copied.
+     */
+    template<class T>
+    class SortedKeyLookup{
+    public:
+        static const std::size_t NotFound = std::numeric_limits<std::size_t>::max();
+
+        SortedKeyLookup(const std::vector<T> & sortedKeys)
+        :   keys_(sortedKeys),
+            minKey_(sortedKeys.empty() ? T(0) : sortedKeys.front()),
+            table_()
+        {
+            if(keys_.empty()){
+                return;
+            }
+            // unsigned difference is well defined for signed keys as well
+            const uint64_t range = uint64_t(keys_.back()) - uint64_t(minKey_);
+            if(range < 2 * uint64_t(keys_.size()) + (1 << 16)){
+                table_.resize(range + 1, NotFound);
+                for(std::size_t i = 0; i < keys_.size(); ++i){
+                    table_[offset(keys_[i])] = i;
+                }
+            }
+        }
+
+        // position of value in the keys or NotFound
+        std::size_t find(const T value) const {
+            if(!table_.empty()){
+                const uint64_t off = offset(value);
+                return (value < minKey_ || off >= table_.size()) ? NotFound : table_[off];
+            }
+            const auto it = std::lower_bound(keys_.begin(), keys_.end(), value);
+            return (it == keys_.end() || *it != value) ? NotFound : std::size_t(it - keys_.begin());
+        }
+
+        const std::vector<T> & keys() const {
+            return keys_;
+        }
+
+    private:
+        uint64_t offset(const T value) const {
+            return uint64_t(value) - uint64_t(minKey_);
+        }
+
+        const std::vector<T> & keys_;
+        T minKey_;
+        std::vector<std::size_t> table_;
+    };
+
+    template<class T>
+    const std::size_t SortedKeyLookup<T>::NotFound;
+
+
+} // namespace tools
+} // namespace nifty
@@ -0,0 +1,215 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "nifty/parallel/threadpool.hxx"
+
+
+namespace nifty {
+namespace ufd{
+
+/// Disjoint set data structure that can be merged from many threads.
+///
+/// Sets are linked by index: the root with the larger index is
+/// attached to the root with the smaller index with a compare-and-swap,
+/// so the representative of a set is always its smallest element,
+/// independent of the order of the merges.
+/// find uses path halving, which is safe under concurrent merges.
+///
+template<class T = uint64_t>
+class ConcurrentUfd {
+public:
+    typedef T Index;
+
+    ConcurrentUfd(const Index = 0);
+    void assign(const Index = 0);
+
+    Index numberOfElements() const;
+    Index find(Index) const; // with path halving
+    bool merge(Index, Index);
+
+    // the number of roots (not thread safe w.r.t. concurrent merges)
+    Index numberOfSets(parallel::ThreadPool &) const;
+
+    template<class Iterator>
+        void elementLabeling(Iterator, parallel::ThreadPool &) const;
+
+private:
+    // path halving only ever moves pointers closer to the root
+    mutable std::vector<std::atomic<Index>> parents_;
+};
+
+/// Construct a ufd (with a number of sets each containing one element).
+///
+/// \param size Number of distinct sets.
+///
+template<class T>
+inline
+ConcurrentUfd<T>::ConcurrentUfd(
+    const Index size
+)
+:   parents_(static_cast<uint64_t>(size))
+{
+    for(Index j = 0; j < size; ++j) {
+        parents_[static_cast<uint64_t>(j)].store(j, std::memory_order_relaxed);
+    }
+}
+
+/// Reset the ufd (to a number of sets each containing one element).
+///
+/// \param size Number of distinct sets.
+///
+template<class T>
+inline void
+ConcurrentUfd<T>::assign(
+    const Index size
+) {
+    std::vector<std::atomic<Index>>(static_cast<uint64_t>(size)).swap(parents_);
+    for(Index j = 0; j < size; ++j) {
+        parents_[static_cast<uint64_t>(j)].store(j, std::memory_order_relaxed);
+    }
+}
+
+template<class T>
+inline typename ConcurrentUfd<T>::Index
+ConcurrentUfd<T>::numberOfElements() const {
+    return static_cast<Index>(parents_.size());
+}
+
+/// Find the representative element of the set that contains the given element.
+///
+/// Every other element on the path is pointed to its grandparent (path halving).
+///
+/// \param element Element.
+///
+template<class T>
+inline typename ConcurrentUfd<T>::Index
+ConcurrentUfd<T>::find(
+    Index element
+) const {
+    for(;;) {
+        Index parent = parents_[static_cast<uint64_t>(element)].load(std::memory_order_relaxed);
+        if(parent == element) {
+            return element;
+        }
+        const Index grandParent = parents_[static_cast<uint64_t>(parent)].load(std::memory_order_relaxed);
+        if(grandParent != parent) {
+            // failing is fine, somebody else shortened the path already
+            parents_[static_cast<uint64_t>(element)].compare_exchange_weak(
+                parent, grandParent, std::memory_order_relaxed
+            );
+        }
+        element = grandParent;
+    }
+}
+
+/// Merge two sets.
+///
+/// \param element1 Element in the first set.
+/// \param element2 Element in the second set.
+///
+/// \return true if the two sets were different, i.e. this call linked them
+///
+template<class T>
+inline bool
+ConcurrentUfd<T>::merge(
+    Index element1,
+    Index element2
+) {
+    for(;;) {
+        element1 = find(element1);
+        element2 = find(element2);
+        if(element1 == element2) {
+            return false;
+        }
+        // link the larger root to the smaller one
+        if(element1 < element2) {
+            std::swap(element1, element2);
+        }
+        Index expected = element1;
+        if(parents_[static_cast<uint64_t>(element1)].compare_exchange_strong(
+            expected, element2, std::memory_order_acq_rel
+        )) {
+            return true;
+        }
+        // element1 got linked by another thread in the meantime, retry from its new root
+    }
+}
+
+template<class T>
+inline typename ConcurrentUfd<T>::Index
+ConcurrentUfd<T>::numberOfSets(
+    parallel::ThreadPool & threadpool
+) const {
+    const std::size_t nThreads = std::max(std::size_t(1), threadpool.nThreads());
+    std::vector<Index> perThreadCounts(nThreads, 0);
+    parallel::parallel_foreach(threadpool, parents_.size(), [&](const int tid, const int64_t j){
+        if(parents_[j].load(std::memory_order_relaxed) == Index(j)) {
+            ++perThreadCounts[tid];
+        }
+    });
+    Index numberOfSets = 0;
+    for(const auto count : perThreadCounts) {
+        numberOfSets += count;
+    }
+    return numberOfSets;
+}
+
+/// Output a contiguous labeling of all elements.
+///
+/// The sets are labeled in the order of their smallest element,
+/// so the labeling does not depend on the order of the merges.
+///
+/// \param out (Output) Random access iterator into a container in which the j-th entry becomes the label of the j-th element.
+///
+template<class T>
+template<class Iterator>
+inline void
+ConcurrentUfd<T>::elementLabeling(
+    Iterator out,
+    parallel::ThreadPool & threadpool
+) const {
+    const std::size_t size = parents_.size();
+    const std::size_t nThreads = std::max(std::size_t(1), threadpool.nThreads());
+    const std::size_t nChunks = std::max(std::size_t(1), std::min(size, nThreads));
+    auto chunkBegin = [&](const std::size_t c){ return (size * c) / nChunks; };
+
+    // count the roots per chunk
+    std::vector<Index> chunkOffsets(nChunks + 1, 0);
+    parallel::parallel_foreach(threadpool, nChunks, [&](const int tid, const int64_t c){
+        Index count = 0;
+        for(std::size_t j = chunkBegin(c); j < chunkBegin(c + 1); ++j) {
+            count += parents_[j].load(std::memory_order_relaxed) == Index(j);
+        }
+        chunkOffsets[c + 1] = count;
+    });
+    for(std::size_t c = 0; c < nChunks; ++c) {
+        chunkOffsets[c + 1] += chunkOffsets[c];
+    }
+
+    // label the roots, a root is always smaller than the other elements of its set
+    parallel::parallel_foreach(threadpool, nChunks, [&](const int tid, const int64_t c){
+        Index label = chunkOffsets[c];
+        for(std::size_t j = chunkBegin(c); j < chunkBegin(c + 1); ++j) {
+            if(parents_[j].load(std::memory_order_relaxed) == Index(j)) {
+                out[j] = label;
+                ++label;
+            }
+        }
+    });
+
+    // label the other elements with the label of their root
+    parallel::parallel_foreach(threadpool, size, [&](const int tid, const int64_t j){
+        const Index root = find(j);
+        if(root != Index(j)) {
+            out[j] = out[root];
+        }
+    });
+}
+
+} // namespace ufd
+} // namespace nifty
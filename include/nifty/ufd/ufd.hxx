@@ -41,6 +41,9 @@ public:
     void merge(Index, Index);
     void insert(const Index);
 
+    template<class UFD>
+        void assignPartition(const UFD &);
+
 private:
     std::vector<Index> parents_;
     std::vector<Index> ranks_;
@@ -188,6 +191,34 @@ Ufd<T>::insert(
     numberOfSets_ += number;
 }
 
+/// Take over the sets of another disjoint set structure, e.g. a ConcurrentUfd.
+///
+/// The representatives become the representatives of the other structure.
+///
+/// \param other Disjoint set structure with find(Index) const.
+///
+template<class T>
+template<class UFD>
+inline void
+Ufd<T>::assignPartition(
+    const UFD & other
+) {
+    const Index size = static_cast<Index>(other.numberOfElements());
+    parents_.resize(static_cast<uint64_t>(size));
+    ranks_.assign(static_cast<uint64_t>(size), 0);
+    numberOfSets_ = 0;
+    for(Index j = 0; j < size; ++j) {
+        const Index root = static_cast<Index>(other.find(j));
+        parents_[static_cast<uint64_t>(j)] = root;
+        if(root == j) {
+            ++numberOfSets_;
+        }
+        else {
+            ranks_[static_cast<uint64_t>(root)] = 1;
+        }
+    }
+}
+
 /// Output all elements which are set representatives.
 /// 
 /// \param it (Output) Iterator.
@@ -0,0 +1,43 @@
+from __future__ import print_function
+
+import numpy
+
+import nifty
+import nifty.graph
+import nifty.graph.rag as nrag
+
+# compare the hierarchical block multicut with a flat
+# greedy additive + kernighan lin run on a multicut
+# with ~10^7 edges: every voxel of a 150^3 volume is a node
+shape = (150, 150, 150)
+nThreads = 8
+
+numberOfLabels = int(numpy.prod(shape))
+labels = numpy.arange(numberOfLabels, dtype='uint32').reshape(shape)
+rag = nrag.gridRag(labels, numberOfLabels=numberOfLabels, numberOfThreads=nThreads)
+
+graph = nifty.graph.undirectedGraph(rag.numberOfNodes)
+graph.insertEdges(rag.uvIds())
+print("graph with", graph.numberOfNodes, "nodes and", graph.numberOfEdges, "edges")
+
+# mostly attractive weights with repulsive noise
+numpy.random.seed(42)
+weights = numpy.random.normal(loc=0.5, scale=1.0, size=graph.numberOfEdges)
+objective = nifty.graph.multicut.multicutObjective(graph, weights)
+Obj = nifty.graph.UndirectedGraph.MulticutObjective
+
+solvers = (
+    ("flat greedy additive + kl",
+     Obj.kernighanLinFactory(warmStartGreedy=True)),
+    ("block multicut (greedy additive)",
+     Obj.blockMulticutFactory(blockSize=10000, numberOfThreads=nThreads)),
+    ("block multicut (greedy additive + kl)",
+     Obj.blockMulticutFactory(submodelFactory=Obj.kernighanLinFactory(warmStartGreedy=True),
+                              blockSize=10000, numberOfThreads=nThreads)),
+)
+
+for name, factory in solvers:
+    solver = factory.create(objective)
+    with nifty.Timer(name):
+        nodeLabels = solver.optimize()
+    print("    energy", objective.evalNodeLabels(nodeLabels))
@@ -0,0 +1,49 @@
+from __future__ import print_function
+
+import os
+import numpy
+import z5py
+
+import nifty
+import nifty.z5
+import nifty.graph.rag as nrag
+
+# compare synchronous block reads with the prefetching block pipeline
+# for projectScalarNodeDataToPixels on a compressed z5 dataset
+path = "/tmp/nifty_block_pipeline_benchmark.n5"
+
+shape = [500, 500, 500]
+chunkShape = [100, 100, 100]
+blockShape = [100, 100, 100]
+nThreads = 8
+ioThreadsToTest = [1, 2, 4]
+
+
+if not os.path.exists(path):
+    # blocky oversegmentation that still compresses reasonably
+    f = z5py.File(path, use_zarr_format=False)
+    cubes = numpy.arange(10**3, dtype='uint64').reshape((10, 10, 10))
+    labels = numpy.kron(cubes, numpy.ones((50, 50, 50), dtype='uint64'))
+    ds = f.create_dataset('labels', shape=shape, chunks=chunkShape,
+                          dtype='uint64', compression='gzip')
+    ds[:] = labels
+    f.create_dataset('out', shape=shape, chunks=chunkShape,
+                     dtype='uint64', compression='gzip')
+
+labels = nifty.z5.datasetWrapper('uint64', os.path.join(path, 'labels'))
+out = nifty.z5.datasetWrapper('uint64', os.path.join(path, 'out'))
+
+numberOfLabels = 10**3
+rag = nrag.gridRagZ5(labels, numberOfLabels=numberOfLabels,
+                     numberOfThreads=nThreads, dtype='uint64')
+nodeData = numpy.arange(numberOfLabels, dtype='uint64')[::-1].copy()
+
+with nifty.Timer("synchronous reads"):
+    nrag.projectScalarNodeDataToPixels(rag, nodeData, out, blockShape=blockShape,
+                                       numberOfThreads=nThreads)
+
+for nIo in ioThreadsToTest:
+    with nifty.Timer("block pipeline with %i io threads" % nIo):
+        nrag.projectScalarNodeDataToPixels(rag, nodeData, out, blockShape=blockShape,
+                                           numberOfThreads=nThreads,
+                                           numberOfIoThreads=nIo)
@@ -0,0 +1,26 @@
+from __future__ import print_function
+
+import numpy
+
+import nifty
+import nifty.graph
+import nifty.tools as nt
+
+# compare the grid graph based connected components with the
+# block parallel labeling on a random binary volume with ~10^8 voxels
+shape = (464, 464, 464)
+mask = numpy.random.rand(*shape) > 0.7
+
+with nifty.Timer("grid graph, 1 thread"):
+    gridGraph = nifty.graph.gridGraph(shape)
+    ccGraph = nifty.graph.connectedComponentsFromNodeLabels(gridGraph, mask.ravel().astype('uint64'),
+                                                            dense=True, ignoreBackground=False,
+                                                            numberOfThreads=1)
+del gridGraph
+
+for nThreads in (1, 8):
+    with nifty.Timer("blocks, %i threads" % nThreads):
+        cc, sizes = nt.blockConnectedComponents(mask, blockShape=[64, 64, 64],
+                                                ignoreBackground=False,
+                                                numberOfThreads=nThreads)
+    assert cc.max() + 1 == len(numpy.unique(ccGraph))
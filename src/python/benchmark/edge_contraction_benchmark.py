@@ -0,0 +1,38 @@
+from __future__ import print_function
+
+import numpy
+
+import nifty
+import nifty.graph
+import nifty.graph.rag as nrag
+
+# compare the adjacency merge modes of the edge contraction graph
+# for an agglomeration on a region adjacency graph with ~10^7 edges:
+# every voxel of a 150^3 volume is a region
+shape = (150, 150, 150)
+nThreads = 8
+
+numberOfLabels = int(numpy.prod(shape))
+labels = numpy.arange(numberOfLabels, dtype='uint32').reshape(shape)
+rag = nrag.gridRag(labels, numberOfLabels=numberOfLabels, numberOfThreads=nThreads)
+print("rag with", rag.numberOfNodes, "nodes and", rag.numberOfEdges, "edges")
+
+graph = nifty.graph.undirectedGraph(rag.numberOfNodes)
+graph.insertEdges(rag.uvIds())
+
+# random edge weights: many clusters grow in parallel (kruskal order)
+randomOrder = numpy.argsort(numpy.random.rand(graph.numberOfEdges)).astype('uint64')
+# edges in id order: a single cluster grows into a hub with a large adjacency
+sweepOrder = numpy.arange(graph.numberOfEdges, dtype='uint64')
+
+modes = (nifty.graph.AdjacencyMergeMode.insertMerge,
+         nifty.graph.AdjacencyMergeMode.sortMerge)
+
+for orderName, order in (("random order", randomOrder), ("sweep order", sweepOrder)):
+    for mode in modes:
+        callback = nifty.graph.EdgeContractionGraphCallback()
+        cgraph = nifty.graph.edgeContractionGraph(graph, callback)
+        cgraph.adjacencyMergeMode = mode
+        with nifty.Timer("%s %s" % (orderName, str(mode))):
+            cgraph.contractEdges(order)
+        assert cgraph.numberOfNodes == 1
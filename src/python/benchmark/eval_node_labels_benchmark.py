@@ -0,0 +1,39 @@
+from __future__ import print_function
+
+import sys
+
+import numpy
+
+import nifty
+import nifty.graph
+import nifty.graph.opt.multicut as nmc
+
+# evaluate a multicut objective with 10^9 edges (~60 GB of memory),
+# a smaller number of edges can be passed as first argument
+numberOfEdges = int(float(sys.argv[1])) if len(sys.argv) > 1 else 10**9
+
+# every node is connected to its successors i + 1, ..., i + 8, so the edges are unique
+strides = numpy.arange(1, 9, dtype='uint64')
+numberOfNodes = numberOfEdges // len(strides) + len(strides)
+chunkSize = 10**7
+
+with nifty.Timer("build graph with %i edges" % numberOfEdges):
+    graph = nifty.graph.UndirectedGraph(numberOfNodes, numberOfEdges)
+    for begin in range(0, numberOfEdges // len(strides), chunkSize):
+        u = numpy.arange(begin, min(begin + chunkSize, numberOfEdges // len(strides)), dtype='uint64')
+        uvIds = numpy.stack([numpy.repeat(u, len(strides)),
+                             (u[:, None] + strides[None, :]).ravel()], axis=1)
+        graph.insertEdges(uvIds)
+
+weights = numpy.random.rand(graph.numberOfEdges) - 0.5
+objective = nmc.multicutObjective(graph, weights)
+del weights
+labels = numpy.random.randint(0, 1000, size=graph.numberOfNodes).astype('uint64')
+
+energies = []
+for nThreads in (1, 2, 4, 8, 16):
+    with nifty.Timer("evalNodeLabels, %i threads" % nThreads):
+        energies.append(objective.evalNodeLabels(labels, numberOfThreads=nThreads))
+
+# the blocks are summed up in the same order for any number of threads
+assert all(e == energies[0] for e in energies)
@@ -56,6 +56,21 @@ if True:
 
 print()
 
+if True:
+    # c++ hyperslab reads vs. direct chunk reads with decompression
+    # in the reading threads
+    h5File = nifty.hdf5.openFile(fileName)
+    array = nifty.hdf5.Hdf5ArrayUInt32(h5File, dsetName)
+    print("supports direct chunk read", array.supportsDirectChunkRead)
+
+    for readMode in (nifty.hdf5.ReadMode.HYPERSLAB_READ,
+                     nifty.hdf5.ReadMode.DIRECT_CHUNK_READ):
+        for n in (1, 2, 4, 8, 16, nThreads):
+            with nifty.Timer("c++ %s %d threads" % (str(readMode), n)):
+                nifty.hdf5.runBenchmark(array, blocking, n, readMode)
+
+print()
+
 if True:
     # first c++
     h5File = nifty.hdf5.openFile(fileName)
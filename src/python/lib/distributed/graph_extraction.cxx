@@ -26,7 +26,8 @@ namespace distributed {
             const std::string & keyToGraph,
             const bool ignoreLabel,
             const bool increaseRoi,
-            const bool serializeToVarlen
+            const bool serializeToVarlen,
+            const int numberOfThreads
         ) {
 
             py::gil_scoped_release allowThreads;
@@ -34,14 +35,15 @@ namespace distributed {
                                         roiBegin, roiEnd,
                                         pathToGraph, keyToGraph,
                                         ignoreLabel, increaseRoi,
-                                        serializeToVarlen);
+                                        serializeToVarlen, numberOfThreads);
 
         }, py::arg("pathToLabels"), py::arg("keyToLabels"),
            py::arg("roiBegin"), py::arg("roiEnd"),
            py::arg("pathToGraph"), py::arg("keyToGraph"),
            py::arg("ignoreLabel")=false,
            py::arg("increaseRoi")=false,
-           py::arg("serializeToVarlen")=false);
+           py::arg("serializeToVarlen")=false,
+           py::arg("numberOfThreads")=1);
 
 
         module.def("mergeSubgraphs", [](
@@ -6,6 +6,7 @@
 
 #include "xtensor-python/pytensor.hpp"
 
+#include "nifty/tools/runtime_check.hxx"
 #include "nifty/filters/gaussian_curvature.hxx"
 
 namespace py = pybind11;
@@ -14,11 +15,12 @@ namespace nifty{
 namespace filters{
 
 
-    void exportGaussianCurvature(py::module & module) {
+    template<class CLS_TYPE, std::size_t DIM>
+    void exportGaussianCurvatureT(py::module & module, const std::string & clsName) {
 
-        typedef GaussianCurvature2D<> ClsType;
+        typedef CLS_TYPE ClsType;
         typedef typename ClsType::ValueType ValueType;
-        auto pyCls = py::class_< ClsType >(module, "GaussianCurvature2D");
+        auto pyCls = py::class_< ClsType >(module, clsName.c_str());
         pyCls
         .def(py::init<
             const ValueType, int, const ValueType
@@ -31,16 +33,26 @@ namespace filters{
         .def("__call__",[](
             const ClsType & self,
             xt::pytensor<float, 2> coords,
-            const bool loop
+            const bool loop,
+            const int numberOfThreads
         ){
+            NIFTY_CHECK_OP(coords.shape()[1], ==, DIM, "coordinates have the wrong dimension");
             typedef typename xt::pytensor<float, 1>::shape_type ShapeType;
             ShapeType shape = {coords.shape()[0]};
             xt::pytensor<float, 1> out = xt::zeros<float>(shape);
-            self(coords, out, loop);
+            {
+                py::gil_scoped_release allowThreads;
+                self(coords, out, loop, numberOfThreads);
+            }
             return out;
-        })
+        }, py::arg("coords"), py::arg("loop"), py::arg("numberOfThreads")=1)
         ;
+    }
 
+
+    void exportGaussianCurvature(py::module & module) {
+        exportGaussianCurvatureT<GaussianCurvature2D<>, 2>(module, "GaussianCurvature2D");
+        exportGaussianCurvatureT<GaussianCurvature3D<>, 3>(module, "GaussianCurvature3D");
     }
 
 }
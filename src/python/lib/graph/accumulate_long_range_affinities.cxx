@@ -6,6 +6,7 @@
 
 
 
+#include "nifty/graph/accumulate_long_range_affinities.hxx"
 #include "nifty/python/graph/undirected_grid_graph.hxx"
 #include "nifty/python/graph/undirected_list_graph.hxx"
 
@@ -23,106 +24,107 @@ namespace graph{
     //  - does not require a RAG but simply a graph and a label image (can include long-range edges)
     //  - can perform weighted average of affinities depending on given affinitiesWeights
     //  - ignore pixels with ignore label
+    //
+    // The affinities are channel first and, like the labels, are read as strided
+    // views of the numpy arrays without copies.
 
-    template<std::size_t DIM, class GRAPH, class LABELS_TYPE>
-    void exportAccumulateAffinitiesMeanAndLength(
+    template<std::size_t DIM, class GRAPH, class LABELS_TYPE, class AFFINITIES_TYPE>
+    void exportAccumulateAffinitiesMeanAndLengthChannelFirst(
             py::module & module
     ) {
+        typedef xt::pytensor<float, 1> OutArrayType;
+        typedef std::tuple<OutArrayType, OutArrayType, OutArrayType>  OutType;
+
+        auto toOffsetVector = [](const xt::pytensor<int, 2> & offsets){
+            NIFTY_CHECK_OP(offsets.shape()[1], ==, DIM, "offsets have wrong dimension");
+            std::vector<array::StaticArray<int64_t, DIM>> offsetVector(offsets.shape()[0]);
+            for(auto i=0; i<offsets.shape()[0]; ++i){
+                for(auto d=0; d<DIM; ++d){
+                    offsetVector[i][d] = offsets(i, d);
+                }
+            }
+            return offsetVector;
+        };
+
+        // weights per offset, no weights if offsetWeights is empty
         module.def("accumulateAffinitiesMeanAndLength_impl_",
-                      [](
+                      [toOffsetVector](
                               const GRAPH &graph,
-                              xt::pytensor<LABELS_TYPE, DIM> labels,
-                              xt::pytensor<float, DIM + 1> affinities,
-                              xt::pytensor<float, DIM + 1> affinitiesWeights,
-                              xt::pytensor<int, 2> offsets,
+                              const xt::pytensor<LABELS_TYPE, DIM> & labels,
+                              const xt::pytensor<AFFINITIES_TYPE, DIM + 1> & affinities,
+                              const xt::pytensor<int, 2> & offsets,
+                              const xt::pytensor<float, 1> & offsetWeights,
                               const bool hasIgnoreLabel,
                               const uint64_t ignoreLabel,
                               const int numberOfThreads
                       ) {
-                          array::StaticArray<uint64_t, DIM> shape;
-
-                          // Check inputs:
-                          for(auto d=0; d<DIM; ++d){
-                              shape[d] = labels.shape()[d];
-                              NIFTY_CHECK_OP(shape[d],==,affinities.shape()[d], "affinities have wrong shape");
-                              NIFTY_CHECK_OP(shape[d],==,affinitiesWeights.shape()[d], "affinities have wrong shape");
+                          const auto offsetVector = toOffsetVector(offsets);
+                          const bool hasOffsetWeights = offsetWeights.size() > 0;
+                          if(hasOffsetWeights){
+                              NIFTY_CHECK_OP(offsetWeights.shape()[0], ==, offsets.shape()[0], "Offsets weights and offsets do not match");
                           }
-                          NIFTY_CHECK_OP(offsets.shape()[0],==,affinities.shape()[DIM], "Affinities and offsets do not match");
-                          NIFTY_CHECK_OP(offsets.shape()[0],==,affinitiesWeights.shape()[DIM], "Affinities and offsets do not match");
-
 
-                          // Create thread pool:
-                          nifty::parallel::ParallelOptions pOpts(numberOfThreads);
-                          nifty::parallel::ThreadPool threadpool(pOpts);
-                          const std::size_t actualNumberOfThreads = pOpts.getActualNumThreads();
-
-                          // Create temporary arrays
                           const std::size_t nb_edges = uint64_t(graph.edgeIdUpperBound()+1);
-                          xt::pytensor<float, 2> accAff = xt::zeros<float>({actualNumberOfThreads, nb_edges});
-                          xt::pytensor<float, 2> maxAff = xt::zeros<float>({actualNumberOfThreads, nb_edges});
-                          xt::pytensor<float, 2> counter = xt::zeros<float>({actualNumberOfThreads, nb_edges});
+                          OutArrayType accAff_out = xt::zeros<float>({nb_edges});
+                          OutArrayType counter_out = xt::zeros<float>({nb_edges});
+                          OutArrayType maxAff_out = xt::zeros<float>({nb_edges});
                           {
                               py::gil_scoped_release allowThreads;
-                              nifty::tools::parallelForEachCoordinate(threadpool,
-                                                                      shape,
-                                                                      [&](const auto threadId, const auto & coordP){
-                                                                          const auto u = labels[coordP];
-                                                                          if ((!hasIgnoreLabel) || (hasIgnoreLabel && u!=ignoreLabel)) {
-                                                                              for(auto i=0; i<offsets.shape()[0]; ++i){
-                                                                                  auto coordQ = coordP;
-                                                                                  for (auto d=0; d<DIM; ++d) {
-                                                                                      coordQ[d] += offsets(i,d);
-                                                                                  }
-                                                                                  if(coordQ.allInsideShape(shape)){
-                                                                                      const auto v = labels[coordQ];
-                                                                                      // Check if there is ignore label:
-                                                                                      if ((!hasIgnoreLabel) || (hasIgnoreLabel && v!=ignoreLabel)) {
-                                                                                          // Only consider if pixels are in different clusters:
-                                                                                          if (u != v) {
-                                                                                              const auto edge = graph.findEdge(u,v);
-                                                                                              if (edge >=0 ){
-                                                                                                  array::StaticArray<int64_t, DIM + 1> affIndex;
-                                                                                                  std::copy(std::begin(coordP), std::end(coordP), std::begin(affIndex));
-                                                                                                  affIndex[DIM] = i;
-                                                                                                  const auto aff_value = affinities[affIndex];
-                                                                                                  if (aff_value > maxAff(threadId, edge))
-                                                                                                      maxAff(threadId, edge) = aff_value;
-                                                                                                  counter(threadId,edge) += affinitiesWeights[affIndex];
-                                                                                                  accAff(threadId,edge) += aff_value * affinitiesWeights[affIndex];
-                                                                                              }
-                                                                                          }
-                                                                                      }
-                                                                                  }
-                                                                              }
-                                                                          }
-                                                                      });
+                              accumulateAffinitiesMeanAndLength<DIM>(graph, labels, affinities, offsetVector,
+                                  [&](const int offsetIndex, const auto & coord){
+                                      return hasOffsetWeights ? offsetWeights(offsetIndex) : 1.f;
+                                  },
+                                  hasIgnoreLabel, ignoreLabel,
+                                  accAff_out, maxAff_out, counter_out, numberOfThreads
+                              );
+                          }
+                          return OutType(accAff_out, maxAff_out, counter_out);
+                      },
+                      py::arg("graph"),
+                      py::arg("labels").noconvert(),
+                      py::arg("affinities").noconvert(),
+                      py::arg("offsets"),
+                      py::arg("offsetWeights"),
+                      py::arg("hasIgnoreLabel"),
+                      py::arg("ignoreLabel"),
+                      py::arg("numberOfThreads") = -1
+        );
+
+        // weights per affinity, channel first like the affinities
+        module.def("accumulateAffinitiesMeanAndLengthWithWeights_impl_",
+                      [toOffsetVector](
+                              const GRAPH &graph,
+                              const xt::pytensor<LABELS_TYPE, DIM> & labels,
+                              const xt::pytensor<AFFINITIES_TYPE, DIM + 1> & affinities,
+                              const xt::pytensor<float, DIM + 1> & affinitiesWeights,
+                              const xt::pytensor<int, 2> & offsets,
+                              const bool hasIgnoreLabel,
+                              const uint64_t ignoreLabel,
+                              const int numberOfThreads
+                      ) {
+                          const auto offsetVector = toOffsetVector(offsets);
+                          for(auto d=0; d<DIM+1; ++d){
+                              NIFTY_CHECK_OP(affinitiesWeights.shape()[d],==,affinities.shape()[d], "affinities weights have wrong shape");
                           }
 
-                          // Create outputs:
-                          typedef xt::pytensor<float, 1> OutArrayType;
-                          typedef std::tuple<OutArrayType, OutArrayType, OutArrayType>  OutType;
+                          const std::size_t nb_edges = uint64_t(graph.edgeIdUpperBound()+1);
                           OutArrayType accAff_out = xt::zeros<float>({nb_edges});
                           OutArrayType counter_out = xt::zeros<float>({nb_edges});
                           OutArrayType maxAff_out = xt::zeros<float>({nb_edges});
-
-                          // Normalize:
-                          for(auto i=0; i<nb_edges; ++i){
-                              maxAff_out(i) = maxAff(0,i);
-                              for(auto thr=1; thr<actualNumberOfThreads; ++thr){
-                                  counter(0,i) += counter(thr,i);
-                                  accAff(0,i) += accAff(thr,i);
-                                  if (maxAff(thr,i) > maxAff_out(i))
-                                      maxAff_out(i) = maxAff(thr,i);
-                              }
-                              if(counter(0,i)>0.    ){
-                                  accAff_out(i) = accAff(0,i) / counter(0,i);
-                                  counter_out(i) = counter(0,i);
-                              } else {
-                                  accAff_out(i) = 0.;
-                                  counter_out(i) = 0.;
-                              }
+                          {
+                              py::gil_scoped_release allowThreads;
+                              accumulateAffinitiesMeanAndLength<DIM>(graph, labels, affinities, offsetVector,
+                                  [&](const int offsetIndex, const auto & coord){
+                                      array::StaticArray<int64_t, DIM + 1> weightCoord;
+                                      weightCoord[0] = offsetIndex;
+                                      std::copy(coord.begin(), coord.end(), weightCoord.begin() + 1);
+                                      return xtensor::read(affinitiesWeights, weightCoord.asStdArray());
+                                  },
+                                  hasIgnoreLabel, ignoreLabel,
+                                  accAff_out, maxAff_out, counter_out, numberOfThreads
+                              );
                           }
-                          return OutType(accAff_out, maxAff_out, counter_out);;
+                          return OutType(accAff_out, maxAff_out, counter_out);
                       },
                       py::arg("graph"),
                       py::arg("labels").noconvert(),
@@ -133,6 +135,14 @@ namespace graph{
                       py::arg("ignoreLabel"),
                       py::arg("numberOfThreads") = -1
         );
+    }
+
+
+    // Accumulate the affinities of the links inside of the clusters (channel last affinities)
+    template<std::size_t DIM, class LABELS_TYPE>
+    void exportAccumulateAffinitiesMeanAndLengthInsideClusters(
+            py::module & module
+    ) {
         module.def("accumulateAffinitiesMeanAndLengthInsideClusters_impl_",
                       [](
                               xt::pytensor<LABELS_TYPE, DIM> labels,
@@ -237,8 +247,16 @@ namespace graph{
 
     void exportAccumulateLongRangeAffinities(py::module & module) {
         typedef PyUndirectedGraph GraphType;
-        exportAccumulateAffinitiesMeanAndLength<3, GraphType, uint64_t>(module);
-        exportAccumulateAffinitiesMeanAndLength<3, GraphType, uint32_t>(module);
+        exportAccumulateAffinitiesMeanAndLengthInsideClusters<3, uint64_t>(module);
+        exportAccumulateAffinitiesMeanAndLengthInsideClusters<3, uint32_t>(module);
+
+        // float32, uint8 and float16 (passed as uint16) affinities
+        exportAccumulateAffinitiesMeanAndLengthChannelFirst<3, GraphType, uint64_t, float>(module);
+        exportAccumulateAffinitiesMeanAndLengthChannelFirst<3, GraphType, uint32_t, float>(module);
+        exportAccumulateAffinitiesMeanAndLengthChannelFirst<3, GraphType, uint64_t, uint8_t>(module);
+        exportAccumulateAffinitiesMeanAndLengthChannelFirst<3, GraphType, uint32_t, uint8_t>(module);
+        exportAccumulateAffinitiesMeanAndLengthChannelFirst<3, GraphType, uint64_t, uint16_t>(module);
+        exportAccumulateAffinitiesMeanAndLengthChannelFirst<3, GraphType, uint32_t, uint16_t>(module);
     }
 }
 }
@@ -15,6 +15,7 @@ namespace graph{
 namespace agglo{
 
     void exportMergeRules(py::module &);
+    void exportMergeTree(py::module &);
     void exportAgglomerativeClustering(py::module &);
     void exportGaspAgglomerativeClustering(py::module &);
     void exportDualAgglomerativeClustering(py::module &);
@@ -35,6 +36,7 @@ PYBIND11_MODULE(_agglo, module) {
 
     using namespace nifty::graph::agglo;
     exportMergeRules(module);
+    exportMergeTree(module);
     exportAgglomerativeClustering(module);
     exportGaspAgglomerativeClustering(module);
     exportDualAgglomerativeClustering(module);
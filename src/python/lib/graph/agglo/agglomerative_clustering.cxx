@@ -172,11 +172,13 @@ namespace agglo{
                     const PyViewFloat1 & edgeSizes,
                     const PyViewFloat1 & nodeSizes,
                     const uint64_t numberOfNodesStop,
-                    const float sizeRegularizer
+                    const float sizeRegularizer,
+                    const int numberOfThreads
                 ){
                     EdgeWeightedClusterPolicySettings s;
                     s.numberOfNodesStop = numberOfNodesStop;
                     s.sizeRegularizer = sizeRegularizer;
+                    s.numberOfThreads = numberOfThreads;
                     auto ptr = new ClusterPolicyType(graph, edgeIndicators, edgeSizes, nodeSizes, s);
                     return ptr;
                 },
@@ -187,7 +189,8 @@ namespace agglo{
                 py::arg("edgeSizes"),
                 py::arg("nodeSizes"),
                 py::arg("numberOfNodesStop") = 1,
-                py::arg("sizeRegularizer") = 0.5f
+                py::arg("sizeRegularizer") = 0.5f,
+                py::arg("numberOfThreads") = 1
             );
 
             // export the agglomerative clustering functionality for this cluster operator
@@ -229,12 +232,14 @@ namespace agglo{
                     const PyViewFloat1 & nodeSizes,
                     const float beta,
                     const uint64_t numberOfNodesStop,
-                    const float sizeRegularizer
+                    const float sizeRegularizer,
+                    const int numberOfThreads
                 ){
                     typename ClusterPolicyType::SettingsType s;
                     s.numberOfNodesStop = numberOfNodesStop;
                     s.sizeRegularizer = sizeRegularizer;
                     s.beta = beta;
+                    s.numberOfThreads = numberOfThreads;
 
                     // create a MultibandArrayViewNodeMap
                     nifty::graph::graph_maps::MultibandArrayViewNodeMap<PyViewFloat2> nodeFeaturesView(nodeFeatures);
@@ -251,7 +256,8 @@ namespace agglo{
                 py::arg("nodeSizes"),
                 py::arg("beta") = 0.5f,
                 py::arg("numberOfNodesStop") = 1,
-                py::arg("sizeRegularizer") = 0.5f
+                py::arg("sizeRegularizer") = 0.5f,
+                py::arg("numberOfThreads") = 1
             );
 
             // export the agglomerative clustering functionality for this cluster operator
@@ -67,16 +67,20 @@ namespace nifty{
                                             const uint64_t numberOfNodesStop,
                                             const double sizeRegularizer,
                                             const bool addNonLinkConstraints,
+                                            const bool nonLinkConstraintsBloomFilter,
                                             const bool mergeConstrainedEdgesAtTheEnd,
-                                            const bool collectStats
+                                            const bool collectStats,
+                                            const int numberOfThreads
                                     ){
                                         typename ClusterPolicyType::SettingsType s;
                                         s.numberOfNodesStop = numberOfNodesStop;
                                         s.sizeRegularizer = sizeRegularizer;
                                         s.updateRule = updateRule;
                                         s.addNonLinkConstraints = addNonLinkConstraints;
+                                        s.nonLinkConstraintsBloomFilter = nonLinkConstraintsBloomFilter;
                                         s.mergeConstrainedEdgesAtTheEnd = mergeConstrainedEdgesAtTheEnd;
                                         s.collectStats = collectStats;
+                                        s.numberOfThreads = numberOfThreads;
                                         auto ptr = new ClusterPolicyType(graph, signedWeights, isLocalEdge, edgeSizes, nodeSizes, s);
                                         return ptr;
                                     },
@@ -91,8 +95,10 @@ namespace nifty{
                                     py::arg("numberOfNodesStop") = 1,
                                     py::arg("sizeRegularizer") = 0.,
                                     py::arg("addNonLinkConstraints") = false,
+                                    py::arg("nonLinkConstraintsBloomFilter") = true,
                                     py::arg("mergeConstrainedEdgesAtTheEnd") = false,
-                                    py::arg("collectStats") = false
+                                    py::arg("collectStats") = false,
+                                    py::arg("numberOfThreads") = 1
                     );
 
                     // export the agglomerative clustering functionality for this cluster operator
@@ -0,0 +1,96 @@
+#include <pybind11/pybind11.h>
+#include <pybind11/numpy.h>
+
+#include "xtensor-python/pytensor.hpp"
+
+#include "nifty/python/graph/undirected_list_graph.hxx"
+#include "nifty/graph/agglo/merge_tree.hxx"
+
+
+namespace py = pybind11;
+
+namespace nifty{
+namespace graph{
+namespace agglo{
+
+
+    void exportMergeTree(py::module & aggloModule) {
+
+        // same as DendrogramAgglomerativeClusteringVisitor::MergeTreeType
+        typedef MergeTree<uint64_t, double, double> MergeTreeType;
+
+        py::class_<MergeTreeType>(aggloModule, "MergeTree")
+            .def_property_readonly("numberOfLeaves", &MergeTreeType::numberOfLeaves)
+            .def_property_readonly("numberOfMerges", &MergeTreeType::numberOfMerges)
+
+            // the merged nodes as (numberOfMerges, 2) array, the i-th merge
+            // creates the node numberOfLeaves + i
+            .def("children", [](const MergeTreeType & self){
+                const std::size_t n = self.numberOfMerges();
+                xt::pytensor<uint64_t, 2> children({n, std::size_t(2)});
+                for(std::size_t i = 0; i < n; ++i){
+                    children(i, 0) = self.childrenA()[i];
+                    children(i, 1) = self.childrenB()[i];
+                }
+                return children;
+            })
+            .def("heights", [](const MergeTreeType & self){
+                xt::pytensor<double, 1> heights({std::size_t(self.numberOfMerges())});
+                std::copy(self.heights().begin(), self.heights().end(), heights.begin());
+                return heights;
+            })
+            .def("sizes", [](const MergeTreeType & self){
+                xt::pytensor<double, 1> sizes({std::size_t(self.numberOfMerges())});
+                std::copy(self.sizes().begin(), self.sizes().end(), sizes.begin());
+                return sizes;
+            })
+            .def("ultrametricHeights", [](const MergeTreeType & self){
+                std::vector<double> heights;
+                self.ultrametricHeights(heights);
+                xt::pytensor<double, 1> out({heights.size()});
+                std::copy(heights.begin(), heights.end(), out.begin());
+                return out;
+            })
+
+            .def("cut", [](const MergeTreeType & self, const double threshold){
+                xt::pytensor<uint64_t, 1> labels({std::size_t(self.numberOfLeaves())});
+                {
+                    py::gil_scoped_release allowThreads;
+                    self.cut(threshold, labels);
+                }
+                return labels;
+            },
+            py::arg("threshold")
+            )
+
+            .def("cuts", [](const MergeTreeType & self,
+                            const xt::pytensor<double, 1> & thresholds,
+                            const int numberOfThreads){
+                xt::pytensor<uint64_t, 2> labels({std::size_t(thresholds.size()),
+                                                  std::size_t(self.numberOfLeaves())});
+                {
+                    py::gil_scoped_release allowThreads;
+                    self.cuts(thresholds, labels, numberOfThreads);
+                }
+                return labels;
+            },
+            py::arg("thresholds"),
+            py::arg("numberOfThreads")=-1
+            )
+
+            .def("edgeUcm", [](const MergeTreeType & self, const PyUndirectedGraph & graph){
+                xt::pytensor<double, 1> ucm({std::size_t(graph.edgeIdUpperBound() + 1)});
+                {
+                    py::gil_scoped_release allowThreads;
+                    self.edgeUcm(graph, ucm);
+                }
+                return ucm;
+            },
+            py::arg("graph")
+            )
+        ;
+    }
+
+}
+}
+}
@@ -24,12 +24,19 @@ namespace graph{
             const GRAPH & graph,
             xt::pytensor<uint64_t, 1> nodeLabels,
             const bool dense,
-            const bool ignoreBackground
+            const bool ignoreBackground,
+            const int numberOfThreads
         ){
 
             xt::pytensor<uint64_t, 1> ccLabels = xt::zeros<uint64_t>({nodeLabels.shape()[0]});
             ComponentsUfd<GRAPH> componentsUfd(graph);
-            componentsUfd.buildFromLabels(nodeLabels);
+            if(numberOfThreads == 1){
+                componentsUfd.buildFromLabels(nodeLabels);
+            }
+            else{
+                py::gil_scoped_release allowThreads;
+                componentsUfd.buildFromLabels(nodeLabels, numberOfThreads);
+            }
 
             for(const auto node : graph.nodes()){
                 ccLabels[node] = componentsUfd.componentLabel(node);
@@ -60,7 +67,7 @@ namespace graph{
                 }
             }
             else if(dense  && !ignoreBackground){
-                componentsUfd.denseRelabeling(ccLabels);
+                componentsUfd.parallelDenseRelabeling(ccLabels, numberOfThreads);
             }
             else if(ignoreBackground){
                 for(const auto node : graph.nodes()){
@@ -79,6 +86,7 @@ namespace graph{
             py::arg("nodeLabels"),
             py::arg("dense")=true,
             py::arg("ignoreBackground")=false,
+            py::arg("numberOfThreads")=1,
             "compute connected component labels of a node labeling\n\n"
             ""
             "All nodes which have zero as nodeLabel will keep a zero"
@@ -88,6 +96,8 @@ namespace graph{
             "   nodeLabels (numpy.ndarray): node labeling\n"
             "   dense (bool): should the returned labeling be dense (default {True})\n\n"
             "   ignoreBackground (bool): if true, all input zeros are mapped to zeros (default {False})\n\n"
+            "   numberOfThreads (int): number of threads, the component ids (but not the\n"
+            "       components) depend on whether this is 1 or not (default {1})\n\n"
             "Returns:\n\n"
             "   numpy.ndarray : connected components labels"
         );
@@ -110,21 +120,41 @@ namespace graph{
         );
 
         componentsPyCls
-        .def("build",[](ComponentsType & self){
-            self.build();
-        })
+        .def("build",[](ComponentsType & self, const int numberOfThreads){
+            py::gil_scoped_release allowThreads;
+            if(numberOfThreads == 1){
+                self.build();
+            }
+            else{
+                self.build(DefaultSubgraphMask<GraphType>(), numberOfThreads);
+            }
+        }, py::arg("numberOfThreads")=1)
         .def("buildFromNodeLabels",[](
             ComponentsType & self,
-            xt::pytensor<uint64_t, 1> labels
+            xt::pytensor<uint64_t, 1> labels,
+            const int numberOfThreads
         ){
-            self.buildFromLabels(labels);
-        })
+            py::gil_scoped_release allowThreads;
+            if(numberOfThreads == 1){
+                self.buildFromLabels(labels);
+            }
+            else{
+                self.buildFromLabels(labels, numberOfThreads);
+            }
+        }, py::arg("labels"), py::arg("numberOfThreads")=1)
         .def("buildFromEdgeLabels",[](
             ComponentsType & self,
-            xt::pytensor<uint8_t, 1> labels
+            xt::pytensor<uint8_t, 1> labels,
+            const int numberOfThreads
         ){
-            self.buildFromEdgeLabels(labels);
-        })
+            py::gil_scoped_release allowThreads;
+            if(numberOfThreads == 1){
+                self.buildFromEdgeLabels(labels);
+            }
+            else{
+                self.buildFromEdgeLabels(labels, numberOfThreads);
+            }
+        }, py::arg("labels"), py::arg("numberOfThreads")=1)
         .def("componentLabels",[](
             ComponentsType & self
         ){
@@ -3,6 +3,7 @@
 #define NIFTY_PYTHON_GRAPH_EXPORT_EDGE_CONTRACTION_GRAPH_HXX
 
 #include <pybind11/functional.h> 
+#include "xtensor-python/pytensor.hpp"
 
 #include "nifty/python/converter.hxx"
 #include "export_undirected_graph_class_api.hxx"
@@ -20,6 +21,12 @@ namespace graph{
         py::module & graphModule
     ){
         typedef FlexibleCallback Callback;
+
+        py::enum_<AdjacencyMergeMode>(graphModule, "AdjacencyMergeMode")
+            .value("insertMerge", INSERT_MERGE)
+            .value("sortMerge", SORT_MERGE)
+        ;
+
         py::class_< Callback >(graphModule, "EdgeContractionGraphCallbackImpl")
             .def(py::init<>())
             .def_readwrite("contractEdgeCallback",&Callback::contractEdgeCallback)
@@ -57,6 +64,27 @@ namespace graph{
             // modifications
             .def("contractEdge", &GraphType::contractEdge)
             .def("reset",&GraphType::reset)
+            .def("contractEdges", [](GraphType & g, const xt::pytensor<uint64_t, 1> & edges){
+                // contract the base graph edges in the given order,
+                // edges whose end nodes are already merged are skipped
+                uint64_t numberOfContractions = 0;
+                for(const auto edge : edges){
+                    const auto uv = g.baseGraph().uv(edge);
+                    const auto u = g.findRepresentativeNode(uv.first);
+                    const auto v = g.findRepresentativeNode(uv.second);
+                    if(u != v){
+                        g.contractEdge(g.findEdge(u, v));
+                        ++numberOfContractions;
+                    }
+                }
+                return numberOfContractions;
+            },
+                py::arg("edges")
+            )
+            .def_property("adjacencyMergeMode",
+                &GraphType::adjacencyMergeMode,
+                &GraphType::setAdjacencyMergeMode
+            )
 
 
             // queries
@@ -26,6 +26,7 @@ namespace graph{
     void exportEdgeWeightedWatersheds(py::module &);
     void exportNodeWeightedWatersheds(py::module &);
     void exportAccumulateLongRangeAffinities(py::module &);
+    void exportMappedUndirectedGraph(py::module &);
 }
 }
 
@@ -50,5 +51,6 @@ PYBIND11_MODULE(_graph, module) {
     exportEdgeWeightedWatersheds(module);
     exportNodeWeightedWatersheds(module);
     exportAccumulateLongRangeAffinities(module);
+    exportMappedUndirectedGraph(module);
 
 }
@@ -0,0 +1,90 @@
+#include <pybind11/pybind11.h>
+#include <pybind11/numpy.h>
+#include <pybind11/stl.h>
+
+#include "nifty/graph/undirected_list_graph.hxx"
+#include "nifty/graph/mapped_undirected_graph.hxx"
+
+#include "export_undirected_graph_class_api.hxx"
+#include "xtensor-python/pytensor.hpp"
+
+namespace py = pybind11;
+
+namespace nifty{
+namespace graph{
+
+    // read-only array which keeps the mapped graph (and thus the mapping) alive
+    template<class T>
+    py::array_t<T> mappedArray(
+        py::object graph,
+        const T * data,
+        const std::vector<py::ssize_t> & shape
+    ){
+        std::vector<py::ssize_t> strides(shape.size(), sizeof(T));
+        for(int d = int(shape.size()) - 2; d >= 0; --d){
+            strides[d] = strides[d + 1] * shape[d + 1];
+        }
+        py::array_t<T> array(shape, strides, data, graph);
+        array.attr("setflags")(py::arg("write")=false);
+        return array;
+    }
+
+    void exportMappedUndirectedGraph(py::module & graphModule) {
+
+        typedef MappedUndirectedGraph GraphType;
+        const auto clsName = std::string("MappedUndirectedGraph");
+        auto mappedGraphCls = py::class_<GraphType>(graphModule, clsName.c_str(),
+            "Read-only graph on a memory-mapped graph file, see writeGraphFile.\n\n"
+            "Processes which map the same file share it through the page cache."
+        );
+
+        mappedGraphCls
+            .def(py::init<const std::string &>(),
+                py::arg("path"),
+                py::call_guard<py::gil_scoped_release>()
+            )
+            .def_property_readonly("numberOfEdgeMaps", &GraphType::numberOfEdgeMaps)
+            .def("edgeMap",
+                [](py::object self, const uint64_t i) {
+                    const auto & g = self.cast<const GraphType &>();
+                    return mappedArray<double>(self, g.edgeMap(i), {py::ssize_t(g.numberOfEdges())});
+                }, py::arg("i"),
+                "Read-only view of the i-th edge map of the file, nothing is copied."
+            )
+            .def("uvIdsView",
+                [](py::object self) {
+                    const auto & g = self.cast<const GraphType &>();
+                    return mappedArray<int64_t>(self, g.file().uvIds(), {py::ssize_t(g.numberOfEdges()), 2});
+                },
+                "Read-only view of the uv-ids in the file, nothing is copied."
+            )
+        ;
+
+        exportUndirectedGraphClassAPI<GraphType>(graphModule, mappedGraphCls, clsName);
+
+        graphModule.def("writeGraphFile",
+            [](
+                const std::string & path,
+                const UndirectedGraph<> & graph,
+                const std::vector<xt::pytensor<double, 1> > & edgeMaps,
+                const bool withAdjacency
+            ){
+                py::gil_scoped_release allowThreads;
+                writeGraphFile(path, graph, edgeMaps, withAdjacency);
+            },
+            py::arg("path"),
+            py::arg("graph"),
+            py::arg("edgeMaps") = std::vector<xt::pytensor<double, 1> >(),
+            py::arg("withAdjacency") = true,
+            "Write a graph and edge maps to a binary graph file.\n\n"
+            "The file can be opened with MappedUndirectedGraph.\n\n"
+            "Args:\n"
+            "   path (str): path of the file\n"
+            "   graph (UndirectedGraph): the graph, region adjacency graphs are supported as well\n"
+            "   edgeMaps (list): float64 arrays with graph.numberOfEdges entries\n"
+            "   withAdjacency (bool): store the adjacency, otherwise it is rebuilt when mapping the file"
+        );
+    }
+
+} // namespace nifty::graph
+} // namespace nifty
@@ -32,6 +32,7 @@ namespace lifted_multicut{
             .def_readwrite("numberOfInnerIterations", &SettingsType::numberOfInnerIterations)
             .def_readwrite("numberOfOuterIterations", &SettingsType::numberOfOuterIterations)
             .def_readwrite("epsilon", &SettingsType::epsilon)
+            .def_readwrite("numberOfThreads", &SettingsType::numberOfThreads)
             //.def_readwrite("numberOfOuterIterations", &SettingsType::numberOfOuterIterations)
 
             //.def_readwrite("verbose", &SettingsType::verbose)
@@ -95,9 +95,14 @@ namespace lifted_multicut{
 
 
             .def("evalNodeLabels",[](const ObjectiveType & objective,
-                                     xt::pytensor<uint64_t, 1> & array){
-                return objective.evalNodeLabels(array);
-            })
+                                     const xt::pytensor<uint64_t, 1> & array,
+                                     const int numberOfThreads){
+                py::gil_scoped_release allowThreads;
+                return objective.evalNodeLabels(array, numberOfThreads);
+            },
+                py::arg("labels"),
+                py::arg("numberOfThreads") = 1
+            )
             .def_property_readonly("graph", &ObjectiveType::graph)
             .def_property_readonly("liftedGraph",
                     [](const ObjectiveType & self) -> const LiftedGraphType & {
@@ -50,15 +50,18 @@ namespace lifted_multicut{
             .def("evaluate",
             [](
                 const ObjType & self,
-                const xt::pytensor<int, DIM> & labels
+                const xt::pytensor<int, DIM> & labels,
+                const int numberOfThreads
             ){
                 double v=0.0;
                 {
-                    v =  self.evaluate(labels);
+                    py::gil_scoped_release allowThreads;
+                    v =  self.evaluate(labels, numberOfThreads);
                 }
                 return v;
             },
-                py::arg("labels")
+                py::arg("labels"),
+                py::arg("number_of_threads") = 1
             )
             .def("optimize",
             [](
@@ -99,17 +102,21 @@ namespace lifted_multicut{
             .def(py::init(
             [](
                 const ObjType & objective,
-                CCLmcFactoryBaseSharedPtr solver_factory
+                CCLmcFactoryBaseSharedPtr solver_factory,
+                const int numberOfThreads
             ) { 
                 CCFusionType * ret;
                 {
                     py::gil_scoped_release allowThreads;
-                    ret =  new CCFusionType(objective,solver_factory);
+                    typename CCFusionType::Settings settings;
+                    settings.numberOfThreads = numberOfThreads;
+                    ret =  new CCFusionType(objective,solver_factory,settings);
                 }
                 return ret;
             }),
                 py::arg("objective"),
                 py::arg("solver_factory"),
+                py::arg("number_of_threads") = 1,
                 py::keep_alive<1,2>()
             )
 
@@ -136,6 +143,21 @@ namespace lifted_multicut{
                 }
                 return res;
             })
+            .def("fuse_coarse_to_fine",[](
+                CCFusionType & self,
+                xt::pytensor<uint64_t,  DIM+1> labels,
+                const std::vector<int> & factors
+            ){
+                xt::xtensor<uint64_t, DIM> res;
+                {
+                    py::gil_scoped_release allowThreads;
+                    res =  self.fuseCoarseToFine(labels, factors);
+                }
+                return res;
+            },
+                py::arg("labels"),
+                py::arg("factors")
+            )
 
         ;
 
@@ -27,9 +27,14 @@ namespace mincut{
         mincutObjectiveCls
             .def_property_readonly("graph", &ObjectiveType::graph)
             .def("evalNodeLabels",[](const ObjectiveType & objective,
-                                     const xt::pytensor<uint64_t, 1> & array){
-                return objective.evalNodeLabels(array);
-            })
+                                     const xt::pytensor<uint64_t, 1> & array,
+                                     const int numberOfThreads){
+                py::gil_scoped_release allowThreads;
+                return objective.evalNodeLabels(array, numberOfThreads);
+            },
+                py::arg("labels"),
+                py::arg("numberOfThreads") = 1
+            )
         ;
 
 
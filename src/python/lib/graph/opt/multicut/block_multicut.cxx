@@ -0,0 +1,60 @@
+#include <pybind11/pybind11.h>
+
+
+
+// concrete solvers for concrete factories
+#include "nifty/graph/opt/multicut/block_multicut.hxx"
+
+
+
+#include "nifty/python/graph/undirected_list_graph.hxx"
+#include "nifty/python/graph/edge_contraction_graph.hxx"
+#include "nifty/python/graph/opt/multicut/multicut_objective.hxx"
+#include "nifty/python/converter.hxx"
+#include "nifty/python/graph/opt/multicut/export_multicut_solver.hxx"
+
+namespace py = pybind11;
+
+PYBIND11_DECLARE_HOLDER_TYPE(T, std::shared_ptr<T>);
+
+namespace nifty{
+namespace graph{
+namespace opt{
+namespace multicut{
+
+    template<class OBJECTIVE>
+    void exportBlockMulticutT(py::module & multicutModule){
+
+        typedef OBJECTIVE ObjectiveType;
+        typedef BlockMulticut<ObjectiveType> Solver;
+        typedef typename Solver::SettingsType SettingsType;
+        const auto solverName = std::string("BlockMulticut");
+        exportMulticutSolver<Solver>(multicutModule, solverName.c_str())
+            .def(py::init<>())
+            .def_readwrite("submodelFactory",       &SettingsType::submodelFactory)
+            .def_readwrite("reducedProblemFactory", &SettingsType::reducedProblemFactory)
+            .def_readwrite("blockSize",             &SettingsType::blockSize)
+            .def_readwrite("numberOfNodesStop",     &SettingsType::numberOfNodesStop)
+            .def_readwrite("minimumReduction",      &SettingsType::minimumReduction)
+            .def_readwrite("numberOfLevels",        &SettingsType::numberOfLevels)
+            .def_readwrite("numberOfThreads",       &SettingsType::numberOfThreads)
+        ;
+    }
+
+
+    void exportBlockMulticut(py::module & multicutModule){
+        {
+            typedef PyUndirectedGraph GraphType;
+            typedef MulticutObjective<GraphType, double> ObjectiveType;
+            exportBlockMulticutT<ObjectiveType>(multicutModule);
+        }
+        {
+            typedef PyContractionGraph<PyUndirectedGraph> GraphType;
+            typedef MulticutObjective<GraphType, double> ObjectiveType;
+            exportBlockMulticutT<ObjectiveType>(multicutModule);
+        }
+    }
+} // namespace nifty::graph::opt::multicut
+} // namespace nifty::graph::opt
+}
+}
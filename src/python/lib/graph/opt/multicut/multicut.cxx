@@ -28,6 +28,8 @@ namespace multicut{
     void exportFusionMoveBased(py::module &);
     void exportPerturbAndMap(py::module &);
     void exportMulticutDecomposer(py::module &);
+    void exportBlockMulticut(py::module &);
+    void exportMultilevelMulticut(py::module &);
     void exportChainedSolvers(py::module &);
     void exportMulticutCcFusionMoveBased(py::module &);
     void exportKernighanLin(py::module &);
@@ -59,6 +61,8 @@ PYBIND11_MODULE(_multicut, multicutModule) {
     exportFusionMoveBased(multicutModule);
     exportPerturbAndMap(multicutModule);
     exportMulticutDecomposer(multicutModule);
+    exportBlockMulticut(multicutModule);
+    exportMultilevelMulticut(multicutModule);
     exportChainedSolvers(multicutModule);
     exportMulticutCcFusionMoveBased(multicutModule);
     exportKernighanLin(multicutModule);
@@ -0,0 +1,61 @@
+#include <pybind11/pybind11.h>
+
+
+
+// concrete solvers for concrete factories
+#include "nifty/graph/opt/multicut/multilevel_multicut.hxx"
+
+
+
+#include "nifty/python/graph/undirected_list_graph.hxx"
+#include "nifty/python/graph/edge_contraction_graph.hxx"
+#include "nifty/python/graph/opt/multicut/multicut_objective.hxx"
+#include "nifty/python/converter.hxx"
+#include "nifty/python/graph/opt/multicut/export_multicut_solver.hxx"
+
+namespace py = pybind11;
+
+PYBIND11_DECLARE_HOLDER_TYPE(T, std::shared_ptr<T>);
+
+namespace nifty{
+namespace graph{
+namespace opt{
+namespace multicut{
+
+    template<class OBJECTIVE>
+    void exportMultilevelMulticutT(py::module & multicutModule){
+
+        typedef OBJECTIVE ObjectiveType;
+        typedef MultilevelMulticut<ObjectiveType> Solver;
+        typedef typename Solver::SettingsType SettingsType;
+        const auto solverName = std::string("MultilevelMulticut");
+        exportMulticutSolver<Solver>(multicutModule, solverName.c_str())
+            .def(py::init<>())
+            .def_readwrite("coarsestFactory",        &SettingsType::coarsestFactory)
+            .def_readwrite("refinementFactory",      &SettingsType::refinementFactory)
+            .def_readwrite("inputRefinementFactory", &SettingsType::inputRefinementFactory)
+            .def_readwrite("numberOfNodesStop",      &SettingsType::numberOfNodesStop)
+            .def_readwrite("minimumReduction",       &SettingsType::minimumReduction)
+            .def_readwrite("numberOfLevels",         &SettingsType::numberOfLevels)
+            .def_readwrite("numberOfCycles",         &SettingsType::numberOfCycles)
+            .def_readwrite("seed",                   &SettingsType::seed)
+        ;
+    }
+
+
+    void exportMultilevelMulticut(py::module & multicutModule){
+        {
+            typedef PyUndirectedGraph GraphType;
+            typedef MulticutObjective<GraphType, double> ObjectiveType;
+            exportMultilevelMulticutT<ObjectiveType>(multicutModule);
+        }
+        {
+            typedef PyContractionGraph<PyUndirectedGraph> GraphType;
+            typedef MulticutObjective<GraphType, double> ObjectiveType;
+            exportMultilevelMulticutT<ObjectiveType>(multicutModule);
+        }
+    }
+} // namespace nifty::graph::opt::multicut
+} // namespace nifty::graph::opt
+}
+}
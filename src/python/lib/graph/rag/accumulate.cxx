@@ -209,13 +209,15 @@ namespace graph{
             const nifty::hdf5::Hdf5Array<DATA_T> & data,
             array::StaticArray<int64_t, DIM> blockShape,
             const int numberOfThreads,
-            const bool saveMemory
+            const bool saveMemory,
+            const int numberOfIoThreads
         ){
             xt::pytensor<DATA_T, 2> edgeOut({int64_t(rag.edgeIdUpperBound()+1), int64_t(2)});
             xt::pytensor<DATA_T, 2> nodeOut({int64_t(rag.nodeIdUpperBound()+1), int64_t(2)});
             {
                 py::gil_scoped_release allowThreads;
-                accumulateMeanAndLength(rag, data, blockShape, edgeOut, nodeOut, numberOfThreads);
+                accumulateMeanAndLength(rag, data, blockShape, edgeOut, nodeOut, numberOfThreads,
+                                        false, numberOfIoThreads);
             }
             return std::make_pair(edgeOut, nodeOut);;
         },
@@ -223,7 +225,8 @@ namespace graph{
         py::arg("data").noconvert(),
         py::arg("blockShape") = array::StaticArray<int64_t,DIM>(100),
         py::arg("numberOfThreads")= -1,
-        py::arg_t<bool>("saveMemory",false)
+        py::arg_t<bool>("saveMemory",false),
+        py::arg("numberOfIoThreads") = 0
         );
     }
     #endif
@@ -273,13 +276,15 @@ namespace graph{
             const double minVal,
             const double maxVal,
             array::StaticArray<int64_t, DIM> blockShape,
-            const int numberOfThreads
+            const int numberOfThreads,
+            const int numberOfIoThreads
         ){
             xt::pytensor<DATA_T, 2> edgeOut({int64_t(rag.edgeIdUpperBound()+1), int64_t(9)});
             xt::pytensor<DATA_T, 2> nodeOut({int64_t(rag.nodeIdUpperBound()+1), int64_t(9)});
             {
                 py::gil_scoped_release allowThreads;
-                accumulateStandartFeatures(rag, data, minVal, maxVal, blockShape, edgeOut, nodeOut, numberOfThreads);
+                accumulateStandartFeatures(rag, data, minVal, maxVal, blockShape, edgeOut, nodeOut,
+                                           numberOfThreads, numberOfIoThreads);
             }
             return std::make_pair(edgeOut, nodeOut);
         },
@@ -288,7 +293,8 @@ namespace graph{
         py::arg("minVal"),
         py::arg("maxVal"),
         py::arg("blockShape") = array::StaticArray<int64_t,DIM>(100),
-        py::arg("numberOfThreads")= -1
+        py::arg("numberOfThreads")= -1,
+        py::arg("numberOfIoThreads") = 0
         );
     }
 
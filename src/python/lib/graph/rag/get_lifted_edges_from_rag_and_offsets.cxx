@@ -6,6 +6,7 @@
 #include <cstddef>
 #include "nifty/graph/rag/grid_rag.hxx"
 #include "nifty/graph/rag/get_lifted_edges_from_rag_and_offsets.hxx"
+#include "nifty/tools/runtime_check.hxx"
 
 
 
@@ -17,6 +18,27 @@ namespace nifty {
 
         using namespace py;
 
+        template<std::size_t DIM>
+        std::vector<array::StaticArray<int64_t, DIM>> toOffsetVector(const std::vector<std::vector<int>> & offsets){
+            std::vector<array::StaticArray<int64_t, DIM>> offsetVector(offsets.size());
+            for(auto i=0; i<offsetVector.size(); ++i){
+                NIFTY_CHECK_OP(offsets[i].size(), ==, DIM, "offsets have the wrong dimension");
+                for(auto d=0; d<DIM; ++d){
+                    offsetVector[i][d] = offsets[i][d];
+                }
+            }
+            return offsetVector;
+        }
+
+        inline xt::pytensor<uint64_t, 2> uvIdsToTensor(const std::vector<std::pair<uint64_t, uint64_t>> & uvIds){
+            xt::pytensor<uint64_t, 2> out({(int64_t) uvIds.size(), (int64_t) 2});
+            for(std::size_t i = 0; i < uvIds.size(); ++i){
+                out(i, 0) = uvIds[i].first;
+                out(i, 1) = uvIds[i].second;
+            }
+            return out;
+        }
+
         template<std::size_t DIM, class RAG>
         void exportComputeLiftedEdgesFromRagAndOffsets(
                 py::module & ragModule
@@ -25,56 +47,72 @@ namespace nifty {
                             [](
                                     const RAG & rag,
                                     const std::vector<std::vector<int>> & offsets,
-                                    // xt::pytensor<int64_t, 2> offsets,
                                     const int numberOfThreads
                             ){
-                                // Get the offset vector:
-                                typedef typename std::vector<array::StaticArray<int64_t, DIM>> OffsetVectorType;
-                                // OffsetVectorType offsetVector(offsets.shape()[0]);
-                                OffsetVectorType offsetVector(offsets.size());
-                                for(auto i=0; i<offsetVector.size(); ++i){
-                                    for(auto d=0; d<DIM; ++d){
-                                        offsetVector[i][d] = offsets[i][d];
-                                        // offsetVector[i][d] = offsets(i,d);
-                                    }
-                                }
-
-                                // Initialize vector that will contain the longRange uvIds:
-                                nifty::parallel::ParallelOptions pOpts(numberOfThreads);
-                                nifty::parallel::ThreadPool threadpool(pOpts);
-                                const std::size_t actualNumberOfThreads = pOpts.getActualNumThreads();
-                                std::vector<std::vector<std::pair<uint64_t,uint64_t>>> longRangePairs(actualNumberOfThreads);
-
-                                // Look for lifted edges:
+                                const auto offsetVector = toOffsetVector<DIM>(offsets);
+                                std::vector<std::pair<uint64_t, uint64_t>> uvIds;
                                 {
                                     py::gil_scoped_release allowThreads;
-                                    computeLiftedEdgesFromRagAndOffsets(rag, offsetVector, longRangePairs, numberOfThreads);
+                                    computeLiftedEdgesFromRagAndOffsets(rag, offsetVector, uvIds, numberOfThreads);
                                 }
+                                return uvIdsToTensor(uvIds);
+                            },
+                            py::arg("rag"),
+                            py::arg("offsets"),
+                            py::arg("numberOfThreads") = -1
+            );
 
-                                // Get the total number of found edges:
-                                int total_nb_edges = 0;
-                                std::vector<int> index_offset(actualNumberOfThreads);
-                                for (int i=0; i<actualNumberOfThreads; i++) {
-                                    index_offset[i] = total_nb_edges;
-                                    total_nb_edges += (int) longRangePairs[i].size();
+            // lifted edges with the number of links (and mean affinity) per edge
+            ragModule.def("computeLiftedEdgesWithStatisticsFromRagAndOffsets_impl",
+                            [](
+                                    const RAG & rag,
+                                    const std::vector<std::vector<int>> & offsets,
+                                    const int numberOfThreads
+                            ){
+                                const auto offsetVector = toOffsetVector<DIM>(offsets);
+                                std::vector<std::pair<uint64_t, uint64_t>> uvIds;
+                                std::vector<uint64_t> counts;
+                                std::vector<double> meanAffinities;
+                                {
+                                    py::gil_scoped_release allowThreads;
+                                    computeLiftedEdgesFromRagAndOffsets(rag, offsetVector,
+                                        static_cast<const xt::pytensor<float, DIM + 1> *>(nullptr),
+                                        uvIds, counts, meanAffinities, numberOfThreads);
                                 }
+                                xt::pytensor<uint64_t, 1> countsOut({(int64_t) counts.size()});
+                                std::copy(counts.begin(), counts.end(), countsOut.begin());
+                                return std::make_tuple(uvIdsToTensor(uvIds), countsOut);
+                            },
+                            py::arg("rag"),
+                            py::arg("offsets"),
+                            py::arg("numberOfThreads") = -1
+            );
 
-                                // Create output tensor:
-                                xt::pytensor<uint64_t, 2> out_tensor = xt::zeros<float>({(std::size_t) total_nb_edges, (std::size_t) 2});
-
-                                // Collect results in output tensor:
-                                for (int i=0; i<actualNumberOfThreads; i++) {
-                                    for (int j=0; j<longRangePairs[i].size(); j++) {
-                                        out_tensor(index_offset[i]+j,0) = longRangePairs[i][j].first;
-                                        out_tensor(index_offset[i]+j,1) = longRangePairs[i][j].second;
-                                    }
+            ragModule.def("computeLiftedEdgesWithStatisticsFromRagAndOffsets_impl",
+                            [](
+                                    const RAG & rag,
+                                    const std::vector<std::vector<int>> & offsets,
+                                    const xt::pytensor<float, DIM + 1> & affinities,
+                                    const int numberOfThreads
+                            ){
+                                const auto offsetVector = toOffsetVector<DIM>(offsets);
+                                std::vector<std::pair<uint64_t, uint64_t>> uvIds;
+                                std::vector<uint64_t> counts;
+                                std::vector<double> meanAffinities;
+                                {
+                                    py::gil_scoped_release allowThreads;
+                                    computeLiftedEdgesFromRagAndOffsets(rag, offsetVector, &affinities,
+                                        uvIds, counts, meanAffinities, numberOfThreads);
                                 }
-
-                                return out_tensor;
-
+                                xt::pytensor<uint64_t, 1> countsOut({(int64_t) counts.size()});
+                                std::copy(counts.begin(), counts.end(), countsOut.begin());
+                                xt::pytensor<double, 1> meanOut({(int64_t) meanAffinities.size()});
+                                std::copy(meanAffinities.begin(), meanAffinities.end(), meanOut.begin());
+                                return std::make_tuple(uvIdsToTensor(uvIds), countsOut, meanOut);
                             },
                             py::arg("rag"),
                             py::arg("offsets"),
+                            py::arg("affinities"),
                             py::arg("numberOfThreads") = -1
             );
         };
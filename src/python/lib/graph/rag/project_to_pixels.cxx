@@ -47,6 +47,32 @@ namespace graph{
     }
 
 
+    template<class LABELS, class T, std::size_t DATA_DIM>
+    void exportProjectEdgeDataToPixelsT(py::module & ragModule){
+
+        ragModule.def("projectEdgeDataToPixels",
+           [](
+                const GridRag<DATA_DIM, LABELS> & rag,
+                const xt::pytensor<T, 1> & edgeData,
+                const int numberOfThreads
+           ){
+                NIFTY_CHECK_OP(edgeData.size(), ==, rag.edgeIdUpperBound() + 1,
+                               "edgeData has wrong size");
+                typedef typename xt::pytensor<T, DATA_DIM>::shape_type ShapeType;
+                ShapeType shape;
+                std::copy(rag.shape().begin(), rag.shape().end(), shape.begin());
+                xt::pytensor<T, DATA_DIM> pixelData(shape);
+                {
+                    py::gil_scoped_release allowThreads;
+                    projectEdgeDataToPixels(rag, edgeData, pixelData, numberOfThreads);
+                }
+                return pixelData;
+           },
+           py::arg("graph"),py::arg("edgeData"),py::arg("numberOfThreads")=-1
+        );
+    }
+
+
     template<class LABELS, class T, class PIXEL_DATA, std::size_t DATA_DIM>
     void exportProjectScalarNodeDataToPixelsOutOfCoreT(py::module & ragModule){
 
@@ -56,17 +82,20 @@ namespace graph{
                 const xt::pytensor<T, 1> & nodeData,
                 PIXEL_DATA & pixelData,
                 nifty::array::StaticArray<int64_t, DATA_DIM> blockShape,
-                const int numberOfThreads
+                const int numberOfThreads,
+                const int numberOfIoThreads
            ){
                 py::gil_scoped_release allowThreads;
                 projectScalarNodeDataToPixelsOutOfCore(rag, nodeData, pixelData,
-                                                       blockShape, numberOfThreads);
+                                                       blockShape, numberOfThreads,
+                                                       numberOfIoThreads);
            },
            py::arg("graph"),
            py::arg("nodeData"),
            py::arg("pixelData"),
            py::arg("blockShape"),
-           py::arg("numberOfThreads")=-1
+           py::arg("numberOfThreads")=-1,
+           py::arg("numberOfIoThreads")=0
         );
     }
 
@@ -173,6 +202,18 @@ namespace graph{
             exportProjectScalarNodeDataToPixelsT<ExplicitPyLabels3D, double, 3>(ragModule);
         }
 
+        // exportEdgeDataToPixels
+        {
+            typedef xt::pytensor<uint32_t, 2> ExplicitPyLabels2D;
+            typedef xt::pytensor<uint32_t, 3> ExplicitPyLabels3D;
+
+            exportProjectEdgeDataToPixelsT<ExplicitPyLabels2D, float, 2>(ragModule);
+            exportProjectEdgeDataToPixelsT<ExplicitPyLabels3D, float, 3>(ragModule);
+
+            exportProjectEdgeDataToPixelsT<ExplicitPyLabels2D, double, 2>(ragModule);
+            exportProjectEdgeDataToPixelsT<ExplicitPyLabels3D, double, 3>(ragModule);
+        }
+
         // z5
         #ifdef WITH_Z5
         {
@@ -43,6 +43,8 @@ namespace hdf5{
                 py::arg("compression")=-1
             )
             .def_property_readonly("isChunked", &Hdf5ArrayType::isChunked)
+            .def_property_readonly("supportsDirectChunkRead", &Hdf5ArrayType::supportsDirectChunkRead)
+            .def_property("readMode", &Hdf5ArrayType::readMode, &Hdf5ArrayType::setReadMode)
             .def_property_readonly("ndim", &Hdf5ArrayType::dimension)
             .def_property_readonly("shape", [](const Hdf5ArrayType & array){
                 return array.shape();
@@ -90,6 +92,11 @@ namespace hdf5{
 
     void exportHdf5Array(py::module & hdf5Module) {
 
+        py::enum_<ReadMode>(hdf5Module, "ReadMode")
+            .value("HYPERSLAB_READ", HYPERSLAB_READ)
+            .value("DIRECT_CHUNK_READ", DIRECT_CHUNK_READ)
+            .export_values();
+
         exportHdf5ArrayT<uint8_t >(hdf5Module, "Hdf5ArrayUInt8");
         exportHdf5ArrayT<uint16_t>(hdf5Module, "Hdf5ArrayUInt16");
         exportHdf5ArrayT<uint32_t>(hdf5Module, "Hdf5ArrayUInt32");
@@ -22,12 +22,18 @@ namespace hdf5{
     void exportBenchmark(py::module & hdf5Module) {
 
 
+        // read all blocks with the given read mode,
+        // the array itself serializes the hdf5 calls
         hdf5Module.def("runBenchmark",
         [](
-            const nifty::hdf5::Hdf5Array<uint32_t> & data,
+            nifty::hdf5::Hdf5Array<uint32_t> & data,
             const nifty::tools::Blocking<3> & blocking,
-            const int numberOfThreads
+            const int numberOfThreads,
+            const ReadMode readMode
         ){
+            py::gil_scoped_release liftGil;
+            const auto oldReadMode = data.readMode();
+            data.setReadMode(readMode);
 
             std::mutex lock;
             uint64_t val = 0;
@@ -43,19 +49,24 @@ namespace hdf5{
                     typedef typename xt::xarray<uint32_t>::shape_type ShapeType;
                     const auto block = blocking.getBlock(blockIndex);
                     const ShapeType blockShape(block.shape().begin(), block.shape().end());
-                    lock.lock();
                     xt::xarray<uint32_t> subarray(blockShape);
                     data.readSubarray(block.begin().begin(), subarray);
 
                     const auto _val = subarray(0,0,0);
 
+                    lock.lock();
                     val += _val;
                     lock.unlock();
                 }
             );
+            data.setReadMode(oldReadMode);
             // to make sure the above code is not optimized away
             std::cout<<"val "<<val<<"\n";
-        }
+        },
+        py::arg("data"),
+        py::arg("blocking"),
+        py::arg("numberOfThreads"),
+        py::arg("readMode")=HYPERSLAB_READ
         );
 
     }
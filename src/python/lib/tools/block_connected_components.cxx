@@ -0,0 +1,107 @@
+#include <pybind11/pybind11.h>
+#include <pybind11/numpy.h>
+#include <pybind11/stl.h>
+
+#include "xtensor-python/pytensor.hpp"
+
+#ifdef WITH_HDF5
+#include "nifty/hdf5/hdf5_array.hxx"
+#endif
+
+#ifdef WITH_Z5
+#include "nifty/z5/z5.hxx"
+#endif
+
+#include "nifty/tools/block_connected_components.hxx"
+
+namespace py = pybind11;
+
+
+namespace nifty{
+namespace tools{
+
+    template<class T, std::size_t DIM>
+    void exportBlockConnectedComponentsT(py::module & toolsModule) {
+
+        toolsModule.def("blockConnectedComponents",
+        [](const xt::pytensor<T, DIM> & labels,
+           const std::array<int64_t, DIM> & blockShape,
+           const bool ignoreBackground,
+           const int numberOfThreads
+        ){
+            typedef typename xt::pytensor<uint64_t, DIM>::shape_type ShapeType;
+            ShapeType shape;
+            std::copy(labels.shape().begin(), labels.shape().end(), shape.begin());
+            xt::pytensor<uint64_t, DIM> out(shape);
+            std::vector<uint64_t> sizes;
+            {
+                py::gil_scoped_release allowThreads;
+                typename Blocking<DIM>::VectorType blockShape_;
+                std::copy(blockShape.begin(), blockShape.end(), blockShape_.begin());
+                blockConnectedComponents<DIM>(labels, out, blockShape_, ignoreBackground, sizes, numberOfThreads);
+            }
+            xt::pytensor<uint64_t, 1> sizesOut = xt::zeros<uint64_t>({sizes.size()});
+            std::copy(sizes.begin(), sizes.end(), sizesOut.begin());
+            return std::make_pair(out, sizesOut);
+        }, py::arg("labels"), py::arg("blockShape"), py::arg("ignoreBackground")=false, py::arg("numberOfThreads")=-1);
+    }
+
+
+    // out of core version, the blocks of dataOut must not share chunks
+    template<class DATA_IN, class DATA_OUT>
+    void exportBlockwiseConnectedComponentsT(py::module & toolsModule) {
+
+        toolsModule.def("blockConnectedComponents",
+        [](const DATA_IN & dataIn,
+           DATA_OUT & dataOut,
+           const std::array<int64_t, 3> & blockShape,
+           const bool ignoreBackground,
+           const int numberOfThreads
+        ){
+            std::vector<uint64_t> sizes;
+            {
+                py::gil_scoped_release allowThreads;
+                array::StaticArray<int64_t, 3> blockShape_;
+                std::copy(blockShape.begin(), blockShape.end(), blockShape_.begin());
+                blockConnectedComponents<3>(dataIn, dataOut, blockShape_, ignoreBackground, sizes, numberOfThreads);
+            }
+            return sizes;
+        }, py::arg("dataIn"), py::arg("dataOut"), py::arg("blockShape"),
+           py::arg("ignoreBackground")=false, py::arg("numberOfThreads")=-1);
+    }
+
+
+    void exportBlockConnectedComponents(py::module & toolsModule) {
+
+        exportBlockConnectedComponentsT<bool, 2>(toolsModule);
+        exportBlockConnectedComponentsT<bool, 3>(toolsModule);
+        exportBlockConnectedComponentsT<uint8_t, 2>(toolsModule);
+        exportBlockConnectedComponentsT<uint8_t, 3>(toolsModule);
+        exportBlockConnectedComponentsT<uint32_t, 2>(toolsModule);
+        exportBlockConnectedComponentsT<uint32_t, 3>(toolsModule);
+        exportBlockConnectedComponentsT<uint64_t, 2>(toolsModule);
+        exportBlockConnectedComponentsT<uint64_t, 3>(toolsModule);
+        exportBlockConnectedComponentsT<int64_t, 2>(toolsModule);
+        exportBlockConnectedComponentsT<int64_t, 3>(toolsModule);
+
+        #ifdef WITH_HDF5
+        {
+            typedef nifty::hdf5::Hdf5Array<uint64_t> Hdf5Out;
+            exportBlockwiseConnectedComponentsT<nifty::hdf5::Hdf5Array<uint8_t>, Hdf5Out>(toolsModule);
+            exportBlockwiseConnectedComponentsT<nifty::hdf5::Hdf5Array<uint32_t>, Hdf5Out>(toolsModule);
+            exportBlockwiseConnectedComponentsT<nifty::hdf5::Hdf5Array<uint64_t>, Hdf5Out>(toolsModule);
+        }
+        #endif
+
+        #ifdef WITH_Z5
+        {
+            typedef nifty::nz5::DatasetWrapper<uint64_t> Z5Out;
+            exportBlockwiseConnectedComponentsT<nifty::nz5::DatasetWrapper<uint8_t>, Z5Out>(toolsModule);
+            exportBlockwiseConnectedComponentsT<nifty::nz5::DatasetWrapper<uint32_t>, Z5Out>(toolsModule);
+            exportBlockwiseConnectedComponentsT<nifty::nz5::DatasetWrapper<uint64_t>, Z5Out>(toolsModule);
+        }
+        #endif
+    }
+
+}
+}
@@ -252,6 +252,54 @@ namespace tools{
                                             const VectorType & coordinates){
                 return self.coordinatesToBlockId(coordinates);
             }, py::arg("coordinates"))
+
+            .def("coordinatesToBlockIds", [](const BlockingType & self,
+                                             const xt::pytensor<int64_t, 2> & coordinates){
+                NIFTY_CHECK_OP(coordinates.shape()[1], ==, DIM, "coordinates need to be of shape (N, DIM)");
+                const std::size_t nCoordinates = coordinates.shape()[0];
+                xt::pytensor<uint64_t, 1> out = xt::zeros<uint64_t>({nCoordinates});
+                {
+                    py::gil_scoped_release allowThreads;
+                    VectorType coord;
+                    for(std::size_t i = 0; i < nCoordinates; ++i) {
+                        for(unsigned d = 0; d < DIM; ++d) {
+                            coord[d] = coordinates(i, d);
+                        }
+                        out(i) = self.coordinatesToBlockId(coord);
+                    }
+                }
+                return out;
+            }, py::arg("coordinates"))
+
+            .def("getBlockIdsOverlappingBoundingBoxes", [](const BlockingType & self,
+                                                           const xt::pytensor<int64_t, 2> & roiBegins,
+                                                           const xt::pytensor<int64_t, 2> & roiEnds) {
+                NIFTY_CHECK_OP(roiBegins.shape()[1], ==, DIM, "roiBegins need to be of shape (N, DIM)");
+                NIFTY_CHECK_OP(roiEnds.shape()[1], ==, DIM, "roiEnds need to be of shape (N, DIM)");
+                NIFTY_CHECK_OP(roiBegins.shape()[0], ==, roiEnds.shape()[0], "number of roi begins and ends do not match");
+                const std::size_t nRois = roiBegins.shape()[0];
+
+                std::vector<uint64_t> ids, offsets;
+                {
+                    py::gil_scoped_release allowThreads;
+                    std::vector<VectorType> begins(nRois), ends(nRois);
+                    for(std::size_t i = 0; i < nRois; ++i) {
+                        for(unsigned d = 0; d < DIM; ++d) {
+                            begins[i][d] = roiBegins(i, d);
+                            ends[i][d] = roiEnds(i, d);
+                        }
+                    }
+                    self.getBlockIdsOverlappingBoundingBoxes(begins, ends, ids, offsets);
+                }
+                xt::pytensor<uint64_t, 1> idsOut = xt::zeros<uint64_t>({ids.size()});
+                xt::pytensor<uint64_t, 1> offsetsOut = xt::zeros<uint64_t>({offsets.size()});
+                {
+                    py::gil_scoped_release allowThreads;
+                    std::copy(ids.begin(), ids.end(), idsOut.begin());
+                    std::copy(offsets.begin(), offsets.end(), offsetsOut.begin());
+                }
+                return std::make_pair(idsOut, offsetsOut);
+            }, py::arg("roiBegins"), py::arg("roiEnds"))
         ;
     }
 
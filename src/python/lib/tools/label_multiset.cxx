@@ -47,7 +47,8 @@ namespace tools{
             }
             return std::make_pair(ids_out, counts_out);
         }, py::arg("offsets"), py::arg("sizes"), py::arg("ids"), py::arg("counts"),
-           py::arg("argsort")=true);
+           py::arg("argsort")=true,
+           "argsort is deprecated and ignored, the output is always sorted by id");
 
 
         m.def("downsampleMultiset", [](const Blocking<NDIM> & blocking,
@@ -56,7 +57,8 @@ namespace tools{
                                        const OffsetVector & entry_offsets,
                                        const IdVector & ids,
                                        const CountVector & counts,
-                                       const int restrict_set){
+                                       const int restrict_set,
+                                       const int numberOfThreads){
             // argmax and offsets: we know the size already and can allocate the pyarrays
             const int64_t n_blocks = blocking.numberOfBlocks();
             IdVector new_argmax = xt::zeros<IdType>({n_blocks});
@@ -70,7 +72,8 @@ namespace tools{
                 downsampleMultiset(blocking,
                                    offsets, entry_sizes, entry_offsets,
                                    ids, counts, restrict_set,
-                                   new_argmax, new_offsets, new_ids, new_counts);
+                                   new_argmax, new_offsets, new_ids, new_counts,
+                                   numberOfThreads);
             }
 
             // TODO can we use xt::adapt here instead of copying values?
@@ -87,7 +90,8 @@ namespace tools{
             return std::make_tuple(new_argmax, new_offsets, ids_out, counts_out);
         }, py::arg("blocking"),
            py::arg("offsets"), py::arg("entry_sizes"), py::arg("entry_offsets"),
-           py::arg("ids"), py::arg("counts"), py::arg("restrict_set"));
+           py::arg("ids"), py::arg("counts"), py::arg("restrict_set"),
+           py::arg("numberOfThreads")=1);
 
 
         typedef MultisetMerger<OffsetType, IdType, CountType> Merger;
@@ -20,17 +20,50 @@ namespace tools{
     void exportMakeDenseT(py::module & toolsModule) {
 
         toolsModule.def("makeDense",
-        [](const xt::pyarray<T> & dataIn){
+        [](const xt::pyarray<T> & dataIn, const int numberOfThreads){
 
             typedef typename xt::pyarray<T>::shape_type ShapeType;
             ShapeType shape(dataIn.shape().begin(), dataIn.shape().end());
             xt::pyarray<T> dataOut(shape);
             {
                 py::gil_scoped_release allowThreads;
-                tools::makeDense(dataIn, dataOut);
+                tools::makeDense(dataIn, dataOut, numberOfThreads);
             }
             return dataOut;
-        });
+        }, py::arg("dataIn"), py::arg("numberOfThreads")=-1);
+    }
+
+
+    template<class DATA_BACKEND>
+    void exportBlockwiseMakeDenseT(py::module & toolsModule) {
+        typedef typename DATA_BACKEND::value_type DataType;
+
+        toolsModule.def("blockwiseUnique",
+        [](const DATA_BACKEND & data,
+           const std::array<int64_t, 3> & blockShape,
+           const int numberOfThreads
+        ){
+            std::vector<DataType> out;
+            {
+                py::gil_scoped_release allowThreads;
+                array::StaticArray<int64_t, 3> blockShape_;
+                std::copy(blockShape.begin(), blockShape.end(), blockShape_.begin());
+                blockwiseUnique(data, blockShape_, out, numberOfThreads);
+            }
+            return out;
+        }, py::arg("data"), py::arg("blockShape"), py::arg("numberOfThreads")=-1);
+
+        toolsModule.def("blockwiseMakeDense",
+        [](const DATA_BACKEND & dataIn,
+           DATA_BACKEND & dataOut,
+           const std::array<int64_t, 3> & blockShape,
+           const int numberOfThreads
+        ){
+            py::gil_scoped_release allowThreads;
+            array::StaticArray<int64_t, 3> blockShape_;
+            std::copy(blockShape.begin(), blockShape.end(), blockShape_.begin());
+            return blockwiseMakeDense(dataIn, dataOut, blockShape_, numberOfThreads);
+        }, py::arg("dataIn"), py::arg("dataOut"), py::arg("blockShape"), py::arg("numberOfThreads")=-1);
     }
 
 
@@ -42,6 +75,16 @@ namespace tools{
 
         //exportMakeDenseT<float   , false>(toolsModule);
         exportMakeDenseT<int64_t>(toolsModule);
+
+        // export out of core versions for z5
+        #ifdef WITH_Z5
+        {
+            typedef nifty::nz5::DatasetWrapper<uint32_t> Z5Array32;
+            typedef nifty::nz5::DatasetWrapper<uint64_t> Z5Array64;
+            exportBlockwiseMakeDenseT<Z5Array32>(toolsModule);
+            exportBlockwiseMakeDenseT<Z5Array64>(toolsModule);
+        }
+        #endif
     }
 
 }
@@ -18,12 +18,14 @@ namespace tools{
     void exportMapDictionaryToArrayT(py::module & toolsModule) {
 
         toolsModule.def("mapDictionaryToArray",
-        [](xt::pytensor<T, DIM> & data, std::map<T, T> dict, bool haveIgnoreValue, T ignoreValue){
+        [](xt::pytensor<T, DIM> & data, std::map<T, T> dict, bool haveIgnoreValue, T ignoreValue,
+           const int numberOfThreads){
 
             py::gil_scoped_release allowThreads;
-            mapDictionaryToArray<DIM>(data, dict, haveIgnoreValue, ignoreValue);
+            mapDictionaryToArray<DIM>(data, dict, haveIgnoreValue, ignoreValue, numberOfThreads);
 
-        }, py::arg("data"), py::arg("dict"), py::arg("haveIgnoreValue")=false, py::arg("ignoreValue")=0);
+        }, py::arg("data"), py::arg("dict"), py::arg("haveIgnoreValue")=false, py::arg("ignoreValue")=0,
+           py::arg("numberOfThreads")=-1);
 
     }
 
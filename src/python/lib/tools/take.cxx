@@ -1,4 +1,6 @@
 #include <pybind11/pybind11.h>
+#include <algorithm>
+#include <atomic>
 #include <iostream>
 #include <sstream>
 #include <pybind11/numpy.h>
@@ -8,6 +10,7 @@
 
 #include "nifty/tools/for_each_coordinate.hxx"
 #include "nifty/parallel/threadpool.hxx"
+#include "nifty/tools/sorted_key_lookup.hxx"
 
 
 namespace py = pybind11;
@@ -22,7 +25,8 @@ namespace tools{
 
         toolsModule.def("_take",
         [](const xt::pytensor<T, 1> & relabeling,
-           const xt::pytensor<T, 1> & toRelabel
+           const xt::pytensor<T, 1> & toRelabel,
+           const int numberOfThreads
         ){
             typedef typename xt::pytensor<T, 1>::shape_type ShapeType;
             ShapeType shape;
@@ -30,12 +34,13 @@ namespace tools{
             xt::pytensor<T, 1> out = xt::zeros<T>(shape);
             {
                 py::gil_scoped_release allowThreads;
-                for(std::size_t i = 0; i < shape[0]; ++i){
+                parallel::ThreadPool threadpool(numberOfThreads);
+                parallel::parallel_foreach(threadpool, shape[0], [&](const int tid, const int64_t i){
                     out(i) = relabeling(toRelabel(i));
-                }
+                });
             }
             return out;
-        }, py::arg("relabeling"), py::arg("toRelabel"));
+        }, py::arg("relabeling"), py::arg("toRelabel"), py::arg("numberOfThreads")=-1);
 
         // Multi-threaded version for multiple features:
         toolsModule.def("_mapFeaturesToLabelArray",
@@ -79,7 +84,8 @@ namespace tools{
 
         toolsModule.def("_takeDict",
         [](const std::unordered_map<T, T> & relabeling,
-           const xt::pytensor<T, 1> & toRelabel
+           const xt::pytensor<T, 1> & toRelabel,
+           const int numberOfThreads
         ){
             typedef typename xt::pytensor<T, 1>::shape_type ShapeType;
             ShapeType shape;
@@ -87,12 +93,33 @@ namespace tools{
             xt::pytensor<T, 1> out = xt::zeros<T>(shape);
             {
                 py::gil_scoped_release allowThreads;
-                for(std::size_t i = 0; i < shape[0]; ++i){
-                    out(i) = relabeling.at(toRelabel(i));
+                // flatten the dict to sorted keys / values for a lookup without hashing
+                std::vector<std::pair<T, T>> items(relabeling.begin(), relabeling.end());
+                std::sort(items.begin(), items.end());
+                std::vector<T> keys(items.size()), values(items.size());
+                for(std::size_t i = 0; i < items.size(); ++i){
+                    keys[i] = items[i].first;
+                    values[i] = items[i].second;
+                }
+                const SortedKeyLookup<T> lookup(keys);
+
+                parallel::ThreadPool threadpool(numberOfThreads);
+                std::atomic<bool> missingKey(false);
+                parallel::parallel_foreach(threadpool, shape[0], [&](const int tid, const int64_t i){
+                    const auto pos = lookup.find(toRelabel(i));
+                    if(pos == SortedKeyLookup<T>::NotFound){
+                        missingKey = true;
+                    }
+                    else{
+                        out(i) = values[pos];
+                    }
+                });
+                if(missingKey){
+                    throw std::out_of_range("takeDict: value is not contained in the relabeling");
                 }
             }
             return out;
-        }, py::arg("relabeling"), py::arg("toRelabel"));
+        }, py::arg("relabeling"), py::arg("toRelabel"), py::arg("numberOfThreads")=-1);
 
 
         toolsModule.def("inflateLabeling",
@@ -24,6 +24,7 @@ namespace tools{
     void exportMapDictionaryToArray(py::module &);
     void exportMergeHelper(py::module &);
     void exportLabelMultiset(py::module &);
+    void exportBlockConnectedComponents(py::module &);
 }
 }
 
@@ -49,4 +50,5 @@ PYBIND11_MODULE(_tools, toolsModule) {
     exportMapDictionaryToArray(toolsModule);
     exportMergeHelper(toolsModule);
     exportLabelMultiset(toolsModule);
+    exportBlockConnectedComponents(toolsModule);
 }
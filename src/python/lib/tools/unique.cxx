@@ -6,7 +6,10 @@
 #include <pybind11/stl.h>
 
 #include "nifty/python/converter.hxx"
+#include "xtensor-python/pyarray.hpp"
+
 #include "nifty/tools/array_tools.hxx"
+#include "nifty/tools/make_dense.hxx"
 
 namespace py = pybind11;
 
@@ -18,20 +21,41 @@ namespace tools{
         
         toolsModule.def("uniqueList",
         [](
-           const std::vector<T> & values
+           const std::vector<T> & values,
+           const int numberOfThreads
         ){
             std::vector<T> out; 
             {
                 py::gil_scoped_release allowThreads;
-                uniques(values, out);
+                parallel::ThreadPool threadpool(numberOfThreads);
+                parallelUniques(values.data(), values.size(), out, threadpool);
             }
             return out;
-        });
+        }, py::arg("values"), py::arg("numberOfThreads")=-1);
+
+        toolsModule.def("unique",
+        [](
+           const xt::pyarray<T> & values,
+           const int numberOfThreads
+        ){
+            std::vector<T> out;
+            {
+                py::gil_scoped_release allowThreads;
+                parallel::ThreadPool threadpool(numberOfThreads);
+                // the input might be strided
+                std::vector<T> flat(values.begin(), values.end());
+                parallelUniques(flat.data(), flat.size(), out, threadpool);
+            }
+            xt::pyarray<T> ret = xt::zeros<T>({out.size()});
+            std::copy(out.begin(), out.end(), ret.begin());
+            return ret;
+        }, py::arg("values"), py::arg("numberOfThreads")=-1);
     }
     
     void exportUnique(py::module & toolsModule) {
         exportUniqueListT<uint32_t>(toolsModule);
         exportUniqueListT<uint64_t>(toolsModule);
+        exportUniqueListT<int64_t>(toolsModule);
     }
 }
 }
@@ -217,23 +217,19 @@ def accumulate_affinities_mean_and_length(affinities, offsets, labels, graph=Non
     Parameters
     ----------
     affinities: offset channels expected to be the first one
-    """
-    affinities = np.require(affinities, dtype='float32')
-
-    if affinities_weights is not None:
-        assert offset_weights is None, "Affinities weights and offset weights cannot be passed at the same time"
-        affinities_weights = np.require(affinities_weights, dtype='float32')
 
-    else:
-        affinities_weights = np.ones_like(affinities)
-        if offset_weights is not None:
-            offset_weights = np.require(offset_weights, dtype='float32')
-            for _ in range(affinities_weights.ndim-1):
-                offset_weights = np.expand_dims(offset_weights, axis=-1)
-            affinities_weights *= offset_weights
+    The affinities (float32, float16 or uint8, the latter scaled to [0, 1]) and
+    the labels (uint32 or uint64) are passed to C++ without copies,
+    other dtypes are converted to float32 and uint64.
+    """
+    if affinities.dtype == np.float16:
+        # read as the raw float16 bits
+        affinities = affinities.view('uint16')
+    elif affinities.dtype != np.uint8:
+        affinities = np.require(affinities, dtype='float32')
 
-    affinities = np.rollaxis(affinities, axis=0, start=len(affinities.shape))
-    affinities_weights = np.rollaxis(affinities_weights, axis=0, start=len(affinities_weights.shape))
+    if labels.dtype not in (np.uint32, np.uint64):
+        labels = np.require(labels, dtype='uint64')
 
     offsets = np.require(offsets, dtype='int32')
     assert len(offsets.shape) == 2
@@ -241,23 +237,40 @@ def accumulate_affinities_mean_and_length(affinities, offsets, labels, graph=Non
     if graph is None:
         graph = nrag.gridRag(labels)
 
-
     hasIgnoreLabel = (ignore_label is not None)
     ignore_label = 0 if ignore_label is None else int(ignore_label)
 
     number_of_threads = -1 if number_of_threads is None else number_of_threads
 
-    edge_indicators_mean, edge_indicators_max, edge_sizes = \
-        accumulateAffinitiesMeanAndLength_impl_(
-            graph,
-            labels.astype('uint64'),
-            affinities,
-            affinities_weights,
-            offsets,
-            hasIgnoreLabel,
-            ignore_label,
-            number_of_threads
-        )
+    if affinities_weights is not None:
+        assert offset_weights is None, "Affinities weights and offset weights cannot be passed at the same time"
+        affinities_weights = np.require(affinities_weights, dtype='float32')
+        edge_indicators_mean, edge_indicators_max, edge_sizes = \
+            accumulateAffinitiesMeanAndLengthWithWeights_impl_(
+                graph,
+                labels,
+                affinities,
+                affinities_weights,
+                offsets,
+                hasIgnoreLabel,
+                ignore_label,
+                number_of_threads
+            )
+    else:
+        # an empty array means unweighted
+        offset_weights = np.zeros(0, dtype='float32') if offset_weights is None else \
+            np.require(offset_weights, dtype='float32')
+        edge_indicators_mean, edge_indicators_max, edge_sizes = \
+            accumulateAffinitiesMeanAndLength_impl_(
+                graph,
+                labels,
+                affinities,
+                offsets,
+                offset_weights,
+                hasIgnoreLabel,
+                ignore_label,
+                number_of_threads
+            )
     return edge_indicators_mean, edge_sizes
 
 
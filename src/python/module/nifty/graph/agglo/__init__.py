@@ -50,7 +50,8 @@ def get_GASP_policy(graph,
                     size_regularizer = 0.0,
                     number_of_nodes_to_stop = 1,
                     merge_constrained_edges_at_the_end=False,
-                    collect_stats_for_exported_data=False
+                    collect_stats_for_exported_data=False,
+                    number_of_threads=1
                     ):
     linkage_criteria_kwargs = {} if linkage_criteria_kwargs is None else linkage_criteria_kwargs
     parsed_rule = updateRule(linkage_criteria, **linkage_criteria_kwargs)
@@ -69,7 +70,8 @@ def get_GASP_policy(graph,
                              sizeRegularizer=size_regularizer,
                              addNonLinkConstraints=add_cannot_link_constraints,
                              mergeConstrainedEdgesAtTheEnd=merge_constrained_edges_at_the_end,
-                             collectStats=collect_stats_for_exported_data)
+                             collectStats=collect_stats_for_exported_data,
+                             numberOfThreads=number_of_threads)
 
 
 get_GASP_policy.__doc__ = """
@@ -5,6 +5,7 @@ from functools import partial
 from ..multicut import ilpSettings
 from .. import Configuration
 import numpy
+import sys
 
 __all__ = []
 for key in __lifted_multicut.__dict__.keys():
@@ -46,8 +47,8 @@ class PixelWiseLmcObjective(object):
 
 
 
-    def evaluate(self, labels):
-        return self._obj.evaluate(labels)
+    def evaluate(self, labels, number_of_threads=1):
+        return self._obj.evaluate(labels, number_of_threads=number_of_threads)
 
     def cpp_obj(self):
         return self._obj
@@ -224,12 +225,28 @@ def __extendLiftedMulticutObj(objectiveCls, objectiveName):
 
 
     def liftedMulticutKernighanLinFactory(numberOfOuterIterations=1000000,
-                                          numberOfInnerIterations=100,
-                                          epsilon=1e-7):
+                                          numberOfInnerIterations=sys.maxsize,
+                                          epsilon=1e-7,
+                                          numberOfThreads=1):
+        """factory function for a lifted multicut kernighan lin solver
+
+        Args:
+            numberOfOuterIterations (int, optional): Maximum number of outer iterations (default 1000000)
+            numberOfInnerIterations (int, optional): Maximum number of moves of a single two cut,
+                a two cut is stopped early if this is smaller than the number of
+                nodes of its two partitions (default sys.maxsize, unbounded)
+            epsilon (float, optional): Minimum energy decrease of an iteration (default 1e-7)
+            numberOfThreads (int, optional): Pairs of partitions that are not linked by
+                lifted edges are optimized in parallel (default 1)
+
+        Returns:
+            TYPE: Description
+        """
         s,F = getSettingsAndFactoryCls("LiftedMulticutKernighanLin")
         s.numberOfOuterIterations = int(numberOfOuterIterations)
         s.numberOfInnerIterations = int(numberOfInnerIterations)
         s.epsilon = float(epsilon)
+        s.numberOfThreads = int(numberOfThreads)
         return F(s)
     O.liftedMulticutKernighanLinFactory = staticmethod(liftedMulticutKernighanLinFactory)
 
@@ -338,6 +338,108 @@ def __extendMulticutObj(objectiveCls, objectiveName, graphCls):
         %s : multicut factory
     """ % (factoryClsName("MulticutDecomposer"), factoryClsName("MulticutDecomposer"))
 
+    def blockMulticutFactory(submodelFactory=None, reducedProblemFactory=None,
+                             blockSize=1000, numberOfNodesStop=None,
+                             minimumReduction=0.01, numberOfLevels=100,
+                             numberOfThreads=-1):
+
+        if submodelFactory is None:
+            submodelFactory = MulticutObjectiveUndirectedGraph.greedyAdditiveFactory()
+
+        if reducedProblemFactory is None:
+            reducedProblemFactory = submodelFactory
+
+        s, F = getSettingsAndFactoryCls("BlockMulticut")
+        s.submodelFactory = submodelFactory
+        s.reducedProblemFactory = reducedProblemFactory
+        s.blockSize = int(blockSize)
+        s.numberOfNodesStop = int(blockSize if numberOfNodesStop is None else numberOfNodesStop)
+        s.minimumReduction = float(minimumReduction)
+        s.numberOfLevels = int(numberOfLevels)
+        s.numberOfThreads = int(numberOfThreads)
+        return F(s)
+
+    O.blockMulticutFactory = staticmethod(blockMulticutFactory)
+    O.blockMulticutFactory.__doc__ = """ create an instance of :class:`%s`
+
+        Hierarchical block-wise multicut:
+        the graph is partitioned into connected blocks of nodes,
+        the sub-multicuts of the blocks are solved in parallel
+        and the graph is contracted with their solutions.
+        This is repeated on the reduced graph until it is small enough
+        (or does not shrink anymore) and the reduced graph is solved as a whole.
+
+    Args:
+        submodelFactory: multicut factory for the blocks
+            (default: {:func:`greedyAdditiveFactory()`})
+        reducedProblemFactory: multicut factory for the final reduced problem
+            (default: {submodelFactory})
+        blockSize (int): maximum number of nodes in a block (default: {1000})
+        numberOfNodesStop (int): solve the reduced problem as a whole once it
+            has at most this many nodes (default: {blockSize})
+        minimumReduction (float): stop the hierarchy if a level removes less than
+            this fraction of the nodes (default: {0.01})
+        numberOfLevels (int): maximum number of levels (default: {100})
+        numberOfThreads (int): number of threads, -1 uses all cores (default: {-1})
+
+    Returns:
+        %s : multicut factory
+    """ % (factoryClsName("BlockMulticut"), factoryClsName("BlockMulticut"))
+
+    def multilevelMulticutFactory(coarsestFactory=None, refinementFactory=None,
+                                  inputRefinementFactory=None, numberOfNodesStop=1000,
+                                  minimumReduction=0.05, numberOfLevels=100,
+                                  numberOfCycles=1, seed=42):
+
+        if coarsestFactory is None:
+            coarsestFactory = MulticutObjectiveUndirectedGraph.greedyAdditiveFactory()
+
+        if refinementFactory is None:
+            refinementFactory = MulticutObjectiveUndirectedGraph.kernighanLinFactory()
+
+        if inputRefinementFactory is None:
+            inputRefinementFactory = O.kernighanLinFactory()
+
+        s, F = getSettingsAndFactoryCls("MultilevelMulticut")
+        s.coarsestFactory = coarsestFactory
+        s.refinementFactory = refinementFactory
+        s.inputRefinementFactory = inputRefinementFactory
+        s.numberOfNodesStop = int(numberOfNodesStop)
+        s.minimumReduction = float(minimumReduction)
+        s.numberOfLevels = int(numberOfLevels)
+        s.numberOfCycles = int(numberOfCycles)
+        s.seed = int(seed)
+        return F(s)
+
+    O.multilevelMulticutFactory = staticmethod(multilevelMulticutFactory)
+    O.multilevelMulticutFactory.__doc__ = """ create an instance of :class:`%s`
+
+        Multilevel multicut with V-cycles:
+        the graph is coarsened with a heavy edge matching on the attractive edges,
+        the coarsest level is solved and the solution is projected back down,
+        where every level is refined, warm-started from the projection.
+        Further cycles coarsen within the clusters of the current solution
+        and stop as soon as a cycle does not improve the energy.
+
+    Args:
+        coarsestFactory: multicut factory for the coarsest level
+            (default: {:func:`greedyAdditiveFactory()`})
+        refinementFactory: multicut factory for the refinement of the coarse levels
+            (default: {:func:`kernighanLinFactory()`})
+        inputRefinementFactory: multicut factory for the refinement of the input graph
+            (default: {:func:`kernighanLinFactory()`})
+        numberOfNodesStop (int): stop coarsening once a level has
+            at most this many nodes (default: {1000})
+        minimumReduction (float): stop coarsening if a level removes less than
+            this fraction of the nodes (default: {0.05})
+        numberOfLevels (int): maximum number of levels (default: {100})
+        numberOfCycles (int): maximum number of V-cycles (default: {1})
+        seed (int): seed for the matching order (default: {42})
+
+    Returns:
+        %s : multicut factory
+    """ % (factoryClsName("MultilevelMulticut"), factoryClsName("MultilevelMulticut"))
+
     def multicutIlpFactory(addThreeCyclesConstraints=True,
                            addOnlyViolatedThreeCyclesConstraints=True,
                            ilpSolverSettings=None,
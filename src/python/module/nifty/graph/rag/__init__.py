@@ -284,11 +284,33 @@ if WITH_H5PY:
                        serialization=serialization.squeeze())
 
 
-def compute_lifted_edges_from_rag_and_offsets(rag, offsets, numberOfThreads=-1):
+def compute_lifted_edges_from_rag_and_offsets(rag, offsets, numberOfThreads=-1,
+                                              affinities=None, return_counts=False):
+    """ Lifted edges between the non-adjacent regions of a rag that
+    are connected by one of the offsets.
+
+    Args:
+        rag: the region adjacency graph
+        offsets: list of offsets
+        numberOfThreads (int): number of threads (default: {-1})
+        affinities (numpy.ndarray): channel first affinities, one channel per offset.
+            If given, the mean affinity of every lifted edge is returned (default: {None})
+        return_counts (bool): return the number of offset links of every lifted edge (default: {False})
+
+    Returns:
+        numpy.ndarray: the unique lifted edges, sorted and with u < v
+        numpy.ndarray: number of offset links per lifted edge (only if return_counts)
+        numpy.ndarray: mean affinity per lifted edge (only if affinities are given)
+    """
     if isinstance(offsets, numpy.ndarray):
         offsets = offsets.tolist()
     else:
         assert isinstance(offsets, (list, tuple))
-        assert isinstance(offsets, (list, tuple))
+    if affinities is not None:
+        uvIds, counts, meanAffinities = computeLiftedEdgesWithStatisticsFromRagAndOffsets_impl(
+            rag, offsets, affinities.astype('float32', copy=False), numberOfThreads)
+        return (uvIds, counts, meanAffinities) if return_counts else (uvIds, meanAffinities)
+    if return_counts:
+        return computeLiftedEdgesWithStatisticsFromRagAndOffsets_impl(rag, offsets, numberOfThreads)
     return computeLiftedEdgesFromRagAndOffsets_impl(rag, offsets, numberOfThreads)
 
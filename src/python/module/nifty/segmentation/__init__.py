@@ -1,6 +1,7 @@
 from __future__ import absolute_import,print_function
 from .. import graph
 from .. import filters
+from .. import tools
 
 from skimage.feature import peak_local_max as __peak_local_max
 import skimage.segmentation
@@ -198,31 +199,47 @@ def localMaxima(image):
 
     return  __peak_local_max(image, exclude_border=False, indices=False)
 
-def connectedComponents(labels, dense=True, ignoreBackground=False):
+def connectedComponents(labels, dense=True, ignoreBackground=False,
+                        numberOfThreads=-1, blockShape=None, returnSizes=False):
     """get connected components of a label image
 
     Get connected components of an image w.r.t.
-    a 4-neighborhood .
-    This is a high level wrapper for
-        :func:`nifty.graph.connectedComponentsFromNodeLabels`
+    a 4-neighborhood (6-neighborhood in 3D).
+    Blocks of the image are labeled in parallel and merged
+    across the block faces, see
+        :func:`nifty.tools.blockConnectedComponents`
 
     Args:
-        labels (numpy.ndarray):
-        dense (bool): should the return labeling be dense (default: {True})
-        ignoreBackground (bool): should values of zero be excluded (default: {False})
+        labels (numpy.ndarray): 2D or 3D label or binary image
+        dense (bool): the labeling is always dense, kept for compatibility (default: {True})
+        ignoreBackground (bool): should values of zero be excluded,
+            they get label 0 and the components start at 1 (default: {False})
+        numberOfThreads (int): number of threads (default: {-1})
+        blockShape (tuple): shape of the blocks labeled in parallel (default: {None})
+        returnSizes (bool): also return the number of pixels per label (default: {False})
 
     Returns:
-        [description]
-        [type]
+        numpy.ndarray: connected component labels
+        numpy.ndarray: number of pixels per label, if returnSizes is True
     """
-    shape = labels.shape
-    gridGraph = graph.gridGraph(shape)
-
-    ccLabels = graph.connectedComponentsFromNodeLabels(gridGraph,
-            labels.ravel(), dense=dense,
-            ignoreBackground=bool(ignoreBackground))
-
-    return ccLabels.reshape(shape)
+    labels = numpy.asarray(labels)
+    if labels.ndim not in (2, 3):
+        raise RuntimeError("connectedComponents is only implemented for 2D and 3D images")
+    # bool, uint8, uint32, uint64 and int64 labels are supported without a copy
+    if labels.dtype.kind in 'ui' and labels.dtype.itemsize == 1:
+        labels = numpy.require(labels, dtype='uint8')
+    elif labels.dtype not in (numpy.bool_, numpy.uint32, numpy.uint64, numpy.int64):
+        labels = numpy.require(labels, dtype='int64')
+
+    if blockShape is None:
+        blockShape = (256, 256) if labels.ndim == 2 else (64, 64, 64)
+
+    ccLabels, sizes = tools.blockConnectedComponents(labels, blockShape=list(blockShape),
+                                                     ignoreBackground=bool(ignoreBackground),
+                                                     numberOfThreads=numberOfThreads)
+    if returnSizes:
+        return ccLabels, sizes
+    return ccLabels
 
 def localMinimaSeeds(image):
     """Get seed from local minima
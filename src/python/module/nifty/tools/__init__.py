@@ -56,10 +56,10 @@ def rand_choice(probs, choose_from=None):
 
 
 
-def take(relabeling, toRelabel):
+def take(relabeling, toRelabel, numberOfThreads=-1):
     shape = toRelabel.shape
     toRelabelFlat = toRelabel.ravel()
-    return _tools._take(relabeling, toRelabelFlat).reshape(shape)
+    return _tools._take(relabeling, toRelabelFlat, numberOfThreads).reshape(shape)
 
 
 def mapFeaturesToLabelArray(label_array, feature_array,
@@ -74,10 +74,10 @@ def mapFeaturesToLabelArray(label_array, feature_array,
     return _tools._mapFeaturesToLabelArray(label_array_flat.astype(numpy.int64), feature_array.astype(numpy.float32), ignore_label, fill_value, nb_threads).reshape(shape + feature_array.shape[1:])
 
 
-def takeDict(relabeling, toRelabel):
+def takeDict(relabeling, toRelabel, numberOfThreads=-1):
     shape = toRelabel.shape
     toRelabelFlat = toRelabel.ravel()
-    return _tools._takeDict(relabeling, toRelabelFlat).reshape(shape)
+    return _tools._takeDict(relabeling, toRelabelFlat, numberOfThreads).reshape(shape)
 
 
 
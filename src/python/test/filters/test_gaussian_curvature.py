@@ -0,0 +1,71 @@
+import unittest
+
+import numpy as np
+import nifty.filters as nf
+
+
+class TestGaussianCurvature(unittest.TestCase):
+
+    # the derivative kernels are not normalized, so the curvature is scaled
+    # by a constant gain; at the vertex of the parabola (t, t^2 / 2)
+    # the convolution is exact and the curvature is 1
+    def gain(self, op, ndim):
+        n = 8 * op.radius + 1
+        t = np.arange(n, dtype='float32') - n // 2
+        coords = np.zeros((n, ndim), dtype='float32')
+        coords[:, 0] = t
+        coords[:, 1] = 0.5 * t ** 2
+        return op(coords, False)[n // 2]
+
+    def check_threads(self, op, coords, loop):
+        # curves with more than one block of points are processed in parallel
+        out = op(coords, loop)
+        for n_threads in (1, 4):
+            out_threads = op(coords, loop, numberOfThreads=n_threads)
+            self.assertTrue(np.array_equal(out, out_threads))
+        return out
+
+    def test_circle_2d(self):
+        for sigma in (1., 2.):
+            op = nf.GaussianCurvature2D(sigma)
+            gain = self.gain(op, 2)
+            margin = 2 * op.radius
+            r = 50. * sigma
+            n = int(2 * np.pi * r)
+            t = 2 * np.pi * np.arange(n) / n
+            circle = np.stack([r * np.cos(t), r * np.sin(t)], axis=1).astype('float32')
+            # closed circle and open (three quarter) arc, the ends are not checked
+            for coords, loop in ((circle, True), (circle[:3 * n // 4], False)):
+                out = self.check_threads(op, coords, loop)
+                self.assertEqual(out.shape, (len(coords),))
+                self.assertTrue(np.allclose(out[margin:-margin] / gain * r, 1., atol=.01))
+
+    def test_helix_3d(self):
+        for sigma in (1., 2.):
+            op = nf.GaussianCurvature3D(sigma)
+            gain = self.gain(op, 3)
+            margin = 2 * op.radius
+            a, b = 50. * sigma, 12.5 * sigma
+            expected = a / (a ** 2 + b ** 2)
+            dt = 1. / np.sqrt(a ** 2 + b ** 2)
+            t = dt * np.arange(int(6 * np.pi / dt))
+            coords = np.stack([a * np.cos(t), a * np.sin(t), b * t], axis=1).astype('float32')
+            out = self.check_threads(op, coords, False)
+            self.assertTrue(np.allclose(out[margin:-margin] / gain / expected, 1., atol=.01))
+
+    def test_threads(self):
+        # random curves with several blocks of points
+        for op, ndim in ((nf.GaussianCurvature2D(1.5), 2), (nf.GaussianCurvature3D(1.5), 3)):
+            coords = np.cumsum(np.random.rand(10000, ndim) - .5, axis=0).astype('float32')
+            out = self.check_threads(op, coords, False)
+            self.assertEqual(out.shape, (len(coords),))
+            self.assertTrue(np.all(np.isfinite(out)))
+
+    def test_wrong_dimension(self):
+        coords = np.random.rand(100, 3).astype('float32')
+        with self.assertRaises(RuntimeError):
+            nf.GaussianCurvature2D(1.)(coords, False)
+
+
+if __name__ == '__main__':
+    unittest.main()
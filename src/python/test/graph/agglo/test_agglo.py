@@ -28,6 +28,62 @@ class TestAgglo(unittest.TestCase):
         # TODO actually test something
         seg = agglomerativeClustering.result()
 
+    def testMergeTree(self):
+        g = nifty.graph.UndirectedGraph(4)
+        edges = numpy.array([[0, 1], [1, 2], [2, 3]], dtype='uint64')
+        g.insertEdges(edges)
+
+        edgeIndicators = numpy.array([0.1, 0.3, 0.2])
+        edgeSizes = numpy.ones(g.numberOfEdges)
+        nodeSizes = numpy.ones(g.numberOfNodes)
+
+        clusterPolicy = nagglo.edgeWeightedClusterPolicy(
+            graph=g, edgeIndicators=edgeIndicators,
+            edgeSizes=edgeSizes, nodeSizes=nodeSizes)
+        agglomerativeClustering = nagglo.agglomerativeClustering(clusterPolicy)
+        visitor = agglomerativeClustering.dendrogramVisitor()
+        agglomerativeClustering.run(visitor)
+
+        tree = visitor.mergeTree()
+        self.assertEqual(tree.numberOfLeaves, 4)
+        self.assertEqual(tree.numberOfMerges, 3)
+
+        labels = tree.cuts(numpy.array([0.15, 0.25]), numberOfThreads=2)
+        self.assertEqual(labels.tolist(), [[0, 0, 1, 2], [0, 0, 1, 1]])
+        self.assertEqual(tree.cut(0.15).tolist(), [0, 0, 1, 2])
+
+        ucm = tree.edgeUcm(g)
+        self.assertTrue(numpy.allclose(ucm, edgeIndicators))
+
+        # the heights are stored in double precision, the first merge
+        # (of two single nodes) has exactly the height of its edge
+        nodes, heights, sizes = visitor.dendrogramEncoding()
+        self.assertEqual(heights[0], 0.1)
+        self.assertEqual(tree.heights().tolist(), heights.tolist())
+
+    def testParallelInitialization(self):
+        numberOfNodes = 500
+        g = nifty.graph.UndirectedGraph(numberOfNodes)
+        chain = numpy.array([[u, u + 1] for u in range(numberOfNodes - 1)], dtype='uint64')
+        g.insertEdges(chain)
+        uvs = numpy.random.randint(0, numberOfNodes, size=(2000, 2)).astype('uint64')
+        g.insertEdges(uvs[uvs[:, 0] != uvs[:, 1]])
+
+        edgeIndicators = numpy.random.rand(g.numberOfEdges)
+        edgeSizes = numpy.ones(g.numberOfEdges)
+        nodeSizes = numpy.ones(g.numberOfNodes)
+
+        results = []
+        for numberOfThreads in (1, 4):
+            clusterPolicy = nagglo.edgeWeightedClusterPolicy(
+                graph=g, edgeIndicators=edgeIndicators,
+                edgeSizes=edgeSizes, nodeSizes=nodeSizes,
+                numberOfNodesStop=20, numberOfThreads=numberOfThreads)
+            agglomerativeClustering = nagglo.agglomerativeClustering(clusterPolicy)
+            agglomerativeClustering.run()
+            results.append(agglomerativeClustering.result())
+        self.assertTrue(numpy.array_equal(results[0], results[1]))
+
 
 if __name__ == '__main__':
     unittest.main()
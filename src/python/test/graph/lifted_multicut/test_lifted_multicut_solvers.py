@@ -158,6 +158,35 @@ class TestLiftedMulticutSolver(unittest.TestCase):
 
                 self.assertAlmostEqual(ekl, eakl)
 
+    def testLiftedMulticutKernighanLinParallel(self):
+        random.seed(0)
+        gridSize = [30, 30]
+        obj, nid = self.gridLiftedModel(gridSize=gridSize, bfsRadius=3, weightRange=[-1, 1])
+
+        solver = obj.liftedMulticutGreedyAdditiveFactory().create(obj)
+        argGC = solver.optimize()
+        egc = obj.evalNodeLabels(argGC)
+
+        # start from 3x3 blocks as well, so the two cuts move many nodes
+        blocks = numpy.zeros(gridSize[0] * gridSize[1], dtype='uint64')
+        for x in range(gridSize[0]):
+            for y in range(gridSize[1]):
+                blocks[nid(x, y)] = (x // 3) * gridSize[1] + y // 3
+
+        for start in (argGC, blocks):
+            estart = obj.evalNodeLabels(start)
+            results = []
+            for numberOfThreads in (1, 2, 4):
+                solverFactory = obj.liftedMulticutKernighanLinFactory(numberOfThreads=numberOfThreads)
+                solver = solverFactory.create(obj)
+                arg = solver.optimize(start.copy())
+                self.assertLessEqual(obj.evalNodeLabels(arg), estart + 1e-7)
+                results.append(arg)
+
+            # the rounds do not depend on the number of threads,
+            # so any number of threads > 1 gives the same result
+            self.assertTrue(numpy.array_equal(results[1], results[2]))
+
     def testLiftedMulticutSolverFm(self):
         random.seed(0)
         for x in range(1):
@@ -176,6 +205,51 @@ class TestLiftedMulticutSolver(unittest.TestCase):
             visitor = obj.verboseVisitor(100)
             argN = solver.optimize(visitor)
 
+    def testLiftedMulticutSolverFmParallel(self):
+        random.seed(0)
+        obj, nid = self.gridLiftedModel(gridSize=[40,40] , bfsRadius=4, weightRange=[-1,1])
+        pgen = obj.watershedProposalGenerator(sigma=1.0,
+                                              seedingStrategy='SEED_FROM_LOCAL',
+                                              numberOfSeeds=0.1)
+        energies = []
+        for x in range(2):
+            solverFactory = obj.fusionMoveBasedFactory(proposalGenerator=pgen,
+                                                       numberOfThreads=3,
+                                                       numberOfIterations=20,
+                                                       stopIfNoImprovement=5)
+            solver = solverFactory.create(obj)
+            arg = solver.optimize()
+            energies.append(obj.evalNodeLabels(arg))
+            self.assertLess(energies[-1], 0.)
+        # the proposals do not depend on the scheduling of the threads
+        self.assertAlmostEqual(energies[0], energies[1])
+
+    def testPixelWiseLmcFusionCoarseToFine(self):
+        lmc = nifty.graph.lifted_multicut
+        shape = (30, 40)
+        offsets = numpy.array([[0, 1], [1, 0], [0, -4], [-3, 2], [5, 5]], dtype='int32')
+        numpy.random.seed(0)
+        weights = (numpy.random.rand(*(shape + (len(offsets),))) - 0.4).astype('float32')
+        obj = lmc.pixelWiseLmcObjective(weights, offsets)
+
+        # block-wise constant proposals
+        x, y = numpy.indices(shape)
+        proposals = numpy.stack([(x // s) * 1000 + y // (s + 1) for s in (3, 4, 5)], axis=-1)
+        proposals = proposals.astype('uint64')
+        bestProposal = min(obj.evaluate(proposals[..., i]) for i in range(3))
+
+        # the lifted multicut problem of the components is defined on an undirected graph
+        ccObj = lmc.liftedMulticutObjective(nifty.graph.UndirectedGraph(1))
+        factory = ccObj.liftedMulticutGreedyAdditiveFactory()
+        fusion = lmc.PixelWiseLmcConnetedComponentsFusion2D(obj.cpp_obj(), factory,
+                                                            number_of_threads=2)
+        res = fusion.fuse(proposals)
+        resCoarseToFine = fusion.fuse_coarse_to_fine(proposals, factors=[4, 2, 1])
+        self.assertLessEqual(obj.evaluate(res), bestProposal)
+        self.assertLessEqual(obj.evaluate(resCoarseToFine), bestProposal)
+        self.assertAlmostEqual(obj.evaluate(resCoarseToFine, number_of_threads=3),
+                               obj.evaluate(resCoarseToFine), places=3)
+
     def implTestLiftedMulticutIlpBfsGrid(self, ilpSolver,
                                          gridSize=[4,4], bfsRadius=4,
                                          weightRange=[-2,1], verbose=0,
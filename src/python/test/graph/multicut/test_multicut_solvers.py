@@ -70,6 +70,19 @@ class TestLiftedMulticutSolver(unittest.TestCase):
         solver = factory.create(objective)
         arg = solver.optimize()
 
+    def testEvalNodeLabelsParallel(self):
+        # enough edges for several blocks
+        g, _ = self.generateGrid([300, 300])
+        w = numpy.random.rand(g.numberOfEdges) - 0.5
+        objective = nifty.graph.multicut.multicutObjective(g, w)
+        labels = numpy.random.randint(0, 10, size=g.numberOfNodes).astype('uint64')
+        uv = g.uvIds()
+        expected = w[labels[uv[:, 0]] != labels[uv[:, 1]]].sum()
+        e = objective.evalNodeLabels(labels)
+        self.assertAlmostEqual(e, expected, places=6)
+        for nThreads in (2, 4):
+            self.assertEqual(objective.evalNodeLabels(labels, numberOfThreads=nThreads), e)
+
     @unittest.skipUnless(nifty.Configuration.WITH_QPBO, "need qpbo")
     def testCgc(self):
         objective = self.gridModel(gridSize=[6,6])
@@ -89,6 +102,44 @@ class TestLiftedMulticutSolver(unittest.TestCase):
         Obj = nifty.graph.UndirectedGraph.MulticutObjective
         self._testGridModelImpl(Obj.multicutDecomposerFactory(), gridSize=[6,6])
 
+    def testBlockMulticut(self):
+        Obj = nifty.graph.UndirectedGraph.MulticutObjective
+        self._testGridModelImpl(Obj.blockMulticutFactory(blockSize=8), gridSize=[10,10])
+
+        # the block solutions are contracted, so the result can not be worse
+        # than the clustering of the first level blocks
+        objective = self.gridModel(gridSize=[20,20])
+        arg = Obj.blockMulticutFactory(blockSize=16).create(objective).optimize()
+        # a reduced problem solver that does not merge anything
+        # returns the clustering of the first level blocks
+        keepClusters = Obj.greedyAdditiveFactory(weightStopCond=float('inf'))
+        firstLevel = Obj.blockMulticutFactory(blockSize=16, numberOfLevels=1,
+                                              reducedProblemFactory=keepClusters).create(objective).optimize()
+        singletons = numpy.arange(objective.graph.numberOfNodes, dtype='uint64')
+        self.assertLess(objective.evalNodeLabels(firstLevel), objective.evalNodeLabels(singletons))
+        self.assertLessEqual(objective.evalNodeLabels(arg), objective.evalNodeLabels(firstLevel) + 1e-7)
+
+    def testBlockAndMultilevelMulticutContractionGraph(self):
+        g, _ = self.generateGrid([10, 10])
+        w = numpy.random.rand(g.numberOfEdges) - 0.6
+        contractionGraph = nifty.graph.edgeContractionGraph(g, nifty.graph.EdgeContractionGraphCallback())
+        objective = nifty.graph.multicut.multicutObjective(contractionGraph, w)
+        singletons = numpy.arange(g.numberOfNodes, dtype='uint64')
+        for factory in (objective.blockMulticutFactory(blockSize=8),
+                        objective.multilevelMulticutFactory(numberOfNodesStop=10)):
+            arg = factory.create(objective).optimize()
+            self.assertLessEqual(objective.evalNodeLabels(arg), objective.evalNodeLabels(singletons))
+
+    def testMultilevelMulticut(self):
+        Obj = nifty.graph.UndirectedGraph.MulticutObjective
+        self._testGridModelImpl(Obj.multilevelMulticutFactory(numberOfNodesStop=10), gridSize=[10,10])
+
+        # further cycles can only improve the first one
+        objective = self.gridModel(gridSize=[30,30])
+        arg1 = Obj.multilevelMulticutFactory(numberOfNodesStop=20).create(objective).optimize()
+        arg3 = Obj.multilevelMulticutFactory(numberOfNodesStop=20, numberOfCycles=3).create(objective).optimize()
+        self.assertLessEqual(objective.evalNodeLabels(arg3), objective.evalNodeLabels(arg1))
+
     def testChainedSolvers(self):
         Obj = nifty.graph.UndirectedGraph.MulticutObjective
         a = Obj.greedyAdditiveFactory()
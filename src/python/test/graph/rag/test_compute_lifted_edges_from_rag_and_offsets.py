@@ -29,6 +29,39 @@ class TestAccumulate(unittest.TestCase):
             self.assertTrue(2 in lifted_e or 0 in lifted_e)
 
 
+    def test_lifted_edges_statistics_2d(self):
+        offsets = [[3, 0], [0, 4], [-2, 5]]
+        # vertical stripes of width 2, so only neighbouring stripes are rag-adjacent
+        # and the offsets with a horizontal component reach non-adjacent stripes
+        labels = np.repeat(np.arange(16, dtype='uint32')[None, :], 2, axis=1)
+        labels = np.repeat(labels, 32, axis=0)
+        affinities = np.random.random(size=(len(offsets),) + labels.shape).astype('float32')
+        rag = nrag.gridRag(labels, numberOfLabels=16)
+        uv_ids, counts, mean_affinities = nrag.compute_lifted_edges_from_rag_and_offsets(rag, offsets,
+                                                                                         affinities=affinities,
+                                                                                         return_counts=True)
+
+        # brute force
+        expected = {}
+        for io, offset in enumerate(offsets):
+            for x in range(labels.shape[0]):
+                for y in range(labels.shape[1]):
+                    xx, yy = x + offset[0], y + offset[1]
+                    if not (0 <= xx < labels.shape[0] and 0 <= yy < labels.shape[1]):
+                        continue
+                    u, v = labels[x, y], labels[xx, yy]
+                    if u == v or rag.findEdge(int(u), int(v)) != -1:
+                        continue
+                    key = (min(u, v), max(u, v))
+                    count, aff_sum = expected.get(key, (0, 0.))
+                    expected[key] = (count + 1, aff_sum + affinities[io, x, y])
+
+        keys = sorted(expected.keys())
+        self.assertGreater(len(uv_ids), 0)
+        self.assertEqual(uv_ids.tolist(), [list(key) for key in keys])
+        self.assertEqual(counts.tolist(), [expected[key][0] for key in keys])
+        expected_means = [expected[key][1] / expected[key][0] for key in keys]
+        self.assertTrue(np.allclose(mean_affinities, expected_means))
 
     def test_accumulate_mean_and_length_3d(self):
         labels = np.random.randint(0, 100, size=self.shape_3d, dtype='uint32')
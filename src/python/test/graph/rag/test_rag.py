@@ -98,6 +98,26 @@ class TestRag(TestRagBase):
                               shouldEdges=shouldEdges,
                               shouldNotEdges=shouldNotEdges)
 
+    def test_project_edge_data_to_pixels(self):
+        labels = numpy.array([[0, 1, 2],
+                              [0, 0, 2],
+                              [3, 3, 2],
+                              [4, 4, 4]], dtype='uint32')
+        rag = nifty.graph.rag.gridRag(labels, int(labels.max() + 1))
+        edgeData = numpy.arange(1, rag.numberOfEdges + 1, dtype='float64')
+        pixelData = nifty.graph.rag.projectEdgeDataToPixels(rag, edgeData, numberOfThreads=2)
+
+        # every pixel gets the maximum value of the edges to its direct neighbours
+        expected = numpy.zeros(labels.shape)
+        for x in range(labels.shape[0]):
+            for y in range(labels.shape[1]):
+                for xx, yy in ((x - 1, y), (x + 1, y), (x, y - 1), (x, y + 1)):
+                    if 0 <= xx < labels.shape[0] and 0 <= yy < labels.shape[1]:
+                        u, v = int(labels[x, y]), int(labels[xx, yy])
+                        if u != v:
+                            expected[x, y] = max(expected[x, y], edgeData[rag.findEdge(u, v)])
+        self.assertTrue(numpy.array_equal(pixelData, expected))
+
     # This will fail because the expliecit labels python bindings are broken
     def test_explicit_labels_rag3d(self):
         labels = [[[0, 1],
@@ -21,6 +21,48 @@ class TestAffinityAccumulation(unittest.TestCase):
         mean, count = accumulate_affinities_mean_and_length(random_affinities, offsets, random_labels,
                                                                  offset_weights=[2, 4, 1, 5])
 
+    def test_accumulate_affinity_mean_and_length_dtypes(self):
+        import nifty.graph.rag as nrag
+        offsets = [[-1, 0, 0], [0, -1, 0], [0, 0, -1], [-2, 0, -1]]
+        offset_weights = np.array([2, 4, 1, 5], dtype='float32')
+
+        affinities = np.random.randint(256, size=(len(offsets),) + self.IMAGE_SHAPE).astype('uint8')
+        labels = np.random.randint(25, size=self.IMAGE_SHAPE).astype('uint32')
+        graph = nrag.gridRag(labels)
+
+        # brute force reference
+        float_affinities = affinities.astype('float32') / 255.
+        acc = np.zeros(graph.numberOfEdges)
+        count = np.zeros(graph.numberOfEdges)
+        for io, offset in enumerate(offsets):
+            for p in np.ndindex(*self.IMAGE_SHAPE):
+                q = tuple(pp + oo for pp, oo in zip(p, offset))
+                if min(q) < 0 or any(qq >= s for qq, s in zip(q, self.IMAGE_SHAPE)):
+                    continue
+                u, v = labels[p], labels[q]
+                edge = graph.findEdge(int(u), int(v)) if u != v else -1
+                if edge >= 0:
+                    acc[edge] += offset_weights[io] * float_affinities[(io,) + p]
+                    count[edge] += offset_weights[io]
+        expected_mean = np.divide(acc, count, out=np.zeros_like(acc), where=count > 0)
+
+        # uint8, float16, float32 and strided (non contiguous) affinities
+        for affs in (affinities, float_affinities.astype('float16'), float_affinities,
+                     np.moveaxis(np.moveaxis(float_affinities, 0, -1).copy(), -1, 0)):
+            mean, size = accumulate_affinities_mean_and_length(affs, offsets, labels, graph=graph,
+                                                               offset_weights=offset_weights,
+                                                               number_of_threads=2)
+            tolerance = 1e-3 if affs.dtype == np.float16 else 1e-5
+            self.assertTrue(np.allclose(size, count))
+            self.assertTrue(np.allclose(mean, expected_mean, atol=tolerance))
+
+        # per affinity weights that are equal to the offset weights
+        affinities_weights = np.ones_like(float_affinities) * offset_weights[:, None, None, None]
+        mean, size = accumulate_affinities_mean_and_length(affinities, offsets, labels, graph=graph,
+                                                           affinities_weights=affinities_weights)
+        self.assertTrue(np.allclose(size, count))
+        self.assertTrue(np.allclose(mean, expected_mean, atol=1e-5))
+
     def test_accumulate_affinity_mean_and_length_inside_cluster(self):
         offsets = [
             # Direct 3D neighborhood:
@@ -0,0 +1,59 @@
+import os
+import shutil
+import tempfile
+import unittest
+
+import numpy as np
+import nifty.graph
+
+
+class TestMappedUndirectedGraph(unittest.TestCase):
+
+    def setUp(self):
+        self.tmp_dir = tempfile.mkdtemp()
+
+    def tearDown(self):
+        shutil.rmtree(self.tmp_dir)
+
+    def random_graph(self, number_of_nodes=200, number_of_edges=1000):
+        np.random.seed(42)
+        uv_ids = np.random.randint(0, number_of_nodes, size=(number_of_edges, 2)).astype('uint64')
+        uv_ids = uv_ids[uv_ids[:, 0] != uv_ids[:, 1]]
+        graph = nifty.graph.UndirectedGraph(number_of_nodes)
+        graph.insertEdges(uv_ids)
+        return graph
+
+    def check_mapped(self, graph, weights, with_adjacency):
+        path = os.path.join(self.tmp_dir, 'graph.bin')
+        nifty.graph.writeGraphFile(path, graph, [weights], withAdjacency=with_adjacency)
+        mapped = nifty.graph.MappedUndirectedGraph(path)
+
+        self.assertEqual(mapped.numberOfNodes, graph.numberOfNodes)
+        self.assertEqual(mapped.numberOfEdges, graph.numberOfEdges)
+        self.assertEqual(mapped.numberOfEdgeMaps, 1)
+        self.assertTrue(np.array_equal(mapped.uvIds(), graph.uvIds()))
+        self.assertTrue(np.array_equal(mapped.uvIdsView(), graph.uvIds()))
+        self.assertTrue(np.array_equal(mapped.edgeMap(0), weights))
+        self.assertFalse(mapped.edgeMap(0).flags.writeable)
+
+        for node in range(graph.numberOfNodes):
+            self.assertEqual(list(mapped.nodeAdjacency(node)), list(graph.nodeAdjacency(node)))
+        uv_ids = np.random.randint(0, graph.numberOfNodes, size=(500, 2)).astype('uint64')
+        self.assertTrue(np.array_equal(mapped.findEdges(uv_ids), graph.findEdges(uv_ids)))
+
+    def test_mapped_graph(self):
+        graph = self.random_graph()
+        weights = np.random.rand(graph.numberOfEdges)
+        self.check_mapped(graph, weights, with_adjacency=True)
+        self.check_mapped(graph, weights, with_adjacency=False)
+
+    def test_invalid_file(self):
+        path = os.path.join(self.tmp_dir, 'invalid.bin')
+        with open(path, 'wb') as f:
+            f.write(b'\0' * 256)
+        with self.assertRaises(RuntimeError):
+            nifty.graph.MappedUndirectedGraph(path)
+
+
+if __name__ == '__main__':
+    unittest.main()
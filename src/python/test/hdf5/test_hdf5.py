@@ -145,6 +145,29 @@ class TestHDF5(unittest.TestCase):
 
         self.assertTrue(numpy.array_equal(toWrite, subarray))
 
+    @unittest.skipUnless(WITH_HDF5 and WITH_H5PY,
+                         "Need nifty-hdf5 and h5py")
+    def test_direct_chunk_read(self):
+        import nifty.hdf5 as nhdf5
+        fpath = os.path.join(self.tempFolder, '_nifty_test_array_.h5')
+
+        shape = (101, 102, 103)
+        chunks = (10, 20, 30)
+        data = numpy.random.randint(0, 1000, size=shape).astype('uint32')
+        with h5py.File(fpath, 'a') as f:
+            f.create_dataset("data", shape, dtype='uint32', data=data, chunks=chunks,
+                             compression='gzip', shuffle=True)
+
+        hidT = nhdf5.openFile(fpath)
+        array = nhdf5.Hdf5ArrayUInt32(hidT, "data")
+        self.assertEqual(array.readMode, nhdf5.ReadMode.HYPERSLAB_READ)
+        if not array.supportsDirectChunkRead:
+            self.skipTest("direct chunk read is not supported for this dataset")
+
+        array.readMode = nhdf5.ReadMode.DIRECT_CHUNK_READ
+        for bb in (numpy.s_[0:101, 0:102, 0:103], numpy.s_[5:95, 17:83, 29:102], numpy.s_[3:4, 21:22, 30:31]):
+            self.assertTrue(numpy.array_equal(array[bb], data[bb]))
+
 
 if __name__ == '__main__':
     unittest.main()
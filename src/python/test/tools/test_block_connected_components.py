@@ -0,0 +1,44 @@
+import unittest
+
+import numpy as np
+import nifty.tools as nt
+
+
+class TestBlockConnectedComponents(unittest.TestCase):
+
+    def check_same_partition(self, labels, expected, mask=None):
+        if mask is not None:
+            labels, expected = labels[mask], expected[mask]
+        pairs = np.unique(np.stack([labels.ravel(), expected.ravel()], axis=1), axis=0)
+        self.assertEqual(len(pairs), len(np.unique(labels)))
+        self.assertEqual(len(pairs), len(np.unique(expected)))
+
+    def test_binary(self):
+        from scipy.ndimage import label
+        mask = np.random.rand(40, 50, 30) > 0.6
+        expected, n_expected = label(mask)
+        for block_shape in ([8, 8, 8], [40, 50, 30], [5, 16, 3]):
+            for n_threads in (1, 4):
+                cc, sizes = nt.blockConnectedComponents(mask, blockShape=block_shape,
+                                                        ignoreBackground=True,
+                                                        numberOfThreads=n_threads)
+                self.assertEqual(cc.max(), n_expected)
+                self.assertTrue(np.array_equal(cc == 0, ~mask))
+                self.check_same_partition(cc, expected, mask)
+                self.assertTrue(np.array_equal(sizes, np.bincount(cc.ravel())))
+
+    def test_labels(self):
+        labels = np.random.randint(0, 3, size=(64, 48)).astype('uint32')
+        cc1, sizes1 = nt.blockConnectedComponents(labels, blockShape=[64, 48], numberOfThreads=1)
+        cc4, sizes4 = nt.blockConnectedComponents(labels, blockShape=[7, 9], numberOfThreads=4)
+        # the labeling does not depend on the blocking
+        self.check_same_partition(cc1, cc4)
+        self.assertEqual(cc1.max() + 1, len(sizes1))
+        self.assertTrue(np.array_equal(np.sort(sizes1), np.sort(sizes4)))
+        # every component has a single label value
+        pairs = np.unique(np.stack([cc4.ravel(), labels.ravel()], axis=1), axis=0)
+        self.assertEqual(len(pairs), cc4.max() + 1)
+
+
+if __name__ == '__main__':
+    unittest.main()
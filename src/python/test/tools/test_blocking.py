@@ -1,4 +1,5 @@
 import unittest
+import numpy
 import nifty.tools as nt
 
 
@@ -140,6 +141,49 @@ class TestBlocking(unittest.TestCase):
         self.assertEqual(neighbors[3][0], 1)
         self.assertEqual(neighbors[3][1], 2)
 
+    def testBlockIdsInBoundingBox(self):
+        blocking = nt.blocking(roiBegin=[0, 0, 0],
+                               roiEnd=[40, 35, 17],
+                               blockShape=[5, 5, 5])
+
+        def brute_force(begin, end, enclosed):
+            ids = []
+            for block_id in range(blocking.numberOfBlocks):
+                block = blocking.getBlock(block_id)
+                if enclosed:
+                    inside = all(b >= rb and e <= re for b, e, rb, re in
+                                 zip(block.begin, block.end, begin, end))
+                else:
+                    inside = all(b < re and e > rb for b, e, rb, re in
+                                 zip(block.begin, block.end, begin, end))
+                if inside:
+                    ids.append(block_id)
+            return ids
+
+        begin, end = [3, 10, 0], [27, 22, 17]
+        ids = blocking.getBlockIdsInBoundingBox(begin, end)
+        self.assertEqual(ids.tolist(), brute_force(begin, end, True))
+        ids = blocking.getBlockIdsOverlappingBoundingBox(begin, end)
+        self.assertEqual(ids.tolist(), brute_force(begin, end, False))
+
+    def testBatchQueries(self):
+        blocking = nt.blocking(roiBegin=[0, 0, 0],
+                               roiEnd=[40, 35, 17],
+                               blockShape=[5, 5, 5])
+
+        coordinates = numpy.array([[0, 0, 0], [39, 34, 16], [12, 7, 5]], dtype='int64')
+        ids = blocking.coordinatesToBlockIds(coordinates)
+        expected = [blocking.coordinatesToBlockId(list(coord)) for coord in coordinates]
+        self.assertEqual(ids.tolist(), expected)
+
+        begins = numpy.array([[3, 10, 0], [0, 0, 0]], dtype='int64')
+        ends = numpy.array([[27, 22, 17], [5, 5, 5]], dtype='int64')
+        ids, offsets = blocking.getBlockIdsOverlappingBoundingBoxes(begins, ends)
+        self.assertEqual(len(offsets), 3)
+        for i in range(2):
+            expected = blocking.getBlockIdsOverlappingBoundingBox(list(begins[i]), list(ends[i]))
+            self.assertEqual(ids[offsets[i]:offsets[i + 1]].tolist(), expected.tolist())
+
 
 if __name__ == '__main__':
     unittest.main()
@@ -78,5 +78,38 @@ class TestEdgeMapping(unittest.TestCase):
         self.assertTrue(np.allclose(new_values, new_values_exp))
 
 
+    def test_edge_mapping_random(self):
+        np.random.seed(42)
+        n_nodes, n_edges = 200, 1500
+        uv_ids = np.random.randint(0, n_nodes, size=(n_edges, 2)).astype('int64')
+        uv_ids = uv_ids[uv_ids[:, 0] != uv_ids[:, 1]]
+        uv_ids = np.unique(np.sort(uv_ids, axis=1), axis=0)
+        node_labeling = np.random.randint(0, 40, size=n_nodes).astype('uint64')
+
+        # reference: ordered new uv-ids and the mapping of the old edges
+        new_uvs = node_labeling[uv_ids]
+        new_uvs = np.sort(new_uvs, axis=1)
+        not_contracted = new_uvs[:, 0] != new_uvs[:, 1]
+        new_uv_ids_exp = np.unique(new_uvs[not_contracted], axis=0)
+        uv_to_id = {tuple(uv): ii for ii, uv in enumerate(new_uv_ids_exp)}
+        edge_mapping_exp = np.array([uv_to_id[tuple(uv)] if valid else -1
+                                     for uv, valid in zip(new_uvs, not_contracted)],
+                                    dtype='int64')
+        edge_values = np.random.rand(len(uv_ids)).astype('float32')
+        new_values_exp = np.zeros(len(new_uv_ids_exp), dtype='float32')
+        np.add.at(new_values_exp, edge_mapping_exp[not_contracted],
+                  edge_values[not_contracted])
+
+        # the result must not depend on the number of threads
+        for n_threads in (1, 2, 4):
+            edge_mapping = nt.EdgeMapping(uv_ids, node_labeling,
+                                          numberOfThreads=n_threads)
+            self.assertEqual(edge_mapping.newUvIds().shape, new_uv_ids_exp.shape)
+            self.assertTrue((edge_mapping.newUvIds() == new_uv_ids_exp).all())
+            self.assertTrue((edge_mapping.edgeMapping() == edge_mapping_exp).all())
+            new_values = edge_mapping.mapEdgeValues(edge_values, "sum")
+            self.assertTrue(np.allclose(new_values, new_values_exp, atol=1e-5))
+
+
 if __name__ == '__main__':
     unittest.main()
@@ -0,0 +1,43 @@
+import unittest
+
+import numpy as np
+import nifty.tools as nt
+
+
+class TestMakeDense(unittest.TestCase):
+
+    def make_labels(self, dtype='uint64'):
+        # sparse labels with runs, as in a segmentation
+        labels = np.random.randint(0, 1000, size=(32, 64, 64)).astype(dtype) * 1337
+        labels[:, :32] = labels[:, :1]
+        return labels
+
+    def test_unique(self):
+        labels = self.make_labels()
+        expected = np.unique(labels)
+        for n_threads in (1, 4):
+            uniques = nt.unique(labels, numberOfThreads=n_threads)
+            self.assertTrue(np.array_equal(uniques, expected))
+            uniques = nt.uniqueList(labels.ravel().tolist(), numberOfThreads=n_threads)
+            self.assertTrue(np.array_equal(uniques, expected))
+
+    def test_make_dense(self):
+        for dtype in ('uint32', 'uint64', 'int64'):
+            labels = self.make_labels(dtype)
+            _, expected = np.unique(labels, return_inverse=True)
+            expected = expected.reshape(labels.shape)
+            for n_threads in (1, 4):
+                dense = nt.makeDense(labels, numberOfThreads=n_threads)
+                self.assertTrue(np.array_equal(dense, expected))
+
+    def test_take_dict(self):
+        labels = self.make_labels()
+        uniques = np.unique(labels)
+        relabeling = {int(u): int(i) for i, u in enumerate(uniques)}
+        for n_threads in (1, 4):
+            dense = nt.takeDict(relabeling, labels, numberOfThreads=n_threads)
+            self.assertTrue(np.array_equal(dense, nt.makeDense(labels)))
+
+
+if __name__ == '__main__':
+    unittest.main()
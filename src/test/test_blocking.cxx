@@ -1,3 +1,6 @@
+#include <random>
+#include <vector>
+
 #include "nifty/tools/blocking.hxx"
 
 
@@ -23,6 +26,73 @@ void blockingTest()
 
 }
 
+
+// compare the arithmetic bounding box queries against checking every block
+void blockIdsInBoundingBoxTest()
+{
+    typedef nifty::tools::Blocking<3> Blocking;
+    typedef typename Blocking::VectorType VectorType;
+
+    std::mt19937 rng(42);
+    auto randInt = [&](const int64_t lo, const int64_t hi){
+        return std::uniform_int_distribution<int64_t>(lo, hi)(rng);
+    };
+
+    for(int trial = 0; trial < 50; ++trial){
+        VectorType roiBegin, roiEnd, blockShape, blockShift;
+        for(int d = 0; d < 3; ++d){
+            roiBegin[d] = randInt(0, 5);
+            roiEnd[d] = roiBegin[d] + randInt(1, 40);
+            blockShape[d] = randInt(1, 9);
+            blockShift[d] = randInt(0, blockShape[d] - 1);
+        }
+        Blocking blocking(roiBegin, roiEnd, blockShape, blockShift);
+
+        for(int query = 0; query < 20; ++query){
+            VectorType qBegin, qEnd;
+            for(int d = 0; d < 3; ++d){
+                qBegin[d] = randInt(roiBegin[d] - 3, roiEnd[d]);
+                qEnd[d] = qBegin[d] + randInt(0, 20);
+            }
+
+            std::vector<uint64_t> enclosed, overlapping;
+            for(uint64_t blockId = 0; blockId < blocking.numberOfBlocks(); ++blockId){
+                const auto block = blocking.getBlock(blockId);
+                bool isEnclosed = true, isOverlapping = true;
+                for(int d = 0; d < 3; ++d){
+                    const auto end = std::max(qEnd[d], qBegin[d] + 1);
+                    isEnclosed = isEnclosed && block.begin()[d] >= qBegin[d] && block.end()[d] <= qEnd[d];
+                    isOverlapping = isOverlapping && block.begin()[d] < end && block.end()[d] > qBegin[d];
+                }
+                if(isEnclosed){
+                    enclosed.push_back(blockId);
+                }
+                if(isOverlapping){
+                    overlapping.push_back(blockId);
+                }
+            }
+
+            std::vector<uint64_t> ids;
+            blocking.getBlockIdsInBoundingBox(qBegin, qEnd, ids);
+            NIFTY_TEST(ids == enclosed);
+            NIFTY_TEST_OP(blocking.blockIdsInBoundingBox(qBegin, qEnd).size(), ==, enclosed.size());
+
+            blocking.getBlockIdsOverlappingBoundingBox(qBegin, qEnd, ids);
+            NIFTY_TEST(ids == overlapping);
+
+            // the block containing a coordinate overlaps the coordinate
+            if(qBegin.allInsideShape(roiEnd) && qBegin[0] >= roiBegin[0] &&
+               qBegin[1] >= roiBegin[1] && qBegin[2] >= roiBegin[2]){
+                VectorType qEndSingle = qBegin + VectorType(1);
+                blocking.getBlockIdsOverlappingBoundingBox(qBegin, qEndSingle, ids);
+                NIFTY_TEST_OP(ids.size(), ==, 1);
+                NIFTY_TEST_OP(ids[0], ==, blocking.coordinatesToBlockId(qBegin));
+            }
+        }
+    }
+}
+
 int main() {
 	blockingTest();
-}
\ No newline at end of file
+	blockIdsInBoundingBoxTest();
+}
@@ -0,0 +1,221 @@
+#include <iostream>
+#include <array>
+#include <vector>
+#include <cmath>
+#include <random>
+
+#include "nifty/tools/runtime_check.hxx"
+#include "nifty/filters/gaussian_curvature.hxx"
+
+typedef std::array<double, 2> Point2;
+typedef std::array<double, 3> Point3;
+
+// the derivative kernels are not normalized, so the operator returns the curvature
+// times a constant gain that only depends on the kernels;
+// at the vertex of the parabola (t, t^2 / 2) the convolution is exact and the curvature is 1
+template<class OP>
+double curvatureGain(const OP & op, const std::size_t dim){
+    const int n = 8 * op.radius() + 1;
+    const int center = n / 2;
+    std::vector<std::array<double, 3>> coords(n, std::array<double, 3>({0.0, 0.0, 0.0}));
+    for(int i = 0; i < n; ++i){
+        const double t = i - center;
+        coords[i][0] = t;
+        coords[i][1] = 0.5 * t * t;
+    }
+    std::vector<double> out(n);
+    if(dim == 2){
+        std::vector<Point2> coords2(n);
+        for(int i = 0; i < n; ++i){
+            coords2[i] = Point2({coords[i][0], coords[i][1]});
+        }
+        op(coords2.begin(), coords2.end(), out.begin(), false);
+    }
+    else{
+        op(coords.begin(), coords.end(), out.begin(), false);
+    }
+    return out[center];
+}
+
+
+// the implementation before the blocked version, extrapolates the coordinates lazily
+template<class T, class COORD_ITER, class OUT_ITER>
+void referenceCurvature2D(const T sigma, COORD_ITER coords, OUT_ITER out, const std::size_t size){
+    typedef T ValueType;
+    const int radius = std::max(1, int(sigma * 3.5 + 0.5));
+    const int kSize = 2 * radius + 1;
+    std::vector<ValueType> kdx(kSize), kdxx(kSize);
+    const auto sigmaP2 = sigma * sigma;
+    const auto sigmaP4 = sigmaP2 * sigmaP2;
+    ValueType sxx = 0;
+    for(int i = 0; i < kSize; ++i){
+        const auto x = double(i - radius);
+        const auto xP2 = x * x;
+        const auto g0 = std::exp(-1.0 * xP2 / sigmaP2);
+        kdx[i] = -1.0 * (-1.0 * x / sigmaP2) * g0;
+        kdxx[i] = ((xP2 - sigmaP2) / sigmaP4) * g0;
+        sxx += kdxx[i];
+    }
+    for(int i = 0; i < kSize; ++i){
+        kdxx[i] -= (sxx / kSize);
+    }
+
+    const int s = size;
+    ValueType dLow[2], dHigh[2];
+    for(int d = 0; d < 2; ++d){
+        dLow[d] = coords[0][d] - coords[1][d];
+        dHigh[d] = coords[s - 1][d] - coords[s - 2][d];
+    }
+    auto extrapolated = [&](const int i, const int d){
+        if(i >= 0 && i < s){
+            return ValueType(coords[i][d]);
+        }
+        else if(i < 0){
+            return ValueType(coords[0][d]) + dLow[d] * ValueType(std::abs(i));
+        }
+        return ValueType(coords[s - 1][d]) + dHigh[d] * ValueType(i - (s - 1));
+    };
+
+    for(int i = 0; i < s; ++i){
+        ValueType dx[2] = {ValueType(0), ValueType(0)};
+        ValueType dxx[2] = {ValueType(0), ValueType(0)};
+        for(int ki = 0; ki < kSize; ++ki){
+            for(int d = 0; d < 2; ++d){
+                const auto c = extrapolated(i - radius + ki, d);
+                dx[d] += c * kdx[ki];
+                dxx[d] += c * kdxx[ki];
+            }
+        }
+        const auto a = std::abs(dx[0] * dxx[1] - dx[1] * dxx[0]);
+        const auto b = std::pow(dx[0] * dx[0] + dx[1] * dx[1], 3.0 / 2.0);
+        if(std::abs(a) < 0.000000001 && std::abs(b) < 0.000000001){
+            out[i] = 0.0;
+        }
+        else{
+            out[i] = a / b;
+        }
+    }
+}
+
+
+void circleTest(){
+    const double tol = 0.01;
+    for(const double sigma : {1.0, 2.0, 4.0}){
+        nifty::filters::GaussianCurvature2D<double> op(sigma);
+        const double gain = curvatureGain(op, 2);
+        const int margin = 2 * op.radius();
+
+        // the smoothing flattens circles that are not large compared to sigma
+        for(const double rFactor : {12.0, 50.0}){
+            const double r = rFactor * sigma;
+            const int n = int(2.0 * M_PI * r);
+
+            // closed circle and open (three quarter) arc, unit spacing along the curve
+            for(const bool closed : {true, false}){
+                const int size = closed ? n : 3 * n / 4;
+                std::vector<Point2> coords(size);
+                for(int i = 0; i < size; ++i){
+                    const double t = 2.0 * M_PI * i / n;
+                    coords[i] = Point2({r * std::cos(t), r * std::sin(t)});
+                }
+                std::vector<double> out(size);
+                op(coords.begin(), coords.end(), out.begin(), closed);
+
+                // the curve is extrapolated linearly, so the ends are not checked
+                for(int i = margin; i < size - margin; ++i){
+                    const double relativeCurvature = out[i] / gain * r;
+                    NIFTY_TEST_EQ_TOL(relativeCurvature, 1.0, tol);
+                }
+            }
+        }
+    }
+}
+
+
+void helixTest(){
+    const double tol = 0.01;
+    for(const double sigma : {1.0, 3.0}){
+        nifty::filters::GaussianCurvature3D<double> op(sigma);
+        const double gain = curvatureGain(op, 3);
+        const int margin = 2 * op.radius();
+
+        // as for the circle, the radius of curvature must be large compared to sigma
+        for(const double aFactor : {15.0, 50.0}){
+            const double a = aFactor * sigma;
+            const double b = 0.25 * a;
+            const double expected = a / (a * a + b * b);
+            // unit spacing along the curve
+            const double dt = 1.0 / std::sqrt(a * a + b * b);
+            const int size = int(6.0 * M_PI / dt);
+            std::vector<Point3> coords(size);
+            for(int i = 0; i < size; ++i){
+                const double t = i * dt;
+                coords[i] = Point3({a * std::cos(t), a * std::sin(t), b * t});
+            }
+            std::vector<double> out(size);
+            op(coords.begin(), coords.end(), out.begin(), false);
+
+            for(int i = margin; i < size - margin; ++i){
+                const double relativeCurvature = out[i] / gain / expected;
+                NIFTY_TEST_EQ_TOL(relativeCurvature, 1.0, tol);
+            }
+
+            // a planar curve in 3D has the same curvature as in 2D
+            std::vector<Point2> coords2(size);
+            std::vector<Point3> coords3(size);
+            for(int i = 0; i < size; ++i){
+                coords2[i] = Point2({coords[i][0], coords[i][1]});
+                coords3[i] = Point3({coords[i][0], coords[i][1], 0.0});
+            }
+            nifty::filters::GaussianCurvature2D<double> op2(sigma);
+            std::vector<double> out2(size), out3(size);
+            op2(coords2.begin(), coords2.end(), out2.begin(), false);
+            op(coords3.begin(), coords3.end(), out3.begin(), false);
+            for(int i = 0; i < size; ++i){
+                NIFTY_TEST_EQ_TOL(out2[i], out3[i], 1e-9);
+            }
+        }
+    }
+}
+
+
+void regressionTest(){
+    // random polylines, the long one is split into several blocks
+    std::mt19937 gen(42);
+    std::uniform_real_distribution<double> step(-1.0, 1.0);
+    for(const std::size_t size : {std::size_t(5), std::size_t(100), std::size_t(10000)}){
+        std::vector<Point2> coords(size);
+        Point2 p({0.0, 0.0});
+        for(auto & c : coords){
+            p[0] += step(gen);
+            p[1] += step(gen);
+            c = p;
+        }
+
+        for(const long double sigma : {1.0L, 2.5L}){
+            nifty::filters::GaussianCurvature2D<> op(sigma);
+            std::vector<long double> expected(size);
+            referenceCurvature2D(sigma, coords.begin(), expected.begin(), size);
+
+            // with and without threads and a reused workspace
+            nifty::filters::GaussianCurvature2D<>::Workspace workspace;
+            for(const int nThreads : {1, 4}){
+                std::vector<long double> out(size), outWorkspace(size);
+                op(coords.begin(), coords.end(), out.begin(), false, nThreads);
+                op(coords.begin(), coords.end(), outWorkspace.begin(), false, workspace, nThreads);
+                for(std::size_t i = 0; i < size; ++i){
+                    const long double tol = 1e-12L * std::max(1.0L, std::abs(expected[i]));
+                    NIFTY_TEST_EQ_TOL(out[i], expected[i], tol);
+                    NIFTY_TEST_EQ_TOL(outWorkspace[i], out[i], 0.0L);
+                }
+            }
+        }
+    }
+}
+
+
+int main(){
+    circleTest();
+    helixTest();
+    regressionTest();
+}
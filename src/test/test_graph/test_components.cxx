@@ -0,0 +1,64 @@
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include "nifty/tools/runtime_check.hxx"
+#include "nifty/graph/undirected_list_graph.hxx"
+#include "nifty/graph/components.hxx"
+
+// the parallel build must find the same partition as the serial one
+void parallelComponentsTest()
+{
+    typedef nifty::graph::UndirectedGraph<>  GraphType;
+    const uint64_t numberOfNodes = 5000;
+    GraphType g(numberOfNodes);
+
+    std::mt19937 gen(42);
+    std::uniform_int_distribution<uint64_t> nodeDist(0, numberOfNodes - 1);
+    for(int i = 0; i < 20000; ++i){
+        const auto u = nodeDist(gen);
+        const auto v = nodeDist(gen);
+        if(u != v){
+            g.insertEdge(u, v);
+        }
+    }
+
+    std::vector<uint8_t> edgeLabels(g.edgeIdUpperBound() + 1);
+    std::bernoulli_distribution cutDist(0.8);
+    for(auto & l : edgeLabels){
+        l = cutDist(gen);
+    }
+
+    nifty::graph::ComponentsUfd<GraphType> serial(g);
+    const auto nSerial = serial.buildFromEdgeLabels(edgeLabels);
+    std::vector<uint64_t> serialLabels(numberOfNodes);
+    serial.denseRelabeling(serialLabels);
+
+    for(const int numberOfThreads : {1, 4}){
+        nifty::graph::ComponentsUfd<GraphType> parallel(g);
+        const auto nParallel = parallel.buildFromEdgeLabels(edgeLabels, numberOfThreads);
+        NIFTY_TEST_OP(nParallel, ==, nSerial);
+
+        std::vector<uint64_t> parallelLabels(numberOfNodes);
+        parallel.parallelDenseRelabeling(parallelLabels, numberOfThreads);
+
+        // same partition, labels may be permuted
+        std::vector<int64_t> serialToParallel(nSerial, -1);
+        for(uint64_t node = 0; node < numberOfNodes; ++node){
+            auto & mapped = serialToParallel[serialLabels[node]];
+            if(mapped == -1){
+                mapped = parallelLabels[node];
+            }
+            NIFTY_TEST_OP(mapped, ==, int64_t(parallelLabels[node]));
+        }
+
+        for(const auto edge : g.edges()){
+            NIFTY_TEST_OP(parallel.areConnected(g.u(edge), g.v(edge)), ==,
+                          serial.areConnected(g.u(edge), g.v(edge)));
+        }
+    }
+}
+
+int main(){
+    parallelComponentsTest();
+}
@@ -0,0 +1,100 @@
+#include <iostream>
+#include <random>
+#include <tuple>
+#include <vector>
+
+#include "nifty/tools/runtime_check.hxx"
+#include "nifty/graph/undirected_list_graph.hxx"
+#include "nifty/graph/edge_contraction_graph.hxx"
+
+typedef nifty::graph::UndirectedGraph<> GraphType;
+
+// records all callbacks, so that different merge modes can be compared
+struct RecordingCallback{
+    void contractEdge(const uint64_t edge){
+        calls.emplace_back(0, edge, 0);
+    }
+    void mergeNodes(const uint64_t aliveNode, const uint64_t deadNode){
+        calls.emplace_back(1, aliveNode, deadNode);
+    }
+    void mergeEdges(const uint64_t aliveEdge, const uint64_t deadEdge){
+        calls.emplace_back(2, aliveEdge, deadEdge);
+    }
+    void contractEdgeDone(const uint64_t edge){
+        calls.emplace_back(3, edge, 0);
+    }
+    std::vector<std::tuple<int, uint64_t, uint64_t>> calls;
+};
+
+template<bool WITH_EDGE_UFD>
+void contractAll(const GraphType & g,
+                 const std::vector<uint64_t> & order,
+                 const nifty::graph::AdjacencyMergeMode mode,
+                 RecordingCallback & callback,
+                 std::vector<std::vector<std::pair<int64_t, int64_t>>> & adjacencies)
+{
+    nifty::graph::EdgeContractionGraph<GraphType, RecordingCallback, WITH_EDGE_UFD> cgraph(g, callback);
+    cgraph.setAdjacencyMergeMode(mode);
+    for(const auto edge : order){
+        const auto uv = cgraph.uv(edge);
+        if(uv.first != uv.second){
+            cgraph.contractEdge(cgraph.findEdge(uv.first, uv.second));
+        }
+        if(cgraph.numberOfNodes() == 4){
+            break;
+        }
+    }
+
+    adjacencies.assign(g.numberOfNodes(), {});
+    for(uint64_t node = 0; node < g.numberOfNodes(); ++node){
+        if(cgraph.findRepresentativeNode(node) == node){
+            for(const auto adj : cgraph.adjacency(node)){
+                adjacencies[node].emplace_back(adj.node(), adj.edge());
+            }
+        }
+    }
+    NIFTY_TEST_OP(cgraph.numberOfNodes(), ==, 4);
+}
+
+template<bool WITH_EDGE_UFD>
+void testSortMergeEqualsInsertMerge()
+{
+    const uint64_t numberOfNodes = 500;
+    std::mt19937 gen(42);
+    std::uniform_int_distribution<uint64_t> nodeDist(0, numberOfNodes - 1);
+
+    // a chain keeps the graph connected, the random edges create hubs
+    GraphType g(numberOfNodes);
+    for(uint64_t u = 0; u + 1 < numberOfNodes; ++u){
+        g.insertEdge(u, u + 1);
+    }
+    for(int i = 0; i < 3000; ++i){
+        const auto u = nodeDist(gen);
+        const auto v = nodeDist(gen);
+        if(u != v){
+            g.insertEdge(u, v);
+        }
+    }
+
+    std::vector<uint64_t> order;
+    std::uniform_int_distribution<uint64_t> edgeDist(0, g.numberOfEdges() - 1);
+    for(int i = 0; i < 20000; ++i){
+        order.push_back(edgeDist(gen));
+    }
+
+    RecordingCallback insertCallback, sortCallback;
+    std::vector<std::vector<std::pair<int64_t, int64_t>>> insertAdjacencies, sortAdjacencies;
+    contractAll<WITH_EDGE_UFD>(g, order, nifty::graph::INSERT_MERGE, insertCallback, insertAdjacencies);
+    contractAll<WITH_EDGE_UFD>(g, order, nifty::graph::SORT_MERGE, sortCallback, sortAdjacencies);
+
+    NIFTY_TEST_OP(insertCallback.calls.size(), ==, sortCallback.calls.size());
+    const bool sameCalls = insertCallback.calls == sortCallback.calls;
+    NIFTY_TEST(sameCalls);
+    const bool sameAdjacencies = insertAdjacencies == sortAdjacencies;
+    NIFTY_TEST(sameAdjacencies);
+}
+
+int main(){
+    testSortMergeEqualsInsertMerge<true>();
+    testSortMergeEqualsInsertMerge<false>();
+}
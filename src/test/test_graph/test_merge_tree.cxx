@@ -0,0 +1,120 @@
+#include <algorithm>
+#include <iostream>
+#include <limits>
+#include <numeric>
+#include <random>
+#include <vector>
+
+#include "nifty/tools/runtime_check.hxx"
+#include "nifty/graph/undirected_list_graph.hxx"
+#include "nifty/graph/agglo/merge_tree.hxx"
+#include "nifty/ufd/ufd.hxx"
+
+typedef nifty::graph::UndirectedGraph<> GraphType;
+typedef nifty::graph::agglo::MergeTree<uint32_t, float> MergeTreeType;
+
+// merge along the edges in the order of random weights (kruskal),
+// which gives a monotone merge tree
+void buildTree(const uint64_t numberOfNodes, GraphType & g, MergeTreeType & tree)
+{
+    std::mt19937 gen(42);
+    std::uniform_int_distribution<uint64_t> nodeDist(0, numberOfNodes - 1);
+    for(int i = 0; i < 4 * int(numberOfNodes); ++i){
+        const auto u = nodeDist(gen);
+        const auto v = nodeDist(gen);
+        if(u != v){
+            g.insertEdge(u, v);
+        }
+    }
+    std::vector<float> weights(g.numberOfEdges());
+    std::uniform_real_distribution<float> weightDist(0, 1);
+    for(auto & w : weights){
+        w = weightDist(gen);
+    }
+    std::vector<uint64_t> order(g.numberOfEdges());
+    std::iota(order.begin(), order.end(), 0);
+    std::sort(order.begin(), order.end(), [&](uint64_t a, uint64_t b){return weights[a] < weights[b];});
+
+    nifty::ufd::Ufd<uint64_t> ufd(numberOfNodes);
+    std::vector<uint64_t> clusterNode(numberOfNodes);
+    std::iota(clusterNode.begin(), clusterNode.end(), 0);
+    for(const auto e : order){
+        const auto ru = ufd.find(g.u(e));
+        const auto rv = ufd.find(g.v(e));
+        if(ru != rv){
+            const auto merged = tree.addMerge(clusterNode[ru], clusterNode[rv], weights[e], 0);
+            ufd.merge(ru, rv);
+            clusterNode[ufd.find(ru)] = merged;
+        }
+    }
+}
+
+// brute force: the height of the lowest common ancestor
+float lcaHeight(const MergeTreeType & tree, const uint64_t u, const uint64_t v)
+{
+    const uint64_t nNodes = tree.numberOfNodes();
+    std::vector<uint64_t> parents(nNodes, nNodes);
+    for(uint64_t i = 0; i < tree.numberOfMerges(); ++i){
+        parents[tree.childrenA()[i]] = tree.numberOfLeaves() + i;
+        parents[tree.childrenB()[i]] = tree.numberOfLeaves() + i;
+    }
+    std::vector<char> isAncestor(nNodes + 1, false);
+    for(uint64_t x = u; x != nNodes; x = parents[x]){
+        isAncestor[x] = true;
+    }
+    uint64_t x = v;
+    while(x != nNodes && !isAncestor[x]){
+        x = parents[x];
+    }
+    return x == nNodes ? std::numeric_limits<float>::infinity() : tree.heights()[x - tree.numberOfLeaves()];
+}
+
+void edgeUcmTest()
+{
+    const uint64_t numberOfNodes = 300;
+    GraphType g(numberOfNodes);
+    MergeTreeType tree(numberOfNodes);
+    buildTree(numberOfNodes, g, tree);
+
+    std::vector<float> ucm(g.edgeIdUpperBound() + 1);
+    tree.edgeUcm(g, ucm);
+    for(const auto e : g.edges()){
+        NIFTY_TEST_OP(ucm[e], ==, lcaHeight(tree, g.u(e), g.v(e)));
+    }
+}
+
+void cutTest()
+{
+    const uint64_t numberOfNodes = 300;
+    GraphType g(numberOfNodes);
+    MergeTreeType tree(numberOfNodes);
+    buildTree(numberOfNodes, g, tree);
+
+    const std::vector<float> thresholds = {-1.f, 0.1f, 0.3f, 0.5f, 2.f};
+    struct Labels2D{
+        Labels2D(const std::size_t n) : n_(n), data_(5 * n){}
+        uint64_t & operator()(const std::size_t t, const std::size_t i){return data_[t * n_ + i];}
+        std::size_t n_;
+        std::vector<uint64_t> data_;
+    } allLabels(numberOfNodes);
+    tree.cuts(thresholds, allLabels, 4);
+
+    for(std::size_t t = 0; t < thresholds.size(); ++t){
+        std::vector<uint64_t> labels(numberOfNodes);
+        tree.cut(thresholds[t], labels);
+        for(uint64_t u = 0; u < numberOfNodes; ++u){
+            NIFTY_TEST_OP(allLabels(t, u), ==, labels[u]);
+            // two leaves are in the same cluster iff they are merged below the threshold
+            for(uint64_t v = u + 1; v < numberOfNodes; v += 7){
+                const bool sameCluster = labels[u] == labels[v];
+                const bool mergedBelow = lcaHeight(tree, u, v) <= thresholds[t];
+                NIFTY_TEST_OP(sameCluster, ==, mergedBelow);
+            }
+        }
+    }
+}
+
+int main(){
+    edgeUcmTest();
+    cutTest();
+}
@@ -0,0 +1,59 @@
+#include <iostream>
+#include <random>
+#include <set>
+#include <utility>
+#include <vector>
+
+#include "nifty/tools/runtime_check.hxx"
+#include "nifty/ufd/ufd.hxx"
+#include "nifty/graph/agglo/cluster_policies/non_link_constraints.hxx"
+
+// random constraints and merges, compared to eagerly relabeled sets
+void testNonLinkConstraints(const bool useBloomFilter)
+{
+    const uint64_t numberOfNodes = 300;
+    std::mt19937 gen(42);
+    std::uniform_int_distribution<uint64_t> nodeDist(0, numberOfNodes - 1);
+
+    nifty::ufd::Ufd<uint64_t> ufd(numberOfNodes);
+    auto findRoot = [&](const uint64_t node){
+        return ufd.find(node);
+    };
+    nifty::graph::agglo::NonLinkConstraints constraints(numberOfNodes, useBloomFilter);
+    std::set<std::pair<uint64_t, uint64_t>> reference;
+
+    for(int i = 0; i < 5000; ++i){
+        const auto u = ufd.find(nodeDist(gen));
+        const auto v = ufd.find(nodeDist(gen));
+        if(u == v){
+            continue;
+        }
+        const bool isConstrained = reference.count(std::make_pair(std::min(u, v), std::max(u, v))) > 0;
+        const bool found = constraints.isConstrained(u, v, findRoot);
+        NIFTY_TEST_OP(found, ==, isConstrained);
+
+        if(i % 3 == 0){
+            constraints.add(u, v);
+            reference.emplace(std::min(u, v), std::max(u, v));
+        }
+        else if(!isConstrained){
+            ufd.merge(u, v);
+            const auto alive = ufd.find(u);
+            const auto dead = alive == u ? v : u;
+            constraints.merge(alive, dead, findRoot);
+
+            std::set<std::pair<uint64_t, uint64_t>> relabeled;
+            for(const auto & uv : reference){
+                const auto ru = ufd.find(uv.first);
+                const auto rv = ufd.find(uv.second);
+                relabeled.emplace(std::min(ru, rv), std::max(ru, rv));
+            }
+            reference.swap(relabeled);
+        }
+    }
+}
+
+int main(){
+    testNonLinkConstraints(true);
+    testNonLinkConstraints(false);
+}
@@ -2,6 +2,7 @@
 
 #include "nifty/tools/runtime_check.hxx"
 #include "nifty/histogram/histogram.hxx"
+#include "nifty/histogram/histogram_pool.hxx"
 
 static const float tol = 0.000001;
 
@@ -45,6 +46,44 @@ void histogramTest1()
 
 }
 
+void histogramPoolTest()
+{
+    // the pooled histograms must behave like individual histograms
+    const std::size_t nHist = 4;
+    nifty::histogram::HistogramPool<double, double> pool(nHist, 0.0, 6.0, 10);
+    std::vector<nifty::histogram::Histogram<double, double>> hists(nHist,
+        nifty::histogram::Histogram<double, double>(0.0, 6.0, 10));
+
+    for(std::size_t h = 0; h < nHist; ++h){
+        for(std::size_t i = 0; i <= 3 * h; ++i){
+            const double value = 0.37 * double(i * (h + 1)) - 0.5;
+            pool.insert(h, value, 1.0 + 0.1 * i);
+            hists[h].insert(value, 1.0 + 0.1 * i);
+        }
+    }
+
+    pool.merge(1, 2);
+    hists[1].merge(hists[2]);
+
+    const auto tsum = hists[3].sum();
+    hists[3] = hists[0];
+    hists[3].normalize(tsum);
+    const auto ptsum = pool.sum(3);
+    pool.copy(3, 0);
+    pool.normalize(3, ptsum);
+
+    for(std::size_t h = 0; h < nHist; ++h){
+        NIFTY_TEST_EQ_TOL(pool.sum(h), hists[h].sum(), tol);
+        for(std::size_t bin = 0; bin < hists[h].numberOfBins(); ++bin){
+            NIFTY_TEST_EQ_TOL(pool[h][bin], hists[h][bin], tol);
+        }
+        for(const double q : {0.1, 0.5, 0.9}){
+            NIFTY_TEST_EQ_TOL(pool.rank(h, q), hists[h].rank(q), tol);
+        }
+    }
+}
+
 int main(){
     histogramTest1();
+    histogramPoolTest();
 }
\ No newline at end of file